@@ -0,0 +1,57 @@
+// Hour aggregation: the native kernels against the JavaScript ones, on work
+// entry columns spread over two years. Build the addon first
+// (npm run build:native), or only JavaScript runs.
+//
+//   npm run bench:aggregate [-- entries...]
+
+const { aggregate, kernels } = require('../src/reports/aggregate');
+
+const SIZES = process.argv.slice(2).map(Number).filter(Boolean);
+
+function columns(entries) {
+  const days = new Int32Array(entries);
+  const hundredths = new Int32Array(entries);
+  for (let i = 0; i < entries; i++) {
+    days[i] = 19723 + ((i * 7919) % 730);
+    hundredths[i] = 25 * (1 + (i % 32));
+  }
+  return { days, hundredths };
+}
+
+// Best of five runs, in milliseconds
+function measure(run) {
+  let best = Infinity;
+  for (let i = 0; i < 5; i++) {
+    const start = process.hrtime.bigint();
+    run();
+    best = Math.min(best, Number(process.hrtime.bigint() - start) / 1e6);
+  }
+  return best;
+}
+
+const implementations = [['javascript', kernels.javascript]];
+if (kernels.native) {
+  implementations.push(['native', kernels.native]);
+}
+
+const results = [];
+(SIZES.length > 0 ? SIZES : [10000, 1000000, 10000000]).forEach((entries) => {
+  const data = columns(entries);
+  const times = {};
+  implementations.forEach(([name, kernel]) => {
+    const sum = measure(() => kernel.sum(data.hundredths));
+    const histogram = measure(() => aggregate(data, { kernel }));
+    times[name] = histogram;
+    results.push({
+      entries,
+      kernel: name,
+      'sum ms': sum.toFixed(2),
+      'histogram ms': histogram.toFixed(2),
+      'M entries/s': (entries / 1e3 / histogram).toFixed(0),
+      speedup: `${(times.javascript / histogram).toFixed(1)}x`
+    });
+  });
+});
+
+console.log(`node ${process.version}, native addon ${kernels.native ? 'built' : 'not built'}`);
+console.table(results);
@@ -0,0 +1,70 @@
+// CSV report encoding: the native addon against the JavaScript encoder, on
+// work entry rows as GET /api/reports/export/csv/:clientId writes them.
+// Build the addon first (npm run build:native), or only JavaScript runs.
+//
+//   npm run bench:csv [-- rows...]
+
+const { CsvEncoder } = require('../src/export/csvEncoder');
+
+const SIZES = process.argv.slice(2).map(Number).filter(Boolean);
+const FIELDS = [
+  { title: 'Date', type: 'date' },
+  { title: 'Hours', type: 'number' },
+  { title: 'Description', type: 'text' },
+  { title: 'Created At', type: 'text' }
+];
+const DESCRIPTIONS = ['Sprint planning', 'Code review', 'Client call, follow-up', 'Design "v2" mockups', 'Fehlerbehebung'];
+
+function columns(rows) {
+  const dates = new Float64Array(rows);
+  const hours = new Float64Array(rows);
+  const descriptions = new Array(rows);
+  const createdAt = new Array(rows);
+  for (let i = 0; i < rows; i++) {
+    dates[i] = 1704067200000 + (i % 730) * 86400000;
+    hours[i] = 0.25 * (1 + (i % 32));
+    descriptions[i] = `${DESCRIPTIONS[i % DESCRIPTIONS.length]} #${i}`;
+    createdAt[i] = '2024-01-15 09:30:00';
+  }
+  return [dates, hours, descriptions, createdAt];
+}
+
+// Best of three runs: milliseconds and bytes
+function measure(encoder, data, rows) {
+  let best = Infinity;
+  let bytes = 0;
+  for (let run = 0; run < 3; run++) {
+    const start = process.hrtime.bigint();
+    bytes = 0;
+    for (const chunk of encoder.rows(data, rows)) {
+      bytes += chunk.length;
+    }
+    best = Math.min(best, Number(process.hrtime.bigint() - start) / 1e6);
+  }
+  return { ms: best, bytes };
+}
+
+const implementations = [['javascript', CsvEncoder.javascript]];
+if (CsvEncoder.native) {
+  implementations.push(['native', CsvEncoder.native]);
+}
+
+const results = [];
+(SIZES.length > 0 ? SIZES : [10000, 100000, 1000000]).forEach((rows) => {
+  const data = columns(rows);
+  const times = {};
+  implementations.forEach(([name, implementation]) => {
+    const { ms, bytes } = measure(new CsvEncoder(FIELDS, { implementation }), data, rows);
+    times[name] = ms;
+    results.push({
+      rows,
+      encoder: name,
+      ms: ms.toFixed(1),
+      'MB/s': (bytes / 1e6 / (ms / 1000)).toFixed(0),
+      speedup: `${(times.javascript / ms).toFixed(1)}x`
+    });
+  });
+});
+
+console.log(`node ${process.version}, native addon ${CsvEncoder.native ? 'built' : 'not built'}`);
+console.table(results);
@@ -0,0 +1,59 @@
+// Throughput of POST /api/work-entries/import's importer: generates a CSV
+// of `rows` work entries and imports it into a fresh in-memory database
+// with the full schema (change log and search triggers included).
+//
+//   npm run bench:import [-- rows]
+
+const sqlite3 = require('sqlite3');
+const { Readable } = require('stream');
+const { run } = require('../src/database/query');
+const { runMigrations } = require('../src/database/migrate');
+const { importWorkEntries } = require('../src/import/workEntryImport');
+
+const ROWS = Number(process.argv[2]) || 1000000;
+const USER = 'bench@example.com';
+
+// The CSV in ~64KB chunks, as an upload arrives
+function* csv(rows) {
+  let chunk = 'date,hours,description,client\n';
+  for (let i = 0; i < rows; i++) {
+    chunk += `2024-${String(1 + (i % 12)).padStart(2, '0')}-${String(1 + (i % 28)).padStart(2, '0')},` +
+      `${1 + (i % 8)}.5,"Task ${i}, reviewed",Client ${i % 20}\n`;
+    if (chunk.length >= 64 * 1024) {
+      yield Buffer.from(chunk);
+      chunk = '';
+    }
+  }
+  yield Buffer.from(chunk);
+}
+
+async function main() {
+  const db = new sqlite3.Database(':memory:');
+  const log = console.log;
+  console.log = () => {};
+  await runMigrations(db);
+  console.log = log;
+
+  await run(db, 'INSERT INTO users (email) VALUES (?)', [USER]);
+  for (let i = 0; i < 20; i++) {
+    await run(db, 'INSERT INTO clients (name, user_email) VALUES (?, ?)', [`Client ${i}`, USER]);
+  }
+
+  const start = process.hrtime.bigint();
+  const report = await importWorkEntries(db, USER, Readable.from(csv(ROWS)));
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+  console.log(`${ROWS} rows, node ${process.version}`);
+  console.table([{
+    imported: report.imported,
+    failed: report.failed,
+    seconds: seconds.toFixed(2),
+    'rows/s': Math.round(report.imported / seconds)
+  }]);
+  db.close();
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,86 @@
+// Write throughput by shard count: concurrent users each inserting work
+// entries one committed statement at a time, with every user on the shard
+// the router picks. One shard is the unsharded baseline (one write lock);
+// the files live in a temporary directory, removed afterwards. Set
+// UV_THREADPOOL_SIZE above the largest shard count so shards aren't
+// waiting on libuv threads.
+//
+//   npm run bench:shards [-- shardCounts...]
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const sqlite3 = require('sqlite3');
+const { run } = require('../src/database/query');
+const { runMigrations } = require('../src/database/migrate');
+const { ShardRouter } = require('../src/database/shards');
+
+const COUNTS = process.argv.slice(2).map(Number).filter(Boolean);
+const USERS = 64;
+const WRITES_PER_USER = 200;
+
+function open(file) {
+  const db = new sqlite3.Database(file);
+  db.exec('PRAGMA foreign_keys = ON');
+  return db;
+}
+
+async function prepare(db) {
+  await run(db, 'PRAGMA journal_mode = WAL');
+  await runMigrations(db);
+}
+
+async function bench(count) {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'shards-bench-'));
+  const main = open(path.join(dir, 'timesheet.db'));
+  const router = new ShardRouter({ path: path.join(dir, 'timesheet.db'), count, open });
+
+  try {
+    await prepare(main);
+    await router.initialize(main, prepare);
+
+    const users = Array.from({ length: USERS }, (_, index) => `user${index}@example.com`);
+    const clients = new Map();
+    for (const email of users) {
+      const db = router.database(email);
+      await run(db, 'INSERT INTO users (email) VALUES (?)', [email]);
+      const { lastID } = await run(db, 'INSERT INTO clients (name, user_email) VALUES (?, ?)', ['Acme', email]);
+      clients.set(email, lastID);
+    }
+
+    const start = process.hrtime.bigint();
+    await Promise.all(users.map(async (email) => {
+      for (let i = 0; i < WRITES_PER_USER; i++) {
+        await run(router.database(email), 'INSERT INTO work_entries (client_id, user_email, hours, date) VALUES (?, ?, ?, ?)',
+          [clients.get(email), email, 1.5, Date.UTC(2024, 0, 1) + i]);
+      }
+    }));
+    const ms = Number(process.hrtime.bigint() - start) / 1e6;
+
+    return { ms, perSecond: Math.round((USERS * WRITES_PER_USER) / (ms / 1000)) };
+  } finally {
+    await router.close();
+    await new Promise((resolve) => main.close(resolve));
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+}
+
+async function main() {
+  const log = console.log;
+  const counts = COUNTS.length > 0 ? COUNTS : [1, 2, 4, 8];
+  let baseline = null;
+
+  for (const count of counts) {
+    console.log = () => {};
+    const { ms, perSecond } = await bench(count);
+    console.log = log;
+    baseline = baseline || perSecond;
+    console.log(`${String(count).padStart(2)} shards: ${ms.toFixed(0).padStart(6)} ms  ` +
+      `${String(perSecond).padStart(7)} writes/s  (${(perSecond / baseline).toFixed(2)}x)`);
+  }
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
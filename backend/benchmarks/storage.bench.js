@@ -0,0 +1,101 @@
+// The storage backends side by side: bulk insert (multi-row INSERT on
+// SQLite, COPY on PostgreSQL), a full listing in keyset pages, point reads
+// and the hours-by-client total. SQLite runs in memory; PostgreSQL runs
+// when TEST_DATABASE_URL is set, in a schema dropped afterwards.
+//
+//   npm run bench:storage [-- entries]
+
+const sqlite3 = require('sqlite3');
+const { createStorage } = require('../src/storage');
+
+const ENTRIES = Number(process.argv[2]) || 200000;
+const PAGE_SIZE = 500;
+const POINT_READS = 5000;
+const USER = 'bench@example.com';
+const DAY_MS = 24 * 60 * 60 * 1000;
+
+const backends = [
+  ['sqlite', () => createStorage({ backend: 'sqlite', db: new sqlite3.Database(':memory:') })]
+];
+if (process.env.TEST_DATABASE_URL) {
+  backends.push(['postgres', () => createStorage({
+    backend: 'postgres',
+    connectionString: process.env.TEST_DATABASE_URL,
+    schema: `bench_${process.pid}`
+  })]);
+}
+
+async function time(run) {
+  const start = process.hrtime.bigint();
+  const result = await run();
+  return { ms: Number(process.hrtime.bigint() - start) / 1e6, result };
+}
+
+async function bench(name, create) {
+  const storage = create();
+  const log = console.log;
+  console.log = () => {};
+  await storage.migrate();
+  console.log = log;
+
+  await storage.createUser(USER);
+  const clients = [];
+  for (let i = 0; i < 20; i++) {
+    clients.push((await storage.createClient(USER, { name: `Client ${i}` })).id);
+  }
+  const entries = Array.from({ length: ENTRIES }, (_, i) => ({
+    clientId: clients[i % clients.length],
+    hours: 0.25 * (1 + (i % 32)),
+    description: `Task ${i}, reviewed`,
+    date: Date.UTC(2024, 0, 1) + (i % 730) * DAY_MS
+  }));
+
+  const results = [];
+  const insert = await time(() => storage.insertWorkEntries(USER, entries));
+  results.push({ backend: name, operation: 'bulk insert', ms: insert.ms, 'ops/s': ENTRIES / (insert.ms / 1000) });
+
+  const list = await time(async () => {
+    const ids = [];
+    let cursor;
+    do {
+      const page = await storage.listWorkEntries(USER, { limit: PAGE_SIZE, cursor });
+      page.forEach((entry) => ids.push(entry.id));
+      const last = page[PAGE_SIZE - 1];
+      cursor = last ? [last.date, last.created_at, last.id] : null;
+    } while (cursor);
+    return ids;
+  });
+  results.push({ backend: name, operation: `list (${PAGE_SIZE}/page)`, ms: list.ms, 'ops/s': ENTRIES / (list.ms / 1000) });
+
+  const ids = list.result;
+  const reads = await time(async () => {
+    for (let i = 0; i < POINT_READS; i++) {
+      await storage.getWorkEntry(USER, ids[(i * 7919) % ids.length]);
+    }
+  });
+  results.push({ backend: name, operation: 'point read', ms: reads.ms, 'ops/s': POINT_READS / (reads.ms / 1000) });
+
+  const totals = await time(() => storage.hoursByClient(USER, { from: Date.UTC(2024, 5, 1), to: Date.UTC(2024, 5, 30) }));
+  results.push({ backend: name, operation: 'hours by client (1 month)', ms: totals.ms, 'ops/s': 1000 / totals.ms });
+
+  if (name === 'postgres') {
+    await storage.pool.query(`DROP SCHEMA IF EXISTS ${storage.schema} CASCADE`);
+  }
+  await storage.close();
+  return results;
+}
+
+async function main() {
+  const results = [];
+  for (const [name, create] of backends) {
+    results.push(...await bench(name, create));
+  }
+
+  console.log(`${ENTRIES} entries, node ${process.version}${process.env.TEST_DATABASE_URL ? '' : ' (set TEST_DATABASE_URL for PostgreSQL)'}`);
+  console.table(results.map((row) => ({ ...row, ms: row.ms.toFixed(1), 'ops/s': Math.round(row['ops/s']) })));
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
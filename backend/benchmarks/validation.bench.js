@@ -0,0 +1,48 @@
+// Per-validation cost of the compiled validators against Joi's own
+// validate(), on typical request payloads.
+//
+//   npm run bench:validation [-- iterations]
+
+const schemas = require('../src/validation/schemas');
+
+const ITERATIONS = Number(process.argv[2]) || 200000;
+
+const payloads = {
+  clientSchema: {
+    name: 'Acme Corporation',
+    description: 'Website redesign',
+    department: 'Marketing',
+    email: 'billing@acme.example.com'
+  },
+  workEntrySchema: { clientId: 12, hours: 7.5, description: 'Sprint planning', date: '2024-06-03' },
+  updateWorkEntrySchema: { hours: '2.25', description: 'Adjusted' },
+  changesQuerySchema: { since: '1042' },
+  emailSchema: { email: 'user@example.com' }
+};
+
+// Mean nanoseconds per call, after a warm-up run
+function measure(validate, input) {
+  for (let i = 0; i < ITERATIONS / 10; i++) {
+    validate(input);
+  }
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < ITERATIONS; i++) {
+    validate(input);
+  }
+  return Number(process.hrtime.bigint() - start) / ITERATIONS;
+}
+
+const rows = Object.entries(payloads).map(([name, input]) => {
+  const validator = schemas[name];
+  const joi = measure((value) => validator.schema.validate(value), input);
+  const compiled = measure((value) => validator.validate(value), input);
+  return {
+    schema: name,
+    'joi (ns)': Math.round(joi),
+    'compiled (ns)': Math.round(compiled),
+    speedup: `${(joi / compiled).toFixed(1)}x`
+  };
+});
+
+console.log(`${ITERATIONS} validations per schema, node ${process.version}`);
+console.table(rows);
@@ -0,0 +1,290 @@
+// Native hour aggregation kernel; see src/reports/aggregate.js, which runs
+// the same loops in JavaScript when this addon isn't built.
+//
+// Entries come as two Int32Arrays of equal length: day numbers (days since
+// 1970-01-01, UTC) and hours in hundredths. Hundredths are integers, so
+// sums are exact and do not depend on the order they are added in.
+//
+// sum(hundredths) -> the total, exact
+// range(days) -> [min, max], or null when empty
+//   Both four lanes at a time (SSE2 or NEON).
+// histogram(days, hundredths, from, counts, totals)
+//   For each entry with from <= day < from + counts.length, adds 1 to
+//   counts[day - from] (Uint32Array) and its hundredths to
+//   totals[day - from] (Float64Array). Entries are spread over four
+//   sub-histograms so consecutive entries on the same day don't wait on
+//   each other's stores; the range check and offsets are computed four
+//   lanes at a time.
+
+#include <node_api.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr int kLanes = 4;
+
+struct Int32Array {
+  const int32_t* data = nullptr;
+  size_t length = 0;
+};
+
+bool GetTypedArray(napi_env env, napi_value value, napi_typedarray_type expected, void** data, size_t* length) {
+  bool isTypedArray = false;
+  napi_typedarray_type type;
+  if (napi_is_typedarray(env, value, &isTypedArray) != napi_ok || !isTypedArray ||
+      napi_get_typedarray_info(env, value, &type, length, data, nullptr, nullptr) != napi_ok) {
+    return false;
+  }
+  return type == expected;
+}
+
+bool GetInt32Array(napi_env env, napi_value value, Int32Array* array) {
+  void* data;
+  if (!GetTypedArray(env, value, napi_int32_array, &data, &array->length)) {
+    return false;
+  }
+  array->data = static_cast<const int32_t*>(data);
+  return true;
+}
+
+napi_value Throw(napi_env env, const char* message) {
+  napi_throw_type_error(env, nullptr, message);
+  return nullptr;
+}
+
+#if defined(__SSE2__)
+// SSE2 has no 32-bit min/max: select with a comparison mask
+inline __m128i Min(__m128i a, __m128i b) {
+  const __m128i greater = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+}
+
+inline __m128i Max(__m128i a, __m128i b) {
+  const __m128i greater = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+#endif
+
+int64_t Sum(const int32_t* values, size_t length) {
+  size_t i = 0;
+  int64_t total = 0;
+#if defined(__SSE2__)
+  // Sign-extend to 64 bits: two accumulators of two lanes each
+  __m128i low = _mm_setzero_si128();
+  __m128i high = _mm_setzero_si128();
+  for (; i + 4 <= length; i += 4) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    const __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), chunk);
+    low = _mm_add_epi64(low, _mm_unpacklo_epi32(chunk, sign));
+    high = _mm_add_epi64(high, _mm_unpackhi_epi32(chunk, sign));
+  }
+  alignas(16) int64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(low, high));
+  total = lanes[0] + lanes[1];
+#elif defined(__aarch64__)
+  int64x2_t sums = vdupq_n_s64(0);
+  for (; i + 4 <= length; i += 4) {
+    sums = vpadalq_s32(sums, vld1q_s32(values + i));
+  }
+  total = vaddvq_s64(sums);
+#endif
+  for (; i < length; i++) {
+    total += values[i];
+  }
+  return total;
+}
+
+void Range(const int32_t* days, size_t length, int32_t* min, int32_t* max) {
+  size_t i = 0;
+  int32_t low = std::numeric_limits<int32_t>::max();
+  int32_t high = std::numeric_limits<int32_t>::min();
+#if defined(__SSE2__)
+  if (length >= 8) {
+    __m128i lows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(days));
+    __m128i highs = lows;
+    for (i = 4; i + 4 <= length; i += 4) {
+      const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(days + i));
+      lows = Min(lows, chunk);
+      highs = Max(highs, chunk);
+    }
+    alignas(16) int32_t lanes[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), lows);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), highs);
+    low = std::min({ lanes[0], lanes[1], lanes[2], lanes[3] });
+    high = std::max({ lanes[4], lanes[5], lanes[6], lanes[7] });
+  }
+#elif defined(__aarch64__)
+  if (length >= 8) {
+    int32x4_t lows = vld1q_s32(days);
+    int32x4_t highs = lows;
+    for (i = 4; i + 4 <= length; i += 4) {
+      const int32x4_t chunk = vld1q_s32(days + i);
+      lows = vminq_s32(lows, chunk);
+      highs = vmaxq_s32(highs, chunk);
+    }
+    low = vminvq_s32(lows);
+    high = vmaxvq_s32(highs);
+  }
+#endif
+  for (; i < length; i++) {
+    low = std::min(low, days[i]);
+    high = std::max(high, days[i]);
+  }
+  *min = low;
+  *max = high;
+}
+
+napi_value SumFn(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  Int32Array values;
+  if (napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr) != napi_ok || argc < 1 ||
+      !GetInt32Array(env, argv[0], &values)) {
+    return Throw(env, "sum(hundredths) expects an Int32Array");
+  }
+  napi_value result;
+  napi_create_double(env, static_cast<double>(Sum(values.data, values.length)), &result);
+  return result;
+}
+
+napi_value RangeFn(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  Int32Array days;
+  if (napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr) != napi_ok || argc < 1 ||
+      !GetInt32Array(env, argv[0], &days)) {
+    return Throw(env, "range(days) expects an Int32Array");
+  }
+
+  napi_value result;
+  if (days.length == 0) {
+    napi_get_null(env, &result);
+    return result;
+  }
+  int32_t min;
+  int32_t max;
+  Range(days.data, days.length, &min, &max);
+  napi_value low;
+  napi_value high;
+  napi_create_array_with_length(env, 2, &result);
+  napi_create_int32(env, min, &low);
+  napi_create_int32(env, max, &high);
+  napi_set_element(env, result, 0, low);
+  napi_set_element(env, result, 1, high);
+  return result;
+}
+
+napi_value HistogramFn(napi_env env, napi_callback_info info) {
+  size_t argc = 5;
+  napi_value argv[5];
+  Int32Array days;
+  Int32Array hundredths;
+  int32_t from;
+  void* countsData;
+  void* totalsData;
+  size_t span;
+  size_t totalsLength;
+  if (napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr) != napi_ok || argc < 5 ||
+      !GetInt32Array(env, argv[0], &days) || !GetInt32Array(env, argv[1], &hundredths) ||
+      napi_get_value_int32(env, argv[2], &from) != napi_ok ||
+      !GetTypedArray(env, argv[3], napi_uint32_array, &countsData, &span) ||
+      !GetTypedArray(env, argv[4], napi_float64_array, &totalsData, &totalsLength)) {
+    return Throw(env, "histogram(days, hundredths, from, counts, totals) expects Int32Arrays, a day, a Uint32Array and a Float64Array");
+  }
+  if (hundredths.length != days.length || totalsLength != span) {
+    return Throw(env, "days and hundredths, and counts and totals, must have the same lengths");
+  }
+
+  auto* counts = static_cast<uint32_t*>(countsData);
+  auto* totals = static_cast<double*>(totalsData);
+  // Sub-histograms, merged into the caller's arrays at the end
+  std::vector<uint32_t> laneCounts(kLanes * span, 0);
+  std::vector<int64_t> laneTotals(kLanes * span, 0);
+  const auto limit = static_cast<uint32_t>(span);
+
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i base = _mm_set1_epi32(from);
+  // Unsigned offset < span, via a signed compare with the sign bit flipped
+  const __m128i flip = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m128i bound = _mm_set1_epi32(static_cast<int32_t>(limit ^ 0x80000000u));
+  for (; i + kLanes <= days.length; i += kLanes) {
+    const __m128i offsets = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(days.data + i)), base);
+    const __m128i inside = _mm_cmplt_epi32(_mm_xor_si128(offsets, flip), bound);
+    alignas(16) uint32_t lanes[kLanes];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), offsets);
+    const int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+    for (int lane = 0; lane < kLanes; lane++) {
+      if (mask & (1 << lane)) {
+        const size_t slot = lane * span + lanes[lane];
+        laneCounts[slot] += 1;
+        laneTotals[slot] += hundredths.data[i + lane];
+      }
+    }
+  }
+#elif defined(__aarch64__)
+  const int32x4_t base = vdupq_n_s32(from);
+  const uint32x4_t bound = vdupq_n_u32(limit);
+  for (; i + kLanes <= days.length; i += kLanes) {
+    const uint32x4_t offsets = vreinterpretq_u32_s32(vsubq_s32(vld1q_s32(days.data + i), base));
+    const uint32x4_t inside = vcltq_u32(offsets, bound);
+    uint32_t lanes[kLanes];
+    uint32_t masks[kLanes];
+    vst1q_u32(lanes, offsets);
+    vst1q_u32(masks, inside);
+    for (int lane = 0; lane < kLanes; lane++) {
+      if (masks[lane]) {
+        const size_t slot = lane * span + lanes[lane];
+        laneCounts[slot] += 1;
+        laneTotals[slot] += hundredths.data[i + lane];
+      }
+    }
+  }
+#endif
+  for (; i < days.length; i++) {
+    const uint32_t offset = static_cast<uint32_t>(days.data[i]) - static_cast<uint32_t>(from);
+    if (offset < limit) {
+      laneCounts[offset] += 1;
+      laneTotals[offset] += hundredths.data[i];
+    }
+  }
+
+  for (size_t day = 0; day < span; day++) {
+    int64_t total = 0;
+    uint32_t count = 0;
+    for (int lane = 0; lane < kLanes; lane++) {
+      count += laneCounts[lane * span + day];
+      total += laneTotals[lane * span + day];
+    }
+    counts[day] += count;
+    totals[day] += static_cast<double>(total);
+  }
+
+  napi_value result;
+  napi_get_undefined(env, &result);
+  return result;
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+    { "sum", nullptr, SumFn, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+    { "range", nullptr, RangeFn, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+    { "histogram", nullptr, HistogramFn, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+  };
+  napi_define_properties(env, exports, sizeof(properties) / sizeof(*properties), properties);
+  return exports;
+}
+
+}  // namespace
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
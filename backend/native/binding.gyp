@@ -0,0 +1,24 @@
+{
+  "targets": [
+    {
+      "target_name": "aggregate",
+      "sources": ["aggregate.cc"],
+      "defines": ["NAPI_VERSION=8"],
+      "cflags_cc": ["-std=c++17", "-O3"],
+      "xcode_settings": {
+        "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+        "GCC_OPTIMIZATION_LEVEL": "3"
+      }
+    },
+    {
+      "target_name": "csv_encoder",
+      "sources": ["csv_encoder.cc"],
+      "defines": ["NAPI_VERSION=8"],
+      "cflags_cc": ["-std=c++17", "-O3"],
+      "xcode_settings": {
+        "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+        "GCC_OPTIMIZATION_LEVEL": "3"
+      }
+    }
+  ]
+}
@@ -0,0 +1,445 @@
+// Native RFC 4180 CSV encoder for report exports; see
+// src/export/csvEncoder.js, which falls back to the same encoding in
+// JavaScript when this addon isn't built.
+//
+// encode(types, columns, rows) -> Buffer
+//   types    DATE (0), NUMBER (1) or TEXT (2) per column
+//   columns  DATE and NUMBER: a Float64Array (dates in epoch milliseconds;
+//            NaN is an empty field). TEXT: a string table { text, offsets },
+//            row i being text[offsets[i], offsets[i + 1]) in UTF-16 units
+//   rows     rows to write, each ending in CRLF
+//
+// A string table costs one crossing into JavaScript per column instead of
+// one per field. Text is transcoded to UTF-8 and checked for characters
+// that need quoting 8 code units at a time (SSE2 or NEON): runs of ASCII
+// without quotes are narrowed straight into the output. The output buffer
+// is per thread and reused across calls.
+
+#include <node_api.h>
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+enum ColumnType : int32_t { kDate = 0, kNumber = 1, kText = 2 };
+
+constexpr double kDayMs = 86400000.0;
+// The furthest a Date reaches either side of the epoch
+constexpr double kMaxDateMs = 8.64e15;
+
+struct Column {
+  ColumnType type;
+  const double* numbers = nullptr;
+  std::vector<char16_t> text;
+  const uint32_t* offsets = nullptr;
+  size_t length = 0;
+};
+
+// Grow-only output buffer; capacity carries over between calls
+struct Output {
+  std::vector<char> bytes = std::vector<char>(1 << 16);
+  size_t size = 0;
+
+  char* Reserve(size_t length) {
+    if (size + length > bytes.size()) {
+      bytes.resize(std::max(bytes.size() * 2, size + length));
+    }
+    return bytes.data() + size;
+  }
+
+  void Push(char c) {
+    *Reserve(1) = c;
+    size += 1;
+  }
+};
+
+thread_local Output out;
+
+inline bool IsSpecial(char16_t c) {
+  return c == u'"' || c == u',' || c == u'\r' || c == u'\n';
+}
+
+// Whether any code unit is " , \r or \n
+bool NeedsQuotes(const char16_t* data, size_t length) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi16(u'"');
+  const __m128i comma = _mm_set1_epi16(u',');
+  const __m128i cr = _mm_set1_epi16(u'\r');
+  const __m128i lf = _mm_set1_epi16(u'\n');
+  for (; i + 8 <= length; i += 8) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi16(chunk, quote), _mm_cmpeq_epi16(chunk, comma)),
+        _mm_or_si128(_mm_cmpeq_epi16(chunk, cr), _mm_cmpeq_epi16(chunk, lf)));
+    if (_mm_movemask_epi8(hits) != 0) {
+      return true;
+    }
+  }
+#elif defined(__aarch64__)
+  const uint16x8_t quote = vdupq_n_u16(u'"');
+  const uint16x8_t comma = vdupq_n_u16(u',');
+  const uint16x8_t cr = vdupq_n_u16(u'\r');
+  const uint16x8_t lf = vdupq_n_u16(u'\n');
+  for (; i + 8 <= length; i += 8) {
+    const uint16x8_t chunk = vld1q_u16(reinterpret_cast<const uint16_t*>(data + i));
+    const uint16x8_t hits = vorrq_u16(
+        vorrq_u16(vceqq_u16(chunk, quote), vceqq_u16(chunk, comma)),
+        vorrq_u16(vceqq_u16(chunk, cr), vceqq_u16(chunk, lf)));
+    if (vmaxvq_u16(hits) != 0) {
+      return true;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    if (IsSpecial(data[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether the 8 code units at `data` are ASCII other than '"'; if so they
+// are written narrowed to `to`
+inline bool CopyAsciiRun(const char16_t* data, char* to) {
+#if defined(__SSE2__)
+  const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  const __m128i high = _mm_and_si128(chunk, _mm_set1_epi16(static_cast<int16_t>(0xff80)));
+  const __m128i bad = _mm_or_si128(
+      _mm_cmpeq_epi16(chunk, _mm_set1_epi16(u'"')),
+      _mm_andnot_si128(_mm_cmpeq_epi16(high, _mm_setzero_si128()), _mm_set1_epi16(-1)));
+  if (_mm_movemask_epi8(bad) != 0) {
+    return false;
+  }
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(to), _mm_packus_epi16(chunk, chunk));
+  return true;
+#elif defined(__aarch64__)
+  const uint16x8_t chunk = vld1q_u16(reinterpret_cast<const uint16_t*>(data));
+  const uint16x8_t bad = vorrq_u16(vceqq_u16(chunk, vdupq_n_u16(u'"')), vcgtq_u16(chunk, vdupq_n_u16(0x7f)));
+  if (vmaxvq_u16(bad) != 0) {
+    return false;
+  }
+  vst1_u8(reinterpret_cast<uint8_t*>(to), vmovn_u16(chunk));
+  return true;
+#else
+  for (int i = 0; i < 8; i++) {
+    if (data[i] >= 0x80 || data[i] == u'"') {
+      return false;
+    }
+  }
+  for (int i = 0; i < 8; i++) {
+    to[i] = static_cast<char>(data[i]);
+  }
+  return true;
+#endif
+}
+
+// UTF-16 -> UTF-8, quoted (with " doubled) if needed. Unpaired surrogates
+// become U+FFFD, as in Buffer.from(string).
+void AppendText(const char16_t* data, size_t length) {
+  const bool quoted = NeedsQuotes(data, length);
+  // At most 3 bytes per code unit, or 2 per unit for a quote
+  char* to = out.Reserve(3 * length + 2);
+  char* const start = to;
+  if (quoted) {
+    *to++ = '"';
+  }
+
+  size_t i = 0;
+  while (i < length) {
+    if (i + 8 <= length && CopyAsciiRun(data + i, to)) {
+      i += 8;
+      to += 8;
+      continue;
+    }
+    const char16_t c = data[i++];
+    if (c < 0x80) {
+      *to++ = static_cast<char>(c);
+      if (c == u'"') {
+        *to++ = '"';
+      }
+    } else if (c < 0x800) {
+      *to++ = static_cast<char>(0xc0 | (c >> 6));
+      *to++ = static_cast<char>(0x80 | (c & 0x3f));
+    } else if (c >= 0xd800 && c <= 0xdbff && i < length && data[i] >= 0xdc00 && data[i] <= 0xdfff) {
+      const uint32_t point = 0x10000 + ((static_cast<uint32_t>(c) - 0xd800) << 10) + (data[i++] - 0xdc00);
+      *to++ = static_cast<char>(0xf0 | (point >> 18));
+      *to++ = static_cast<char>(0x80 | ((point >> 12) & 0x3f));
+      *to++ = static_cast<char>(0x80 | ((point >> 6) & 0x3f));
+      *to++ = static_cast<char>(0x80 | (point & 0x3f));
+    } else {
+      const char16_t point = (c >= 0xd800 && c <= 0xdfff) ? 0xfffd : c;
+      *to++ = static_cast<char>(0xe0 | (point >> 12));
+      *to++ = static_cast<char>(0x80 | ((point >> 6) & 0x3f));
+      *to++ = static_cast<char>(0x80 | (point & 0x3f));
+    }
+  }
+
+  if (quoted) {
+    *to++ = '"';
+  }
+  out.size += to - start;
+}
+
+// YYYY-MM-DD of a UTC date, by days since 1970-01-01 as in
+// http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+// Date#toISOString's date part: years 0-9999 as four digits, others in
+// the expanded form (+010000, -000001). Like `new Date(ms)`, drops the
+// fraction towards zero and writes nothing beyond the Date range.
+void AppendDate(double ms) {
+  ms = std::trunc(ms);
+  if (!(std::fabs(ms) <= kMaxDateMs)) {
+    return;
+  }
+  const int64_t days = static_cast<int64_t>(std::floor(ms / kDayMs)) + 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const int64_t dayOfEra = days - era * 146097;
+  const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const int64_t mp = (5 * dayOfYear + 2) / 153;
+  const int64_t day = dayOfYear - (153 * mp + 2) / 5 + 1;
+  const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+  const int64_t year = yearOfEra + era * 400 + (month <= 2);
+
+  const bool expanded = year < 0 || year > 9999;
+  const int yearDigits = expanded ? 6 : 4;
+  char* to = out.Reserve(13);
+  size_t length = 0;
+  if (expanded) {
+    to[length++] = year < 0 ? '-' : '+';
+  }
+  int64_t rest = year < 0 ? -year : year;
+  for (int i = yearDigits - 1; i >= 0; i--) {
+    to[length + i] = static_cast<char>('0' + rest % 10);
+    rest /= 10;
+  }
+  length += yearDigits;
+  to[length++] = '-';
+  to[length++] = static_cast<char>('0' + month / 10);
+  to[length++] = static_cast<char>('0' + month % 10);
+  to[length++] = '-';
+  to[length++] = static_cast<char>('0' + day / 10);
+  to[length++] = static_cast<char>('0' + day % 10);
+  out.size += length;
+}
+
+// Number::toString from ECMAScript, as String(number) gives: the shortest
+// digits that round-trip, written out in full for 1e-7 <= |value| < 1e21
+// and as d.ddde+n (1e-7, 1.5e+21) beyond
+void AppendNumber(double value) {
+  if (!std::isfinite(value)) {
+    return;
+  }
+  if (value == 0) {
+    out.Push('0');
+    return;
+  }
+
+  // to_chars gives the shortest round-trip digits as d.ddde+xx; ECMAScript
+  // picks the same digits and only lays them out differently
+  char scientific[32];
+  const auto result = std::to_chars(scientific, scientific + sizeof(scientific), std::fabs(value),
+                                    std::chars_format::scientific);
+  char digits[20];
+  int k = 0;
+  const char* at = scientific;
+  for (; *at != 'e'; at++) {
+    if (*at != '.') {
+      digits[k++] = *at;
+    }
+  }
+  const bool negativeExponent = at[1] == '-';
+  int exponent = 0;
+  for (at += 2; at < result.ptr; at++) {
+    exponent = exponent * 10 + (*at - '0');
+  }
+  // The decimal point goes after n digits
+  const int n = (negativeExponent ? -exponent : exponent) + 1;
+
+  char* to = out.Reserve(32);
+  size_t length = 0;
+  if (value < 0) {
+    to[length++] = '-';
+  }
+  if (k <= n && n <= 21) {
+    std::memcpy(to + length, digits, k);
+    std::memset(to + length + k, '0', n - k);
+    length += n;
+  } else if (0 < n && n <= 21) {
+    std::memcpy(to + length, digits, n);
+    to[length + n] = '.';
+    std::memcpy(to + length + n + 1, digits + n, k - n);
+    length += k + 1;
+  } else if (-6 < n && n <= 0) {
+    to[length++] = '0';
+    to[length++] = '.';
+    std::memset(to + length, '0', -n);
+    length += -n;
+    std::memcpy(to + length, digits, k);
+    length += k;
+  } else {
+    to[length++] = digits[0];
+    if (k > 1) {
+      to[length++] = '.';
+      std::memcpy(to + length, digits + 1, k - 1);
+      length += k - 1;
+    }
+    to[length++] = 'e';
+    to[length++] = n - 1 < 0 ? '-' : '+';
+    const auto written = std::to_chars(to + length, to + 32, n - 1 < 0 ? 1 - n : n - 1);
+    length = written.ptr - to;
+  }
+  out.size += length;
+}
+
+napi_value Throw(napi_env env, const char* message) {
+  napi_throw_type_error(env, nullptr, message);
+  return nullptr;
+}
+
+bool Float64Array(napi_env env, napi_value value, const double** data, size_t* length) {
+  bool isTypedArray = false;
+  napi_typedarray_type type;
+  void* raw;
+  if (napi_is_typedarray(env, value, &isTypedArray) != napi_ok || !isTypedArray ||
+      napi_get_typedarray_info(env, value, &type, length, &raw, nullptr, nullptr) != napi_ok ||
+      type != napi_float64_array) {
+    return false;
+  }
+  *data = static_cast<const double*>(raw);
+  return true;
+}
+
+bool StringTable(napi_env env, napi_value table, Column* column, size_t rows) {
+  napi_value text;
+  napi_value offsets;
+  if (napi_get_named_property(env, table, "text", &text) != napi_ok ||
+      napi_get_named_property(env, table, "offsets", &offsets) != napi_ok) {
+    return false;
+  }
+
+  bool isTypedArray = false;
+  napi_typedarray_type type;
+  size_t count;
+  void* raw;
+  if (napi_is_typedarray(env, offsets, &isTypedArray) != napi_ok || !isTypedArray ||
+      napi_get_typedarray_info(env, offsets, &type, &count, &raw, nullptr, nullptr) != napi_ok ||
+      type != napi_uint32_array || count < rows + 1) {
+    return false;
+  }
+  column->offsets = static_cast<const uint32_t*>(raw);
+
+  size_t length;
+  if (napi_get_value_string_utf16(env, text, nullptr, 0, &length) != napi_ok) {
+    return false;
+  }
+  column->text.resize(length + 1);
+  if (napi_get_value_string_utf16(env, text, column->text.data(), length + 1, &length) != napi_ok) {
+    return false;
+  }
+  // Every field must lie within the text
+  for (size_t row = 0; row < rows; row++) {
+    if (column->offsets[row] > column->offsets[row + 1] || column->offsets[row + 1] > length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+napi_value Encode(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  if (napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr) != napi_ok || argc < 3) {
+    return Throw(env, "encode(types, columns, rows) expects 3 arguments");
+  }
+
+  uint32_t count;
+  uint32_t columnCount;
+  if (napi_get_array_length(env, argv[0], &count) != napi_ok ||
+      napi_get_array_length(env, argv[1], &columnCount) != napi_ok || columnCount != count) {
+    return Throw(env, "types and columns must be arrays of the same length");
+  }
+  int64_t rowCount;
+  if (napi_get_value_int64(env, argv[2], &rowCount) != napi_ok || rowCount < 0) {
+    return Throw(env, "rows must be a count");
+  }
+  const auto rows = static_cast<size_t>(rowCount);
+
+  std::vector<Column> columns(count);
+  for (uint32_t index = 0; index < count; index++) {
+    napi_value type;
+    napi_value value;
+    int32_t typeId;
+    if (napi_get_element(env, argv[0], index, &type) != napi_ok ||
+        napi_get_element(env, argv[1], index, &value) != napi_ok ||
+        napi_get_value_int32(env, type, &typeId) != napi_ok) {
+      return Throw(env, "unknown column type");
+    }
+    Column& column = columns[index];
+    column.type = static_cast<ColumnType>(typeId);
+    if (typeId == kDate || typeId == kNumber) {
+      if (!Float64Array(env, value, &column.numbers, &column.length) || column.length < rows) {
+        return Throw(env, "date and number columns must be Float64Arrays of at least `rows` values");
+      }
+    } else if (typeId == kText) {
+      if (!StringTable(env, value, &column, rows)) {
+        return Throw(env, "text columns must be string tables covering `rows` values");
+      }
+    } else {
+      return Throw(env, "unknown column type");
+    }
+  }
+
+  out.size = 0;
+  for (size_t row = 0; row < rows; row++) {
+    for (uint32_t index = 0; index < count; index++) {
+      if (index > 0) {
+        out.Push(',');
+      }
+      const Column& column = columns[index];
+      switch (column.type) {
+        case kDate:
+          AppendDate(column.numbers[row]);
+          break;
+        case kNumber:
+          AppendNumber(column.numbers[row]);
+          break;
+        case kText:
+          AppendText(column.text.data() + column.offsets[row], column.offsets[row + 1] - column.offsets[row]);
+          break;
+      }
+    }
+    char* to = out.Reserve(2);
+    to[0] = '\r';
+    to[1] = '\n';
+    out.size += 2;
+  }
+
+  napi_value result;
+  if (napi_create_buffer_copy(env, out.size, out.bytes.data(), nullptr, &result) != napi_ok) {
+    return nullptr;
+  }
+  return result;
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+    { "encode", nullptr, Encode, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+  };
+  napi_define_properties(env, exports, sizeof(properties) / sizeof(*properties), properties);
+  return exports;
+}
+
+}  // namespace
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
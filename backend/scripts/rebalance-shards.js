@@ -0,0 +1,83 @@
+// Put every user on the shard the router sends them to, or move one user
+// to a named shard (e.g. a large tenant to a file of its own). Prints the
+// plan; --apply carries it out. Stop the server first.
+//
+//   npm run shards:rebalance [-- --apply]
+//   npm run shards:rebalance -- --move user@example.com --to tenant-acme [--apply]
+//
+// Reads DATABASE_PATH and DATABASE_SHARDS like the server. After changing
+// DATABASE_SHARDS, or when turning sharding on, run a full rebalance with
+// the new count before starting the server.
+
+const fs = require('fs');
+const path = require('path');
+const sqlite3 = require('sqlite3');
+const { run } = require('../src/database/query');
+const { runMigrations } = require('../src/database/migrate');
+const { ShardRouter } = require('../src/database/shards');
+const { planRebalance, planMove, applyRebalance } = require('../src/database/shardRebalance');
+
+function option(name) {
+  const index = process.argv.indexOf(name);
+  return index === -1 ? undefined : process.argv[index + 1];
+}
+
+function open(file) {
+  fs.mkdirSync(path.dirname(file), { recursive: true });
+  const db = new sqlite3.Database(file);
+  db.exec('PRAGMA foreign_keys = ON');
+  return db;
+}
+
+// Migrations log each step; keep the output to the plan
+async function prepare(db) {
+  const log = console.log;
+  console.log = () => {};
+  try {
+    await run(db, 'PRAGMA journal_mode = WAL');
+    await runMigrations(db);
+  } finally {
+    console.log = log;
+  }
+}
+
+async function main() {
+  const databasePath = process.env.DATABASE_PATH;
+  const count = Number(process.env.DATABASE_SHARDS);
+  if (!databasePath || !(count > 1)) {
+    throw new Error('Set DATABASE_PATH and DATABASE_SHARDS (2 or more)');
+  }
+
+  const email = option('--move');
+  if (email && !option('--to')) {
+    throw new Error('--move needs --to <shard>');
+  }
+
+  const router = new ShardRouter({ path: databasePath, count, open });
+  const mainDb = open(databasePath);
+  await prepare(mainDb);
+  await router.initialize(mainDb, prepare);
+
+  try {
+    const plan = email ? await planMove(router, email, option('--to')) : await planRebalance(router);
+
+    if (plan.length === 0) {
+      console.log('Nothing to do');
+    } else if (!process.argv.includes('--apply')) {
+      plan.forEach((step) => console.log(step.action === 'move'
+        ? `move ${step.email}: ${step.from} -> ${step.to}`
+        : `${step.action} ${step.email}: ${step.from || step.shards.join(', ')}`));
+      console.log(`${plan.length} steps; run again with --apply to carry them out`);
+    } else {
+      await applyRebalance(router, plan, { prepare, log: console.log });
+    }
+  } finally {
+    await router.close();
+    await new Promise((resolve) => mainDb.close(resolve));
+  }
+}
+
+main().catch((error) => {
+  console.error(error.message);
+  process.exit(1);
+});
@@ -0,0 +1,61 @@
+const jwt = require('jsonwebtoken');
+const { issueTokens, verifyToken, checkSigningKey, resetSigningKey } = require('../../auth/tokens');
+
+describe('Session Tokens', () => {
+  afterEach(() => {
+    resetSigningKey();
+  });
+
+  test('should issue an access and a refresh token for the user', () => {
+    const tokens = issueTokens('user@example.com', 3);
+
+    expect(tokens.expiresIn).toBe(15 * 60);
+    expect(verifyToken(tokens.accessToken, 'access')).toMatchObject({ sub: 'user@example.com', typ: 'access' });
+    expect(verifyToken(tokens.refreshToken, 'refresh')).toMatchObject({ sub: 'user@example.com', ver: 3 });
+  });
+
+  test('should give refresh tokens a longer lifetime than access tokens', () => {
+    const { accessToken, refreshToken } = issueTokens('user@example.com');
+    const access = jwt.decode(accessToken);
+    const refresh = jwt.decode(refreshToken);
+
+    expect(access.exp - access.iat).toBe(15 * 60);
+    expect(refresh.exp - refresh.iat).toBe(7 * 24 * 60 * 60);
+  });
+
+  test('should not accept one token type as the other', () => {
+    const { accessToken, refreshToken } = issueTokens('user@example.com');
+
+    expect(() => verifyToken(accessToken, 'refresh')).toThrow(jwt.JsonWebTokenError);
+    expect(() => verifyToken(refreshToken, 'access')).toThrow(jwt.JsonWebTokenError);
+  });
+
+  test('should stop accepting tokens once the secret changes', () => {
+    const { accessToken } = issueTokens('user@example.com');
+    const secret = process.env.JWT_SECRET;
+
+    try {
+      process.env.JWT_SECRET = 'a-rotated-secret';
+      resetSigningKey();
+      expect(() => verifyToken(accessToken, 'access')).toThrow(jwt.JsonWebTokenError);
+    } finally {
+      process.env.JWT_SECRET = secret;
+    }
+  });
+
+  test('should refuse to run in production without a secret', () => {
+    const { JWT_SECRET: secret, NODE_ENV: env } = process.env;
+
+    try {
+      delete process.env.JWT_SECRET;
+      process.env.NODE_ENV = 'production';
+      resetSigningKey();
+      expect(() => checkSigningKey()).toThrow('JWT_SECRET must be set in production');
+    } finally {
+      process.env.NODE_ENV = env;
+      if (secret !== undefined) {
+        process.env.JWT_SECRET = secret;
+      }
+    }
+  });
+});
@@ -0,0 +1,213 @@
+const { run, all } = require('../../database/query');
+const { runMigrations } = require('../../database/migrate');
+const {
+  ChangeLogVersionError,
+  getCurrentVersion,
+  readChanges,
+  compactChangeLog
+} = require('../../database/changeLog');
+const { softDeleteClients } = require('../../database/clientPurge');
+
+function loadSqlite() {
+  try {
+    // The real driver: __tests__/setup.js mocks it for everything else
+    return jest.requireActual('sqlite3');
+  } catch (err) {
+    return null;
+  }
+}
+
+const sqlite3 = loadSqlite();
+const describeSqlite = sqlite3 ? describe : describe.skip;
+
+// In-memory stand-in for the change_log tables, answering the statements
+// the module issues
+function createFakeDb(rows, { compactedThrough = 0, floors = {} } = {}) {
+  const state = { rows: [...rows], compactedThrough, floors, lastSeq: Math.max(0, ...rows.map(row => row.seq)) };
+
+  const db = {
+    state,
+    get: jest.fn((sql, params, callback) => {
+      callback(null, { current: state.lastSeq, oldest: state.compactedThrough, floor: state.floors[params[0]] });
+    }),
+    all: jest.fn((sql, params, callback) => {
+      if (sql.includes('GROUP BY entity_id')) {
+        const [userEmail, entity, since] = params;
+        const limit = params[params.length - 1];
+        const latest = new Map();
+        state.rows
+          .filter(row => row.user_email === userEmail && row.entity === entity && row.seq > since)
+          .forEach(row => latest.set(row.entity_id, row.seq));
+        const result = [...latest].map(([entity_id, seq]) => ({ entity_id, seq }))
+          .sort((a, b) => a.seq - b.seq)
+          .slice(0, limit);
+        return callback(null, result);
+      }
+      if (sql.includes('WHERE seq > ?')) {
+        const [from, limit] = params;
+        return callback(null, state.rows.filter(row => row.seq > from).slice(0, limit));
+      }
+      const [limit] = params;
+      callback(null, state.rows.slice(0, limit));
+    }),
+    run: jest.fn((sql, params, callback) => {
+      const before = state.rows.length;
+      if (sql.includes('EXISTS')) {
+        const [from, to] = params;
+        state.rows = state.rows.filter(row => !(row.seq > from && row.seq <= to && state.rows.some(
+          newer => newer.entity === row.entity && newer.entity_id === row.entity_id && newer.seq > row.seq
+        )));
+      } else if (sql.includes('change_log_state')) {
+        state.compactedThrough = Math.max(state.compactedThrough, params[0]);
+      } else if (sql.includes('DELETE FROM change_log WHERE seq <= ?')) {
+        state.rows = state.rows.filter(row => row.seq > params[0]);
+      }
+      callback.call({ changes: before - state.rows.length }, null);
+    })
+  };
+  return db;
+}
+
+const change = (seq, entityId, { entity = 'work_entry', user = 'a@example.com', at = '2024-06-01 00:00:00' } = {}) => ({
+  seq,
+  entity,
+  entity_id: entityId,
+  user_email: user,
+  changed_at: at
+});
+
+describe('Change Log', () => {
+  describe('readChanges', () => {
+    test('should return each changed row once, oldest change first', async () => {
+      const db = createFakeDb([change(1, 10), change(2, 11), change(3, 10), change(4, 12, { user: 'b@example.com' })]);
+
+      const result = await readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since: 1, limit: 100 });
+
+      expect(result).toEqual({ ids: [11, 10], version: 4, hasMore: false });
+    });
+
+    test('should page with the last returned sequence as version', async () => {
+      const db = createFakeDb([change(1, 1), change(2, 2), change(3, 3)]);
+
+      const result = await readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since: 0, limit: 2 });
+
+      expect(result).toEqual({ ids: [1, 2], version: 2, hasMore: true });
+    });
+
+    test('should reject versions outside the retained range', async () => {
+      const db = createFakeDb([change(5, 1)], { compactedThrough: 3 });
+      const read = since => readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since, limit: 10 });
+
+      await expect(read(6)).rejects.toBeInstanceOf(ChangeLogVersionError);
+      await expect(read(2)).rejects.toMatchObject({ version: 5 });
+      await expect(read(3)).resolves.toEqual({ ids: [1], version: 5, hasMore: false });
+    });
+
+    test('should reject versions from before the user moved shards', async () => {
+      const db = createFakeDb([change(4, 1), change(5, 2, { user: 'b@example.com' })], { floors: { 'a@example.com': 4 } });
+      const read = (userEmail, since) => readChanges(db, { userEmail, entity: 'work_entry', since, limit: 10 });
+
+      await expect(read('a@example.com', 3)).rejects.toBeInstanceOf(ChangeLogVersionError);
+      await expect(read('a@example.com', 4)).resolves.toEqual({ ids: [], version: 5, hasMore: false });
+      await expect(read('b@example.com', 3)).resolves.toEqual({ ids: [2], version: 5, hasMore: false });
+    });
+  });
+
+  describe('getCurrentVersion', () => {
+    test('should be 0 for an empty log', async () => {
+      const db = { get: jest.fn((sql, params, callback) => callback(null, { current: null, oldest: 0 })) };
+
+      expect(await getCurrentVersion(db)).toBe(0);
+    });
+  });
+
+  describe('compactChangeLog', () => {
+    const now = new Date('2024-06-30T00:00:00Z');
+
+    test('should drop superseded changes without affecting readers', async () => {
+      const db = createFakeDb([change(1, 1), change(2, 2), change(3, 1), change(4, 1)]);
+      const before = await readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since: 0, limit: 10 });
+
+      const result = await compactChangeLog(db, { now, batchSize: 2, pauseMs: 0 });
+
+      expect(result).toEqual({ superseded: 2, expired: 0 });
+      expect(db.state.rows.map(row => row.seq)).toEqual([2, 4]);
+      expect(db.state.compactedThrough).toBe(0);
+      expect(await readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since: 0, limit: 10 }))
+        .toEqual(before);
+    });
+
+    test('should expire old changes and raise the oldest servable version', async () => {
+      const db = createFakeDb([
+        change(1, 1, { at: '2024-04-01 00:00:00' }),
+        change(2, 2, { at: '2024-05-01 00:00:00' }),
+        change(3, 3, { at: '2024-06-15 00:00:00' })
+      ]);
+
+      const result = await compactChangeLog(db, { now, retentionDays: 30, pauseMs: 0 });
+
+      expect(result.expired).toBe(2);
+      expect(db.state.rows.map(row => row.seq)).toEqual([3]);
+      expect(db.state.compactedThrough).toBe(2);
+    });
+  });
+
+  describeSqlite('client-level changes', () => {
+    let db;
+
+    beforeEach(async () => {
+      jest.spyOn(console, 'log').mockImplementation();
+      db = new sqlite3.Database(':memory:');
+      await runMigrations(db);
+      console.log.mockRestore();
+      await run(db, "INSERT INTO users (email) VALUES ('a@example.com')");
+      for (const name of ['Acme', 'Globex']) {
+        const { lastID } = await run(db, "INSERT INTO clients (name, user_email) VALUES (?, 'a@example.com')", [name]);
+        for (let i = 0; i < 3; i++) {
+          await run(db, "INSERT INTO work_entries (client_id, user_email, hours, date) VALUES (?, 'a@example.com', 1, ?)", [lastID, i]);
+        }
+      }
+    });
+
+    afterEach(async () => {
+      await new Promise(resolve => db.close(resolve));
+    });
+
+    test('should log a rename once and report every entry of the client', async () => {
+      const since = await getCurrentVersion(db);
+
+      await run(db, "UPDATE clients SET name = 'Acme Corp' WHERE name = 'Acme'");
+
+      expect(await all(db, 'SELECT entity, entity_id FROM change_log WHERE seq > ? ORDER BY entity', [since]))
+        .toEqual([{ entity: 'client', entity_id: 1 }, { entity: 'client_entries', entity_id: 1 }]);
+      const changes = await readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since, limit: 100 });
+      expect(changes.ids.sort()).toEqual([1, 2, 3]);
+      expect(changes.hasMore).toBe(false);
+    });
+
+    test('should not split one client change across pages', async () => {
+      const since = await getCurrentVersion(db);
+      await run(db, "UPDATE work_entries SET hours = 2 WHERE id = 4");
+      await run(db, "UPDATE clients SET name = 'Acme Corp' WHERE name = 'Acme'");
+      await run(db, "UPDATE work_entries SET hours = 3 WHERE id = 5");
+      const read = from => readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since: from, limit: 2 });
+
+      const first = await read(since);
+      expect(first.ids[0]).toBe(4);
+      expect(first.ids.slice(1).sort()).toEqual([1, 2, 3]);
+      expect(first.hasMore).toBe(true);
+
+      const second = await read(first.version);
+      expect(second).toEqual({ ids: [5], version: await getCurrentVersion(db), hasMore: false });
+    });
+
+    test('should report the entries of a soft-deleted client before they are purged', async () => {
+      const since = await getCurrentVersion(db);
+
+      await softDeleteClients(db, 'a@example.com', 2);
+
+      const changes = await readChanges(db, { userEmail: 'a@example.com', entity: 'work_entry', since, limit: 100 });
+      expect(changes.ids.sort()).toEqual([4, 5, 6]);
+    });
+  });
+});
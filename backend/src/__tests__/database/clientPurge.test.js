@@ -0,0 +1,228 @@
+const {
+  ClientPurger,
+  softDeleteClients,
+  getPurgeProgress,
+  purgeClient,
+  purgeDeletedClients
+} = require('../../database/clientPurge');
+
+// In-memory stand-in for the clients and work_entries tables, answering the
+// statements the module issues
+function createFakeDb({ clients = [], entries = [] } = {}) {
+  const state = { clients: clients.map(client => ({ ...client })), entries: [...entries] };
+
+  const db = {
+    state,
+    all: jest.fn((sql, params, callback) => {
+      const deleted = state.clients.filter(client => client.deleted_at);
+      if (sql.includes('remainingEntries')) {
+        return callback(null, deleted
+          .filter(client => client.user_email === params[0])
+          .map(client => ({
+            clientId: client.id,
+            name: client.name,
+            deletedAt: client.deleted_at,
+            totalEntries: client.purge_entries,
+            remainingEntries: state.entries.filter(entry => entry.client_id === client.id).length
+          })));
+      }
+      callback(null, deleted.map(client => ({ id: client.id })));
+    }),
+    run: jest.fn((sql, params, callback) => {
+      let changes = 0;
+      if (sql.includes('UPDATE clients')) {
+        const [userEmail, clientId] = params;
+        state.clients
+          .filter(client => client.user_email === userEmail && !client.deleted_at)
+          .filter(client => clientId === undefined || client.id === clientId)
+          .forEach(client => {
+            client.deleted_at = '2024-06-01 00:00:00';
+            client.purge_entries = state.entries.filter(entry => entry.client_id === client.id).length;
+            changes += 1;
+          });
+      } else if (sql.includes('DELETE FROM work_entries')) {
+        const [clientId, limit] = params;
+        const chunk = state.entries.filter(entry => entry.client_id === clientId).slice(0, limit);
+        state.entries = state.entries.filter(entry => !chunk.includes(entry));
+        changes = chunk.length;
+      } else if (sql.includes('DELETE FROM clients')) {
+        const before = state.clients.length;
+        state.clients = state.clients.filter(client => !(client.id === params[0] && client.deleted_at));
+        changes = before - state.clients.length;
+      }
+      callback.call({ changes }, null);
+    })
+  };
+  return db;
+}
+
+const entriesFor = (clientId, count) => Array.from({ length: count }, () => ({ client_id: clientId }));
+
+describe('Client Purge', () => {
+  beforeEach(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    console.log.mockRestore();
+  });
+
+  describe('softDeleteClients', () => {
+    test('should mark one client with its entry count', async () => {
+      const db = createFakeDb({
+        clients: [{ id: 1, user_email: 'a@example.com' }, { id: 2, user_email: 'a@example.com' }],
+        entries: entriesFor(1, 3)
+      });
+
+      const marked = await softDeleteClients(db, 'a@example.com', 1);
+
+      expect(marked).toBe(1);
+      expect(db.run.mock.calls[0][0]).toContain('AND id = ?');
+      expect(db.run.mock.calls[0][1]).toEqual(['a@example.com', 1]);
+      expect(db.state.clients[0]).toMatchObject({ purge_entries: 3 });
+      expect(db.state.clients[1].deleted_at).toBeUndefined();
+    });
+
+    test('should mark all of the user\'s clients without an id', async () => {
+      const db = createFakeDb({
+        clients: [{ id: 1, user_email: 'a@example.com' }, { id: 2, user_email: 'b@example.com' }]
+      });
+
+      const marked = await softDeleteClients(db, 'a@example.com');
+
+      expect(marked).toBe(1);
+      expect(db.run.mock.calls[0][1]).toEqual(['a@example.com']);
+    });
+  });
+
+  describe('purgeClient', () => {
+    test('should delete entries in chunks, then the client', async () => {
+      const db = createFakeDb({
+        clients: [{ id: 1, user_email: 'a@example.com', deleted_at: '2024-06-01 00:00:00' }],
+        entries: [...entriesFor(1, 5), ...entriesFor(2, 2)]
+      });
+
+      const removed = await purgeClient(db, 1, { batchSize: 2, pauseMs: 0 });
+
+      expect(removed).toBe(5);
+      // 2 + 2 + 1, then the empty chunk that ends the loop
+      expect(db.run.mock.calls.filter(([sql]) => sql.includes('DELETE FROM work_entries'))).toHaveLength(4);
+      expect(db.state.entries).toEqual(entriesFor(2, 2));
+      expect(db.state.clients).toEqual([]);
+    });
+
+    test('should stop between chunks once aborted and keep the client', async () => {
+      const db = createFakeDb({
+        clients: [{ id: 1, user_email: 'a@example.com', deleted_at: '2024-06-01 00:00:00' }],
+        entries: entriesFor(1, 5)
+      });
+      const controller = new AbortController();
+      db.run.mockImplementationOnce((sql, params, callback) => {
+        controller.abort();
+        db.state.entries = db.state.entries.slice(2);
+        callback.call({ changes: 2 }, null);
+      });
+
+      const removed = await purgeClient(db, 1, { batchSize: 2, pauseMs: 0, signal: controller.signal });
+
+      expect(removed).toBe(2);
+      expect(db.state.entries).toHaveLength(3);
+      expect(db.state.clients).toHaveLength(1);
+    });
+  });
+
+  describe('purgeDeletedClients', () => {
+    test('should purge every deleted client and leave the rest', async () => {
+      const db = createFakeDb({
+        clients: [
+          { id: 1, user_email: 'a@example.com', deleted_at: '2024-06-01 00:00:00' },
+          { id: 2, user_email: 'a@example.com' },
+          { id: 3, user_email: 'b@example.com', deleted_at: '2024-06-02 00:00:00' }
+        ],
+        entries: [...entriesFor(1, 3), ...entriesFor(2, 1), ...entriesFor(3, 2)]
+      });
+
+      const result = await purgeDeletedClients(db, { pauseMs: 0 });
+
+      expect(result).toEqual({ clients: 2, entries: 5 });
+      expect(db.state.clients.map(client => client.id)).toEqual([2]);
+      expect(db.state.entries).toEqual(entriesFor(2, 1));
+    });
+  });
+
+  describe('getPurgeProgress', () => {
+    test('should report remaining entries for the user\'s deleted clients', async () => {
+      const db = createFakeDb({
+        clients: [{ id: 1, name: 'Acme', user_email: 'a@example.com' }],
+        entries: entriesFor(1, 4)
+      });
+      await softDeleteClients(db, 'a@example.com', 1);
+      db.state.entries = db.state.entries.slice(1);
+
+      const progress = await getPurgeProgress(db, 'a@example.com');
+
+      expect(progress).toEqual([
+        { clientId: 1, name: 'Acme', deletedAt: '2024-06-01 00:00:00', totalEntries: 4, remainingEntries: 3 }
+      ]);
+      expect(await getPurgeProgress(db, 'b@example.com')).toEqual([]);
+    });
+  });
+
+  describe('ClientPurger', () => {
+    test('should resume leftover purges on start and stop cleanly', async () => {
+      const db = createFakeDb({
+        clients: [{ id: 1, user_email: 'a@example.com', deleted_at: '2024-06-01 00:00:00' }],
+        entries: entriesFor(1, 3)
+      });
+      const purger = new ClientPurger();
+
+      purger.start(db, { pauseMs: 0 });
+      await purger.running;
+      await purger.stop();
+
+      expect(db.state.clients).toEqual([]);
+      expect(purger.timer).toBeNull();
+    });
+
+    test('should run one more pass when woken during a pass', async () => {
+      const db = createFakeDb();
+      const purger = new ClientPurger();
+
+      purger.start(db, { pauseMs: 0 });
+      purger.wake();
+      await purger.running;
+      await new Promise(resolve => setImmediate(resolve));
+      await purger.stop();
+
+      // The pass on start, and the one the wake asked for
+      expect(db.all).toHaveBeenCalledTimes(2);
+    });
+
+    test('should purge every database it is given', async () => {
+      const shards = [1, 2].map(id => createFakeDb({
+        clients: [{ id, user_email: 'a@example.com', deleted_at: '2024-06-01 00:00:00' }],
+        entries: entriesFor(id, 2)
+      }));
+      const eachDatabase = async (fn) => {
+        for (const shard of shards) {
+          await fn(shard);
+        }
+      };
+      const purger = new ClientPurger();
+
+      purger.start(eachDatabase, { pauseMs: 0 });
+      await purger.running;
+      await purger.stop();
+
+      expect(shards.map(shard => shard.state.clients)).toEqual([[], []]);
+    });
+
+    test('should ignore wakes before start', () => {
+      const purger = new ClientPurger();
+
+      purger.wake();
+
+      expect(purger.running).toBeNull();
+    });
+  });
+});
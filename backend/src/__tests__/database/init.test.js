@@ -1,13 +1,15 @@
 const sqlite3 = require('sqlite3');
-const { getDatabase, initializeDatabase, closeDatabase } = require('../../database/init');
+const { getDatabase, initializeDatabase, checkpointDatabase, closeDatabase } = require('../../database/init');
 
 // Mock sqlite3
 jest.mock('sqlite3', () => {
   const mockDatabase = {
     serialize: jest.fn((callback) => callback()),
-    run: jest.fn((query, callback) => {
-      if (typeof callback === 'function') callback(null);
+    run: jest.fn((query, paramsOrCallback, callback) => {
+      const cb = typeof paramsOrCallback === 'function' ? paramsOrCallback : callback;
+      if (typeof cb === 'function') cb(null);
     }),
+    all: jest.fn((query, params, callback) => callback(null, [])),
     close: jest.fn((callback) => callback(null))
   };
 
@@ -79,7 +81,6 @@ describe('Database Initialization', () => {
       const db = getDatabase();
       await initializeDatabase();
 
-      expect(db.serialize).toHaveBeenCalled();
       expect(db.run).toHaveBeenCalled();
       
       // Check that run was called for each table and index
@@ -104,6 +105,16 @@ describe('Database Initialization', () => {
       expect(queries.some(q => q.includes('CREATE INDEX IF NOT EXISTS idx_work_entries_date'))).toBe(true);
     });
 
+    test('should record applied migrations in schema_version', async () => {
+      const db = getDatabase();
+      await initializeDatabase();
+
+      const queries = db.run.mock.calls.map(call => call[0]);
+
+      expect(queries.some(q => q.includes('CREATE TABLE IF NOT EXISTS schema_version'))).toBe(true);
+      expect(queries.filter(q => q.includes('INSERT INTO schema_version')).length).toBeGreaterThan(0);
+    });
+
     test('should log success message', async () => {
       await initializeDatabase();
       
@@ -115,30 +126,40 @@ describe('Database Initialization', () => {
     });
   });
 
+  describe('checkpointDatabase', () => {
+    test('should checkpoint and truncate the WAL', async () => {
+      const db = getDatabase();
+
+      await checkpointDatabase();
+
+      expect(db.run).toHaveBeenCalledWith('PRAGMA wal_checkpoint(TRUNCATE)', [], expect.any(Function));
+    });
+  });
+
   describe('closeDatabase', () => {
-    test('should close database connection', () => {
+    test('should close database connection', async () => {
       const db = getDatabase();
-      closeDatabase();
+      await closeDatabase();
 
       expect(db.close).toHaveBeenCalled();
       expect(consoleLogSpy).toHaveBeenCalledWith('Database connection closed');
     });
 
-    test('should handle close error gracefully', () => {
+    test('should handle close error gracefully', async () => {
       const db = getDatabase();
       db.close.mockImplementation((callback) => callback(new Error('Close error')));
 
-      closeDatabase();
+      await closeDatabase();
 
       expect(consoleErrorSpy).toHaveBeenCalledWith('Error closing database:', expect.any(Error));
     });
 
-    test('should handle multiple close calls safely', () => {
+    test('should handle multiple close calls safely', async () => {
       const db = getDatabase();
       // Reset close mock to default behavior (no error)
       db.close.mockImplementation((callback) => callback(null));
-      closeDatabase();
-      closeDatabase(); // Second call should not throw
+      // Second call should not throw
+      await Promise.all([closeDatabase(), closeDatabase()]);
 
       expect(consoleErrorSpy).not.toHaveBeenCalled();
     });
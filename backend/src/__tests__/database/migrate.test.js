@@ -0,0 +1,172 @@
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const {
+  checksum,
+  loadMigrations,
+  runInChunks,
+  runMigrations,
+  runOnlineMigrations
+} = require('../../database/migrate');
+
+function writeMigration(dir, file, body) {
+  fs.writeFileSync(path.join(dir, file), body);
+}
+
+// Minimal stand-in for a sqlite3 Database that records every statement
+function createFakeDb(appliedRows = []) {
+  const statements = [];
+  return {
+    statements,
+    run: jest.fn((sql, params, callback) => {
+      statements.push(sql.trim());
+      callback.call({ changes: 0 }, null);
+    }),
+    all: jest.fn((sql, params, callback) => {
+      if (sql.includes('completed_at IS NULL')) {
+        return callback(null, appliedRows.filter(row => !row.completed_at));
+      }
+      callback(null, sql.includes('FROM schema_version') ? appliedRows : []);
+    })
+  };
+}
+
+describe('Migration Runner', () => {
+  let dir;
+  let consoleLogSpy, consoleWarnSpy;
+
+  beforeEach(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'migrations-'));
+    consoleLogSpy = jest.spyOn(console, 'log').mockImplementation();
+    consoleWarnSpy = jest.spyOn(console, 'warn').mockImplementation();
+  });
+
+  afterEach(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+    consoleLogSpy.mockRestore();
+    consoleWarnSpy.mockRestore();
+    jest.clearAllMocks();
+  });
+
+  describe('loadMigrations', () => {
+    test('should load migrations in version order with checksums', () => {
+      writeMigration(dir, '002_second.js', 'module.exports = { up: async () => {} };');
+      writeMigration(dir, '001_first.js', 'module.exports = { up: async () => {} };');
+      writeMigration(dir, 'README.md', 'not a migration');
+
+      const migrations = loadMigrations(dir);
+
+      expect(migrations.map(m => m.version)).toEqual([1, 2]);
+      expect(migrations[0].name).toBe('first');
+      expect(migrations[0].checksum).toBe(checksum('module.exports = { up: async () => {} };'));
+    });
+
+    test('should reject duplicate versions', () => {
+      writeMigration(dir, '001_a.js', 'module.exports = { up: async () => {} };');
+      writeMigration(dir, '001_b.js', 'module.exports = { up: async () => {} };');
+
+      expect(() => loadMigrations(dir)).toThrow('Duplicate migration version 1');
+    });
+
+    test('should reject migrations without up()', () => {
+      writeMigration(dir, '001_broken.js', 'module.exports = {};');
+
+      expect(() => loadMigrations(dir)).toThrow('must export an up() function');
+    });
+  });
+
+  describe('checksum', () => {
+    test('should ignore line ending differences', () => {
+      expect(checksum('a\r\nb')).toBe(checksum('a\nb'));
+    });
+  });
+
+  describe('runMigrations', () => {
+    test('should apply pending migrations in a transaction and record them', async () => {
+      writeMigration(dir, '001_first.js', `
+        module.exports = { up: (db) => new Promise((resolve) => db.run('CREATE TABLE a (id INTEGER)', [], resolve)) };
+      `);
+      const db = createFakeDb();
+
+      const applied = await runMigrations(db, { dir });
+
+      expect(applied).toEqual([1]);
+      expect(db.statements[0]).toContain('CREATE TABLE IF NOT EXISTS schema_version');
+      expect(db.statements.slice(1)).toEqual([
+        'BEGIN IMMEDIATE',
+        'CREATE TABLE a (id INTEGER)',
+        expect.stringContaining('INSERT INTO schema_version'),
+        'COMMIT'
+      ]);
+    });
+
+    test('should skip migrations that are already applied', async () => {
+      const source = 'module.exports = { up: async () => { throw new Error("should not run"); } };';
+      writeMigration(dir, '001_first.js', source);
+      const db = createFakeDb([{ version: 1, name: 'first', checksum: checksum(source), completed_at: 'now' }]);
+
+      const applied = await runMigrations(db, { dir });
+
+      expect(applied).toEqual([]);
+      expect(db.statements).not.toContain('BEGIN IMMEDIATE');
+    });
+
+    test('should refuse to run when an applied migration was edited', async () => {
+      writeMigration(dir, '001_first.js', 'module.exports = { up: async () => {} };');
+      const db = createFakeDb([{ version: 1, name: 'first', checksum: 'stale' }]);
+
+      await expect(runMigrations(db, { dir })).rejects.toThrow('checksum mismatch');
+    });
+
+    test('should roll back a failed migration', async () => {
+      writeMigration(dir, '001_first.js', 'module.exports = { up: async () => { throw new Error("boom"); } };');
+      const db = createFakeDb();
+
+      await expect(runMigrations(db, { dir })).rejects.toThrow('Migration 001_first.js failed: boom');
+      expect(db.statements).toContain('ROLLBACK');
+      expect(db.statements).not.toContain('COMMIT');
+    });
+
+    test('should leave online migrations marked incomplete', async () => {
+      writeMigration(dir, '001_first.js', 'module.exports = { up: async () => {}, online: async () => {} };');
+      const db = createFakeDb();
+
+      await runMigrations(db, { dir });
+
+      const insert = db.run.mock.calls.find(call => call[0].includes('INSERT INTO schema_version'));
+      expect(insert[0]).toContain('NULL');
+    });
+  });
+
+  describe('runOnlineMigrations', () => {
+    test('should run unfinished online steps and mark them complete', async () => {
+      writeMigration(dir, '001_first.js', `
+        module.exports = {
+          up: async () => {},
+          online: async (db, { runInChunks }) => { global.__onlineRan = typeof runInChunks; }
+        };
+      `);
+      const db = createFakeDb([{ version: 1, name: 'first', checksum: 'x', completed_at: null }]);
+
+      await runOnlineMigrations(db, { dir });
+
+      expect(global.__onlineRan).toBe('function');
+      expect(db.statements).toContain('UPDATE schema_version SET completed_at = CURRENT_TIMESTAMP WHERE version = ?');
+      delete global.__onlineRan;
+    });
+  });
+
+  describe('runInChunks', () => {
+    test('should repeat the step until it reports no changes', async () => {
+      const step = jest.fn()
+        .mockResolvedValueOnce(100)
+        .mockResolvedValueOnce(40)
+        .mockResolvedValueOnce(0);
+
+      const total = await runInChunks(step, { pauseMs: 0 });
+
+      expect(total).toBe(140);
+      expect(step).toHaveBeenCalledTimes(3);
+    });
+  });
+});
@@ -0,0 +1,105 @@
+const { noteBulkChange, noteChange } = require('../../database/readCoherence');
+const { readFlights } = require('../../database/singleFlight');
+const { workEntryCache } = require('../../database/workEntryCache');
+const { publishChange, publishResync } = require('../../realtime/changeEvents');
+const { SqliteStorage } = require('../../storage/sqlite');
+
+function loadSqlite() {
+  try {
+    // The real driver: __tests__/setup.js mocks it for everything else
+    return jest.requireActual('sqlite3');
+  } catch (err) {
+    return null;
+  }
+}
+
+const sqlite3 = loadSqlite();
+const USER = 'a@example.com';
+
+describe('Read coherence', () => {
+  beforeEach(() => {
+    jest.spyOn(readFlights, 'invalidate');
+    jest.spyOn(workEntryCache, 'apply');
+    jest.spyOn(workEntryCache, 'drop');
+  });
+
+  afterEach(() => {
+    jest.restoreAllMocks();
+  });
+
+  test('should invalidate shared reads and apply a change to the cached window', () => {
+    const change = { entity: 'work_entry', op: 'delete', id: 4 };
+
+    noteChange(USER, change);
+
+    expect(readFlights.invalidate).toHaveBeenCalledWith(USER);
+    expect(workEntryCache.apply).toHaveBeenCalledWith(USER, change);
+  });
+
+  test('should drop the cached window after a bulk change', () => {
+    noteBulkChange(USER);
+
+    expect(readFlights.invalidate).toHaveBeenCalledWith(USER);
+    expect(workEntryCache.drop).toHaveBeenCalledWith(USER);
+  });
+
+  test('should leave reads alone when a change is only published', () => {
+    publishChange(USER, { entity: 'client', op: 'clear' });
+    publishResync(USER);
+
+    expect(readFlights.invalidate).not.toHaveBeenCalled();
+    expect(workEntryCache.apply).not.toHaveBeenCalled();
+    expect(workEntryCache.drop).not.toHaveBeenCalled();
+  });
+
+  (sqlite3 ? describe : describe.skip)('SQLite storage writes', () => {
+    let db;
+    let storage;
+    let clientId;
+
+    beforeAll(async () => {
+      jest.spyOn(console, 'log').mockImplementation();
+      db = new sqlite3.Database(':memory:');
+      storage = new SqliteStorage(db);
+      await storage.migrate();
+      await storage.createUser(USER);
+      ({ id: clientId } = await storage.createClient(USER, { name: 'Acme' }));
+      console.log.mockRestore();
+    });
+
+    afterAll(async () => {
+      await SqliteStorage.release(db);
+      await new Promise((resolve) => db.close(resolve));
+    });
+
+    test('should report each row written as it commits', async () => {
+      const row = await storage.insertWorkEntry(USER, { clientId, hours: 2, date: new Date(Date.UTC(2024, 0, 15)) });
+      expect(workEntryCache.apply).toHaveBeenLastCalledWith(USER, { entity: 'work_entry', op: 'upsert', row });
+
+      const updated = await storage.updateWorkEntry(USER, row.id, { hours: 3 });
+      expect(workEntryCache.apply).toHaveBeenLastCalledWith(USER, { entity: 'work_entry', op: 'upsert', row: updated });
+
+      await storage.deleteWorkEntry(USER, row.id);
+      expect(workEntryCache.apply).toHaveBeenLastCalledWith(USER, { entity: 'work_entry', op: 'delete', id: row.id });
+      expect(readFlights.invalidate).toHaveBeenCalledTimes(3);
+    });
+
+    test('should not report a write that changed nothing', async () => {
+      expect(await storage.deleteWorkEntry(USER, 999)).toBe(false);
+      expect(await storage.updateWorkEntry(USER, 999, { hours: 1 })).toBeUndefined();
+
+      expect(readFlights.invalidate).not.toHaveBeenCalled();
+      expect(workEntryCache.apply).not.toHaveBeenCalled();
+    });
+
+    test('should drop the cached window after a bulk insert', async () => {
+      await storage.insertWorkEntries(USER, [
+        { clientId, hours: 1, date: Date.UTC(2024, 0, 16) },
+        { clientId, hours: 2, date: Date.UTC(2024, 0, 17) }
+      ]);
+
+      expect(workEntryCache.drop).toHaveBeenCalledWith(USER);
+      expect(workEntryCache.apply).not.toHaveBeenCalled();
+    });
+  });
+});
@@ -0,0 +1,133 @@
+const { run, get, all } = require('../../database/query');
+const { runMigrations } = require('../../database/migrate');
+const { ShardRouter, hashShard } = require('../../database/shards');
+const { ChangeLogVersionError, getCurrentVersion, readChanges } = require('../../database/changeLog');
+const { MAIN, copyUser, planRebalance, planMove, applyRebalance } = require('../../database/shardRebalance');
+
+function loadSqlite() {
+  try {
+    // The real driver: __tests__/setup.js mocks it for everything else
+    return jest.requireActual('sqlite3');
+  } catch (err) {
+    return null;
+  }
+}
+
+const sqlite3 = loadSqlite();
+const describeSqlite = sqlite3 ? describe : describe.skip;
+
+const DAY = Date.UTC(2024, 0, 15);
+
+describeSqlite('Shard rebalancing', () => {
+  let files;
+  let main;
+  let router;
+
+  // Each shard "file" is an in-memory database, kept for the whole test
+  const open = (file) => {
+    if (!files.has(file)) {
+      const db = new sqlite3.Database(':memory:');
+      db.exec('PRAGMA foreign_keys = ON');
+      files.set(file, db);
+    }
+    return files.get(file);
+  };
+  const prepare = (db) => runMigrations(db);
+
+  async function addUser(db, email, clients) {
+    await run(db, 'INSERT INTO users (email) VALUES (?)', [email]);
+    for (const [name, hours] of clients) {
+      const { lastID } = await run(db, 'INSERT INTO clients (name, user_email) VALUES (?, ?)', [name, email]);
+      for (const [index, value] of hours.entries()) {
+        await run(db, 'INSERT INTO work_entries (client_id, user_email, hours, description, date) VALUES (?, ?, ?, ?, ?)',
+          [lastID, email, value, `${name} ${index}`, DAY + index]);
+      }
+    }
+  }
+
+  const entriesOf = (db, email) => all(db, `
+    SELECT c.name, we.hours, we.description, we.date
+    FROM work_entries we JOIN clients c ON c.id = we.client_id
+    WHERE we.user_email = ? ORDER BY we.description
+  `, [email]);
+
+  beforeEach(async () => {
+    jest.spyOn(console, 'log').mockImplementation();
+    files = new Map();
+    main = open('/data/t.db');
+    await prepare(main);
+    router = new ShardRouter({ path: '/data/t.db', count: 2, open });
+    router.existingShards = () => [];
+  });
+
+  afterEach(async () => {
+    await router.close();
+    await Promise.all([...files.values()].map((db) => new Promise((resolve) => db.close(resolve))));
+    console.log.mockRestore();
+  });
+
+  test('should move users out of the main database onto their shards', async () => {
+    await addUser(main, 'a@example.com', [['Acme', [1, 2.5]], ['Globex', [8]]]);
+    await addUser(main, 'b@example.com', [['Initech', [4]]]);
+    const before = await entriesOf(main, 'a@example.com');
+    await router.initialize(main, prepare);
+
+    const plan = await planRebalance(router);
+    expect(plan).toEqual([
+      { action: 'move', email: 'a@example.com', from: MAIN, to: hashShard('a@example.com', 2) },
+      { action: 'move', email: 'b@example.com', from: MAIN, to: hashShard('b@example.com', 2) }
+    ]);
+
+    await applyRebalance(router, plan, { prepare });
+
+    expect(await entriesOf(router.database('a@example.com'), 'a@example.com')).toEqual(before);
+    expect(await entriesOf(router.database('b@example.com'), 'b@example.com')).toHaveLength(1);
+    expect(await all(main, 'SELECT email FROM users')).toEqual([]);
+    expect(await all(main, 'SELECT id FROM work_entries')).toEqual([]);
+    expect(router.stats().pinned).toBe(0);
+    expect(await planRebalance(router)).toEqual([]);
+  });
+
+  test('should make clients resync after a move', async () => {
+    const shard = hashShard('a@example.com', 2);
+    await router.initialize(main, prepare);
+    const source = router.connect(shard);
+    await addUser(source, 'a@example.com', [['Acme', [1, 2]]]);
+    const since = await getCurrentVersion(source);
+    const target = router.connect('tenant-a');
+    await prepare(target);
+    await addUser(target, 'other@example.com', Array.from({ length: 5 }, (_, index) => [`C${index}`, [1, 1]]));
+
+    await applyRebalance(router, await planMove(router, 'a@example.com', 'tenant-a'), { prepare });
+
+    expect(router.shardFor('a@example.com')).toBe('tenant-a');
+    expect(await get(source, 'SELECT email FROM users WHERE email = ?', ['a@example.com'])).toBeUndefined();
+    await expect(readChanges(target, { userEmail: 'a@example.com', entity: 'work_entry', since, limit: 10 }))
+      .rejects.toBeInstanceOf(ChangeLogVersionError);
+
+    const version = await getCurrentVersion(target);
+    expect(version).toBeGreaterThan(since);
+    expect(await readChanges(target, { userEmail: 'a@example.com', entity: 'work_entry', since: version, limit: 10 }))
+      .toEqual({ ids: [], version, hasMore: false });
+    expect((await readChanges(target, { userEmail: 'other@example.com', entity: 'client', since: 0, limit: 10 })).ids)
+      .toHaveLength(5);
+  });
+
+  test('should drop the stale copy an interrupted move left behind', async () => {
+    const shard = hashShard('a@example.com', 2);
+    const other = shard === 'shard-0' ? 'shard-1' : 'shard-0';
+    await router.initialize(main, prepare);
+    await addUser(router.connect(shard), 'a@example.com', [['Acme', [3]]]);
+    await copyUser(router.connect(shard), router.connect(other), 'a@example.com');
+
+    await expect(copyUser(router.connect(shard), router.connect(other), 'a@example.com'))
+      .rejects.toThrow('already on the target shard');
+
+    const plan = await planRebalance(router);
+    expect(plan).toEqual([{ action: 'drop', email: 'a@example.com', from: other }]);
+
+    await applyRebalance(router, plan, { prepare });
+    expect(await entriesOf(router.connect(other), 'a@example.com')).toEqual([]);
+    expect(await entriesOf(router.connect(shard), 'a@example.com')).toHaveLength(1);
+  });
+});
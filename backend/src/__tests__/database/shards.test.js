@@ -0,0 +1,240 @@
+const { ShardRouter, hashEmail, hashShard, shardFile } = require('../../database/shards');
+
+function loadSqlite() {
+  try {
+    // The real driver: __tests__/setup.js mocks it for everything else
+    return jest.requireActual('sqlite3');
+  } catch (err) {
+    return null;
+  }
+}
+
+const sqlite3 = loadSqlite();
+const describeSqlite = sqlite3 ? describe : describe.skip;
+
+// A connection stand-in that records whether it was closed
+function fakeConnection(file, { closeError = null } = {}) {
+  return {
+    file,
+    closed: false,
+    close: jest.fn(function(callback) {
+      this.closed = !closeError;
+      callback(closeError);
+    })
+  };
+}
+
+describe('Shard routing', () => {
+  test('should hash a user to the same shard every time', () => {
+    expect(hashEmail('a@example.com')).toBe(hashEmail('a@example.com'));
+    expect(hashShard('a@example.com', 4)).toBe(`shard-${hashEmail('a@example.com') % 4}`);
+  });
+
+  test('should spread users across shards', () => {
+    const counts = new Map();
+    for (let i = 0; i < 4000; i++) {
+      const shard = hashShard(`user${i}@example.com`, 4);
+      counts.set(shard, (counts.get(shard) || 0) + 1);
+    }
+
+    expect([...counts.keys()].sort()).toEqual(['shard-0', 'shard-1', 'shard-2', 'shard-3']);
+    counts.forEach((count) => expect(count).toBeGreaterThan(800));
+  });
+
+  test('should name shard files after the main database', () => {
+    expect(shardFile('/data/timesheet.db', 'shard-3')).toBe('/data/timesheet.shard-3.db');
+    expect(shardFile('/data/timesheet', 'tenant-acme')).toBe('/data/timesheet.tenant-acme');
+  });
+
+  test('should reject an invalid shard count', () => {
+    expect(() => new ShardRouter({ path: '/data/t.db', count: 0, open: fakeConnection })).toThrow('Invalid shard count');
+  });
+});
+
+describe('ShardRouter connections', () => {
+  let now;
+  let router;
+
+  beforeEach(() => {
+    now = 0;
+    router = new ShardRouter({ path: '/data/t.db', count: 2, open: jest.fn(fakeConnection), idleMs: 1000, now: () => now });
+  });
+
+  test('should open a shard on first use and reuse it', () => {
+    const db = router.database('a@example.com');
+
+    expect(db.file).toBe(`/data/t.${hashShard('a@example.com', 2)}.db`);
+    expect(router.database('a@example.com')).toBe(db);
+    expect(router.open).toHaveBeenCalledTimes(1);
+  });
+
+  test('should close idle shards and reopen them on demand', async () => {
+    const first = router.database('a@example.com');
+
+    now = 500;
+    await router.sweep();
+    expect(first.closed).toBe(false);
+
+    now = 1500;
+    await router.sweep();
+    expect(first.closed).toBe(true);
+    expect(router.stats()).toMatchObject({ open: 0, opened: 1, closed: 1 });
+
+    const second = router.database('a@example.com');
+    expect(second).not.toBe(first);
+    expect(router.stats()).toMatchObject({ open: 1, opened: 2 });
+  });
+
+  test('should keep a shard open while a background job uses it', async () => {
+    let release;
+    const job = router.each((db) => new Promise((resolve) => {
+      release = resolve;
+    }), ['shard-0']);
+
+    now = 5000;
+    await router.sweep();
+    expect(router.stats().open).toBe(1);
+
+    release();
+    await job;
+    now = 10000;
+    await router.sweep();
+    expect(router.stats().open).toBe(0);
+  });
+
+  test('should keep using a shard that cannot close yet', async () => {
+    jest.spyOn(console, 'error').mockImplementation();
+    router.open = jest.fn((file) => fakeConnection(file, { closeError: new Error('SQLITE_BUSY') }));
+    const db = router.database('a@example.com');
+
+    now = 2000;
+    await router.sweep();
+
+    expect(db.close).toHaveBeenCalled();
+    expect(router.database('a@example.com')).toBe(db);
+    expect(router.stats()).toMatchObject({ open: 1, closing: 0 });
+    console.error.mockRestore();
+  });
+
+  test('should keep a shard open for a long export spanning sweeps', async () => {
+    const { db, release } = router.acquire('a@example.com');
+
+    // A page read every 800ms, past the idle time of 1000ms
+    for (let page = 0; page < 5; page++) {
+      now += 800;
+      await router.sweep();
+      expect(router.database('a@example.com')).toBe(db);
+    }
+    expect(db.closed).toBe(false);
+
+    release();
+    release();
+    now += 1000;
+    await router.sweep();
+    expect(db.closed).toBe(true);
+    expect(router.stats()).toMatchObject({ open: 0, closed: 1 });
+  });
+
+  test('should release a shard before closing it', async () => {
+    const order = [];
+    router.release = jest.fn(async () => order.push('release'));
+    const db = router.database('a@example.com');
+    db.close.mockImplementation((callback) => {
+      order.push('close');
+      callback(null);
+    });
+
+    now = 2000;
+    await router.sweep();
+
+    expect(router.release).toHaveBeenCalledWith(db);
+    expect(order).toEqual(['release', 'close']);
+  });
+
+  test('should retry closing a shard reopened while its close failed', async () => {
+    jest.spyOn(console, 'error').mockImplementation();
+    let failClose;
+    router.open = jest.fn((file) => fakeConnection(file));
+    const first = router.database('a@example.com');
+    first.close.mockImplementationOnce((callback) => {
+      failClose = () => callback(new Error('SQLITE_BUSY'));
+    });
+
+    now = 2000;
+    const sweep = router.sweep();
+    await new Promise(setImmediate);
+    const second = router.database('a@example.com');
+    failClose();
+    await sweep;
+
+    expect(console.error).toHaveBeenCalledWith(expect.stringContaining('Error closing shard'), expect.any(Error));
+    expect(router.database('a@example.com')).toBe(second);
+    expect(router.stats()).toMatchObject({ open: 1, closing: 1, closed: 0 });
+
+    await router.sweep();
+    expect(first.closed).toBe(true);
+    expect(second.closed).toBe(false);
+    expect(router.stats()).toMatchObject({ open: 1, closing: 0, closed: 1 });
+    console.error.mockRestore();
+  });
+
+  test('should keep a shard reopened while its old connection closes', async () => {
+    let finishClose;
+    const first = router.database('a@example.com');
+    first.close.mockImplementationOnce((callback) => {
+      finishClose = () => callback(null);
+    });
+
+    now = 2000;
+    const sweep = router.sweep();
+    await new Promise(setImmediate);
+    const second = router.database('a@example.com');
+    finishClose();
+    await sweep;
+
+    expect(router.database('a@example.com')).toBe(second);
+    expect(router.stats()).toMatchObject({ open: 1, closing: 0, closed: 1 });
+  });
+
+  test('should refuse an invalid shard name', () => {
+    expect(() => router.connect('../elsewhere')).toThrow('Invalid shard name');
+  });
+});
+
+describeSqlite('ShardRouter directory', () => {
+  let main;
+
+  beforeEach(() => {
+    main = new sqlite3.Database(':memory:');
+  });
+
+  afterEach(async () => {
+    await new Promise((resolve) => main.close(resolve));
+  });
+
+  const createRouter = () => new ShardRouter({ path: '/data/t.db', count: 4, open: fakeConnection });
+
+  test('should pin users to a shard across restarts', async () => {
+    const prepare = jest.fn();
+    const router = createRouter();
+    await router.initialize(main, prepare);
+
+    expect(prepare.mock.calls.map((call) => call[1])).toEqual(['shard-0', 'shard-1', 'shard-2', 'shard-3']);
+
+    await router.assign('big@example.com', 'tenant-big');
+    expect(router.shardFor('big@example.com')).toBe('tenant-big');
+    expect(router.database('big@example.com').file).toBe('/data/t.tenant-big.db');
+    await router.close();
+
+    const restarted = createRouter();
+    await restarted.initialize(main, prepare);
+    expect(restarted.shardFor('big@example.com')).toBe('tenant-big');
+    expect(restarted.shardNames()).toContain('tenant-big');
+    expect(restarted.stats()).toMatchObject({ shards: 4, pinned: 1 });
+
+    await restarted.assign('big@example.com', hashShard('big@example.com', 4));
+    expect(restarted.shardFor('big@example.com')).toBe(hashShard('big@example.com', 4));
+    expect(restarted.stats().pinned).toBe(0);
+    await restarted.close();
+  });
+});
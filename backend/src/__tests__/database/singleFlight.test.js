@@ -0,0 +1,82 @@
+const { SingleFlight } = require('../../database/singleFlight');
+
+// A db whose queries stay pending until released
+function createDeferredDb() {
+  const pending = [];
+  const query = jest.fn((sql, params, callback) => pending.push(callback));
+  return {
+    all: query,
+    get: query,
+    release: (err, result) => pending.splice(0).forEach(callback => callback(err, result))
+  };
+}
+
+describe('SingleFlight', () => {
+  let flights;
+  let db;
+
+  beforeEach(() => {
+    flights = new SingleFlight();
+    db = createDeferredDb();
+  });
+
+  test('should run identical concurrent reads once and share the result', () => {
+    const first = jest.fn();
+    const second = jest.fn();
+
+    flights.all(db, 'a@example.com', 'SELECT 1', ['a@example.com'], first);
+    flights.all(db, 'a@example.com', 'SELECT 1', ['a@example.com'], second);
+    db.release(null, [{ id: 1 }]);
+
+    expect(db.all).toHaveBeenCalledTimes(1);
+    expect(first).toHaveBeenCalledWith(null, [{ id: 1 }]);
+    expect(second).toHaveBeenCalledWith(null, [{ id: 1 }]);
+    expect(flights.stats()).toEqual({ executed: 1, coalesced: 1, inFlight: 0 });
+  });
+
+  test('should share errors too', () => {
+    const callbacks = [jest.fn(), jest.fn()];
+    const error = new Error('SQLITE_BUSY');
+
+    callbacks.forEach(callback => flights.get(db, 'a@example.com', 'SELECT 1', [], callback));
+    db.release(error);
+
+    callbacks.forEach(callback => expect(callback).toHaveBeenCalledWith(error, undefined));
+  });
+
+  test('should not coalesce different parameters, users or methods', () => {
+    flights.all(db, 'a@example.com', 'SELECT 1', [1], jest.fn());
+    flights.all(db, 'a@example.com', 'SELECT 1', [2], jest.fn());
+    flights.all(db, 'b@example.com', 'SELECT 1', [1], jest.fn());
+    flights.get(db, 'a@example.com', 'SELECT 1', [1], jest.fn());
+
+    expect(db.all).toHaveBeenCalledTimes(4);
+    expect(flights.stats().inFlight).toBe(4);
+  });
+
+  test('should run a new query once the previous one finished', () => {
+    flights.all(db, 'a@example.com', 'SELECT 1', [], jest.fn());
+    db.release(null, []);
+    flights.all(db, 'a@example.com', 'SELECT 1', [], jest.fn());
+
+    expect(db.all).toHaveBeenCalledTimes(2);
+  });
+
+  test('should not let reads join a query started before a change', () => {
+    const stale = jest.fn();
+    const fresh = jest.fn();
+    const later = jest.fn();
+
+    flights.all(db, 'a@example.com', 'SELECT 1', [], stale);
+    flights.invalidate('a@example.com');
+    flights.all(db, 'a@example.com', 'SELECT 1', [], fresh);
+    // The first query finishing must not drop the second one's entry
+    const [, , firstCallback] = db.all.mock.calls[0];
+    firstCallback(null, ['old']);
+    flights.all(db, 'a@example.com', 'SELECT 1', [], later);
+
+    expect(db.all).toHaveBeenCalledTimes(2);
+    expect(stale).toHaveBeenCalledWith(null, ['old']);
+    expect(flights.stats()).toEqual({ executed: 2, coalesced: 1, inFlight: 1 });
+  });
+});
@@ -0,0 +1,202 @@
+const { WorkEntryCache } = require('../../database/workEntryCache');
+
+const DAY_MS = 24 * 60 * 60 * 1000;
+const NOW = Date.UTC(2024, 2, 15, 12);
+const TODAY = Date.UTC(2024, 2, 15);
+const USER = 'a@example.com';
+
+const entry = (id, daysAgo, overrides = {}) => ({
+  id,
+  client_id: 1,
+  hours: 2.5,
+  description: `Entry ${id}`,
+  date: TODAY - daysAgo * DAY_MS,
+  created_at: '2024-03-01 09:00:00',
+  updated_at: '2024-03-01 09:00:00',
+  ...overrides
+});
+
+// A db answering the cache's two load queries, held until released
+function createDb(clients, entries) {
+  const pending = [];
+  const all = jest.fn((sql, params, callback) => {
+    pending.push(() => callback(null, sql.includes('FROM clients') ? clients : entries));
+  });
+  return {
+    all,
+    release: () => new Promise((resolve) => {
+      pending.splice(0).forEach((answer) => answer());
+      setImmediate(resolve);
+    })
+  };
+}
+
+// The cached window for a read from `from`, or null
+async function read(cache, db, from) {
+  const result = new Promise((resolve) => cache.window(db, USER, from, (err, segment) => resolve(segment)));
+  await db.release();
+  return result;
+}
+
+describe('WorkEntryCache', () => {
+  const clients = [{ id: 1, name: 'Acme' }, { id: 2, name: 'Globex' }];
+  let cache;
+
+  beforeEach(() => {
+    cache = new WorkEntryCache({ budgetBytes: 1024 * 1024, windowDays: 42, now: () => NOW });
+  });
+
+  test('should do nothing unless given a budget', () => {
+    const disabled = new WorkEntryCache({ budgetBytes: 0, now: () => NOW });
+    const db = createDb(clients, []);
+    const callback = jest.fn();
+
+    disabled.window(db, USER, new Date(TODAY), callback);
+
+    expect(callback).toHaveBeenCalledWith(null, null);
+    expect(db.all).not.toHaveBeenCalled();
+  });
+
+  test('should load the window once for concurrent reads', async () => {
+    const db = createDb(clients, [entry(1, 1), entry(2, 3)]);
+    const first = jest.fn();
+    const second = jest.fn();
+
+    cache.window(db, USER, new Date(TODAY - 7 * DAY_MS), first);
+    cache.window(db, USER, new Date(TODAY - 7 * DAY_MS), second);
+    await db.release();
+
+    expect(db.all).toHaveBeenCalledTimes(2);
+    expect(db.all.mock.calls[1][1]).toEqual([USER, TODAY - 42 * DAY_MS]);
+    expect(first.mock.calls[0][1]).toBe(second.mock.calls[0][1]);
+    expect(first.mock.calls[0][1].length).toBe(2);
+    expect(cache.stats()).toMatchObject({ users: 1, hits: 2, misses: 0 });
+  });
+
+  test('should leave reads from before the window to the database', async () => {
+    const db = createDb(clients, []);
+
+    expect(await read(cache, db, new Date(TODAY - 60 * DAY_MS))).toBeNull();
+    expect(await read(cache, db, undefined)).toBeNull();
+    expect(db.all).not.toHaveBeenCalled();
+  });
+
+  test('should list entries newest first with the route\'s filters', async () => {
+    const db = createDb(clients, [
+      entry(1, 5),
+      entry(2, 1, { client_id: 2, hours: 8 }),
+      entry(3, 1, { created_at: '2024-03-02 09:00:00', description: null }),
+      entry(4, 10, { hours: 0.25 })
+    ]);
+    const segment = await read(cache, db, new Date(TODAY - 30 * DAY_MS));
+
+    expect(segment.list({}).map((row) => row.id)).toEqual([3, 2, 1, 4]);
+    expect(segment.list({})[0]).toEqual({
+      id: 3,
+      client_id: 1,
+      hours: 2.5,
+      description: null,
+      date: TODAY - DAY_MS,
+      created_at: '2024-03-02 09:00:00',
+      updated_at: '2024-03-01 09:00:00',
+      client_name: 'Acme'
+    });
+    expect(segment.list({ clientIds: [2] }).map((row) => row.id)).toEqual([2]);
+    expect(segment.list({ clientId: 1, maxHours: 2.5 }).map((row) => row.id)).toEqual([3, 1, 4]);
+    expect(segment.list({ minHours: 2.5 }).map((row) => row.id)).toEqual([3, 2, 1]);
+    expect(segment.list({ from: new Date(TODAY - 5 * DAY_MS), to: new Date(TODAY - 2 * DAY_MS) }).map((row) => row.id))
+      .toEqual([1]);
+  });
+
+  test('should page after a cursor like the keyset query', async () => {
+    const db = createDb(clients, [entry(1, 1), entry(2, 1), entry(3, 2), entry(4, 3)]);
+    const segment = await read(cache, db, new Date(TODAY - 7 * DAY_MS));
+
+    const page = segment.list({ limit: 2 });
+    const last = page[1];
+
+    expect(page.map((row) => row.id)).toEqual([2, 1, 3]);
+    expect(segment.list({ limit: 2, cursor: [last.date, last.created_at, last.id] }).map((row) => row.id))
+      .toEqual([3, 4]);
+    expect(segment.list({ cursor: ['2024-03-01', last.created_at, last.id] })).toBeNull();
+  });
+
+  test('should apply work entry and client changes', async () => {
+    const db = createDb(clients, [entry(1, 1), entry(2, 2, { client_id: 2 })]);
+    const segment = await read(cache, db, new Date(TODAY - 7 * DAY_MS));
+
+    cache.apply(USER, { entity: 'work_entry', op: 'upsert', row: { ...entry(3, 0), client_name: 'Acme' } });
+    cache.apply(USER, { entity: 'work_entry', op: 'upsert', row: { ...entry(1, 4), hours: 1.25, client_name: 'Acme' } });
+    expect(segment.list({}).map((row) => [row.id, row.hours])).toEqual([[3, 2.5], [2, 2.5], [1, 1.25]]);
+
+    // Moved out of the window
+    cache.apply(USER, { entity: 'work_entry', op: 'upsert', row: { ...entry(1, 90), client_name: 'Acme' } });
+    cache.apply(USER, { entity: 'work_entry', op: 'delete', id: 3 });
+    cache.apply(USER, { entity: 'client', op: 'upsert', row: { id: 2, name: 'Initech' } });
+    expect(segment.list({}).map((row) => [row.id, row.client_name])).toEqual([[2, 'Initech']]);
+
+    cache.apply(USER, { entity: 'client', op: 'delete', id: 2 });
+    expect(segment.list({})).toEqual([]);
+    expect(segment.clients.has(2)).toBe(false);
+
+    cache.apply(USER, { entity: 'client', op: 'clear' });
+    expect(segment.clients.size).toBe(0);
+  });
+
+  test('should discard a load that overlaps a change', async () => {
+    const db = createDb(clients, [entry(1, 1)]);
+    const callback = jest.fn();
+
+    cache.window(db, USER, new Date(TODAY), callback);
+    cache.apply(USER, { entity: 'work_entry', op: 'delete', id: 1 });
+    await db.release();
+
+    expect(callback).toHaveBeenCalledWith(null, null);
+    expect(cache.stats().users).toBe(0);
+    expect((await read(cache, db, new Date(TODAY))).length).toBe(1);
+  });
+
+  test('should reload after a resync', async () => {
+    const db = createDb(clients, [entry(1, 1)]);
+    await read(cache, db, new Date(TODAY));
+
+    cache.drop(USER);
+
+    expect(cache.stats().users).toBe(0);
+    expect(await read(cache, db, new Date(TODAY))).not.toBeNull();
+    expect(db.all).toHaveBeenCalledTimes(4);
+  });
+
+  test('should evict the least recently used user over budget', async () => {
+    const entries = Array.from({ length: 40 }, (_, index) => entry(index + 1, index % 30));
+    const small = new WorkEntryCache({ budgetBytes: 12 * 1024, now: () => NOW });
+    const db = createDb(clients, entries);
+    const readAs = async (user) => {
+      const result = new Promise((resolve) => small.window(db, user, new Date(TODAY), (err, segment) => resolve(segment)));
+      await db.release();
+      return result;
+    };
+
+    await readAs('a@example.com');
+    await readAs('b@example.com');
+    await readAs('a@example.com');
+    await readAs('c@example.com');
+
+    expect([...small.segments.keys()]).toEqual(['a@example.com', 'c@example.com']);
+    expect(small.stats().evictions).toBe(1);
+    expect(small.stats().bytes).toBeLessThanOrEqual(12 * 1024);
+  });
+
+  test('should not cache a window it cannot hold exactly', async () => {
+    const db = createDb(clients, [entry(1, 1), entry(2, 1, { date: '2024-03-14' })]);
+
+    expect(await read(cache, db, new Date(TODAY))).toBeNull();
+    expect(await read(cache, db, new Date(TODAY))).toBeNull();
+    expect(db.all).toHaveBeenCalledTimes(2);
+
+    const tooLarge = new WorkEntryCache({ budgetBytes: 1024, now: () => NOW });
+    const large = createDb(clients, Array.from({ length: 100 }, (_, index) => entry(index + 1, 1)));
+    expect(await read(tooLarge, large, new Date(TODAY))).toBeNull();
+    expect(tooLarge.stats()).toMatchObject({ users: 0, bytes: 0 });
+  });
+});
@@ -0,0 +1,141 @@
+const {
+  FlatBufferWriter,
+  encodeSchema,
+  encodeDictionary,
+  encodeRecordBatch,
+  END_OF_STREAM
+} = require('../../export/arrow');
+
+// Minimal FlatBuffers reader: the position of field `id` in the table at
+// `at`, or undefined when absent
+function field(bytes, at, id) {
+  const vtable = at - bytes.readInt32LE(at);
+  const vtableSize = bytes.readUInt16LE(vtable);
+  if (4 + 2 * id >= vtableSize) {
+    return undefined;
+  }
+  const offset = bytes.readUInt16LE(vtable + 4 + 2 * id);
+  return offset === 0 ? undefined : at + offset;
+}
+const deref = (bytes, at) => at + bytes.readUInt32LE(at);
+const readString = (bytes, at) => {
+  const start = deref(bytes, at);
+  return bytes.toString('utf8', start + 4, start + 4 + bytes.readUInt32LE(start));
+};
+
+// Split an encapsulated message into its Message table and body
+function readMessage(buffer) {
+  expect(buffer.readInt32LE(0)).toBe(-1);
+  const metadataLength = buffer.readInt32LE(4);
+  expect(metadataLength % 8).toBe(0);
+  const metadata = buffer.subarray(8, 8 + metadataLength);
+  const root = metadata.readUInt32LE(0);
+  return {
+    metadata,
+    root,
+    version: metadata.readInt16LE(field(metadata, root, 0)),
+    headerType: metadata.readUInt8(field(metadata, root, 1)),
+    header: deref(metadata, field(metadata, root, 2)),
+    bodyLength: Number(metadata.readBigInt64LE(field(metadata, root, 3))),
+    body: buffer.subarray(8 + metadataLength)
+  };
+}
+
+describe('Arrow IPC writer', () => {
+  test('should write tables whose fields read back', () => {
+    const writer = new FlatBufferWriter();
+    const bytes = writer.finish({
+      kind: 'table',
+      fields: [
+        { type: 'int16', value: 7 },
+        undefined,
+        { type: 'int64', value: 1234567890123 },
+        { type: 'offset', value: { kind: 'string', value: 'hello' } }
+      ]
+    });
+    const root = bytes.readUInt32LE(0);
+
+    expect(bytes.readInt16LE(field(bytes, root, 0))).toBe(7);
+    expect(field(bytes, root, 1)).toBeUndefined();
+    expect(field(bytes, root, 2) % 8).toBe(0);
+    expect(bytes.readBigInt64LE(field(bytes, root, 2))).toBe(1234567890123n);
+    expect(readString(bytes, field(bytes, root, 3))).toBe('hello');
+  });
+
+  test('should encode the schema with field names and nullability', () => {
+    const message = readMessage(encodeSchema([
+      { name: 'id', type: 'int64' },
+      { name: 'client', type: 'utf8', dictionary: 0 },
+      { name: 'description', type: 'utf8', nullable: true }
+    ]));
+    const { metadata, header } = message;
+
+    expect(message.version).toBe(4);
+    expect(message.headerType).toBe(1);
+    expect(message.bodyLength).toBe(0);
+    const fields = deref(metadata, field(metadata, header, 1));
+    expect(metadata.readUInt32LE(fields)).toBe(3);
+    const described = [0, 1, 2].map((index) => {
+      const at = deref(metadata, fields + 4 + 4 * index);
+      const nullable = field(metadata, at, 1);
+      return {
+        name: readString(metadata, field(metadata, at, 0)),
+        nullable: nullable !== undefined && metadata.readUInt8(nullable) === 1,
+        dictionary: field(metadata, at, 4) !== undefined
+      };
+    });
+    expect(described).toEqual([
+      { name: 'id', nullable: false, dictionary: false },
+      { name: 'client', nullable: false, dictionary: true },
+      { name: 'description', nullable: true, dictionary: false }
+    ]);
+  });
+
+  test('should lay out record batch buffers padded to 8 bytes', () => {
+    const message = readMessage(encodeRecordBatch(
+      [
+        { name: 'hours', type: 'float64' },
+        { name: 'description', type: 'utf8', nullable: true },
+        { name: 'client', type: 'utf8', dictionary: 0 }
+      ],
+      [[1.5, 8], ['Design', null], [0, 1]]
+    ));
+    const { metadata, header, body } = message;
+
+    expect(message.headerType).toBe(3);
+    expect(Number(metadata.readBigInt64LE(field(metadata, header, 0)))).toBe(2);
+    expect(body.length).toBe(message.bodyLength);
+
+    const buffers = deref(metadata, field(metadata, header, 2));
+    const layout = Array.from({ length: metadata.readUInt32LE(buffers) }, (_, index) => [
+      Number(metadata.readBigInt64LE(buffers + 4 + 16 * index)),
+      Number(metadata.readBigInt64LE(buffers + 12 + 16 * index))
+    ]);
+    // hours: no validity, values; description: validity, offsets, bytes;
+    // client: no validity, int32 indices
+    expect(layout).toEqual([[0, 0], [0, 16], [16, 1], [24, 12], [40, 6], [48, 0], [48, 8]]);
+    layout.forEach(([offset]) => expect(offset % 8).toBe(0));
+    expect(body.readDoubleLE(8)).toBe(8);
+    expect(body[16]).toBe(0b01);
+    expect(body.toString('utf8', 40, 46)).toBe('Design');
+    expect(body.readInt32LE(52)).toBe(1);
+
+    const nodes = deref(metadata, field(metadata, header, 1));
+    expect(Number(metadata.readBigInt64LE(nodes + 4 + 16 + 8))).toBe(1);
+  });
+
+  test('should mark delta dictionary batches', () => {
+    const first = readMessage(encodeDictionary(0, ['Acme']));
+    const delta = readMessage(encodeDictionary(0, ['Globex'], { delta: true }));
+
+    expect(first.headerType).toBe(2);
+    expect(first.metadata.readUInt8(field(first.metadata, first.header, 2))).toBe(0);
+    expect(delta.metadata.readUInt8(field(delta.metadata, delta.header, 2))).toBe(1);
+    expect(delta.body.toString('utf8', 8, 14)).toBe('Globex');
+  });
+
+  test('should end the stream with a zero-length continuation', () => {
+    expect(END_OF_STREAM.readInt32LE(0)).toBe(-1);
+    expect(END_OF_STREAM.readInt32LE(4)).toBe(0);
+  });
+});
@@ -0,0 +1,153 @@
+const { CsvEncoder, textTable } = require('../../export/csvEncoder');
+
+const FIELDS = [
+  { title: 'Date', type: 'date' },
+  { title: 'Hours', type: 'number' },
+  { title: 'Description', type: 'text' }
+];
+
+const encodeAll = (encoder, columns, length) => Buffer.concat([...encoder.rows(columns, length)]).toString('utf8');
+
+// Columns of `count` pseudo-random rows, covering every escaping and
+// encoding case (fixed seed, so failures reproduce)
+function randomColumns(count) {
+  let seed = 42;
+  const random = (limit) => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed % limit;
+  };
+  const pieces = ['a', 'Review', ' ', ',', '"', '\n', '\r', 'é', '日本', '😀', '\ud800', '\udc00', '\0', 'x'.repeat(17)];
+  const dates = new Float64Array(count);
+  const hours = new Float64Array(count);
+  const descriptions = [];
+  for (let i = 0; i < count; i++) {
+    dates[i] = i % 50 === 0 ? NaN : (random(40000) - 10000) * 86400000 + random(86400000);
+    hours[i] = i % 40 === 0 ? NaN : random(2401) / 100;
+    descriptions.push(i % 30 === 0 ? null : Array.from({ length: random(30) }, () => pieces[random(pieces.length)]).join(''));
+  }
+  return [dates, hours, descriptions];
+}
+
+// Dates and numbers at the edges of their formats, one per row
+function edgeColumns() {
+  const day = 86400000;
+  const numbers = [
+    0.0001, 1e-7, 1.5e-7, 0.000001, 1e20, 1e21, 1.5e21, 123456789012345680000, 1e-300, 5e-324,
+    Number.MAX_VALUE, Number.MIN_VALUE, Number.MAX_SAFE_INTEGER, 0.1 + 0.2, 1 / 3, -0, -7.5, -1e-7, -1e21,
+    2 ** 53 + 2, 1234.5678, 100, 0.5, 1e6, 4.35, 0.000123
+  ];
+  const dates = [
+    0, -1, -0.5, 0.5, day - 1, -day, Date.UTC(0, 0, 1) - 1, Date.UTC(-1, 11, 31), Date.UTC(9999, 11, 31),
+    Date.UTC(10000, 0, 1), 8.64e15, -8.64e15, 8.64e15 + 1, -8.64e15 - 1, 1e300, -271821 * 365 * day,
+    Date.UTC(-99999, 5, 15), Date.UTC(2024, 1, 29) + 0.9, Infinity, -Infinity
+  ];
+  const count = Math.max(numbers.length, dates.length);
+  const column = (values) => Float64Array.from({ length: count }, (_, i) => (i < values.length ? values[i] : NaN));
+  return [column(dates), column(numbers), new Array(count).fill('')];
+}
+
+describe('CSV Encoder', () => {
+  const encoder = new CsvEncoder(FIELDS, { implementation: CsvEncoder.javascript });
+
+  test('should write the header row', () => {
+    expect(encoder.header().toString()).toBe('Date,Hours,Description\r\n');
+  });
+
+  test('should format dates, numbers and text', () => {
+    const columns = [
+      Float64Array.of(1705276800000, 1705320000000, NaN),
+      Float64Array.of(7.5, 0.25, NaN),
+      ['Sprint planning', null, 'Café']
+    ];
+
+    expect(encodeAll(encoder, columns, 3)).toBe([
+      '2024-01-15,7.5,Sprint planning',
+      '2024-01-15,0.25,',
+      ',,Café',
+      ''
+    ].join('\r\n'));
+  });
+
+  test('should quote fields with commas, quotes and line breaks', () => {
+    const columns = [
+      new Float64Array(4),
+      new Float64Array(4),
+      ['a, b', 'say "hi"', 'two\nlines', 'cr\r']
+    ];
+
+    expect(encodeAll(encoder, columns, 4).split('\r\n').map((row) => row.slice('1970-01-01,0,'.length))).toEqual([
+      '"a, b"',
+      '"say ""hi"""',
+      '"two\nlines"',
+      '"cr\r"',
+      ''
+    ]);
+  });
+
+  test('should write numbers as String does', () => {
+    const columns = [new Float64Array(5), Float64Array.of(0.0001, 1e-7, 1e20, 1e21, -0), new Array(5).fill('')];
+
+    expect(encodeAll(encoder, columns, 5).split('\r\n').map((row) => row.split(',')[1])).toEqual([
+      '0.0001', '1e-7', '100000000000000000000', '1e+21', '0', undefined
+    ]);
+  });
+
+  test('should write years outside 0-9999 in the expanded form', () => {
+    const columns = [
+      Float64Array.of(Date.UTC(10000, 0, 1), Date.UTC(-1, 11, 31), -0.5, 8.64e15 + 1),
+      new Float64Array(4),
+      new Array(4).fill('')
+    ];
+
+    expect(encodeAll(encoder, columns, 4).split('\r\n').map((row) => row.split(',')[0])).toEqual([
+      '+010000-01-01', '-000001-12-31', '1970-01-01', '', ''
+    ]);
+  });
+
+  test('should encode in batches', () => {
+    const batched = new CsvEncoder(FIELDS, { batchSize: 2, implementation: CsvEncoder.javascript });
+    const columns = [new Float64Array(5), Float64Array.of(1, 2, 3, 4, 5), ['a', 'b', 'c', 'd', 'e']];
+
+    const chunks = [...batched.rows(columns, 5)];
+
+    expect(chunks.map((chunk) => chunk.toString().split('\r\n').length - 1)).toEqual([2, 2, 1]);
+    expect(Buffer.concat(chunks).toString()).toBe(encodeAll(encoder, columns, 5));
+  });
+
+  test('should pack text into a string table', () => {
+    expect(textTable(['ab', null, 'cde', 7], 0, 4)).toEqual({
+      text: 'abcde',
+      offsets: Uint32Array.of(0, 2, 2, 5, 5)
+    });
+    expect(textTable(['ab', 'c', 'de'], 1, 3)).toEqual({ text: 'cde', offsets: Uint32Array.of(0, 1, 3) });
+  });
+
+  const describeNative = CsvEncoder.native ? describe : describe.skip;
+
+  describeNative('native addon', () => {
+    const native = new CsvEncoder(FIELDS, { batchSize: 1000, implementation: CsvEncoder.native });
+
+    test('should produce the same bytes as the JavaScript encoder', () => {
+      const columns = randomColumns(20000);
+      columns[2][7] = `${'y'.repeat(5000)}"`;
+
+      const expected = Buffer.concat([...encoder.rows(columns, 20000)]);
+      const actual = Buffer.concat([...native.rows(columns, 20000)]);
+
+      expect(actual.equals(expected)).toBe(true);
+    });
+
+    test('should match the JavaScript encoder at the edges of each format', () => {
+      const columns = edgeColumns();
+      const rows = columns[0].length;
+
+      expect(encodeAll(native, columns, rows)).toBe(encodeAll(encoder, columns, rows));
+    });
+
+    test('should reject columns of the wrong kind', () => {
+      expect(() => CsvEncoder.native.encode([1], [[1, 2]], 2)).toThrow('Float64Array');
+      expect(() => CsvEncoder.native.encode([2], [{ text: 'ab', offsets: Uint32Array.of(0, 3) }], 1))
+        .toThrow('string tables');
+    });
+  });
+});
@@ -0,0 +1,64 @@
+const { Readable } = require('stream');
+const { CsvError, CsvParser, readCsv } = require('../../import/csv');
+
+const parseAll = (chunks) => {
+  const parser = new CsvParser();
+  return [...chunks.flatMap(chunk => parser.push(chunk)), ...parser.end()];
+};
+
+const collect = async (stream) => {
+  const records = [];
+  for await (const record of readCsv(stream)) {
+    records.push(record);
+  }
+  return records;
+};
+
+describe('CSV Parser', () => {
+  const text = '﻿date,hours,description\r\n2024-01-15,"7.5","Said ""hi"", left"\n\n2024-01-16,2,"two\nlines"\n2024-01-17,1,';
+  const expected = [
+    { line: 1, fields: ['date', 'hours', 'description'] },
+    { line: 2, fields: ['2024-01-15', '7.5', 'Said "hi", left'] },
+    { line: 4, fields: ['2024-01-16', '2', 'two\nlines'] },
+    { line: 6, fields: ['2024-01-17', '1', ''] }
+  ];
+
+  test('should parse quoted fields, CRLF and blank lines', () => {
+    expect(parseAll([text])).toEqual(expected);
+  });
+
+  test('should give the same records wherever the chunks are split', () => {
+    for (let cut = 0; cut <= text.length; cut++) {
+      expect(parseAll([text.slice(0, cut), text.slice(cut)])).toEqual(expected);
+    }
+  });
+
+  test('should only return records once their line is complete', () => {
+    const parser = new CsvParser();
+
+    expect(parser.push('a,b\nc,')).toEqual([{ line: 1, fields: ['a', 'b'] }]);
+    expect(parser.push('d')).toEqual([]);
+    expect(parser.end()).toEqual([{ line: 2, fields: ['c', 'd'] }]);
+  });
+
+  test('should reject malformed quoting with the line number', () => {
+    expect(() => parseAll(['a\n"b'])).toThrow('Unterminated quoted field on line 2');
+    expect(() => parseAll(['a\n"b"c\n'])).toThrow(CsvError);
+  });
+
+  test('should not buffer records past the length limit', () => {
+    const parser = new CsvParser({ maxRecordLength: 10 });
+
+    expect(() => parser.push('a,b\n"0123456789abc')).toThrow('Line 2 is longer than 10 characters');
+  });
+
+  test('should read records from a byte stream split inside a character', async () => {
+    const bytes = Buffer.from('client,hours\nCafé,1\n');
+    const stream = Readable.from([bytes.subarray(0, 17), bytes.subarray(17)]);
+
+    expect(await collect(stream)).toEqual([
+      { line: 1, fields: ['client', 'hours'] },
+      { line: 2, fields: ['Café', '1'] }
+    ]);
+  });
+});
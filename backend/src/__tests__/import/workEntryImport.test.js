@@ -0,0 +1,101 @@
+const { Readable } = require('stream');
+const { ImportError, importWorkEntries } = require('../../import/workEntryImport');
+
+const upload = (text) => Readable.from([Buffer.from(text)]);
+
+// Answers the client lookup and records the inserts
+function createFakeDb(clients = [{ id: 1, name: 'Acme' }, { id: 2, name: 'Globex' }]) {
+  const inserted = [];
+  return {
+    inserted,
+    all: jest.fn((sql, params, callback) => callback(null, clients)),
+    run: jest.fn(function(sql, params, callback) {
+      for (let i = 0; i < params.length; i += 5) {
+        inserted.push(params.slice(i, i + 5));
+      }
+      callback.call({ changes: params.length / 5 }, null);
+    })
+  };
+}
+
+describe('Work Entry Import', () => {
+  test('should insert valid rows, resolving client names', async () => {
+    const db = createFakeDb();
+
+    const report = await importWorkEntries(db, 'a@example.com', upload(
+      'Date,Hours,Description,Client\n' +
+      '2024-01-15,7.5,"Planning, review",acme\n' +
+      '2024-01-16,2,,Globex\n'
+    ));
+
+    expect(report).toEqual({ imported: 2, failed: 0, errors: [] });
+    expect(db.all).toHaveBeenCalledTimes(1);
+    expect(db.all.mock.calls[0][0]).toContain('deleted_at IS NULL');
+    expect(db.inserted).toEqual([
+      [1, 'a@example.com', 7.5, 'Planning, review', new Date('2024-01-15')],
+      [2, 'a@example.com', 2, null, new Date('2024-01-16')]
+    ]);
+  });
+
+  test('should insert in batches of several rows per statement', async () => {
+    const db = createFakeDb();
+    const rows = Array.from({ length: 7 }, (_, i) => `2024-02-0${i + 1},1,,1`).join('\n');
+
+    const report = await importWorkEntries(db, 'a@example.com', upload(`date,hours,description,clientId\n${rows}\n`), { batchSize: 3 });
+
+    expect(report.imported).toBe(7);
+    expect(db.run.mock.calls.map(([sql, params]) => params.length / 5)).toEqual([3, 3, 1]);
+    expect(db.run.mock.calls[0][0]).toContain('VALUES (?, ?, ?, ?, ?), (?, ?, ?, ?, ?), (?, ?, ?, ?, ?)');
+  });
+
+  test('should report invalid rows by line and import the rest', async () => {
+    const db = createFakeDb([{ id: 1, name: 'Acme' }, { id: 2, name: 'Twin' }, { id: 3, name: 'twin' }]);
+
+    const report = await importWorkEntries(db, 'a@example.com', upload(
+      'date,hours,client,clientId\n' +
+      '2024-01-15,30,Acme,\n' +
+      '2024-01-15,1,Nobody,\n' +
+      '2024-01-15,1,Twin,\n' +
+      '2024-01-15,1,,99\n' +
+      'not a date,1,Acme,\n' +
+      '2024-01-15,1,Twin,3\n'
+    ));
+
+    expect(report.imported).toBe(1);
+    expect(report.failed).toBe(5);
+    expect(report.errors.map(({ line }) => line)).toEqual([2, 3, 4, 5, 6]);
+    expect(report.errors[1].error).toBe('Unknown client "Nobody"');
+    expect(report.errors[2].error).toBe('Several clients are named "Twin"; use clientId');
+    expect(report.errors[3].error).toBe('Client not found or does not belong to user');
+    expect(db.inserted.map(([clientId]) => clientId)).toEqual([3]);
+  });
+
+  test('should reject a file without the required columns', async () => {
+    const db = createFakeDb();
+
+    await expect(importWorkEntries(db, 'a@example.com', upload('date,description\n2024-01-15,x\n')))
+      .rejects.toThrow('Missing column(s): hours, client');
+    await expect(importWorkEntries(db, 'a@example.com', upload(''))).rejects.toThrow(ImportError);
+    expect(db.run).not.toHaveBeenCalled();
+  });
+
+  test('should stop at malformed CSV, keeping what was already inserted', async () => {
+    const db = createFakeDb();
+
+    let error;
+    try {
+      await importWorkEntries(
+        db,
+        'a@example.com',
+        upload('date,hours,clientId\n2024-01-15,1,1\n2024-01-16,1,1\n"2024-01-17,1,1\n'),
+        { batchSize: 1 }
+      );
+    } catch (err) {
+      error = err;
+    }
+
+    expect(error).toBeInstanceOf(ImportError);
+    expect(error.line).toBe(4);
+    expect(error.imported).toBe(2);
+  });
+});
@@ -0,0 +1,148 @@
+const http = require('http');
+const express = require('express');
+const { ServerLifecycle } = require('../../lifecycle/serverLifecycle');
+
+// An app with a request that stays in flight until released
+function createApp(lifecycle) {
+  const app = express();
+  const gates = [];
+  app.use(lifecycle.middleware());
+  app.get('/health/live', (req, res) => lifecycle.liveness(req, res));
+  app.get('/health/ready', (req, res) => lifecycle.readiness(req, res));
+  app.get('/slow', (req, res) => gates.push(() => res.json({ done: true })));
+  return { app, release: () => gates.splice(0).forEach(open => open()), gates };
+}
+
+function listen(app, lifecycle) {
+  return new Promise((resolve) => {
+    const server = app.listen(0, () => {
+      lifecycle.ready(server);
+      resolve(server);
+    });
+  });
+}
+
+function get(port, path) {
+  return new Promise((resolve, reject) => {
+    http.get({ port, path, agent: false }, (res) => {
+      let body = '';
+      res.setEncoding('utf8');
+      res.on('data', (chunk) => {
+        body += chunk;
+      });
+      res.on('end', () => resolve({ status: res.statusCode, headers: res.headers, body: JSON.parse(body) }));
+    }).on('error', reject);
+  });
+}
+
+const waitUntil = async (condition) => {
+  while (!condition()) {
+    await new Promise((resolve) => setTimeout(resolve, 5));
+  }
+};
+
+describe('ServerLifecycle', () => {
+  beforeEach(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    console.log.mockRestore();
+    console.warn.mockRestore();
+  });
+
+  test('should report ready and live while serving', async () => {
+    const lifecycle = new ServerLifecycle();
+    const { app } = createApp(lifecycle);
+    const server = await listen(app, lifecycle);
+    const { port } = server.address();
+
+    const ready = await get(port, '/health/ready');
+    const live = await get(port, '/health/live');
+
+    expect(ready.status).toBe(200);
+    expect(ready.body).toMatchObject({ status: 'OK', state: 'ready' });
+    expect(live.status).toBe(200);
+    await lifecycle.shutdown('test');
+  });
+
+  test('should finish in-flight requests before running close hooks', async () => {
+    const lifecycle = new ServerLifecycle({ drainTimeoutMs: 5000 });
+    const { app, release, gates } = createApp(lifecycle);
+    const server = await listen(app, lifecycle);
+    const { port } = server.address();
+    const steps = [];
+    lifecycle
+      .onDrain('streams', () => steps.push('drain'))
+      .onClose('database', async () => steps.push('close database'))
+      .onClose('logs', () => steps.push('flush logs'));
+
+    const slow = get(port, '/slow');
+    await waitUntil(() => gates.length === 1);
+    const stopped = lifecycle.shutdown('SIGTERM');
+
+    expect(lifecycle.state).toBe('draining');
+    await waitUntil(() => steps.length === 1);
+    expect(lifecycle.inFlight).toBe(1);
+    release();
+
+    expect((await slow).body).toEqual({ done: true });
+    await stopped;
+    expect(steps).toEqual(['drain', 'close database', 'flush logs']);
+    expect(lifecycle.state).toBe('stopped');
+    await expect(get(port, '/health/live')).rejects.toThrow();
+  });
+
+  test('should cut requests still running at the deadline', async () => {
+    const lifecycle = new ServerLifecycle({ drainTimeoutMs: 50 });
+    const { app, gates } = createApp(lifecycle);
+    const server = await listen(app, lifecycle);
+    const closed = jest.fn();
+    lifecycle.onClose('database', closed);
+
+    const slow = get(server.address().port, '/slow').catch(error => error);
+    await waitUntil(() => gates.length === 1);
+    await lifecycle.shutdown('SIGTERM');
+
+    expect(await slow).toBeInstanceOf(Error);
+    expect(closed).toHaveBeenCalled();
+  });
+
+  test('should shut down once however many signals arrive', async () => {
+    const lifecycle = new ServerLifecycle();
+    const hook = jest.fn();
+    lifecycle.onClose('hook', hook);
+
+    await Promise.all([lifecycle.shutdown('SIGTERM'), lifecycle.shutdown('SIGINT')]);
+
+    expect(hook).toHaveBeenCalledTimes(1);
+  });
+
+  test('should keep shutting down when a hook fails', async () => {
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+    const lifecycle = new ServerLifecycle();
+    const after = jest.fn();
+    lifecycle
+      .onClose('checkpoint', () => Promise.reject(new Error('SQLITE_BUSY')))
+      .onClose('close', after);
+
+    await lifecycle.shutdown('SIGTERM');
+
+    expect(after).toHaveBeenCalled();
+    expect(console.error).toHaveBeenCalledWith('Shutdown step "checkpoint" failed:', expect.any(Error));
+    console.error.mockRestore();
+  });
+
+  test('should report not ready while draining', () => {
+    const lifecycle = new ServerLifecycle();
+    lifecycle.state = 'draining';
+    const res = { status: jest.fn().mockReturnThis(), json: jest.fn() };
+
+    lifecycle.readiness({}, res);
+    lifecycle.liveness({}, res);
+
+    expect(res.status.mock.calls).toEqual([[503], [200]]);
+    expect(res.json).toHaveBeenCalledWith({ status: 'UNAVAILABLE', state: 'draining', inFlight: 0 });
+  });
+});
@@ -1,10 +1,12 @@
-const { authenticateUser } = require('../../middleware/auth');
+const jwt = require('jsonwebtoken');
+const { authenticateUser, verifyBearerToken } = require('../../middleware/auth');
+const { issueTokens } = require('../../auth/tokens');
 const { getDatabase } = require('../../database/init');
 
 jest.mock('../../database/init');
 
 describe('Authentication Middleware', () => {
-  let req, res, next, mockDb;
+  let req, res, next;
 
   beforeEach(() => {
     req = {
@@ -15,171 +17,146 @@ describe('Authentication Middleware', () => {
       json: jest.fn()
     };
     next = jest.fn();
-    
-    mockDb = {
-      get: jest.fn(),
-      run: jest.fn()
-    };
-    
-    getDatabase.mockReturnValue(mockDb);
   });
 
   afterEach(() => {
     jest.clearAllMocks();
   });
 
-  describe('Email Header Validation', () => {
-    test('should return 401 if x-user-email header is missing', () => {
+  describe('Authorization Header Validation', () => {
+    test('should return 401 if Authorization header is missing', () => {
       authenticateUser(req, res, next);
 
       expect(res.status).toHaveBeenCalledWith(401);
       expect(res.json).toHaveBeenCalledWith({
-        error: 'User email required in x-user-email header'
+        error: 'Bearer token required in Authorization header'
       });
       expect(next).not.toHaveBeenCalled();
     });
 
-    test('should return 400 if email format is invalid', () => {
-      req.headers['x-user-email'] = 'invalid-email';
+    test('should return 401 for a non-Bearer scheme', () => {
+      req.headers.authorization = 'Basic dGVzdDp0ZXN0';
 
       authenticateUser(req, res, next);
 
-      expect(res.status).toHaveBeenCalledWith(400);
-      expect(res.json).toHaveBeenCalledWith({
-        error: 'Invalid email format'
-      });
+      expect(res.status).toHaveBeenCalledWith(401);
       expect(next).not.toHaveBeenCalled();
     });
 
-    test('should accept valid email format', () => {
-      req.headers['x-user-email'] = 'test@example.com';
-      
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { email: 'test@example.com' });
-      });
+    test('should return 401 for a malformed token', () => {
+      req.headers.authorization = 'Bearer not-a-token';
 
       authenticateUser(req, res, next);
 
-      expect(mockDb.get).toHaveBeenCalled();
+      expect(res.status).toHaveBeenCalledWith(401);
+      expect(res.json).toHaveBeenCalledWith({ error: 'Invalid token' });
     });
   });
 
-  describe('Existing User Authentication', () => {
-    test('should authenticate existing user and call next()', (done) => {
-      req.headers['x-user-email'] = 'existing@example.com';
-      
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { email: 'existing@example.com' });
-      });
+  describe('Batch Sub-requests', () => {
+    test('should not re-authenticate a request that already has a user', () => {
+      req.userEmail = 'test@example.com';
 
       authenticateUser(req, res, next);
 
-      setImmediate(() => {
-        expect(req.userEmail).toBe('existing@example.com');
-        expect(next).toHaveBeenCalled();
-        expect(res.status).not.toHaveBeenCalled();
-        done();
-      });
+      expect(next).toHaveBeenCalled();
+      expect(res.status).not.toHaveBeenCalled();
     });
+  });
 
-    test('should handle database error when checking user', (done) => {
-      req.headers['x-user-email'] = 'test@example.com';
-      
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(new Error('Database error'), null);
-      });
+  describe('Token Verification', () => {
+    test('should authenticate a valid access token without a database lookup', () => {
+      const { accessToken } = issueTokens('existing@example.com');
+      req.headers.authorization = `Bearer ${accessToken}`;
 
       authenticateUser(req, res, next);
 
-      setImmediate(() => {
-        expect(res.status).toHaveBeenCalledWith(500);
-        expect(res.json).toHaveBeenCalledWith({
-          error: 'Internal server error'
-        });
-        expect(next).not.toHaveBeenCalled();
-        done();
-      });
+      expect(req.userEmail).toBe('existing@example.com');
+      expect(next).toHaveBeenCalled();
+      expect(res.status).not.toHaveBeenCalled();
+      expect(getDatabase).not.toHaveBeenCalled();
     });
-  });
 
-  describe('New User Creation', () => {
-    test('should create new user if not exists and call next()', (done) => {
-      req.headers['x-user-email'] = 'newuser@example.com';
-      
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, null); // User doesn't exist
-      });
-      
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
+    test('should reject a refresh token used as an access token', () => {
+      const { refreshToken } = issueTokens('existing@example.com');
+      req.headers.authorization = `Bearer ${refreshToken}`;
 
       authenticateUser(req, res, next);
 
-      setImmediate(() => {
-        expect(mockDb.run).toHaveBeenCalledWith(
-          'INSERT INTO users (email) VALUES (?)',
-          ['newuser@example.com'],
-          expect.any(Function)
-        );
-        expect(req.userEmail).toBe('newuser@example.com');
-        expect(next).toHaveBeenCalled();
-        done();
-      });
+      expect(res.status).toHaveBeenCalledWith(401);
+      expect(next).not.toHaveBeenCalled();
     });
 
-    test('should handle error when creating new user', (done) => {
-      req.headers['x-user-email'] = 'newuser@example.com';
-      
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, null);
-      });
-      
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(new Error('Insert failed'));
-      });
+    test('should reject an expired token', () => {
+      const expired = jwt.sign(
+        { typ: 'access', exp: Math.floor(Date.now() / 1000) - 60 },
+        process.env.JWT_SECRET,
+        { algorithm: 'HS256', issuer: 'time-tracking-api', subject: 'test@example.com' }
+      );
+      req.headers.authorization = `Bearer ${expired}`;
 
       authenticateUser(req, res, next);
 
-      setImmediate(() => {
-        expect(res.status).toHaveBeenCalledWith(500);
-        expect(res.json).toHaveBeenCalledWith({
-          error: 'Failed to create user'
-        });
-        expect(next).not.toHaveBeenCalled();
-        done();
-      });
+      expect(res.status).toHaveBeenCalledWith(401);
+      expect(res.json).toHaveBeenCalledWith({ error: 'Token expired' });
     });
-  });
 
-  describe('Email Format Edge Cases', () => {
-    test('should reject email without @', () => {
-      req.headers['x-user-email'] = 'notanemail';
+    test('should reject a token signed with another key', () => {
+      const forged = jwt.sign({ typ: 'access' }, 'some-other-secret', {
+        algorithm: 'HS256',
+        issuer: 'time-tracking-api',
+        subject: 'test@example.com'
+      });
+      req.headers.authorization = `Bearer ${forged}`;
+
       authenticateUser(req, res, next);
-      expect(res.status).toHaveBeenCalledWith(400);
+
+      expect(res.status).toHaveBeenCalledWith(401);
+      expect(res.json).toHaveBeenCalledWith({ error: 'Invalid token' });
     });
 
-    test('should reject email without domain', () => {
-      req.headers['x-user-email'] = 'test@';
+    test('should reject unsigned tokens', () => {
+      const encode = (part) => Buffer.from(JSON.stringify(part)).toString('base64url');
+      const unsigned = `${encode({ alg: 'none', typ: 'JWT' })}.${encode({
+        typ: 'access',
+        iss: 'time-tracking-api',
+        sub: 'test@example.com',
+        exp: Math.floor(Date.now() / 1000) + 60
+      })}.`;
+      req.headers.authorization = `Bearer ${unsigned}`;
+
       authenticateUser(req, res, next);
-      expect(res.status).toHaveBeenCalledWith(400);
+
+      expect(res.status).toHaveBeenCalledWith(401);
+      expect(next).not.toHaveBeenCalled();
     });
+  });
 
-    test('should reject email without TLD', () => {
-      req.headers['x-user-email'] = 'test@domain';
+  describe('Shared Verification', () => {
+    test('should verify the token once per request', () => {
+      const { accessToken } = issueTokens('existing@example.com');
+      req.headers.authorization = `Bearer ${accessToken}`;
+      const verify = jest.spyOn(jwt, 'verify');
+
+      // As the rate limiter does before the route authenticates
+      verifyBearerToken(req);
       authenticateUser(req, res, next);
-      expect(res.status).toHaveBeenCalledWith(400);
+
+      expect(verify).toHaveBeenCalledTimes(1);
+      expect(req.userEmail).toBe('existing@example.com');
+      expect(next).toHaveBeenCalled();
+      verify.mockRestore();
     });
 
-    test('should accept email with subdomain', () => {
-      req.headers['x-user-email'] = 'test@mail.example.com';
-      
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { email: 'test@mail.example.com' });
-      });
+    test('should still reject a token the rate limiter could not verify', () => {
+      req.headers.authorization = 'Bearer not-a-token';
 
+      expect(verifyBearerToken(req).error).toBeDefined();
       authenticateUser(req, res, next);
-      expect(mockDb.get).toHaveBeenCalled();
+
+      expect(res.status).toHaveBeenCalledWith(401);
+      expect(res.json).toHaveBeenCalledWith({ error: 'Invalid token' });
+      expect(next).not.toHaveBeenCalled();
     });
   });
 });
@@ -0,0 +1,198 @@
+const request = require('supertest');
+const express = require('express');
+const {
+  MemoryBucketStore,
+  SqliteBucketStore,
+  createRateLimiter,
+  routeCost
+} = require('../../middleware/rateLimit');
+const { issueTokens } = require('../../auth/tokens');
+
+const policy = { capacity: 10, refillPerSecond: 2 };
+
+function createApp(options) {
+  const app = express();
+  app.use('/api', createRateLimiter({ capacity: 10, refillPerSecond: 2, ...options }));
+  app.get('/api/clients', (req, res) => res.json({ ok: true }));
+  app.get('/api/reports/export/csv/1', (req, res) => res.json({ ok: true }));
+  app.post('/api/batch', async (req, res) => {
+    if (await req.spendRateLimit(Number(req.query.extra))) {
+      res.json({ ok: true });
+    }
+  });
+  return app;
+}
+
+describe('Rate Limiting', () => {
+  describe('MemoryBucketStore', () => {
+    test('should spend tokens until the bucket is empty', async () => {
+      const store = new MemoryBucketStore({ slots: 16 });
+      const results = [];
+      for (let i = 0; i < 4; i++) {
+        results.push(await store.take('user:a', 3, policy, 1000));
+      }
+
+      expect(results.map(r => r.allowed)).toEqual([true, true, true, false]);
+      expect(results[3].tokens).toBe(1);
+    });
+
+    test('should refill over time up to capacity', async () => {
+      const store = new MemoryBucketStore({ slots: 16 });
+      await store.take('user:a', 10, policy, 0);
+
+      expect(await store.take('user:a', 3, policy, 1500)).toEqual({ allowed: true, tokens: 0 });
+      expect(await store.take('user:a', 1, policy, 60000)).toEqual({ allowed: true, tokens: 9 });
+    });
+
+    test('should keep separate buckets per key', async () => {
+      const store = new MemoryBucketStore();
+      await store.take('user:a', 10, policy, 0);
+
+      expect((await store.take('user:b', 1, policy, 0)).allowed).toBe(true);
+      expect((await store.take('user:a', 1, policy, 0)).allowed).toBe(false);
+    });
+
+    test('should not refill a drained bucket when other keys take its slot', async () => {
+      // One set of two slots: every key collides
+      const store = new MemoryBucketStore({ slots: 2 });
+      await store.take('user:a', 10, policy, 0);
+
+      for (let i = 0; i < 20; i++) {
+        await store.take(`user:cycled${i}`, 1, policy, 0);
+      }
+
+      expect((await store.take('user:a', 1, policy, 0)).allowed).toBe(false);
+    });
+
+    test('should start a key evicting a drained bucket from its balance', async () => {
+      const store = new MemoryBucketStore({ slots: 2 });
+      await store.take('user:a', 10, policy, 0);
+      await store.take('user:b', 9, policy, 0);
+
+      expect(await store.take('user:c', 2, policy, 0)).toEqual({ allowed: false, tokens: 1 });
+    });
+  });
+
+  describe('SqliteBucketStore', () => {
+    test('should take tokens with a single upsert', async () => {
+      const db = {
+        get: jest.fn((sql, params, callback) => callback(null, { tokens: 7, allowed: 1 })),
+        run: jest.fn()
+      };
+      const store = new SqliteBucketStore(() => db);
+
+      const result = await store.take('user:a', 3, policy, 5000);
+
+      expect(result).toEqual({ allowed: true, tokens: 7 });
+      expect(db.get.mock.calls[0][0]).toContain('ON CONFLICT (key) DO UPDATE');
+      expect(db.get.mock.calls[0][1]).toEqual(['user:a', 10, 3, 5000, 0.002]);
+    });
+
+    test('should keep a user\'s bucket in their database and IP buckets in the main one', async () => {
+      const db = {
+        get: jest.fn((sql, params, callback) => callback(null, { tokens: 7, allowed: 1 })),
+        run: jest.fn()
+      };
+      const getDb = jest.fn(() => db);
+      const store = new SqliteBucketStore(getDb);
+
+      await store.take('user:a@example.com', 1, policy, 5000);
+      await store.take('ip:127.0.0.1', 1, policy, 5000);
+
+      expect(getDb.mock.calls).toEqual([['a@example.com'], [undefined]]);
+    });
+
+    test('should prune buckets that have refilled completely', () => {
+      const db = { run: jest.fn() };
+      const store = new SqliteBucketStore(() => db);
+
+      store.prune(policy, 100000);
+
+      expect(db.run).toHaveBeenCalledWith(
+        'DELETE FROM rate_limit_buckets WHERE updated_at < ?',
+        [95000],
+        expect.any(Function)
+      );
+    });
+  });
+
+  describe('routeCost', () => {
+    test('should charge exports more than reads and writes', () => {
+      expect(routeCost({ method: 'GET', originalUrl: '/api/clients' })).toBe(1);
+      expect(routeCost({ method: 'POST', originalUrl: '/api/work-entries' })).toBe(2);
+      expect(routeCost({ method: 'GET', originalUrl: '/api/reports/client/1' })).toBe(3);
+      expect(routeCost({ method: 'GET', originalUrl: '/api/reports/export/csv/1' })).toBe(20);
+    });
+  });
+
+  describe('middleware', () => {
+    test('should set RateLimit headers', async () => {
+      const response = await request(createApp({ now: () => 0 })).get('/api/clients');
+
+      expect(response.status).toBe(200);
+      expect(response.headers['ratelimit-limit']).toBe('10');
+      expect(response.headers['ratelimit-remaining']).toBe('9');
+      expect(response.headers['ratelimit-reset']).toBe('1');
+      expect(response.headers['ratelimit-policy']).toBe('10;w=5');
+    });
+
+    test('should return 429 with Retry-After once the bucket is empty', async () => {
+      const app = createApp({ now: () => 0, costs: [{ method: 'GET', cost: 4 }] });
+      const token = issueTokens('a@example.com').accessToken;
+
+      await request(app).get('/api/clients').set('Authorization', `Bearer ${token}`);
+      await request(app).get('/api/clients').set('Authorization', `Bearer ${token}`);
+      const response = await request(app).get('/api/clients').set('Authorization', `Bearer ${token}`);
+
+      expect(response.status).toBe(429);
+      expect(response.headers['retry-after']).toBe('1');
+      expect(response.headers['ratelimit-remaining']).toBe('2');
+      expect(response.body).toEqual({ error: 'Too many requests', retryAfter: 1 });
+    });
+
+    test('should key buckets by user rather than IP', async () => {
+      const app = createApp({ now: () => 0 });
+
+      await request(app)
+        .get('/api/reports/export/csv/1')
+        .set('Authorization', `Bearer ${issueTokens('a@example.com').accessToken}`);
+      const other = await request(app)
+        .get('/api/clients')
+        .set('Authorization', `Bearer ${issueTokens('b@example.com').accessToken}`);
+
+      expect(other.status).toBe(200);
+      expect(other.headers['ratelimit-remaining']).toBe('9');
+    });
+
+    test('should let routes spend more from the same bucket', async () => {
+      const app = createApp({ now: () => 0 });
+
+      const paid = await request(app).post('/api/batch?extra=7');
+      const unpaid = await request(app).post('/api/batch?extra=1');
+
+      expect(paid.status).toBe(200);
+      expect(paid.headers['ratelimit-remaining']).toBe('1');
+      expect(unpaid.status).toBe(429);
+    });
+
+    test('should not charge extra beyond what the bucket holds', async () => {
+      const app = createApp({ now: () => 0 });
+
+      const response = await request(app).post('/api/batch?extra=9');
+
+      expect(response.status).toBe(429);
+      expect(response.headers['ratelimit-remaining']).toBe('8');
+      expect(response.headers['retry-after']).toBe('1');
+    });
+
+    test('should let requests through when the store fails', async () => {
+      jest.spyOn(console, 'error').mockImplementation(() => {});
+      const store = { take: jest.fn().mockRejectedValue(new Error('database is locked')) };
+
+      const response = await request(createApp({ store })).get('/api/clients');
+
+      expect(response.status).toBe(200);
+      console.error.mockRestore();
+    });
+  });
+});
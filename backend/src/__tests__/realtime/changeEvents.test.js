@@ -0,0 +1,111 @@
+const { EventEmitter } = require('events');
+const { SubscriberRegistry } = require('../../realtime/changeEvents');
+
+// Minimal stand-in for an http.ServerResponse; `full` makes write() report
+// a full socket buffer like a slow client would
+function createResponse() {
+  const res = new EventEmitter();
+  res.full = false;
+  res.chunks = [];
+  res.write = jest.fn((chunk) => {
+    res.chunks.push(chunk);
+    return !res.full;
+  });
+  res.end = jest.fn(() => res.emit('close'));
+  res.destroy = jest.fn(() => res.emit('close'));
+  return res;
+}
+
+const events = (res) => res.chunks.filter((chunk) => chunk.startsWith('event:'));
+
+describe('SubscriberRegistry', () => {
+  let registry;
+
+  beforeEach(() => {
+    registry = new SubscriberRegistry({ heartbeatIntervalMs: 1000, maxConnectionsPerUser: 2 });
+  });
+
+  afterEach(() => {
+    registry.closeAll();
+  });
+
+  test('should deliver events only to the user\'s connections', () => {
+    const mine = createResponse();
+    const theirs = createResponse();
+    registry.subscribe('a@example.com', mine);
+    registry.subscribe('b@example.com', theirs);
+
+    const delivered = registry.publish('a@example.com', 'change', { entity: 'client', op: 'delete', id: 1 });
+
+    expect(delivered).toBe(1);
+    expect(events(mine)).toEqual(['event: change\ndata: {"entity":"client","op":"delete","id":1}\n\n']);
+    expect(events(theirs)).toEqual([]);
+  });
+
+  test('should forget connections once they close', () => {
+    const res = createResponse();
+    registry.subscribe('a@example.com', res);
+
+    res.emit('close');
+
+    expect(registry.size).toBe(0);
+    expect(registry.byUser.size).toBe(0);
+    expect(registry.timer).toBeNull();
+    expect(registry.publish('a@example.com', 'change', {})).toBe(0);
+  });
+
+  test('should close the oldest connection past the per-user limit', () => {
+    const [first, second, third] = [createResponse(), createResponse(), createResponse()];
+    registry.subscribe('a@example.com', first);
+    registry.subscribe('a@example.com', second);
+    registry.subscribe('a@example.com', third);
+
+    expect(first.end).toHaveBeenCalled();
+    expect(registry.size).toBe(2);
+  });
+
+  test('should send heartbeats to idle connections', () => {
+    const res = createResponse();
+    registry.subscribe('a@example.com', res);
+
+    registry.heartbeat();
+
+    expect(res.chunks).toContain(': ping\n\n');
+  });
+
+  test('should drop events for a slow client and ask it to resync once drained', () => {
+    const res = createResponse();
+    registry.subscribe('a@example.com', res);
+
+    res.full = true;
+    registry.publish('a@example.com', 'change', { id: 1 });
+    registry.publish('a@example.com', 'change', { id: 2 });
+    registry.publish('a@example.com', 'change', { id: 3 });
+
+    // Only the write that filled the buffer went out
+    expect(events(res)).toHaveLength(1);
+
+    res.full = false;
+    res.emit('drain');
+    registry.publish('a@example.com', 'change', { id: 4 });
+
+    expect(events(res).slice(1)).toEqual([
+      'event: resync\ndata: {}\n\n',
+      'event: change\ndata: {"id":4}\n\n'
+    ]);
+  });
+
+  test('should disconnect a client that stays blocked', () => {
+    const res = createResponse();
+    registry.subscribe('a@example.com', res);
+    res.full = true;
+    registry.publish('a@example.com', 'change', { id: 1 });
+
+    registry.heartbeat(Date.now() + 500);
+    expect(res.destroy).not.toHaveBeenCalled();
+
+    registry.heartbeat(Date.now() + 5000);
+    expect(res.destroy).toHaveBeenCalled();
+    expect(registry.size).toBe(0);
+  });
+});
@@ -0,0 +1,113 @@
+const { aggregate, dayNumber, toColumns, totalHours, kernels } = require('../../reports/aggregate');
+
+const { javascript } = kernels;
+
+// 2024-01-15, a Monday
+const MONDAY = 19737;
+
+// `count` pseudo-random entries over two years (fixed seed, so failures
+// reproduce)
+function randomColumns(count) {
+  let seed = 7;
+  const random = (limit) => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed % limit;
+  };
+  const days = new Int32Array(count);
+  const hundredths = new Int32Array(count);
+  for (let i = 0; i < count; i++) {
+    days[i] = MONDAY - 365 + random(730);
+    hundredths[i] = random(2401);
+  }
+  return { days, hundredths };
+}
+
+const plain = (result) => JSON.parse(JSON.stringify(result, (key, value) => (ArrayBuffer.isView(value) ? Array.from(value) : value)));
+
+describe('Hour Aggregation', () => {
+  test('should convert rows to day numbers and hundredths', () => {
+    const { days, hundredths } = toColumns([
+      { date: 1705276800000, hours: 8.5 },
+      { date: '2024-01-16', hours: 0.29 },
+      { date: 1705363200000 + 86399999, hours: 2 }
+    ]);
+
+    expect(Array.from(days)).toEqual([MONDAY, MONDAY + 1, MONDAY + 1]);
+    expect(Array.from(hundredths)).toEqual([850, 29, 200]);
+    expect(dayNumber(-1)).toBe(-1);
+  });
+
+  test('should total hours exactly', () => {
+    expect(totalHours([{ hours: 0.1 }, { hours: 0.2 }], { kernel: javascript })).toBe(0.3);
+    expect(totalHours([{ hours: '5.5' }, { hours: 3 }], { kernel: javascript })).toBe(8.5);
+    expect(totalHours([], { kernel: javascript })).toBe(0);
+  });
+
+  test('should bucket hours by day, week and month', () => {
+    const columns = {
+      days: Int32Array.of(MONDAY - 1, MONDAY, MONDAY, MONDAY + 6, MONDAY + 17),
+      hundredths: Int32Array.of(100, 250, 50, 725, 10)
+    };
+
+    const result = plain(aggregate(columns, { kernel: javascript }));
+
+    expect(result).toMatchObject({ count: 5, hours: 11.35, from: MONDAY - 1, to: MONDAY + 17 });
+    expect(result.day.start).toBe(MONDAY - 1);
+    expect(result.day.counts.slice(0, 2)).toEqual([1, 2]);
+    expect(result.day.hours.slice(0, 2)).toEqual([1, 3]);
+    // Weeks start on Monday: Sunday the 14th is the week before
+    expect(result.week.start * 7 - 3).toBe(MONDAY - 7);
+    expect(result.week).toMatchObject({ counts: [1, 3, 0, 1], hours: [1, 10.25, 0, 0.1] });
+    expect(result.month).toEqual({ start: 2024 * 12, counts: [4, 1], hours: [11.25, 0.1] });
+  });
+
+  test('should only count entries in an explicit range', () => {
+    const columns = { days: Int32Array.of(MONDAY - 1, MONDAY, MONDAY + 1), hundredths: Int32Array.of(100, 200, 300) };
+
+    const result = aggregate(columns, { from: MONDAY, to: MONDAY, kernel: javascript });
+
+    expect(result.count).toBe(1);
+    expect(result.hours).toBe(2);
+    expect(Array.from(result.day.counts)).toEqual([1]);
+  });
+
+  test('should return empty totals without entries', () => {
+    expect(aggregate({ days: new Int32Array(0), hundredths: new Int32Array(0) }, { kernel: javascript }))
+      .toEqual({ count: 0, hours: 0, from: null, to: null });
+  });
+
+  test('should refuse implausibly long ranges', () => {
+    const columns = { days: Int32Array.of(0, 200000), hundredths: Int32Array.of(1, 1) };
+
+    expect(() => aggregate(columns, { kernel: javascript })).toThrow(RangeError);
+  });
+
+  const describeNative = kernels.native ? describe : describe.skip;
+
+  describeNative('native addon', () => {
+    test('should match the JavaScript kernels exactly', () => {
+      [0, 1, 3, 4, 5, 17, 20000].forEach((count) => {
+        const columns = randomColumns(count);
+        expect(plain(aggregate(columns, { kernel: kernels.native })))
+          .toEqual(plain(aggregate(columns, { kernel: javascript })));
+        expect(plain(aggregate(columns, { from: MONDAY, to: MONDAY + 30, kernel: kernels.native })))
+          .toEqual(plain(aggregate(columns, { from: MONDAY, to: MONDAY + 30, kernel: javascript })));
+        expect(kernels.native.sum(columns.hundredths)).toBe(javascript.sum(columns.hundredths));
+      });
+    });
+
+    test('should handle extreme day numbers', () => {
+      const days = Int32Array.of(-5, 2147483647, -1, -2147483648, 3);
+
+      expect(kernels.native.range(days)).toEqual([-2147483648, 2147483647]);
+      expect(kernels.native.range(new Int32Array(0))).toBeNull();
+      expect(kernels.native.sum(Int32Array.of(2147483647, 2147483647, 1, -1, 5))).toBe(4294967299);
+    });
+
+    test('should reject arguments of the wrong kind', () => {
+      expect(() => kernels.native.range([1, 2])).toThrow('Int32Array');
+      expect(() => kernels.native.histogram(new Int32Array(2), new Int32Array(1), 0, new Uint32Array(1), new Float64Array(1)))
+        .toThrow();
+    });
+  });
+});
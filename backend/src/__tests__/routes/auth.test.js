@@ -2,6 +2,7 @@ const request = require('supertest');
 const express = require('express');
 const authRoutes = require('../../routes/auth');
 const { getDatabase } = require('../../database/init');
+const { issueTokens, verifyToken } = require('../../auth/tokens');
 
 jest.mock('../../database/init');
 
@@ -51,6 +52,20 @@ describe('Auth Routes', () => {
       expect(response.body.user.email).toBe('existing@example.com');
     });
 
+    test('should issue access and refresh tokens', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, { email: 'existing@example.com', created_at: '2024-01-01T00:00:00.000Z', token_version: 2 });
+      });
+
+      const response = await request(app)
+        .post('/api/auth/login')
+        .send({ email: 'existing@example.com' });
+
+      expect(response.body.expiresIn).toBe(15 * 60);
+      expect(verifyToken(response.body.accessToken, 'access').sub).toBe('existing@example.com');
+      expect(verifyToken(response.body.refreshToken, 'refresh').ver).toBe(2);
+    });
+
     test('should create new user on first login', async () => {
       mockDb.get.mockImplementation((query, params, callback) => {
         callback(null, null); // User doesn't exist
@@ -149,18 +164,18 @@ describe('Auth Routes', () => {
 
       const response = await request(app)
         .get('/api/auth/me')
-        .set('x-user-email', 'test@example.com');
+        .set('Authorization', `Bearer ${issueTokens('test@example.com').accessToken}`);
 
       expect(response.status).toBe(200);
       expect(response.body.user.email).toBe('test@example.com');
       expect(response.body.user.createdAt).toBe('2024-01-01T00:00:00.000Z');
     });
 
-    test('should return 401 if no email header provided', async () => {
+    test('should return 401 if no token provided', async () => {
       const response = await request(app).get('/api/auth/me');
 
       expect(response.status).toBe(401);
-      expect(response.body).toEqual({ error: 'User email required in x-user-email header' });
+      expect(response.body).toEqual({ error: 'Bearer token required in Authorization header' });
     });
 
     test('should return 404 if user not found', async () => {
@@ -176,7 +191,7 @@ describe('Auth Routes', () => {
 
       const response = await request(app)
         .get('/api/auth/me')
-        .set('x-user-email', 'test@example.com');
+        .set('Authorization', `Bearer ${issueTokens('test@example.com').accessToken}`);
 
       expect(response.status).toBe(404);
       expect(response.body).toEqual({ error: 'User not found' });
@@ -193,10 +208,77 @@ describe('Auth Routes', () => {
 
       const response = await request(app)
         .get('/api/auth/me')
-        .set('x-user-email', 'test@example.com');
+        .set('Authorization', `Bearer ${issueTokens('test@example.com').accessToken}`);
 
       expect(response.status).toBe(500);
       expect(response.body).toEqual({ error: 'Internal server error' });
     });
   });
+
+  describe('POST /api/auth/refresh', () => {
+    test('should issue a new token pair for a current refresh token', async () => {
+      const { refreshToken } = issueTokens('test@example.com', 1);
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, { email: 'test@example.com', token_version: 1 });
+      });
+
+      const response = await request(app)
+        .post('/api/auth/refresh')
+        .send({ refreshToken });
+
+      expect(response.status).toBe(200);
+      expect(verifyToken(response.body.accessToken, 'access').sub).toBe('test@example.com');
+      expect(verifyToken(response.body.refreshToken, 'refresh').ver).toBe(1);
+    });
+
+    test('should reject a refresh token revoked by logout', async () => {
+      const { refreshToken } = issueTokens('test@example.com', 1);
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, { email: 'test@example.com', token_version: 2 });
+      });
+
+      const response = await request(app)
+        .post('/api/auth/refresh')
+        .send({ refreshToken });
+
+      expect(response.status).toBe(401);
+      expect(response.body).toEqual({ error: 'Invalid refresh token' });
+    });
+
+    test('should reject an access token', async () => {
+      const { accessToken } = issueTokens('test@example.com');
+
+      const response = await request(app)
+        .post('/api/auth/refresh')
+        .send({ refreshToken: accessToken });
+
+      expect(response.status).toBe(401);
+      expect(mockDb.get).not.toHaveBeenCalled();
+    });
+
+    test('should return 400 without a refresh token', async () => {
+      const response = await request(app)
+        .post('/api/auth/refresh')
+        .send({});
+
+      expect(response.status).toBe(400);
+    });
+  });
+
+  describe('POST /api/auth/logout', () => {
+    test('should revoke the user\'s refresh tokens', async () => {
+      mockDb.run.mockImplementation((query, params, callback) => callback(null));
+
+      const response = await request(app)
+        .post('/api/auth/logout')
+        .set('Authorization', `Bearer ${issueTokens('test@example.com').accessToken}`);
+
+      expect(response.status).toBe(200);
+      expect(mockDb.run).toHaveBeenCalledWith(
+        'UPDATE users SET token_version = token_version + 1 WHERE email = ?',
+        ['test@example.com'],
+        expect.any(Function)
+      );
+    });
+  });
 });
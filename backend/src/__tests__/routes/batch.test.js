@@ -0,0 +1,174 @@
+const request = require('supertest');
+const express = require('express');
+const batchRoutes = require('../../routes/batch');
+const { getDatabase } = require('../../database/init');
+
+jest.mock('../../database/init');
+jest.mock('../../realtime/changeEvents');
+jest.mock('../../middleware/auth', () => ({
+  authenticateUser: (req, res, next) => {
+    req.userEmail = 'test@example.com';
+    next();
+  }
+}));
+
+// `spendRateLimit(extra, res)` stands in for the rate limiter's helper
+function createApp(spendRateLimit) {
+  const app = express();
+  app.use(express.json());
+  if (spendRateLimit) {
+    app.use((req, res, next) => {
+      req.spendRateLimit = (extra) => spendRateLimit(extra, res);
+      next();
+    });
+  }
+  app.use('/api/batch', batchRoutes);
+  // Add error handler for Joi validation
+  app.use((err, req, res, next) => {
+    if (err.isJoi) {
+      return res.status(400).json({ error: 'Validation error' });
+    }
+    res.status(500).json({ error: 'Internal server error' });
+  });
+  return app;
+}
+
+describe('Batch Routes', () => {
+  let mockDb;
+  const app = createApp();
+
+  beforeEach(() => {
+    mockDb = {
+      all: jest.fn(),
+      get: jest.fn(),
+      run: jest.fn()
+    };
+    getDatabase.mockReturnValue(mockDb);
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    jest.clearAllMocks();
+    console.error.mockRestore();
+  });
+
+  test('should return each sub-response in request order', async () => {
+    mockDb.all.mockImplementation((query, params, callback) => callback(null, [{ id: 1, name: 'Acme' }]));
+    mockDb.get.mockImplementation((query, params, callback) => callback(null, { id: 1, name: 'Acme' }));
+
+    const response = await request(app)
+      .post('/api/batch')
+      .send({
+        requests: [
+          { id: 'list', method: 'GET', path: '/api/clients' },
+          { id: 'one', method: 'GET', path: '/api/clients/1' }
+        ]
+      });
+
+    expect(response.status).toBe(200);
+    expect(response.body).toEqual({
+      responses: [
+        { id: 'list', status: 200, body: { clients: [{ id: 1, name: 'Acme' }] } },
+        { id: 'one', status: 200, body: { client: { id: 1, name: 'Acme' } } }
+      ]
+    });
+    expect(mockDb.all.mock.calls[0][1]).toEqual(['test@example.com']);
+  });
+
+  test('should pass bodies to mutations', async () => {
+    mockDb.run.mockImplementation(function(query, params, callback) {
+      callback.call({ lastID: 5 }, null);
+    });
+    mockDb.get.mockImplementation((query, params, callback) => callback(null, { id: 5, name: 'New Client' }));
+
+    const response = await request(app)
+      .post('/api/batch')
+      .send({ requests: [{ method: 'POST', path: '/api/clients', body: { name: 'New Client' } }] });
+
+    expect(response.body.responses[0].status).toBe(201);
+    expect(mockDb.run.mock.calls[0][1]).toEqual(['New Client', null, null, null, 'test@example.com']);
+  });
+
+  test('should report errors per sub-request', async () => {
+    mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+    const response = await request(app)
+      .post('/api/batch')
+      .send({
+        requests: [
+          { method: 'GET', path: '/api/clients' },
+          { method: 'GET', path: '/api/clients/changes?since=-1' },
+          { method: 'GET', path: '/api/clients/changes', query: { since: 'abc' } },
+          { method: 'GET', path: '/api/unknown' }
+        ]
+      });
+
+    expect(response.status).toBe(200);
+    expect(response.body.responses.map(result => result.status)).toEqual([200, 400, 400, 404]);
+    expect(response.body.responses[1].body.error).toBe('Validation error');
+  });
+
+  test('should not run downloads, auth or streams in a batch', async () => {
+    const response = await request(app)
+      .post('/api/batch')
+      .send({
+        requests: [
+          { method: 'GET', path: '/api/reports/export/csv/1' },
+          { method: 'POST', path: '/api/auth/login', body: { email: 'test@example.com' } },
+          { method: 'GET', path: '/api/events' }
+        ]
+      });
+
+    expect(response.body.responses.map(result => result.status)).toEqual([404, 404, 404]);
+    expect(mockDb.get).not.toHaveBeenCalled();
+  });
+
+  test('should reject malformed batches', async () => {
+    const empty = await request(app).post('/api/batch').send({ requests: [] });
+    const badMethod = await request(app)
+      .post('/api/batch')
+      .send({ requests: [{ method: 'PATCH', path: '/api/clients' }] });
+    const tooMany = await request(app)
+      .post('/api/batch')
+      .send({ requests: Array.from({ length: 21 }, () => ({ method: 'GET', path: '/api/clients' })) });
+
+    expect(empty.status).toBe(400);
+    expect(badMethod.status).toBe(400);
+    expect(tooMany.status).toBe(400);
+  });
+
+  describe('Rate limiting', () => {
+    test('should charge the cost of the sub-requests', async () => {
+      const spendRateLimit = jest.fn(async () => true);
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+      await request(createApp(spendRateLimit))
+        .post('/api/batch')
+        .send({
+          requests: [
+            { method: 'GET', path: '/api/search?q=x' },
+            { method: 'GET', path: '/api/search?q=y' },
+            { method: 'GET', path: '/api/clients' }
+          ]
+        });
+
+      // 2 + 2 + 1, less the 2 already charged for the POST
+      expect(spendRateLimit).toHaveBeenCalledWith(3, expect.anything());
+    });
+
+    test('should not run sub-requests the bucket cannot pay for', async () => {
+      const spendRateLimit = jest.fn(async (extra, res) => {
+        res.status(429).json({ error: 'Too many requests', retryAfter: 1 });
+        return false;
+      });
+
+      const response = await request(createApp(spendRateLimit))
+        .post('/api/batch')
+        .send({ requests: [{ method: 'GET', path: '/api/search?q=x' }, { method: 'GET', path: '/api/search?q=y' }] });
+
+      expect(response.status).toBe(429);
+      expect(spendRateLimit).toHaveBeenCalledWith(2, expect.anything());
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+  });
+});
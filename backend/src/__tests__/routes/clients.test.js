@@ -2,8 +2,10 @@ const request = require('supertest');
 const express = require('express');
 const clientRoutes = require('../../routes/clients');
 const { getDatabase } = require('../../database/init');
+const { publishChange } = require('../../realtime/changeEvents');
 
 jest.mock('../../database/init');
+jest.mock('../../realtime/changeEvents');
 jest.mock('../../middleware/auth', () => ({
   authenticateUser: (req, res, next) => {
     req.userEmail = 'test@example.com';
@@ -83,6 +85,40 @@ describe('Client Routes', () => {
     });
   });
 
+  describe('GET /api/clients/changes', () => {
+    test('should return a snapshot when since is 0', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(null, { current: 7, oldest: 0 }));
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, [{ id: 1, name: 'Acme' }]));
+
+      const response = await request(app).get('/api/clients/changes');
+
+      expect(response.status).toBe(200);
+      expect(response.body).toEqual({ clients: [{ id: 1, name: 'Acme' }], deleted: [], version: 7, hasMore: false });
+    });
+
+    test('should report deleted clients as tombstones', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(null, { current: 9, oldest: 0 }));
+      mockDb.all
+        .mockImplementationOnce((query, params, callback) => {
+          callback(null, [{ entity_id: 1, seq: 8 }, { entity_id: 2, seq: 9 }]);
+        })
+        .mockImplementationOnce((query, params, callback) => callback(null, [{ id: 1, name: 'Acme' }]));
+
+      const response = await request(app).get('/api/clients/changes?since=7');
+
+      expect(mockDb.all.mock.calls[0][1]).toEqual(['test@example.com', 'client', 7, 1001]);
+      expect(response.body).toEqual({ clients: [{ id: 1, name: 'Acme' }], deleted: [2], version: 9, hasMore: false });
+    });
+
+    test('should return 410 for an unknown version', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(null, { current: 3, oldest: 0 }));
+
+      const response = await request(app).get('/api/clients/changes?since=4');
+
+      expect(response.status).toBe(410);
+    });
+  });
+
   describe('GET /api/clients/:id', () => {
     test('should return specific client', async () => {
       const mockClient = { id: 1, name: 'Client A', description: 'Desc A' };
@@ -276,6 +312,45 @@ describe('Client Routes', () => {
     });
   });
 
+  describe('DELETE /api/clients', () => {
+    test('should mark all clients deleted and return the count', async () => {
+      mockDb.run.mockImplementation(function(query, params, callback) {
+        callback.call({ changes: 3 }, null);
+      });
+
+      const response = await request(app).delete('/api/clients');
+
+      expect(response.status).toBe(200);
+      expect(response.body).toEqual({ message: 'All clients deleted successfully', deletedCount: 3 });
+      expect(mockDb.run.mock.calls[0][0]).toContain('WHERE user_email = ? AND deleted_at IS NULL');
+      expect(mockDb.run.mock.calls[0][1]).toEqual(['test@example.com']);
+    });
+
+    test('should handle database error', async () => {
+      mockDb.run.mockImplementation((query, params, callback) => {
+        callback(new Error('Update failed'));
+      });
+
+      const response = await request(app).delete('/api/clients');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Failed to delete clients' });
+    });
+  });
+
+  describe('GET /api/clients/purges', () => {
+    test('should return purge progress for the user\'s deleted clients', async () => {
+      const purges = [{ clientId: 2, name: 'Acme', deletedAt: '2024-06-01 00:00:00', totalEntries: 5000, remainingEntries: 1200 }];
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, purges));
+
+      const response = await request(app).get('/api/clients/purges');
+
+      expect(response.status).toBe(200);
+      expect(response.body).toEqual({ purges });
+      expect(mockDb.all.mock.calls[0][1]).toEqual(['test@example.com']);
+    });
+  });
+
   describe('DELETE /api/clients/:id', () => {
     test('should delete existing client', async () => {
       mockDb.get.mockImplementation((query, params, callback) => {
@@ -290,6 +365,13 @@ describe('Client Routes', () => {
 
       expect(response.status).toBe(200);
       expect(response.body).toEqual({ message: 'Client deleted successfully' });
+      // Marked deleted; the work entries are purged in the background
+      expect(mockDb.run).toHaveBeenCalledWith(
+        expect.stringContaining('SET deleted_at = CURRENT_TIMESTAMP'),
+        ['test@example.com', 1],
+        expect.any(Function)
+      );
+      expect(mockDb.run.mock.calls[0][0]).not.toContain('DELETE');
     });
 
     test('should return 404 if client not found', async () => {
@@ -454,4 +536,35 @@ describe('Client Routes', () => {
       expect(response.status).toBe(200);
     });
   });
+
+  describe('Change notifications', () => {
+    test('should publish the updated client', async () => {
+      const saved = { id: 2, name: 'Renamed', description: null, department: null, email: null };
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, query.startsWith('SELECT id FROM') ? { id: 2 } : saved);
+      });
+      mockDb.run.mockImplementation((query, params, callback) => callback(null));
+
+      await request(app)
+        .put('/api/clients/2')
+        .send({ name: 'Renamed' });
+
+      expect(publishChange).toHaveBeenCalledWith('test@example.com', { entity: 'client', op: 'upsert', row: saved });
+    });
+
+    test('should publish deletes of one or all clients', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(null, { id: 2 }));
+      mockDb.run.mockImplementation(function(query, params, callback) {
+        callback.call({ changes: 1 }, null);
+      });
+
+      await request(app).delete('/api/clients/2');
+      await request(app).delete('/api/clients');
+
+      expect(publishChange.mock.calls).toEqual([
+        ['test@example.com', { entity: 'client', op: 'delete', id: 2 }],
+        ['test@example.com', { entity: 'client', op: 'clear' }]
+      ]);
+    });
+  });
 });
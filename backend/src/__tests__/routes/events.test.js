@@ -0,0 +1,85 @@
+const http = require('http');
+const express = require('express');
+const eventRoutes = require('../../routes/events');
+const { registry, publishChange } = require('../../realtime/changeEvents');
+
+jest.mock('../../middleware/auth', () => ({
+  authenticateUser: (req, res, next) => {
+    req.userEmail = 'test@example.com';
+    next();
+  }
+}));
+
+const app = express();
+app.use('/api/events', eventRoutes);
+
+// supertest waits for the response to end, which a stream never does, so
+// read it through a real socket instead
+function openStream(port) {
+  return new Promise((resolve, reject) => {
+    const req = http.get({ port, path: '/api/events' }, (res) => {
+      res.setEncoding('utf8');
+      let received = '';
+      const waiters = [];
+      res.on('data', (chunk) => {
+        received += chunk;
+        waiters.splice(0).forEach((check) => check());
+      });
+      const waitFor = (text) => new Promise((done) => {
+        const check = () => (received.includes(text) ? done(received) : waiters.push(check));
+        check();
+      });
+      resolve({ req, res, waitFor });
+    });
+    req.on('error', reject);
+  });
+}
+
+const waitUntil = async (condition) => {
+  while (!condition()) {
+    await new Promise((resolve) => setTimeout(resolve, 10));
+  }
+};
+
+describe('Event Routes', () => {
+  let server;
+
+  beforeAll((done) => {
+    server = app.listen(0, done);
+  });
+
+  afterAll((done) => {
+    registry.closeAll();
+    server.close(done);
+  });
+
+  test('should open an event stream and push the user\'s changes', async () => {
+    const { req, res, waitFor } = await openStream(server.address().port);
+
+    expect(res.statusCode).toBe(200);
+    expect(res.headers['content-type']).toBe('text/event-stream');
+    expect(res.headers['cache-control']).toBe('no-cache, no-transform');
+    await waitFor('retry: 5000');
+
+    publishChange('test@example.com', { entity: 'work_entry', op: 'delete', id: 5 });
+    publishChange('other@example.com', { entity: 'work_entry', op: 'delete', id: 6 });
+
+    const received = await waitFor('"id":5');
+    expect(received).toContain('event: change\ndata: {"entity":"work_entry","op":"delete","id":5}\n\n');
+    expect(received).not.toContain('"id":6');
+
+    req.destroy();
+    await waitUntil(() => registry.size === 0);
+  });
+
+  test('should unsubscribe when the client disconnects', async () => {
+    const { req, waitFor } = await openStream(server.address().port);
+    await waitFor('retry:');
+    expect(registry.size).toBe(1);
+
+    req.destroy();
+
+    await waitUntil(() => registry.size === 0);
+    expect(registry.byUser.size).toBe(0);
+  });
+});
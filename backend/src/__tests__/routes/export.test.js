@@ -0,0 +1,243 @@
+const request = require('supertest');
+const express = require('express');
+const exportRoutes = require('../../routes/export');
+const { acquireDatabase, getDatabase } = require('../../database/init');
+const { END_OF_STREAM } = require('../../export/arrow');
+
+jest.mock('../../database/init');
+jest.mock('../../middleware/auth', () => ({
+  authenticateUser: (req, res, next) => {
+    req.userEmail = 'test@example.com';
+    next();
+  }
+}));
+
+const app = express();
+app.use(express.json());
+app.use('/api/export', exportRoutes);
+// Add error handler for Joi validation
+app.use((err, req, res, next) => {
+  if (err.isJoi) {
+    return res.status(400).json({ error: 'Validation error' });
+  }
+  res.status(500).json({ error: 'Internal server error' });
+});
+
+const lines = (text) => text.trim().split('\n').map(line => JSON.parse(line));
+
+// Collect a binary response body as a Buffer
+const binary = (res, callback) => {
+  const chunks = [];
+  res.on('data', chunk => chunks.push(chunk));
+  res.on('end', () => callback(null, Buffer.concat(chunks)));
+};
+
+// Header types of the IPC messages in an Arrow stream
+const messageTypes = (stream) => {
+  const types = [];
+  let at = 0;
+  while (stream.readInt32LE(at + 4) !== 0) {
+    const metadataLength = stream.readInt32LE(at + 4);
+    const metadata = stream.subarray(at + 8, at + 8 + metadataLength);
+    const root = metadata.readUInt32LE(0);
+    const vtable = root - metadata.readInt32LE(root);
+    const field = (id) => root + metadata.readUInt16LE(vtable + 4 + 2 * id);
+    types.push(metadata.readUInt8(field(1)));
+    at += 8 + metadataLength + Number(metadata.readBigInt64LE(field(3)));
+  }
+  return types;
+};
+
+describe('Export Routes', () => {
+  let mockDb;
+  let release;
+  let clients;
+  let entries;
+
+  beforeEach(() => {
+    clients = [{ id: 1, name: 'Acme' }, { id: 2, name: 'Globex' }];
+    entries = [];
+    // Serves keyset pages the way the SQL does
+    mockDb = {
+      get: jest.fn((query, params, callback) => callback(null, { current: 42, oldest: 0 })),
+      all: jest.fn((query, params, callback) => {
+        if (query.includes('FROM clients')) {
+          const [, afterId, limit] = params;
+          return callback(null, clients.filter(row => row.id > afterId).slice(0, limit));
+        }
+        const [, afterDate, afterId] = params;
+        const to = query.includes('we.date <= ?') ? params[3] : Infinity;
+        callback(null, entries
+          .filter(row => row.date > afterDate || (row.date === afterDate && row.id > afterId))
+          .filter(row => row.date <= to)
+          .slice(0, params[params.length - 1]));
+      })
+    };
+    getDatabase.mockReturnValue(mockDb);
+    release = jest.fn();
+    acquireDatabase.mockReturnValue({ db: mockDb, release });
+  });
+
+  afterEach(() => {
+    jest.clearAllMocks();
+  });
+
+  describe('GET /api/export/account.ndjson', () => {
+    test('should stream the account as one record per line', async () => {
+      entries = [{ id: 7, client_id: 1, hours: 2, date: 1705276800000 }];
+
+      const response = await request(app).get('/api/export/account.ndjson').set('Accept-Encoding', 'identity');
+
+      expect(response.status).toBe(200);
+      expect(response.headers['content-type']).toContain('application/x-ndjson');
+      expect(response.headers['content-encoding']).toBeUndefined();
+      const records = lines(response.text);
+      expect(records[0]).toMatchObject({ type: 'export', user: 'test@example.com', version: 42 });
+      expect(records.slice(1)).toEqual([
+        { type: 'client', id: 1, name: 'Acme' },
+        { type: 'client', id: 2, name: 'Globex' },
+        { type: 'work_entry', id: 7, client_id: 1, hours: 2, date: 1705276800000 },
+        { type: 'end', clients: 2, workEntries: 1 }
+      ]);
+      expect(mockDb.all.mock.calls.every(([query, params]) => params[0] === 'test@example.com')).toBe(true);
+    });
+
+    test('should hold the user\'s database until the download ends', async () => {
+      entries = Array.from({ length: 1500 }, (_, i) => ({ id: i + 1, date: 1705276800000 + i }));
+
+      const response = await request(app).get('/api/export/account.ndjson');
+
+      expect(response.status).toBe(200);
+      expect(acquireDatabase).toHaveBeenCalledWith('test@example.com');
+      expect(release).toHaveBeenCalledTimes(1);
+    });
+
+    test('should read work entries in keyset pages', async () => {
+      entries = Array.from({ length: 1500 }, (_, i) => ({ id: i + 1, date: 1705276800000 + Math.floor(i / 100) }));
+
+      const response = await request(app).get('/api/export/account.ndjson');
+
+      const records = lines(response.text);
+      expect(records.filter(record => record.type === 'work_entry')).toHaveLength(1500);
+      const pages = mockDb.all.mock.calls.filter(([query]) => query.includes('FROM work_entries'));
+      expect(pages.map(([query, params]) => params.slice(1, 3))).toEqual([
+        [-8640000000000000, 0],
+        [1705276800009, 1000]
+      ]);
+    });
+
+    test('should resume after the given record', async () => {
+      entries = [
+        { id: 3, date: 100 },
+        { id: 4, date: 100 },
+        { id: 1, date: 200 }
+      ];
+
+      const response = await request(app).get('/api/export/account.ndjson?after=work_entry:100:3');
+
+      const records = lines(response.text);
+      expect(records.slice(1).map(record => [record.type, record.id])).toEqual([
+        ['work_entry', 4],
+        ['work_entry', 1],
+        ['end', undefined]
+      ]);
+      expect(mockDb.all.mock.calls.some(([query]) => query.includes('FROM clients'))).toBe(false);
+    });
+
+    test('should gzip the stream when accepted', async () => {
+      const response = await request(app)
+        .get('/api/export/account.ndjson')
+        .set('Accept-Encoding', 'gzip');
+
+      expect(response.headers['content-encoding']).toBe('gzip');
+      expect(lines(response.text).pop()).toEqual({ type: 'end', clients: 2, workEntries: 0 });
+    });
+
+    test('should return 400 for a malformed cursor', async () => {
+      const response = await request(app).get('/api/export/account.ndjson?after=work_entry:12');
+
+      expect(response.status).toBe(400);
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+
+    test('should handle database error before streaming', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(new Error('Database error')));
+
+      const response = await request(app).get('/api/export/account.ndjson');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Internal server error' });
+    });
+  });
+
+  describe('GET /api/export/work-entries.arrow', () => {
+    const SCHEMA = 1;
+    const DICTIONARY = 2;
+    const RECORD_BATCH = 3;
+
+    test('should stream work entries as an Arrow IPC stream', async () => {
+      entries = [
+        { id: 1, client_id: 1, client_name: 'Acme', hours: 2, description: null, date: 1705276800000, created_at: '2024-01-15 09:00:00' },
+        { id: 2, client_id: 2, client_name: 'Globex', hours: 1.5, description: 'Review', date: 1705363200000, created_at: null }
+      ];
+
+      const response = await request(app)
+        .get('/api/export/work-entries.arrow')
+        .set('Accept-Encoding', 'identity')
+        .buffer(true)
+        .parse(binary);
+
+      expect(response.status).toBe(200);
+      expect(response.headers['content-type']).toBe('application/vnd.apache.arrow.stream');
+      // Schema, the empty dictionary, the clients seen, then the rows
+      expect(messageTypes(response.body)).toEqual([SCHEMA, DICTIONARY, DICTIONARY, RECORD_BATCH]);
+      expect(response.body.subarray(-8)).toEqual(END_OF_STREAM);
+      expect(response.body.includes('Globex')).toBe(true);
+    });
+
+    test('should only send names of clients not seen in an earlier batch', async () => {
+      entries = Array.from({ length: 15000 }, (_, i) => ({
+        id: i + 1,
+        client_id: i < 12000 ? 1 : 2,
+        client_name: i < 12000 ? 'Acme' : 'Globex',
+        hours: 1,
+        date: 1705276800000 + i
+      }));
+
+      const response = await request(app).get('/api/export/work-entries.arrow').buffer(true).parse(binary);
+
+      expect(messageTypes(response.body)).toEqual([
+        SCHEMA, DICTIONARY, DICTIONARY, RECORD_BATCH, DICTIONARY, RECORD_BATCH
+      ]);
+    });
+
+    test('should limit the export to the date range', async () => {
+      const response = await request(app)
+        .get('/api/export/work-entries.arrow?from=2024-01-01&to=2024-01-31')
+        .buffer(true)
+        .parse(binary);
+
+      expect(response.status).toBe(200);
+      expect(mockDb.all.mock.calls[0][1]).toEqual([
+        'test@example.com', 1704067200000, 0, 1706659200000, 10000
+      ]);
+      expect(messageTypes(response.body)).toEqual([SCHEMA, DICTIONARY]);
+    });
+
+    test('should return 400 for an invalid date range', async () => {
+      const response = await request(app).get('/api/export/work-entries.arrow?from=2024-02-01&to=2024-01-01');
+
+      expect(response.status).toBe(400);
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+
+    test('should handle database error before streaming', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(new Error('Database error')));
+
+      const response = await request(app).get('/api/export/work-entries.arrow');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Internal server error' });
+    });
+  });
+});
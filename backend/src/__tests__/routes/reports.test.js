@@ -6,11 +6,6 @@ const path = require('path');
 
 jest.mock('../../database/init');
 jest.mock('fs');
-jest.mock('csv-writer', () => ({
-  createObjectCsvWriter: jest.fn(() => ({
-    writeRecords: jest.fn().mockResolvedValue(undefined)
-  }))
-}));
 jest.mock('pdfkit', () => {
   return jest.fn().mockImplementation(() => ({
     fontSize: jest.fn().mockReturnThis(),
@@ -27,6 +22,7 @@ jest.mock('pdfkit', () => {
 });
 
 const reportRoutes = require('../../routes/reports');
+const { readFlights } = require('../../database/singleFlight');
 jest.mock('../../middleware/auth', () => ({
   authenticateUser: (req, res, next) => {
     req.userEmail = 'test@example.com';
@@ -37,6 +33,12 @@ jest.mock('../../middleware/auth', () => ({
 const app = express();
 app.use(express.json());
 app.use('/api/reports', reportRoutes);
+app.use((err, req, res, next) => {
+  if (err.isJoi) {
+    return res.status(400).json({ error: 'Validation error' });
+  }
+  res.status(500).json({ error: 'Internal server error' });
+});
 
 describe('Report Routes', () => {
   let mockDb;
@@ -165,6 +167,84 @@ describe('Report Routes', () => {
     });
   });
 
+  describe('GET /api/reports/client/:clientId with date range', () => {
+    test('should bound work entries by from and to', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, { id: 1, name: 'Test Client' });
+      });
+
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, []);
+      });
+
+      const response = await request(app).get('/api/reports/client/1?from=2024-01-01&to=2024-01-31');
+
+      expect(response.status).toBe(200);
+      expect(mockDb.all).toHaveBeenCalledWith(
+        expect.stringContaining('AND date >= ? AND date <= ?'),
+        [1, 'test@example.com', new Date('2024-01-01'), new Date('2024-01-31')],
+        expect.any(Function)
+      );
+    });
+
+    test('should order work entries like the cached window', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, { id: 1, name: 'Test Client' });
+      });
+
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, []);
+      });
+
+      await request(app).get('/api/reports/client/1');
+
+      expect(mockDb.all).toHaveBeenCalledWith(
+        expect.stringContaining('ORDER BY date DESC, created_at DESC, id DESC'),
+        expect.any(Array),
+        expect.any(Function)
+      );
+    });
+
+    test('should reject an invalid date range', async () => {
+      const response = await request(app).get('/api/reports/client/1?from=not-a-date');
+
+      expect(response.status).toBe(400);
+      expect(mockDb.get).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('GET /api/reports/client/:clientId coalescing', () => {
+    const waitUntil = async (condition) => {
+      while (!condition()) {
+        await new Promise((resolve) => setTimeout(resolve, 5));
+      }
+    };
+
+    test('should share one query between identical concurrent requests', async () => {
+      const before = readFlights.stats().coalesced;
+      let release;
+      mockDb.get.mockImplementation((query, params, callback) => {
+        release = () => callback(null, { id: 1, name: 'Test Client' });
+      });
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [{ id: 1, hours: 2, description: 'Work', date: '2024-01-01' }]);
+      });
+
+      const responses = Promise.all([
+        request(app).get('/api/reports/client/1'),
+        request(app).get('/api/reports/client/1')
+      ]);
+      await waitUntil(() => readFlights.stats().coalesced === before + 1);
+      release();
+
+      const [first, second] = await responses;
+      expect(first.status).toBe(200);
+      expect(second.body).toEqual(first.body);
+      expect(mockDb.get).toHaveBeenCalledTimes(1);
+      expect(mockDb.all).toHaveBeenCalledTimes(1);
+    });
+  });
+
   describe('GET /api/reports/export/csv/:clientId', () => {
     test('should return 400 for invalid client ID', async () => {
       const response = await request(app).get('/api/reports/export/csv/invalid');
@@ -302,10 +382,12 @@ describe('Report Routes', () => {
   });
 
   describe('CSV Export Success Path', () => {
-    test('should handle CSV write error', async () => {
+    test('should stream the report as RFC 4180 CSV', async () => {
       const mockClient = { id: 1, name: 'Test Client' };
       const mockWorkEntries = [
-        { date: '2024-01-01', hours: 5, description: 'Work 1', created_at: '2024-01-01' }
+        { date: 1704067200000, hours: 5, description: 'Work 1', created_at: '2024-01-01 09:00:00' },
+        { date: '2024-01-02', hours: 2.25, description: 'Call, then "notes"\nsent', created_at: null },
+        { date: 1704240000000, hours: 1, description: null, created_at: '2024-01-03 10:30:00' }
       ];
 
       mockDb.get.mockImplementation((query, params, callback) => {
@@ -316,90 +398,96 @@ describe('Report Routes', () => {
         callback(null, mockWorkEntries);
       });
 
-      const csvWriter = require('csv-writer');
-      csvWriter.createObjectCsvWriter.mockReturnValue({
-        writeRecords: jest.fn().mockRejectedValue(new Error('Write failed'))
-      });
-
       const response = await request(app).get('/api/reports/export/csv/1');
 
-      expect(response.status).toBe(500);
-      expect(response.body).toEqual({ error: 'Failed to generate CSV report' });
+      expect(response.status).toBe(200);
+      expect(response.headers['content-type']).toContain('text/csv');
+      expect(response.headers['content-disposition']).toMatch(/^attachment; filename="Test_Client_report_.*\.csv"$/);
+      expect(response.text).toBe([
+        'Date,Hours,Description,Created At',
+        '2024-01-01,5,Work 1,2024-01-01 09:00:00',
+        '2024-01-02,2.25,"Call, then ""notes""\nsent",',
+        '2024-01-03,1,,2024-01-03 10:30:00',
+        ''
+      ].join('\r\n'));
     });
 
-    test('should verify CSV export calls correct database queries', async () => {
-      const mockClient = { id: 1, name: 'Test Client' };
-
+    test('should send only the header for a client without entries', async () => {
       mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, mockClient);
+        callback(null, { id: 1, name: 'Test Client' });
       });
 
       mockDb.all.mockImplementation((query, params, callback) => {
         callback(null, []);
       });
 
-      const csvWriter = require('csv-writer');
-      csvWriter.createObjectCsvWriter.mockReturnValue({
-        writeRecords: jest.fn().mockRejectedValue(new Error('Write failed'))
-      });
-
-      await request(app).get('/api/reports/export/csv/1');
+      const response = await request(app).get('/api/reports/export/csv/1');
 
-      expect(mockDb.get).toHaveBeenCalledWith(
-        expect.stringContaining('SELECT id, name FROM clients'),
-        expect.arrayContaining([1, 'test@example.com']),
-        expect.any(Function)
-      );
+      expect(response.status).toBe(200);
+      expect(response.text).toBe('Date,Hours,Description,Created At\r\n');
     });
 
-    test('should create temp directory if it does not exist', async () => {
-      const mockClient = { id: 1, name: 'Test Client' };
-      const mockWorkEntries = [
-        { date: '2024-01-01', hours: 5, description: 'Work 1', created_at: '2024-01-01' }
-      ];
-
+    test('should handle CSV encoding error', async () => {
       mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, mockClient);
+        callback(null, { id: 1, name: 'Test Client' });
       });
 
       mockDb.all.mockImplementation((query, params, callback) => {
-        callback(null, mockWorkEntries);
+        callback(null, [{ date: '2024-01-01', hours: 5, description: 'Work 1', created_at: '2024-01-01' }]);
       });
 
-      fs.existsSync.mockReturnValue(false);
-
-      const csvWriter = require('csv-writer');
-      csvWriter.createObjectCsvWriter.mockReturnValue({
-        writeRecords: jest.fn().mockRejectedValue(new Error('Write failed'))
+      const { CsvEncoder } = require('../../export/csvEncoder');
+      const rows = jest.spyOn(CsvEncoder.prototype, 'rows').mockImplementation(function* () {
+        throw new Error('Encoding failed');
       });
+      jest.spyOn(console, 'error').mockImplementation(() => {});
 
-      await request(app).get('/api/reports/export/csv/1');
+      const response = await request(app).get('/api/reports/export/csv/1');
 
-      expect(fs.mkdirSync).toHaveBeenCalledWith(expect.any(String), { recursive: true });
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Failed to generate CSV report' });
+      rows.mockRestore();
+      console.error.mockRestore();
     });
 
-    test('should not create temp directory if it exists', async () => {
+    test('should verify CSV export calls correct database queries', async () => {
       const mockClient = { id: 1, name: 'Test Client' };
-      const mockWorkEntries = [];
 
       mockDb.get.mockImplementation((query, params, callback) => {
         callback(null, mockClient);
       });
 
       mockDb.all.mockImplementation((query, params, callback) => {
-        callback(null, mockWorkEntries);
+        callback(null, []);
       });
 
-      fs.existsSync.mockReturnValue(true);
+      await request(app).get('/api/reports/export/csv/1');
+
+      expect(mockDb.get).toHaveBeenCalledWith(
+        expect.stringContaining('SELECT id, name FROM clients'),
+        expect.arrayContaining([1, 'test@example.com']),
+        expect.any(Function)
+      );
+      expect(mockDb.all).toHaveBeenCalledWith(
+        expect.stringContaining('SELECT hours, description, date, created_at'),
+        [1, 'test@example.com'],
+        expect.any(Function)
+      );
+    });
+
+    test('should not write a temporary file', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => {
+        callback(null, { id: 1, name: 'Test Client' });
+      });
 
-      const csvWriter = require('csv-writer');
-      csvWriter.createObjectCsvWriter.mockReturnValue({
-        writeRecords: jest.fn().mockRejectedValue(new Error('Write failed'))
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [{ date: '2024-01-01', hours: 5, description: 'Work 1', created_at: '2024-01-01' }]);
       });
 
       await request(app).get('/api/reports/export/csv/1');
 
       expect(fs.mkdirSync).not.toHaveBeenCalled();
+      expect(fs.unlink).not.toHaveBeenCalled();
     });
   });
 
@@ -438,4 +526,112 @@ describe('Report Routes', () => {
       );
     });
   });
+
+  describe('GET /api/reports/summary', () => {
+    test('should total hours per client in one query', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [
+          { clientId: 2, name: 'Globex', period: null, hours: 4, entryCount: 2 },
+          { clientId: 1, name: 'Acme', period: null, hours: 6.5, entryCount: 3 }
+        ]);
+      });
+
+      const response = await request(app).get('/api/reports/summary');
+
+      expect(response.status).toBe(200);
+      expect(response.body).toEqual({
+        groupBy: 'client',
+        periods: [],
+        clients: [
+          { clientId: 1, name: 'Acme', totalHours: 6.5, entryCount: 3 },
+          { clientId: 2, name: 'Globex', totalHours: 4, entryCount: 2 }
+        ],
+        totalHours: 10.5,
+        entryCount: 5
+      });
+      expect(mockDb.all).toHaveBeenCalledTimes(1);
+      const [query, params] = mockDb.all.mock.calls[0];
+      expect(query).toContain('GROUP BY we.client_id');
+      expect(query).toContain('c.deleted_at IS NULL');
+      expect(params).toEqual(['test@example.com']);
+    });
+
+    test('should sum hours per client in hundredths', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+      await request(app).get('/api/reports/summary');
+
+      expect(mockDb.all.mock.calls[0][0]).toContain('SUM(CAST(ROUND(we.hours * 100) AS INTEGER)) / 100.0');
+    });
+
+    test('should build an hours matrix by month in one grouped query', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [
+          { clientId: 1, name: 'Acme', period: '2024-01', hours: 5, entryCount: 2 },
+          { clientId: 1, name: 'Acme', period: '2024-02', hours: 3, entryCount: 1 },
+          { clientId: 2, name: 'Globex', period: '2024-02', hours: 2, entryCount: 1 }
+        ]);
+      });
+
+      const response = await request(app).get('/api/reports/summary?groupBy=month&from=2024-01-01&to=2024-02-29');
+
+      expect(response.status).toBe(200);
+      expect(response.body.periods).toEqual(['2024-01', '2024-02']);
+      expect(response.body.clients).toEqual([
+        { clientId: 1, name: 'Acme', totalHours: 8, entryCount: 3, hours: [5, 3] },
+        { clientId: 2, name: 'Globex', totalHours: 2, entryCount: 1, hours: [0, 2] }
+      ]);
+      expect(response.body.periodTotals).toEqual([5, 5]);
+      expect(response.body.totalHours).toBe(10);
+      expect(response.body.from).toBe('2024-01-01T00:00:00.000Z');
+
+      expect(mockDb.all).toHaveBeenCalledTimes(1);
+      const [query, params] = mockDb.all.mock.calls[0];
+      expect(query).toContain("strftime('%Y-%m', we.date / 1000, 'unixepoch') AS period");
+      expect(query).toContain('GROUP BY we.client_id, period');
+      expect(query).not.toContain('we.date, we.hours');
+      expect(params).toEqual(['test@example.com', new Date('2024-01-01'), new Date('2024-02-29')]);
+    });
+
+    test('should bucket weeks by their Monday', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+      await request(app).get('/api/reports/summary?groupBy=week');
+
+      expect(mockDb.all.mock.calls[0][0]).toContain("date(we.date / 1000, 'unixepoch', 'weekday 0', '-6 days') AS period");
+    });
+
+    test('should total hours exactly', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [
+          { clientId: 1, name: 'Acme', period: '2024-01-01', hours: 0.1, entryCount: 1 },
+          { clientId: 1, name: 'Acme', period: '2024-01-02', hours: 0.2, entryCount: 1 }
+        ]);
+      });
+
+      const response = await request(app).get('/api/reports/summary?groupBy=day');
+
+      expect(response.body.periodTotals).toEqual([0.1, 0.2]);
+      expect(response.body.totalHours).toBe(0.3);
+      expect(response.body.clients[0].totalHours).toBe(0.3);
+    });
+
+    test('should return 400 for an unknown grouping', async () => {
+      const response = await request(app).get('/api/reports/summary?groupBy=year');
+
+      expect(response.status).toBe(400);
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+
+    test('should handle database error', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(new Error('Database error'), null);
+      });
+
+      const response = await request(app).get('/api/reports/summary?groupBy=day');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Internal server error' });
+    });
+  });
 });
@@ -0,0 +1,145 @@
+const request = require('supertest');
+const express = require('express');
+const searchRoutes = require('../../routes/search');
+const { getDatabase } = require('../../database/init');
+
+jest.mock('../../database/init');
+jest.mock('../../middleware/auth', () => ({
+  authenticateUser: (req, res, next) => {
+    req.userEmail = 'test@example.com';
+    next();
+  }
+}));
+
+const app = express();
+app.use(express.json());
+app.use('/api/search', searchRoutes);
+app.use((err, req, res, next) => {
+  if (err.isJoi) {
+    return res.status(400).json({ error: 'Validation error' });
+  }
+  res.status(500).json({ error: 'Internal server error' });
+});
+
+const OWNER = 'u' + Buffer.from('test@example.com').toString('hex');
+
+describe('Search Routes', () => {
+  let mockDb;
+
+  beforeEach(() => {
+    mockDb = {
+      all: jest.fn()
+    };
+    getDatabase.mockReturnValue(mockDb);
+  });
+
+  afterEach(() => {
+    jest.clearAllMocks();
+  });
+
+  describe('GET /api/search', () => {
+    test('should search work entries scoped to the user', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [
+          { id: 1, client_id: 2, hours: 3, date: 1709251200000, description: 'Database migration', client_name: 'Acme', snippet: 'Database \u0002migration\u0003' }
+        ]);
+      });
+
+      const response = await request(app).get('/api/search?q=migration');
+
+      expect(response.status).toBe(200);
+      const [query, params] = mockDb.all.mock.calls[0];
+      expect(query).toContain('FROM work_entries_fts');
+      expect(query).toContain('we.user_email = ?');
+      expect(params).toEqual([
+        `owner:"${OWNER}" AND description:("migration"*)`,
+        'test@example.com',
+        21,
+        0
+      ]);
+      expect(response.body).toEqual({
+        results: [
+          {
+            id: 1,
+            client_id: 2,
+            hours: 3,
+            date: 1709251200000,
+            description: 'Database migration',
+            client_name: 'Acme',
+            snippet: [
+              { text: 'Database ', match: false },
+              { text: 'migration', match: true }
+            ]
+          }
+        ],
+        type: 'entries',
+        limit: 20,
+        offset: 0,
+        hasMore: false
+      });
+    });
+
+    test('should neutralise FTS5 syntax in the query', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+      await request(app).get('/api/search').query({ q: 'foo" OR owner:* NEAR(bar' });
+
+      expect(mockDb.all.mock.calls[0][1][0]).toBe(
+        `owner:"${OWNER}" AND description:("foo"* "OR"* "owner"* "NEAR"* "bar"*)`
+      );
+    });
+
+    test('should apply date range and pagination', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [{ id: 1 }, { id: 2 }, { id: 3 }]);
+      });
+
+      const response = await request(app).get('/api/search?q=work&from=2024-03-01&to=2024-03-31&limit=2&offset=4');
+
+      const [query, params] = mockDb.all.mock.calls[0];
+      expect(query).toContain('AND we.date >= ?');
+      expect(query).toContain('AND we.date <= ?');
+      expect(params.slice(2)).toEqual([new Date('2024-03-01'), new Date('2024-03-31'), 3, 4]);
+      expect(response.body.results).toHaveLength(2);
+      expect(response.body.hasMore).toBe(true);
+    });
+
+    test('should search clients by name and description', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(null, [{ id: 5, name: 'Acme', name_highlight: '\u0002Acme\u0003', snippet: '' }]);
+      });
+
+      const response = await request(app).get('/api/search?q=acme&type=clients');
+
+      const [query, params] = mockDb.all.mock.calls[0];
+      expect(query).toContain('FROM clients_fts');
+      expect(params[0]).toBe(`owner:"${OWNER}" AND {name description}:("acme"*)`);
+      expect(response.body.results[0].name_highlight).toEqual([{ text: 'Acme', match: true }]);
+    });
+
+    test('should require a query', async () => {
+      const response = await request(app).get('/api/search');
+
+      expect(response.status).toBe(400);
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+
+    test('should reject a query without searchable words', async () => {
+      const response = await request(app).get('/api/search').query({ q: '***' });
+
+      expect(response.status).toBe(400);
+      expect(response.body).toEqual({ error: 'Search query must contain letters or numbers' });
+    });
+
+    test('should handle database error', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => {
+        callback(new Error('Database error'), null);
+      });
+
+      const response = await request(app).get('/api/search?q=test');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Internal server error' });
+    });
+  });
+});
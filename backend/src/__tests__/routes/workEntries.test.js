@@ -1,9 +1,13 @@
 const request = require('supertest');
 const express = require('express');
 const workEntryRoutes = require('../../routes/workEntries');
-const { getDatabase } = require('../../database/init');
+const { acquireDatabase, getDatabase } = require('../../database/init');
+const { getStorage } = require('../../storage');
+const { publishChange, publishResync } = require('../../realtime/changeEvents');
 
 jest.mock('../../database/init');
+jest.mock('../../storage');
+jest.mock('../../realtime/changeEvents');
 jest.mock('../../middleware/auth', () => ({
   authenticateUser: (req, res, next) => {
     req.userEmail = 'test@example.com';
@@ -24,14 +28,27 @@ app.use((err, req, res, next) => {
 
 describe('Work Entry Routes', () => {
   let mockDb;
+  let mockStorage;
 
   beforeEach(() => {
+    // The change feed and import still query the database directly
     mockDb = {
       all: jest.fn(),
       get: jest.fn(),
       run: jest.fn()
     };
     getDatabase.mockReturnValue(mockDb);
+    acquireDatabase.mockReturnValue({ db: mockDb, release: jest.fn() });
+
+    mockStorage = {
+      getClient: jest.fn().mockResolvedValue(undefined),
+      getWorkEntry: jest.fn().mockResolvedValue(undefined),
+      listWorkEntries: jest.fn().mockResolvedValue([]),
+      insertWorkEntry: jest.fn(),
+      updateWorkEntry: jest.fn(),
+      deleteWorkEntry: jest.fn().mockResolvedValue(false)
+    };
+    getStorage.mockReturnValue(mockStorage);
   });
 
   afterEach(() => {
@@ -44,29 +61,21 @@ describe('Work Entry Routes', () => {
         { id: 1, client_id: 1, hours: 5, description: 'Work 1', date: '2024-01-01', client_name: 'Client A' },
         { id: 2, client_id: 2, hours: 3, description: 'Work 2', date: '2024-01-02', client_name: 'Client B' }
       ];
-
-      mockDb.all.mockImplementation((query, params, callback) => {
-        callback(null, mockEntries);
-      });
+      mockStorage.listWorkEntries.mockResolvedValue(mockEntries);
 
       const response = await request(app).get('/api/work-entries');
 
       expect(response.status).toBe(200);
       expect(response.body).toEqual({ workEntries: mockEntries });
+      expect(getStorage).toHaveBeenCalledWith('test@example.com');
     });
 
     test('should filter by client ID when provided', async () => {
-      mockDb.all.mockImplementation((query, params, callback) => {
-        expect(params).toEqual(['test@example.com', 1]);
-        callback(null, []);
-      });
-
       await request(app).get('/api/work-entries?clientId=1');
 
-      expect(mockDb.all).toHaveBeenCalledWith(
-        expect.stringContaining('AND we.client_id = ?'),
-        ['test@example.com', 1],
-        expect.any(Function)
+      expect(mockStorage.listWorkEntries).toHaveBeenCalledWith(
+        'test@example.com',
+        expect.objectContaining({ clientId: 1 })
       );
     });
 
@@ -77,10 +86,75 @@ describe('Work Entry Routes', () => {
       expect(response.body).toEqual({ error: 'Invalid client ID' });
     });
 
-    test('should handle database error', async () => {
-      mockDb.all.mockImplementation((query, params, callback) => {
-        callback(new Error('Database error'), null);
+    test('should pass date range, client and hours filters to storage', async () => {
+      const response = await request(app).get(
+        '/api/work-entries?from=2024-01-01&to=2024-01-31&clientIds[]=1&clientIds[]=2&minHours=1&maxHours=8'
+      );
+
+      expect(response.status).toBe(200);
+      expect(mockStorage.listWorkEntries).toHaveBeenCalledWith('test@example.com', expect.objectContaining({
+        clientIds: [1, 2],
+        from: new Date('2024-01-01'),
+        to: new Date('2024-01-31'),
+        minHours: 1,
+        maxHours: 8
+      }));
+    });
+
+    test('should accept a single clientIds value', async () => {
+      await request(app).get('/api/work-entries?clientIds=3');
+
+      expect(mockStorage.listWorkEntries.mock.calls[0][1].clientIds).toEqual([3]);
+    });
+
+    test('should reject a date range that ends before it starts', async () => {
+      const response = await request(app).get('/api/work-entries?from=2024-02-01&to=2024-01-01');
+
+      expect(response.status).toBe(400);
+      expect(mockStorage.listWorkEntries).not.toHaveBeenCalled();
+    });
+
+    test('should reject unknown filter parameters', async () => {
+      const response = await request(app).get('/api/work-entries?sort=hours');
+
+      expect(response.status).toBe(400);
+    });
+
+    test('should page results with a keyset cursor when limit is given', async () => {
+      const rows = [
+        { id: 3, date: 1704153600000, created_at: '2024-01-02 10:00:00' },
+        { id: 2, date: 1704067200000, created_at: '2024-01-01 10:00:00' },
+        { id: 1, date: 1704067200000, created_at: '2024-01-01 09:00:00' }
+      ];
+      mockStorage.listWorkEntries.mockResolvedValueOnce(rows);
+
+      const response = await request(app).get('/api/work-entries?limit=2');
+
+      // One extra row tells whether another page exists
+      expect(mockStorage.listWorkEntries.mock.calls[0][1]).toMatchObject({ limit: 3 });
+      expect(response.body.workEntries).toEqual(rows.slice(0, 2));
+      expect(response.body.nextCursor).toEqual(expect.any(String));
+
+      mockStorage.listWorkEntries.mockResolvedValueOnce([rows[2]]);
+
+      const next = await request(app).get(`/api/work-entries?limit=2&cursor=${response.body.nextCursor}`);
+
+      expect(mockStorage.listWorkEntries.mock.calls[1][1]).toMatchObject({
+        cursor: [1704067200000, '2024-01-01 10:00:00', 2],
+        limit: 3
       });
+      expect(next.body).toEqual({ workEntries: [rows[2]], nextCursor: null });
+    });
+
+    test('should reject a malformed cursor', async () => {
+      const response = await request(app).get('/api/work-entries?limit=2&cursor=not-a-cursor');
+
+      expect(response.status).toBe(400);
+      expect(response.body).toEqual({ error: 'Invalid cursor' });
+    });
+
+    test('should handle database error', async () => {
+      mockStorage.listWorkEntries.mockRejectedValue(new Error('Database error'));
 
       const response = await request(app).get('/api/work-entries');
 
@@ -88,26 +162,125 @@ describe('Work Entry Routes', () => {
       expect(response.body).toEqual({ error: 'Internal server error' });
     });
   });
+  describe('GET /api/work-entries/changes', () => {
+    const mockBounds = (current, oldest = 0) => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(null, { current, oldest }));
+    };
+
+    test('should return a full snapshot with the current version when since is 0', async () => {
+      const rows = [{ id: 2, client_id: 1, hours: 4, client_name: 'Client 1' }];
+      mockBounds(42);
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, rows));
+
+      const response = await request(app).get('/api/work-entries/changes');
+
+      expect(response.status).toBe(200);
+      expect(response.body).toEqual({ workEntries: rows, deleted: [], version: 42, hasMore: false });
+      expect(mockDb.all.mock.calls[0][0]).not.toContain('change_log');
+      expect(mockDb.all.mock.calls[0][1]).toEqual(['test@example.com']);
+    });
+
+    test('should return upserts and tombstones since a version', async () => {
+      mockBounds(12);
+      mockDb.all
+        .mockImplementationOnce((query, params, callback) => {
+          callback(null, [{ entity_id: 1, seq: 11 }, { entity_id: 4, seq: 12 }]);
+        })
+        .mockImplementationOnce((query, params, callback) => {
+          callback(null, [{ id: 1, client_id: 1, hours: 3, client_name: 'Client 1' }]);
+        });
+
+      const response = await request(app).get('/api/work-entries/changes?since=10');
+
+      expect(response.status).toBe(200);
+      const [changesQuery, changesParams] = mockDb.all.mock.calls[0];
+      expect(changesQuery).toContain('FROM change_log');
+      expect(changesQuery).toContain("cl.entity = 'client_entries'");
+      expect(changesParams).toEqual(['test@example.com', 'work_entry', 10, 'test@example.com', 10, 1001]);
+      expect(mockDb.all.mock.calls[1][1]).toEqual(['test@example.com', '[1,4]']);
+      expect(response.body).toEqual({
+        workEntries: [{ id: 1, client_id: 1, hours: 3, client_name: 'Client 1' }],
+        deleted: [4],
+        version: 12,
+        hasMore: false
+      });
+    });
+
+    test('should page large deltas', async () => {
+      mockBounds(50);
+      mockDb.all
+        .mockImplementationOnce((query, params, callback) => {
+          callback(null, [{ entity_id: 1, seq: 21 }, { entity_id: 2, seq: 22 }, { entity_id: 3, seq: 23 }]);
+        })
+        .mockImplementationOnce((query, params, callback) => callback(null, [{ id: 1 }, { id: 2 }]));
+
+      const response = await request(app).get('/api/work-entries/changes?since=20&limit=2');
+
+      expect(mockDb.all.mock.calls[1][1][1]).toBe('[1,2]');
+      expect(response.body.workEntries).toEqual([{ id: 1 }, { id: 2 }]);
+      expect(response.body.version).toBe(22);
+      expect(response.body.hasMore).toBe(true);
+    });
+
+    test('should not query rows when nothing changed', async () => {
+      mockBounds(12);
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+      const response = await request(app).get('/api/work-entries/changes?since=12');
+
+      expect(response.body).toEqual({ workEntries: [], deleted: [], version: 12, hasMore: false });
+      expect(mockDb.all).toHaveBeenCalledTimes(1);
+    });
+
+    test('should return 410 for a version newer than the server knows', async () => {
+      mockBounds(0);
+
+      const response = await request(app).get('/api/work-entries/changes?since=5');
+
+      expect(response.status).toBe(410);
+      expect(response.body).toEqual({ error: 'Sync version is no longer available', version: 0 });
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+
+    test('should return 410 for a version that was compacted away', async () => {
+      mockBounds(100, 40);
+
+      const response = await request(app).get('/api/work-entries/changes?since=30');
+
+      expect(response.status).toBe(410);
+      expect(response.body.version).toBe(100);
+    });
+
+    test('should reject an invalid version', async () => {
+      const response = await request(app).get('/api/work-entries/changes?since=-1');
+
+      expect(response.status).toBe(400);
+      expect(mockDb.get).not.toHaveBeenCalled();
+    });
+
+    test('should handle database error', async () => {
+      mockDb.get.mockImplementation((query, params, callback) => callback(new Error('Database error')));
+
+      const response = await request(app).get('/api/work-entries/changes?since=1');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Internal server error' });
+    });
+  });
 
   describe('GET /api/work-entries/:id', () => {
     test('should return specific work entry', async () => {
       const mockEntry = { id: 1, client_id: 1, hours: 5, description: 'Work', client_name: 'Client A' };
-
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, mockEntry);
-      });
+      mockStorage.getWorkEntry.mockResolvedValue(mockEntry);
 
       const response = await request(app).get('/api/work-entries/1');
 
       expect(response.status).toBe(200);
       expect(response.body).toEqual({ workEntry: mockEntry });
+      expect(mockStorage.getWorkEntry).toHaveBeenCalledWith('test@example.com', 1);
     });
 
     test('should return 404 if work entry not found', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, null);
-      });
-
       const response = await request(app).get('/api/work-entries/999');
 
       expect(response.status).toBe(404);
@@ -130,19 +303,8 @@ describe('Work Entry Routes', () => {
         description: 'Development work',
         date: '2024-01-15'
       };
-
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('clients')) {
-          callback(null, { id: 1 }); // Client exists
-        } else {
-          callback(null, { id: 1, ...newEntry, client_name: 'Client A' });
-        }
-      });
-
-      mockDb.run.mockImplementation(function(query, params, callback) {
-        this.lastID = 1;
-        callback.call(this, null);
-      });
+      mockStorage.getClient.mockResolvedValue({ id: 1 });
+      mockStorage.insertWorkEntry.mockResolvedValue({ id: 1, ...newEntry, client_name: 'Client A' });
 
       const response = await request(app)
         .post('/api/work-entries')
@@ -150,13 +312,27 @@ describe('Work Entry Routes', () => {
 
       expect(response.status).toBe(201);
       expect(response.body.message).toBe('Work entry created successfully');
+      expect(mockStorage.getClient).toHaveBeenCalledWith('test@example.com', 1);
+      expect(mockStorage.insertWorkEntry).toHaveBeenCalledWith('test@example.com', {
+        clientId: 1,
+        hours: 5.5,
+        description: 'Development work',
+        date: new Date('2024-01-15')
+      });
     });
 
-    test('should return 400 if client not found', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, null); // Client doesn't exist
-      });
+    test('should store an empty description as null', async () => {
+      mockStorage.getClient.mockResolvedValue({ id: 1 });
+      mockStorage.insertWorkEntry.mockResolvedValue({ id: 1 });
 
+      await request(app)
+        .post('/api/work-entries')
+        .send({ clientId: 1, hours: 2, description: '', date: '2024-01-15' });
+
+      expect(mockStorage.insertWorkEntry.mock.calls[0][1].description).toBeNull();
+    });
+
+    test('should return 400 if client not found', async () => {
       const response = await request(app)
         .post('/api/work-entries')
         .send({
@@ -167,6 +343,7 @@ describe('Work Entry Routes', () => {
 
       expect(response.status).toBe(400);
       expect(response.body).toEqual({ error: 'Client not found or does not belong to user' });
+      expect(mockStorage.insertWorkEntry).not.toHaveBeenCalled();
     });
 
     test('should return 400 for missing required fields', async () => {
@@ -202,13 +379,8 @@ describe('Work Entry Routes', () => {
     });
 
     test('should handle database error on insert', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { id: 1 });
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(new Error('Insert failed'));
-      });
+      mockStorage.getClient.mockResolvedValue({ id: 1 });
+      mockStorage.insertWorkEntry.mockRejectedValue(new Error('Insert failed'));
 
       const response = await request(app)
         .post('/api/work-entries')
@@ -222,49 +394,98 @@ describe('Work Entry Routes', () => {
       expect(response.body).toEqual({ error: 'Failed to create work entry' });
     });
   });
-
-  describe('PUT /api/work-entries/:id', () => {
-    test('should update work entry hours', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('work_entries we')) {
-          callback(null, { id: 1, hours: 8, client_name: 'Client A' });
-        } else {
-          callback(null, { id: 1 });
-        }
+  describe('POST /api/work-entries/import', () => {
+    test('should import a CSV upload and report failed rows', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, [{ id: 1, name: 'Client A' }]));
+      mockDb.run.mockImplementation(function(query, params, callback) {
+        callback.call({ changes: params.length / 5 }, null);
       });
 
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
+      const response = await request(app)
+        .post('/api/work-entries/import')
+        .set('Content-Type', 'text/csv')
+        .send('date,hours,description,client\n2024-01-15,2,Review,Client A\n2024-01-16,2,,Client B\n');
+
+      expect(response.status).toBe(200);
+      expect(response.body).toEqual({
+        imported: 1,
+        failed: 1,
+        errors: [{ line: 3, error: 'Unknown client "Client B"' }]
       });
+      expect(mockDb.run.mock.calls[0][1]).toEqual([1, 'test@example.com', 2, 'Review', new Date('2024-01-15')]);
+      expect(publishResync).toHaveBeenCalledWith('test@example.com');
+    });
+
+    test('should return 400 for a file missing required columns', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(null, []));
+
+      const response = await request(app)
+        .post('/api/work-entries/import')
+        .set('Content-Type', 'text/csv')
+        .send('date,client\n2024-01-15,Client A\n');
+
+      expect(response.status).toBe(400);
+      expect(response.body).toEqual({ error: 'Missing column(s): hours', line: 1, imported: 0 });
+      expect(publishResync).not.toHaveBeenCalled();
+    });
+
+    test('should return 415 for anything but CSV', async () => {
+      const response = await request(app)
+        .post('/api/work-entries/import')
+        .send({ date: '2024-01-15' });
+
+      expect(response.status).toBe(415);
+      expect(mockDb.all).not.toHaveBeenCalled();
+    });
+
+    test('should handle database errors', async () => {
+      mockDb.all.mockImplementation((query, params, callback) => callback(new Error('Database error')));
+
+      const response = await request(app)
+        .post('/api/work-entries/import')
+        .set('Content-Type', 'text/csv')
+        .send('date,hours,client\n');
+
+      expect(response.status).toBe(500);
+      expect(response.body).toEqual({ error: 'Failed to import work entries' });
+    });
+  });
+
+  describe('PUT /api/work-entries/:id', () => {
+    beforeEach(() => {
+      mockStorage.getWorkEntry.mockResolvedValue({ id: 1 });
+      mockStorage.getClient.mockResolvedValue({ id: 2 });
+    });
+
+    test('should update work entry hours', async () => {
+      mockStorage.updateWorkEntry.mockResolvedValue({ id: 1, hours: 8, client_name: 'Client A' });
 
       const response = await request(app)
         .put('/api/work-entries/1')
         .send({ hours: 8 });
 
       expect(response.status).toBe(200);
-      expect(response.body.message).toBe('Work entry updated successfully');
+      expect(response.body).toEqual({
+        message: 'Work entry updated successfully',
+        workEntry: { id: 1, hours: 8, client_name: 'Client A' }
+      });
+      expect(mockStorage.updateWorkEntry).toHaveBeenCalledWith('test@example.com', 1, { hours: 8 });
+      expect(mockStorage.getClient).not.toHaveBeenCalled();
     });
 
     test('should update work entry client', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { id: 1 });
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
+      mockStorage.updateWorkEntry.mockResolvedValue({ id: 1, client_id: 2 });
 
       const response = await request(app)
         .put('/api/work-entries/1')
         .send({ clientId: 2 });
 
       expect(response.status).toBe(200);
+      expect(mockStorage.getClient).toHaveBeenCalledWith('test@example.com', 2);
     });
 
     test('should return 404 if work entry not found', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, null);
-      });
+      mockStorage.getWorkEntry.mockResolvedValue(undefined);
 
       const response = await request(app)
         .put('/api/work-entries/999')
@@ -272,6 +493,18 @@ describe('Work Entry Routes', () => {
 
       expect(response.status).toBe(404);
       expect(response.body).toEqual({ error: 'Work entry not found' });
+      expect(mockStorage.updateWorkEntry).not.toHaveBeenCalled();
+    });
+
+    test('should return 404 if the work entry is deleted before the update', async () => {
+      mockStorage.updateWorkEntry.mockResolvedValue(undefined);
+
+      const response = await request(app)
+        .put('/api/work-entries/1')
+        .send({ hours: 8 });
+
+      expect(response.status).toBe(404);
+      expect(publishChange).not.toHaveBeenCalled();
     });
 
     test('should return 400 for invalid work entry ID', async () => {
@@ -292,13 +525,7 @@ describe('Work Entry Routes', () => {
     });
 
     test('should return 400 if new client not found', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('work_entries')) {
-          callback(null, { id: 1 });
-        } else {
-          callback(null, null); // Client doesn't exist
-        }
-      });
+      mockStorage.getClient.mockResolvedValue(undefined);
 
       const response = await request(app)
         .put('/api/work-entries/1')
@@ -306,29 +533,49 @@ describe('Work Entry Routes', () => {
 
       expect(response.status).toBe(400);
       expect(response.body).toEqual({ error: 'Client not found or does not belong to user' });
+      expect(mockStorage.updateWorkEntry).not.toHaveBeenCalled();
+    });
+
+    test('should update work entry date', async () => {
+      mockStorage.updateWorkEntry.mockResolvedValue({ id: 1, date: 1706745600000 });
+
+      const response = await request(app)
+        .put('/api/work-entries/1')
+        .send({ date: '2024-02-01' });
+
+      expect(response.status).toBe(200);
+      expect(mockStorage.updateWorkEntry).toHaveBeenCalledWith('test@example.com', 1, { date: new Date('2024-02-01') });
+    });
+
+    test('should update multiple fields at once', async () => {
+      mockStorage.updateWorkEntry.mockResolvedValue({ id: 1, hours: 10, description: 'Updated' });
+
+      const response = await request(app)
+        .put('/api/work-entries/1')
+        .send({ hours: 10, description: 'Updated', date: '2024-03-01' });
+
+      expect(response.status).toBe(200);
+      expect(mockStorage.updateWorkEntry).toHaveBeenCalledWith('test@example.com', 1, {
+        hours: 10,
+        description: 'Updated',
+        date: new Date('2024-03-01')
+      });
     });
   });
 
   describe('DELETE /api/work-entries/:id', () => {
     test('should delete existing work entry', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { id: 1 });
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
+      mockStorage.deleteWorkEntry.mockResolvedValue(true);
 
       const response = await request(app).delete('/api/work-entries/1');
 
       expect(response.status).toBe(200);
       expect(response.body).toEqual({ message: 'Work entry deleted successfully' });
+      expect(mockStorage.deleteWorkEntry).toHaveBeenCalledWith('test@example.com', 1);
     });
 
     test('should return 404 if work entry not found', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, null);
-      });
+      mockStorage.deleteWorkEntry.mockResolvedValue(false);
 
       const response = await request(app).delete('/api/work-entries/999');
 
@@ -344,37 +591,18 @@ describe('Work Entry Routes', () => {
     });
 
     test('should handle database delete error', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { id: 1 });
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(new Error('Delete failed'));
-      });
+      mockStorage.deleteWorkEntry.mockRejectedValue(new Error('Delete failed'));
 
       const response = await request(app).delete('/api/work-entries/1');
 
       expect(response.status).toBe(500);
       expect(response.body).toEqual({ error: 'Failed to delete work entry' });
     });
-
-    test('should handle database error when checking work entry existence', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(new Error('Database error'), null);
-      });
-
-      const response = await request(app).delete('/api/work-entries/1');
-
-      expect(response.status).toBe(500);
-      expect(response.body).toEqual({ error: 'Internal server error' });
-    });
   });
 
   describe('GET /api/work-entries/:id - Error Handling', () => {
     test('should handle database error when fetching single work entry', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(new Error('Database error'), null);
-      });
+      mockStorage.getWorkEntry.mockRejectedValue(new Error('Database error'));
 
       const response = await request(app).get('/api/work-entries/1');
 
@@ -385,9 +613,7 @@ describe('Work Entry Routes', () => {
 
   describe('POST /api/work-entries - Error Handling', () => {
     test('should handle database error when verifying client', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(new Error('Database error'), null);
-      });
+      mockStorage.getClient.mockRejectedValue(new Error('Database error'));
 
       const response = await request(app)
         .post('/api/work-entries')
@@ -400,41 +626,11 @@ describe('Work Entry Routes', () => {
       expect(response.status).toBe(500);
       expect(response.body).toEqual({ error: 'Internal server error' });
     });
-
-    test('should handle error retrieving work entry after creation', async () => {
-      let getCallCount = 0;
-      mockDb.get.mockImplementation((query, params, callback) => {
-        getCallCount++;
-        if (getCallCount === 1) {
-          callback(null, { id: 1 });
-        } else {
-          callback(new Error('Retrieval failed'), null);
-        }
-      });
-
-      mockDb.run.mockImplementation(function(query, params, callback) {
-        this.lastID = 1;
-        callback.call(this, null);
-      });
-
-      const response = await request(app)
-        .post('/api/work-entries')
-        .send({
-          clientId: 1,
-          hours: 5,
-          date: '2024-01-15'
-        });
-
-      expect(response.status).toBe(500);
-      expect(response.body).toEqual({ error: 'Work entry created but failed to retrieve' });
-    });
   });
 
   describe('PUT /api/work-entries/:id - Error Handling', () => {
     test('should handle database error when checking work entry existence', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(new Error('Database error'), null);
-      });
+      mockStorage.getWorkEntry.mockRejectedValue(new Error('Database error'));
 
       const response = await request(app)
         .put('/api/work-entries/1')
@@ -445,15 +641,8 @@ describe('Work Entry Routes', () => {
     });
 
     test('should handle database error when verifying new client in update', async () => {
-      let callCount = 0;
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callCount++;
-        if (callCount === 1) {
-          callback(null, { id: 1 });
-        } else {
-          callback(new Error('Database error'), null);
-        }
-      });
+      mockStorage.getWorkEntry.mockResolvedValue({ id: 1 });
+      mockStorage.getClient.mockRejectedValue(new Error('Database error'));
 
       const response = await request(app)
         .put('/api/work-entries/1')
@@ -464,13 +653,8 @@ describe('Work Entry Routes', () => {
     });
 
     test('should handle database error during update', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        callback(null, { id: 1 });
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(new Error('Update failed'));
-      });
+      mockStorage.getWorkEntry.mockResolvedValue({ id: 1 });
+      mockStorage.updateWorkEntry.mockRejectedValue(new Error('Update failed'));
 
       const response = await request(app)
         .put('/api/work-entries/1')
@@ -479,110 +663,39 @@ describe('Work Entry Routes', () => {
       expect(response.status).toBe(500);
       expect(response.body).toEqual({ error: 'Failed to update work entry' });
     });
+  });
 
-    test('should handle error retrieving work entry after update', async () => {
-      let getCallCount = 0;
-      mockDb.get.mockImplementation((query, params, callback) => {
-        getCallCount++;
-        if (getCallCount === 1) {
-          callback(null, { id: 1 });
-        } else {
-          callback(new Error('Retrieval failed'), null);
-        }
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
-
-      const response = await request(app)
-        .put('/api/work-entries/1')
-        .send({ hours: 8 });
-
-      expect(response.status).toBe(500);
-      expect(response.body).toEqual({ error: 'Work entry updated but failed to retrieve' });
-    });
-
-    test('should update work entry date', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('work_entries we')) {
-          callback(null, { id: 1, date: '2024-02-01', client_name: 'Client A' });
-        } else {
-          callback(null, { id: 1 });
-        }
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
-
-      const response = await request(app)
-        .put('/api/work-entries/1')
-        .send({ date: '2024-02-01' });
+  describe('Change notifications', () => {
+    test('should publish the saved row after creating a work entry', async () => {
+      const saved = { id: 7, client_id: 1, hours: 2, description: null, date: 1705276800000, client_name: 'Client A' };
+      mockStorage.getClient.mockResolvedValue({ id: 1 });
+      mockStorage.insertWorkEntry.mockResolvedValue(saved);
 
-      expect(response.status).toBe(200);
-      expect(response.body.message).toBe('Work entry updated successfully');
-    });
-
-    test('should update work entry description', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('work_entries we')) {
-          callback(null, { id: 1, description: 'New description', client_name: 'Client A' });
-        } else {
-          callback(null, { id: 1 });
-        }
-      });
+      await request(app)
+        .post('/api/work-entries')
+        .send({ clientId: 1, hours: 2, date: '2024-01-15' });
 
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
+      expect(publishChange).toHaveBeenCalledWith('test@example.com', {
+        entity: 'work_entry',
+        op: 'upsert',
+        row: saved
       });
-
-      const response = await request(app)
-        .put('/api/work-entries/1')
-        .send({ description: 'New description' });
-
-      expect(response.status).toBe(200);
     });
 
-    test('should update description to null when empty string provided', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('work_entries we')) {
-          callback(null, { id: 1, description: null, client_name: 'Client A' });
-        } else {
-          callback(null, { id: 1 });
-        }
-      });
-
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
+    test('should publish the id of a deleted work entry', async () => {
+      mockStorage.deleteWorkEntry.mockResolvedValue(true);
 
-      const response = await request(app)
-        .put('/api/work-entries/1')
-        .send({ description: '' });
+      await request(app).delete('/api/work-entries/3');
 
-      expect(response.status).toBe(200);
+      expect(publishChange).toHaveBeenCalledWith('test@example.com', { entity: 'work_entry', op: 'delete', id: 3 });
     });
 
-    test('should update multiple fields at once', async () => {
-      mockDb.get.mockImplementation((query, params, callback) => {
-        if (query.includes('work_entries we')) {
-          callback(null, { id: 1, hours: 10, description: 'Updated', date: '2024-03-01', client_name: 'Client A' });
-        } else {
-          callback(null, { id: 1 });
-        }
-      });
+    test('should not publish when the mutation fails', async () => {
+      mockStorage.deleteWorkEntry.mockRejectedValue(new Error('Database error'));
 
-      mockDb.run.mockImplementation((query, params, callback) => {
-        callback(null);
-      });
+      await request(app).delete('/api/work-entries/3');
 
-      const response = await request(app)
-        .put('/api/work-entries/1')
-        .send({ hours: 10, description: 'Updated', date: '2024-03-01' });
-
-      expect(response.status).toBe(200);
-      expect(response.body.message).toBe('Work entry updated successfully');
+      expect(publishChange).not.toHaveBeenCalled();
     });
   });
 });
@@ -20,3 +20,6 @@ jest.mock('sqlite3', () => {
     }))
   };
 });
+
+// Fixed signing key so tokens issued in one module verify in another
+process.env.JWT_SECRET = 'test-secret-for-signing-session-tokens';
@@ -0,0 +1,226 @@
+const { createStorage } = require('../../storage');
+
+// One suite, run against every storage backend: SQLite always (in memory),
+// PostgreSQL when TEST_DATABASE_URL points at a server (see "Storage
+// Backends" in the backend README for a local container). Each run uses
+// its own schema, dropped afterwards.
+
+const DAY_MS = 24 * 60 * 60 * 1000;
+const DAY = Date.UTC(2024, 0, 15);
+const TIMESTAMP = /^\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}$/;
+
+function loadSqlite() {
+  try {
+    // The real driver: __tests__/setup.js mocks it for everything else
+    return jest.requireActual('sqlite3');
+  } catch (err) {
+    return null;
+  }
+}
+
+const sqlite3 = loadSqlite();
+
+const backends = [
+  {
+    name: 'sqlite',
+    available: Boolean(sqlite3),
+    create: () => createStorage({ backend: 'sqlite', db: new sqlite3.Database(':memory:') }),
+    destroy: async (storage) => {
+      await storage.close();
+      await new Promise((resolve) => storage.db.close(resolve));
+    }
+  },
+  {
+    name: 'postgres',
+    available: Boolean(process.env.TEST_DATABASE_URL),
+    create: () => createStorage({
+      backend: 'postgres',
+      connectionString: process.env.TEST_DATABASE_URL,
+      schema: `conformance_${process.pid}`
+    }),
+    destroy: async (storage) => {
+      await storage.pool.query(`DROP SCHEMA IF EXISTS ${storage.schema} CASCADE`);
+      await storage.close();
+    }
+  }
+];
+
+backends.forEach(({ name, available, create, destroy }) => {
+  const describeBackend = available ? describe : describe.skip;
+
+  describeBackend(`Storage conformance: ${name}`, () => {
+    let storage;
+    let users = 0;
+
+    // A fresh user with two clients, so tests don't see each other's rows
+    async function newUser() {
+      users += 1;
+      const email = `user${users}@example.com`;
+      await storage.createUser(email);
+      const acme = await storage.createClient(email, { name: 'Acme' });
+      const globex = await storage.createClient(email, { name: 'Globex', description: 'Second' });
+      return { email, acme, globex };
+    }
+
+    beforeAll(async () => {
+      if (storage) {
+        return;
+      }
+      jest.spyOn(console, 'log').mockImplementation();
+      storage = create();
+      await storage.migrate();
+      console.log.mockRestore();
+    });
+
+    afterAll(async () => {
+      await destroy(storage);
+    });
+
+    test('should create and read back a work entry', async () => {
+      const { email, acme } = await newUser();
+
+      const created = await storage.insertWorkEntry(email, {
+        clientId: acme.id,
+        hours: 7.25,
+        description: 'Sprint planning',
+        date: new Date(DAY)
+      });
+
+      expect(created).toMatchObject({
+        client_id: acme.id,
+        hours: 7.25,
+        description: 'Sprint planning',
+        date: DAY,
+        client_name: 'Acme'
+      });
+      expect(typeof created.id).toBe('number');
+      expect(created.created_at).toMatch(TIMESTAMP);
+      expect(created.updated_at).toMatch(TIMESTAMP);
+      expect(await storage.getWorkEntry(email, created.id)).toEqual(created);
+      expect(acme).toMatchObject({ name: 'Acme', description: null });
+    });
+
+    test('should keep users apart', async () => {
+      const owner = await newUser();
+      const other = await newUser();
+      const entry = await storage.insertWorkEntry(owner.email, { clientId: owner.acme.id, hours: 1, date: DAY });
+
+      expect(await storage.getWorkEntry(other.email, entry.id)).toBeUndefined();
+      expect(await storage.updateWorkEntry(other.email, entry.id, { hours: 2 })).toBeUndefined();
+      expect(await storage.deleteWorkEntry(other.email, entry.id)).toBe(false);
+      expect(await storage.listWorkEntries(other.email)).toEqual([]);
+      expect((await storage.getWorkEntry(owner.email, entry.id)).hours).toBe(1);
+    });
+
+    test('should list newest first with filters and keyset pages', async () => {
+      const { email, acme, globex } = await newUser();
+      await storage.insertWorkEntries(email, Array.from({ length: 25 }, (_, index) => ({
+        clientId: index % 3 === 0 ? globex.id : acme.id,
+        hours: 1 + (index % 4),
+        description: `Entry ${index}`,
+        date: DAY + (index % 10) * DAY_MS
+      })));
+
+      const all = await storage.listWorkEntries(email);
+      const keys = all.map((entry) => [entry.date, entry.created_at, entry.id]);
+
+      expect(all).toHaveLength(25);
+      expect(keys).toEqual([...keys].sort((a, b) => b[0] - a[0] || b[1].localeCompare(a[1]) || b[2] - a[2]));
+
+      const paged = [];
+      let cursor;
+      do {
+        const page = await storage.listWorkEntries(email, { limit: 7, cursor });
+        paged.push(...page);
+        cursor = page.length === 7 ? [page[6].date, page[6].created_at, page[6].id] : null;
+      } while (cursor);
+      expect(paged.map((entry) => entry.id)).toEqual(all.map((entry) => entry.id));
+
+      const filtered = await storage.listWorkEntries(email, {
+        clientId: acme.id,
+        from: new Date(DAY + 2 * DAY_MS),
+        to: DAY + 5 * DAY_MS
+      });
+      expect(filtered.map((entry) => entry.id)).toEqual(all
+        .filter((entry) => entry.client_id === acme.id && entry.date >= DAY + 2 * DAY_MS && entry.date <= DAY + 5 * DAY_MS)
+        .map((entry) => entry.id));
+
+      const narrowed = await storage.listWorkEntries(email, { clientIds: [globex.id], minHours: 2, maxHours: 3 });
+      expect(narrowed.map((entry) => entry.id)).toEqual(all
+        .filter((entry) => entry.client_id === globex.id && entry.hours >= 2 && entry.hours <= 3)
+        .map((entry) => entry.id));
+    });
+
+    test('should read back only the user\'s own clients', async () => {
+      const owner = await newUser();
+      const other = await newUser();
+
+      expect(await storage.getClient(owner.email, owner.globex.id)).toEqual(owner.globex);
+      expect(await storage.getClient(other.email, owner.globex.id)).toBeUndefined();
+    });
+
+    test('should update only the given fields', async () => {
+      const { email, acme, globex } = await newUser();
+      const entry = await storage.insertWorkEntry(email, { clientId: acme.id, hours: 3, description: 'Draft', date: DAY });
+
+      const moved = await storage.updateWorkEntry(email, entry.id, { clientId: globex.id, date: DAY + DAY_MS });
+      expect(moved).toMatchObject({ client_id: globex.id, client_name: 'Globex', hours: 3, description: 'Draft', date: DAY + DAY_MS });
+
+      const cleared = await storage.updateWorkEntry(email, entry.id, { hours: 4.5, description: '' });
+      expect(cleared).toMatchObject({ hours: 4.5, description: null, date: DAY + DAY_MS });
+    });
+
+    test('should delete a work entry once', async () => {
+      const { email, acme } = await newUser();
+      const entry = await storage.insertWorkEntry(email, { clientId: acme.id, hours: 2, date: DAY });
+
+      expect(await storage.deleteWorkEntry(email, entry.id)).toBe(true);
+      expect(await storage.deleteWorkEntry(email, entry.id)).toBe(false);
+      expect(await storage.getWorkEntry(email, entry.id)).toBeUndefined();
+    });
+
+    test('should bulk insert every value intact', async () => {
+      const { email, acme } = await newUser();
+      const descriptions = ['plain', null, 'tab\there', 'two\nlines', 'cr\r', 'back\\slash', '\\N', 'quote "x", comma', 'Café 日本 😀', ''];
+      const entries = Array.from({ length: 1200 }, (_, index) => ({
+        clientId: acme.id,
+        hours: (1 + (index % 96)) / 4,
+        description: descriptions[index % descriptions.length],
+        date: DAY - index * DAY_MS
+      }));
+
+      expect(await storage.insertWorkEntries(email, entries)).toBe(1200);
+      expect(await storage.insertWorkEntries(email, [])).toBe(0);
+
+      const rows = await storage.listWorkEntries(email);
+      expect(rows).toHaveLength(1200);
+      expect(rows.map((row) => [row.date, row.hours, row.description]))
+        .toEqual(entries.map((entry) => [entry.date, entry.hours, entry.description]));
+    });
+
+    test('should total hours by client', async () => {
+      const { email, acme, globex } = await newUser();
+      await storage.insertWorkEntries(email, [
+        { clientId: acme.id, hours: 2.5, date: DAY },
+        { clientId: acme.id, hours: 1.25, date: DAY + DAY_MS },
+        { clientId: globex.id, hours: 8, date: DAY + 2 * DAY_MS },
+        { clientId: globex.id, hours: 1, date: DAY + 30 * DAY_MS }
+      ]);
+
+      expect(await storage.hoursByClient(email)).toEqual([
+        { clientId: acme.id, name: 'Acme', hours: 3.75, entryCount: 2 },
+        { clientId: globex.id, name: 'Globex', hours: 9, entryCount: 2 }
+      ]);
+      expect(await storage.hoursByClient(email, { from: DAY + DAY_MS, to: DAY + 2 * DAY_MS })).toEqual([
+        { clientId: acme.id, name: 'Acme', hours: 1.25, entryCount: 1 },
+        { clientId: globex.id, name: 'Globex', hours: 8, entryCount: 1 }
+      ]);
+    });
+  });
+});
+
+describe('Storage selection', () => {
+  test('should reject an unknown backend', () => {
+    expect(() => createStorage({ backend: 'mongodb' })).toThrow('Unknown storage backend');
+  });
+});
@@ -0,0 +1,176 @@
+const { Pool } = require('pg');
+const { from: copyFrom } = require('pg-copy-streams');
+const { PostgresStorage, copyField } = require('../../storage/postgres');
+
+// The PostgreSQL adapter against a stub driver, so what it sends is checked
+// on every run; conformance.test.js covers its results against a real
+// server when TEST_DATABASE_URL is set.
+
+jest.mock('pg', () => {
+  class MockPool {
+    constructor(options) {
+      this.options = options;
+      this.queries = [];
+      this.clients = [];
+      this.rows = [];
+      this.fail = null;
+      MockPool.instances.push(this);
+    }
+
+    on() {}
+
+    async query(query) {
+      this.queries.push(query);
+      return { rows: this.rows, rowCount: this.rows.length };
+    }
+
+    async connect() {
+      const client = {
+        queries: [],
+        released: false,
+        query: (query) => {
+          if (query instanceof require('stream').Writable) {
+            return query;
+          }
+          client.queries.push(query);
+          if (this.fail && query.includes(this.fail)) {
+            return Promise.reject(new Error('Statement failed'));
+          }
+          return Promise.resolve({ rows: [] });
+        },
+        release: () => {
+          client.released = true;
+        }
+      };
+      this.clients.push(client);
+      return client;
+    }
+
+    async end() {}
+  }
+  MockPool.instances = [];
+  return { Pool: MockPool };
+}, { virtual: true });
+
+// COPY streams collect what's written to them
+jest.mock('pg-copy-streams', () => ({
+  from: jest.fn((sql) => {
+    const stream = new (require('stream').Writable)({
+      write(chunk, encoding, callback) {
+        stream.data += chunk.toString();
+        callback();
+      }
+    });
+    stream.sql = sql;
+    stream.data = '';
+    return stream;
+  })
+}), { virtual: true });
+
+describe('PostgreSQL storage', () => {
+  let storage;
+  let pool;
+
+  beforeEach(() => {
+    Pool.instances.length = 0;
+    copyFrom.mockClear();
+    storage = new PostgresStorage({ connectionString: 'postgres://stub/timesheet', poolSize: 3, schema: 'tenant_test' });
+    [pool] = Pool.instances;
+  });
+
+  test('should connect in UTC within its schema', () => {
+    expect(pool.options).toEqual({
+      connectionString: 'postgres://stub/timesheet',
+      max: 3,
+      options: '-c TimeZone=UTC -c search_path=tenant_test'
+    });
+    expect(() => new PostgresStorage({ schema: 'bad; DROP' })).toThrow('Invalid schema name');
+  });
+
+  test('should create the schema, change log and search index in one transaction', async () => {
+    await storage.migrate();
+
+    const [client] = pool.clients;
+    const statements = client.queries;
+    expect(statements[0]).toBe('BEGIN');
+    expect(statements[1]).toBe('CREATE SCHEMA IF NOT EXISTS tenant_test');
+    expect(statements[statements.length - 1]).toBe('COMMIT');
+    expect(statements).toEqual(expect.arrayContaining([
+      expect.stringContaining('CREATE TABLE IF NOT EXISTS work_entries'),
+      expect.stringContaining('CREATE TABLE IF NOT EXISTS change_log ('),
+      expect.stringContaining('CREATE TABLE IF NOT EXISTS change_log_state'),
+      expect.stringContaining('CREATE TABLE IF NOT EXISTS change_log_user_floor'),
+      expect.stringContaining('CREATE OR REPLACE TRIGGER work_entries_change_log'),
+      expect.stringContaining('CREATE OR REPLACE TRIGGER clients_change_log_soft_delete'),
+      expect.stringContaining('ON work_entries USING GIN (search)')
+    ]));
+    expect(client.released).toBe(true);
+  });
+
+  test('should roll back a failed migration', async () => {
+    pool.fail = 'CREATE TABLE IF NOT EXISTS change_log (';
+
+    await expect(storage.migrate()).rejects.toThrow('Statement failed');
+
+    const [client] = pool.clients;
+    expect(client.queries[client.queries.length - 1]).toBe('ROLLBACK');
+    expect(client.released).toBe(true);
+  });
+
+  test('should prepare each statement once under a stable name', async () => {
+    await storage.getWorkEntry('a@example.com', 1);
+    await storage.getWorkEntry('b@example.com', 2);
+    await storage.deleteWorkEntry('a@example.com', 1);
+
+    const [first, second, third] = pool.queries;
+    expect(first.name).toBe(second.name);
+    expect(third.name).not.toBe(first.name);
+    expect(second.values).toEqual([2, 'b@example.com']);
+    expect(third.text).toContain('EXISTS (SELECT 1 FROM clients c WHERE c.id = work_entries.client_id AND c.deleted_at IS NULL)');
+  });
+
+  test('should number the placeholders of every filter in order', async () => {
+    await storage.listWorkEntries('a@example.com', {
+      clientIds: [4, 5],
+      from: new Date(Date.UTC(2024, 0, 1)),
+      minHours: 1,
+      cursor: [1704067200000, '2024-01-01 09:00:00', 9],
+      limit: 11
+    });
+
+    const [{ text, values }] = pool.queries;
+    expect(text).toContain('we.user_email = $1');
+    expect(text).toContain('AND we.client_id IN ($2, $3)');
+    expect(text).toContain('AND we.date >= $4');
+    expect(text).toContain('AND we.hours >= $5');
+    expect(text).toContain('AND (we.date, we.created_at, we.id) < ($6, $7, $8)');
+    expect(text).toContain('ORDER BY we.date DESC, we.created_at DESC, we.id DESC LIMIT $9');
+    expect(values).toEqual(['a@example.com', 4, 5, 1704067200000, 1, 1704067200000, '2024-01-01 09:00:00', 9, 11]);
+  });
+
+  test('should bulk insert through COPY in its text format', async () => {
+    const count = await storage.insertWorkEntries('a@example.com', [
+      { clientId: 1, hours: 2.5, description: 'tab\there', date: 1704067200000 },
+      { clientId: 2, hours: 1, description: null, date: new Date(1704153600000) }
+    ]);
+
+    expect(count).toBe(2);
+    expect(copyFrom).toHaveBeenCalledTimes(1);
+    const [{ value: copy }] = copyFrom.mock.results;
+    expect(copy.sql).toBe('COPY work_entries (client_id, user_email, hours, description, date) FROM STDIN');
+    expect(copy.data).toBe(
+      '1\ta@example.com\t2.5\ttab\\there\t1704067200000\n2\ta@example.com\t1\t\\N\t1704153600000\n'
+    );
+    expect(pool.clients[0].released).toBe(true);
+
+    expect(await storage.insertWorkEntries('a@example.com', [])).toBe(0);
+    expect(pool.clients).toHaveLength(1);
+    expect(copyFrom).toHaveBeenCalledTimes(1);
+  });
+
+  test('should escape COPY fields', () => {
+    expect(copyField(null)).toBe('\\N');
+    expect(copyField('a\\b\nc\rd')).toBe('a\\\\b\\nc\\rd');
+    expect(copyField(7.25)).toBe('7.25');
+  });
+});
@@ -0,0 +1,170 @@
+const Joi = require('joi');
+const { compileSchema } = require('../../validation/compile');
+const schemas = require('../../validation/schemas');
+
+// Compiled validators must be indistinguishable from Joi: same value, same
+// error message and details, for valid and invalid input alike.
+const expectParity = (validator, input) => {
+  const expected = validator.schema.validate(input);
+  const actual = validator.validate(input);
+
+  expect(actual.value).toEqual(expected.value);
+  if (expected.error) {
+    expect(actual.error.message).toBe(expected.error.message);
+    expect(actual.error.details).toEqual(expected.error.details);
+  } else {
+    expect(actual.error).toBeUndefined();
+  }
+};
+
+// The schemas.test.js cases, plus conversions and edge cases around them
+const cases = {
+  clientSchema: [
+    { name: 'Test Client', description: 'A test client' },
+    { name: 'Test Client', description: '' },
+    { name: 'Test Client', department: 'Engineering', email: 'client@example.com' },
+    { name: '  Padded Name  ', description: '  padded  ', email: ' client@example.com ' },
+    { name: 'Test Client', email: '' },
+    { name: 'Test Client', description: '   ' },
+    { description: 'Missing name' },
+    { name: '' },
+    { name: '   ' },
+    { name: 'a'.repeat(255) },
+    { name: 'a'.repeat(256) },
+    { name: 'Test Client', description: 'a'.repeat(1001) },
+    { name: 'Test Client', email: 'not-an-email' },
+    { name: 'Test Client', email: 'client@example.invalidtld' },
+    { name: 'Test Client', unknown: true },
+    { name: 123 },
+    { name: null },
+    null,
+    'Test Client',
+    []
+  ],
+  workEntrySchema: [
+    { clientId: 1, hours: 8, description: 'Work done', date: '2024-01-15' },
+    { clientId: 1, hours: 0.25, date: '2024-01-15T09:30:00Z' },
+    { clientId: '7', hours: '7.5', date: '2024-01-15T09:30:00.123+02:00' },
+    { clientId: 1, hours: 24, date: '2024-01-15' },
+    { clientId: 1, hours: 24.01, date: '2024-01-15' },
+    { clientId: 1, hours: 25, date: '2024-01-15' },
+    { clientId: 1, hours: 0, date: '2024-01-15' },
+    { clientId: 1, hours: -1, date: '2024-01-15' },
+    { clientId: 1, hours: 1.234, date: '2024-01-15' },
+    { clientId: 1, hours: 1.5, date: 'not-a-date' },
+    { clientId: 1, hours: 1.5, date: '2024-02-30' },
+    { clientId: 1, hours: 1.5, date: 1705312800000 },
+    { clientId: 0, hours: 1, date: '2024-01-15' },
+    { clientId: -1, hours: 1, date: '2024-01-15' },
+    { clientId: 1.5, hours: 1, date: '2024-01-15' },
+    { clientId: '01', hours: 1, date: '2024-01-15' },
+    { clientId: 1e21, hours: 1, date: '2024-01-15' },
+    { clientId: 1, hours: '1e1', date: '2024-01-15' },
+    { clientId: 1, hours: ' 8 ', date: '2024-01-15' },
+    { clientId: 1, date: '2024-01-15' },
+    { hours: 1, date: '2024-01-15' },
+    { clientId: 1, hours: 1 },
+    { clientId: 1, hours: 1, date: '2024-01-15', description: 'a'.repeat(1001) }
+  ],
+  updateWorkEntrySchema: [
+    { hours: 6 },
+    { description: 'Updated' },
+    { date: '2024-03-01' },
+    { clientId: '3' },
+    {},
+    { hours: 30 },
+    { extra: 'field' }
+  ],
+  updateClientSchema: [
+    { name: 'Updated' },
+    { description: '' },
+    { email: 'new@example.com' },
+    {},
+    { name: '' },
+    { email: 'bad' }
+  ],
+  changesQuerySchema: [
+    {},
+    { since: '42' },
+    { since: '42', limit: '10' },
+    { since: -1 },
+    { limit: '0' },
+    { limit: '5001' },
+    { since: 'abc' },
+    { cursor: 'x' }
+  ],
+  emailSchema: [
+    { email: 'user@example.com' },
+    { email: 'invalid-email' },
+    { email: '' },
+    {},
+    { email: 'user@example.com', other: 1 }
+  ],
+  refreshTokenSchema: [
+    { refreshToken: 'abc.def.ghi' },
+    { refreshToken: '' },
+    { refreshToken: 42 },
+    {}
+  ]
+};
+
+describe('Compiled Validators', () => {
+  test('should compile the hot-path schemas', () => {
+    Object.keys(cases).forEach((name) => {
+      expect({ name, compiled: schemas[name].compiled }).toEqual({ name, compiled: true });
+    });
+  });
+
+  test('should leave schemas with references and arrays to Joi', () => {
+    ['dateRangeSchema', 'workEntryQuerySchema', 'searchQuerySchema'].forEach((name) => {
+      expect(schemas[name].compiled).toBe(false);
+      expect(typeof schemas[name].validate).toBe('function');
+    });
+  });
+
+  Object.entries(cases).forEach(([name, inputs]) => {
+    describe(name, () => {
+      inputs.forEach((input) => {
+        test(`should match Joi for ${JSON.stringify(input)}`.slice(0, 120), () => {
+          expectParity(schemas[name], input);
+        });
+      });
+    });
+  });
+
+  test('should return converted values', () => {
+    const { value } = schemas.workEntrySchema.validate({
+      clientId: '7',
+      hours: '7.5',
+      description: '  Padded  ',
+      date: '2024-01-15'
+    });
+
+    expect(value).toEqual({
+      clientId: 7,
+      hours: 7.5,
+      description: 'Padded',
+      date: new Date('2024-01-15')
+    });
+    expect(schemas.changesQuerySchema.validate({}).value).toEqual({ since: 0, limit: 1000 });
+  });
+
+  test('should hand calls with options to Joi', () => {
+    const validator = compileSchema(Joi.object({ name: Joi.string().required() }));
+
+    const { error, value } = validator.validate({ name: 'x', extra: 1 }, { allowUnknown: true });
+
+    expect(error).toBeUndefined();
+    expect(value).toEqual({ name: 'x', extra: 1 });
+  });
+
+  test('should fall back to Joi for unsupported schemas', () => {
+    const schema = Joi.object({ tags: Joi.array().items(Joi.string()) });
+
+    const validator = compileSchema(schema);
+
+    expect(validator.compiled).toBe(false);
+    expect(validator.reason).toMatch(/array/);
+    expect(validator.validate({ tags: ['a'] })).toEqual(schema.validate({ tags: ['a'] }));
+  });
+});
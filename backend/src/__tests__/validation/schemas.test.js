@@ -3,6 +3,7 @@ const {
   workEntrySchema,
   updateWorkEntrySchema,
   updateClientSchema,
+  workEntryQuerySchema,
   emailSchema
 } = require('../../validation/schemas');
 
@@ -290,6 +291,54 @@ describe('Validation Schemas', () => {
     });
   });
 
+  describe('workEntryQuerySchema', () => {
+    test('should accept an empty filter', () => {
+      const { error } = workEntryQuerySchema.validate({});
+      expect(error).toBeUndefined();
+    });
+
+    test('should convert query string values', () => {
+      const { error, value } = workEntryQuerySchema.validate({
+        from: '2024-01-01',
+        to: '2024-01-31',
+        clientIds: ['1', '2'],
+        minHours: '0.5',
+        maxHours: '8'
+      });
+
+      expect(error).toBeUndefined();
+      expect(value.from).toBeInstanceOf(Date);
+      expect(value.clientIds).toEqual([1, 2]);
+      expect(value.minHours).toBe(0.5);
+      expect(value.maxHours).toBe(8);
+    });
+
+    test('should wrap a single clientIds value in an array', () => {
+      const { value } = workEntryQuerySchema.validate({ clientIds: '4' });
+      expect(value.clientIds).toEqual([4]);
+    });
+
+    test('should reject to before from', () => {
+      const { error } = workEntryQuerySchema.validate({ from: '2024-02-01', to: '2024-01-01' });
+      expect(error).toBeDefined();
+    });
+
+    test('should allow to without from', () => {
+      const { error } = workEntryQuerySchema.validate({ to: '2024-01-01' });
+      expect(error).toBeUndefined();
+    });
+
+    test('should reject maxHours below minHours', () => {
+      const { error } = workEntryQuerySchema.validate({ minHours: 5, maxHours: 2 });
+      expect(error).toBeDefined();
+    });
+
+    test('should reject non-positive client IDs', () => {
+      const { error } = workEntryQuerySchema.validate({ clientIds: ['0'] });
+      expect(error).toBeDefined();
+    });
+  });
+
   describe('emailSchema', () => {
     test('should validate valid email', () => {
       const data = {
@@ -0,0 +1,72 @@
+const crypto = require('crypto');
+const jwt = require('jsonwebtoken');
+
+// Signed session tokens. Access tokens are short-lived and verified without
+// touching the database; refresh tokens are checked against
+// users.token_version so they can be revoked.
+
+const ALGORITHM = 'HS256';
+const ISSUER = 'time-tracking-api';
+const ACCESS_TOKEN_TTL_SECONDS = Number(process.env.JWT_ACCESS_TOKEN_TTL) || 15 * 60;
+const REFRESH_TOKEN_TTL_SECONDS = Number(process.env.JWT_REFRESH_TOKEN_TTL) || 7 * 24 * 60 * 60;
+
+// The secret is turned into a KeyObject once instead of on every sign/verify
+let signingKey = null;
+
+// A random key is per process: with several processes behind one port,
+// tokens issued by one would be rejected by the others. So it is only used
+// outside production.
+function getSigningKey() {
+  if (!signingKey) {
+    const secret = process.env.JWT_SECRET;
+    if (!secret && process.env.NODE_ENV === 'production') {
+      throw new Error('JWT_SECRET must be set in production');
+    }
+    if (!secret) {
+      console.warn('JWT_SECRET is not set; using a random key, sessions will not survive a restart');
+    }
+    signingKey = crypto.createSecretKey(secret ? Buffer.from(secret) : crypto.randomBytes(32));
+  }
+  return signingKey;
+}
+
+// Fail at startup, rather than on the first login, when no key is configured
+function checkSigningKey() {
+  getSigningKey();
+}
+
+// Forget the cached key, e.g. after JWT_SECRET changed
+function resetSigningKey() {
+  signingKey = null;
+}
+
+function issueTokens(email, tokenVersion = 0) {
+  const key = getSigningKey();
+  const options = { algorithm: ALGORITHM, issuer: ISSUER, subject: email };
+
+  return {
+    accessToken: jwt.sign({ typ: 'access' }, key, { ...options, expiresIn: ACCESS_TOKEN_TTL_SECONDS }),
+    refreshToken: jwt.sign({ typ: 'refresh', ver: tokenVersion }, key, {
+      ...options,
+      expiresIn: REFRESH_TOKEN_TTL_SECONDS
+    }),
+    expiresIn: ACCESS_TOKEN_TTL_SECONDS
+  };
+}
+
+// Verify signature, expiry and token type; returns the payload (`sub` is
+// the user's email). Throws jsonwebtoken's errors otherwise.
+function verifyToken(token, type) {
+  const payload = jwt.verify(token, getSigningKey(), { algorithms: [ALGORITHM], issuer: ISSUER });
+  if (payload.typ !== type || typeof payload.sub !== 'string') {
+    throw new jwt.JsonWebTokenError(`Expected a ${type} token`);
+  }
+  return payload;
+}
+
+module.exports = {
+  issueTokens,
+  verifyToken,
+  checkSigningKey,
+  resetSigningKey
+};
@@ -0,0 +1,187 @@
+const { run, get, all } = require('./query');
+const { runInChunks } = require('./migrate');
+
+// Reader and maintenance for the append-only change_log table (see
+// migrations/005_change_log.js). A version is a change_log sequence number;
+// "changes since N" is the latest change of every row changed after N.
+
+const DEFAULT_RETENTION_DAYS = 30;
+const COMPACTION_INTERVAL_MS = 60 * 60 * 1000;
+const COMPACTION_BATCH_SIZE = 5000;
+
+// The requested version can't be served: it is newer than anything we
+// handed out, or older than what compaction kept
+class ChangeLogVersionError extends Error {
+  constructor(version) {
+    super('Sync version is no longer available');
+    this.name = 'ChangeLogVersionError';
+    this.version = version;
+  }
+}
+
+// With a user, `oldest` also honours the floor set when they last moved
+// shards (migrations/009_change_log_user_floor.js)
+async function getVersionBounds(db, userEmail = null) {
+  const row = await get(db, `
+    SELECT (SELECT seq FROM sqlite_sequence WHERE name = 'change_log') AS current,
+           (SELECT compacted_through FROM change_log_state WHERE id = 1) AS oldest,
+           (SELECT version FROM change_log_user_floor WHERE user_email = ?) AS floor
+  `, [userEmail]);
+  return {
+    current: (row && row.current) || 0,
+    oldest: Math.max((row && row.oldest) || 0, (row && row.floor) || 0)
+  };
+}
+
+async function getCurrentVersion(db) {
+  return (await getVersionBounds(db)).current;
+}
+
+// The user's changes to `entity` after `since`, one row per change. Work
+// entries also change through their client (`client_entries`, logged once
+// per client), expanded here to each of the client's entries.
+function changeRows(entity) {
+  const direct = 'SELECT entity_id, seq FROM change_log WHERE user_email = ? AND entity = ? AND seq > ?';
+  if (entity !== 'work_entry') {
+    return direct;
+  }
+  return `${direct}
+    UNION ALL
+    SELECT we.id, cl.seq
+    FROM change_log cl
+    JOIN work_entries we ON we.client_id = cl.entity_id
+    WHERE cl.user_email = ? AND cl.entity = 'client_entries' AND cl.seq > ?`;
+}
+
+// Ids of the user's `entity` rows changed after `since`, oldest change
+// first. Whether a row was upserted or deleted is for the caller to read
+// from the entity table, so a row changed many times is reported once with
+// its current state. Pages of `limit`; continue from `version` while
+// `hasMore`. Entries expanded from one client change share its version, so
+// a page never ends partway through them and may run over `limit`.
+async function readChanges(db, { userEmail, entity, since, limit }) {
+  const { current, oldest } = await getVersionBounds(db, userEmail);
+  if (since > current || since < oldest) {
+    throw new ChangeLogVersionError(current);
+  }
+
+  const sql = `
+    SELECT entity_id, MAX(seq) AS seq
+    FROM (${changeRows(entity)})
+    GROUP BY entity_id`;
+  const params = entity === 'work_entry'
+    ? [userEmail, entity, since, userEmail, since]
+    : [userEmail, entity, since];
+
+  const rows = await all(db, `${sql} ORDER BY seq LIMIT ?`, [...params, limit + 1]);
+  const hasMore = rows.length > limit;
+  let page = rows.slice(0, limit);
+  if (hasMore && rows[limit].seq === rows[limit - 1].seq) {
+    page = await all(db, `${sql} HAVING MAX(seq) <= ? ORDER BY seq`, [...params, rows[limit].seq]);
+  }
+
+  return {
+    ids: page.map((row) => row.entity_id),
+    version: hasMore ? page[page.length - 1].seq : current,
+    hasMore
+  };
+}
+
+const toSqliteTimestamp = (date) => date.toISOString().replace('T', ' ').slice(0, 19);
+
+// Shrink the log in small, independently committed chunks:
+//  1. drop rows superseded by a later change to the same row; readers only
+//     ever use the latest, so this is invisible to them
+//  2. drop everything older than the retention period and raise the
+//     oldest servable version, so clients further behind resync from scratch
+async function compactChangeLog(db, {
+  retentionDays = DEFAULT_RETENTION_DAYS,
+  batchSize = COMPACTION_BATCH_SIZE,
+  now = new Date(),
+  pauseMs
+} = {}) {
+  let from = 0;
+  let superseded = 0;
+  await runInChunks(async () => {
+    const rows = await all(db, 'SELECT seq FROM change_log WHERE seq > ? ORDER BY seq LIMIT ?', [from, batchSize]);
+    if (rows.length === 0) {
+      return 0;
+    }
+    const to = rows[rows.length - 1].seq;
+    const { changes } = await run(db, `
+      DELETE FROM change_log
+      WHERE seq > ? AND seq <= ?
+        AND EXISTS (
+          SELECT 1 FROM change_log newer
+          WHERE newer.entity = change_log.entity
+            AND newer.entity_id = change_log.entity_id
+            AND newer.seq > change_log.seq
+        )
+    `, [from, to]);
+    superseded += changes;
+    from = to;
+    return rows.length;
+  }, { pauseMs });
+
+  const cutoff = toSqliteTimestamp(new Date(now.getTime() - retentionDays * 24 * 60 * 60 * 1000));
+  let expired = 0;
+
+  await runInChunks(async () => {
+    // Sequence and timestamp grow together, so expired rows are a prefix
+    const rows = await all(db, 'SELECT seq, changed_at FROM change_log ORDER BY seq LIMIT ?', [batchSize]);
+    const old = rows.filter((row) => row.changed_at < cutoff);
+    if (old.length === 0) {
+      return 0;
+    }
+
+    const through = old[old.length - 1].seq;
+    // Raise the watermark first: if we stop in between, clients resync
+    // rather than miss a deleted row
+    await run(db, `UPDATE change_log_state SET compacted_through = ?
+                   WHERE id = 1 AND compacted_through < ?`, [through, through]);
+    await run(db, 'DELETE FROM change_log WHERE seq <= ?', [through]);
+    expired += old.length;
+    return old.length;
+  }, { pauseMs });
+
+  return { superseded, expired };
+}
+
+// Run compaction periodically in the background. `db` is a connection, or
+// a function running a callback on each database (eachDatabase in
+// database/init.js). Returns a stop function, which resolves once a pass
+// that is running has finished.
+function startChangeLogCompaction(db, {
+  intervalMs = COMPACTION_INTERVAL_MS,
+  retentionDays = Number(process.env.CHANGE_LOG_RETENTION_DAYS) || DEFAULT_RETENTION_DAYS
+} = {}) {
+  const eachDatabase = typeof db === 'function' ? db : (fn) => fn(db);
+  let running = null;
+
+  const timer = setInterval(() => {
+    if (running) {
+      return;
+    }
+    running = eachDatabase((database) => compactChangeLog(database, { retentionDays }))
+      .catch((error) => {
+        console.error('Change log compaction failed:', error);
+      })
+      .finally(() => {
+        running = null;
+      });
+  }, intervalMs);
+  timer.unref();
+
+  return async () => {
+    clearInterval(timer);
+    await running;
+  };
+}
+
+module.exports = {
+  ChangeLogVersionError,
+  getCurrentVersion,
+  readChanges,
+  compactChangeLog,
+  startChangeLogCompaction
+};
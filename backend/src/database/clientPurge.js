@@ -0,0 +1,154 @@
+const { run, all } = require('./query');
+const { runInChunks } = require('./migrate');
+const { noteChange } = require('./readCoherence');
+
+// Deleting a client is a soft delete (migrations/008): the row gets
+// deleted_at and disappears from every query, and this purger removes its
+// work entries in the background, a chunk per statement so each write
+// transaction stays short. The client row itself goes once it has no
+// entries left.
+//
+// All state is in the database, so a purge interrupted by a restart picks
+// up where it stopped on the next pass.
+
+const PURGE_INTERVAL_MS = 60 * 1000;
+const PURGE_BATCH_SIZE = 1000;
+
+// Mark the user's client (or, without `clientId`, all their clients)
+// deleted. Resolves with the number of clients marked.
+async function softDeleteClients(db, userEmail, clientId = null) {
+  const { changes } = await run(db, `
+    UPDATE clients
+    SET deleted_at = CURRENT_TIMESTAMP,
+        purge_entries = (SELECT COUNT(*) FROM work_entries WHERE client_id = clients.id)
+    WHERE user_email = ? AND deleted_at IS NULL${clientId === null ? '' : ' AND id = ?'}
+  `, clientId === null ? [userEmail] : [userEmail, clientId]);
+  if (changes > 0) {
+    noteChange(userEmail, clientId === null ? { entity: 'client', op: 'clear' } : { entity: 'client', op: 'delete', id: clientId });
+  }
+  return changes;
+}
+
+// The user's clients still being purged, with entries left to remove
+function getPurgeProgress(db, userEmail) {
+  return all(db, `
+    SELECT c.id AS clientId, c.name, c.deleted_at AS deletedAt,
+           c.purge_entries AS totalEntries,
+           (SELECT COUNT(*) FROM work_entries we WHERE we.client_id = c.id) AS remainingEntries
+    FROM clients c
+    WHERE c.user_email = ? AND c.deleted_at IS NOT NULL
+    ORDER BY c.deleted_at, c.id
+  `, [userEmail]);
+}
+
+// Remove one deleted client's entries, then the client. Stops between
+// chunks once `signal` is aborted, leaving the rest for the next pass.
+async function purgeClient(db, clientId, { batchSize = PURGE_BATCH_SIZE, pauseMs, signal } = {}) {
+  const aborted = () => Boolean(signal && signal.aborted);
+
+  const entries = await runInChunks(async () => {
+    if (aborted()) {
+      return 0;
+    }
+    const { changes } = await run(db, `
+      DELETE FROM work_entries
+      WHERE id IN (SELECT id FROM work_entries WHERE client_id = ? LIMIT ?)
+    `, [clientId, batchSize]);
+    return changes;
+  }, { pauseMs });
+
+  if (!aborted()) {
+    await run(db, 'DELETE FROM clients WHERE id = ? AND deleted_at IS NOT NULL', [clientId]);
+  }
+  return entries;
+}
+
+// Purge every deleted client, oldest deletion first
+async function purgeDeletedClients(db, options = {}) {
+  const clients = await all(db, 'SELECT id FROM clients WHERE deleted_at IS NOT NULL ORDER BY deleted_at, id');
+  let entries = 0;
+
+  for (const { id } of clients) {
+    if (options.signal && options.signal.aborted) {
+      break;
+    }
+    const removed = await purgeClient(db, id, options);
+    entries += removed;
+    const done = !(options.signal && options.signal.aborted);
+    console.log(`${done ? 'Purged' : 'Paused purging'} deleted client ${id} (${removed} work entries removed)`);
+  }
+
+  return { clients: clients.length, entries };
+}
+
+// Runs purge passes periodically, and right away when woken after a
+// delete. One pass at a time; a wake during a pass schedules another.
+class ClientPurger {
+  constructor() {
+    this.db = null;
+    this.options = {};
+    this.timer = null;
+    this.running = null;
+    this.pending = false;
+    this.controller = null;
+  }
+
+  // `db` is a connection, or a function running a callback on each
+  // database (eachDatabase in database/init.js)
+  start(db, { intervalMs = PURGE_INTERVAL_MS, ...options } = {}) {
+    this.db = db;
+    this.controller = new AbortController();
+    this.options = { ...options, signal: this.controller.signal };
+    this.timer = setInterval(() => this.wake(), intervalMs);
+    this.timer.unref();
+    // Resume anything left over from before a restart
+    this.wake();
+  }
+
+  wake() {
+    if (!this.db) {
+      return;
+    }
+    if (this.running) {
+      this.pending = true;
+      return;
+    }
+    const db = this.db;
+    const eachDatabase = typeof db === 'function' ? db : (fn) => fn(db);
+    this.running = eachDatabase((database) => purgeDeletedClients(database, this.options))
+      .catch((error) => {
+        console.error('Client purge failed:', error);
+      })
+      .finally(() => {
+        this.running = null;
+        if (this.pending) {
+          this.pending = false;
+          this.wake();
+        }
+      });
+  }
+
+  // Stop scheduling passes and interrupt the current one after its chunk;
+  // resolves once it has stopped
+  async stop() {
+    if (this.controller) {
+      this.controller.abort();
+    }
+    clearInterval(this.timer);
+    this.timer = null;
+    this.db = null;
+    this.pending = false;
+    await this.running;
+  }
+}
+
+const clientPurger = new ClientPurger();
+
+module.exports = {
+  ClientPurger,
+  clientPurger,
+  softDeleteClients,
+  getPurgeProgress,
+  purgeClient,
+  purgeDeletedClients
+};
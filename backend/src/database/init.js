@@ -1,11 +1,17 @@
 const sqlite3 = require('sqlite3').verbose();
 const path = require('path');
+const { run } = require('./query');
+const { runMigrations, runOnlineMigrations } = require('./migrate');
+const { SqliteStorage } = require('../storage/sqlite');
 
 let db = null;
 let isClosing = false;
 let isClosed = false;
 
-function getDatabase() {
+// Callers pass the user whose data they read or write; with one in-memory
+// database every user shares it (the production override routes users to
+// shard files, see database/shards.js)
+function getDatabase(userEmail) {
   if (!db) {
     // Reset state when creating a new database connection
     isClosing = false;
@@ -22,62 +28,46 @@ function getDatabase() {
   return db;
 }
 
-async function initializeDatabase() {
-  const database = getDatabase();
-  
-  return new Promise((resolve, reject) => {
-    database.serialize(() => {
-      // Create users table
-      database.run(`
-        CREATE TABLE IF NOT EXISTS users (
-          email TEXT PRIMARY KEY,
-          created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-        )
-      `);
+// Run `fn` on every database holding user data in turn, for background jobs
+async function eachDatabase(fn) {
+  return fn(getDatabase());
+}
 
-      // Create clients table
-      database.run(`
-        CREATE TABLE IF NOT EXISTS clients (
-          id INTEGER PRIMARY KEY AUTOINCREMENT,
-          name TEXT NOT NULL,
-          description TEXT,
-          department TEXT,
-          email TEXT,
-          user_email TEXT NOT NULL,
-          created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          FOREIGN KEY (user_email) REFERENCES users (email) ON DELETE CASCADE
-        )
-      `);
+// The user's database for a request using it over a while (a streamed
+// export, an import), kept open until `release()`. This build has one
+// connection, open until shutdown.
+function acquireDatabase(userEmail) {
+  return { db: getDatabase(userEmail), release: () => {} };
+}
 
-      // Create work_entries table
-      database.run(`
-        CREATE TABLE IF NOT EXISTS work_entries (
-          id INTEGER PRIMARY KEY AUTOINCREMENT,
-          client_id INTEGER NOT NULL,
-          user_email TEXT NOT NULL,
-          hours DECIMAL(5,2) NOT NULL,
-          description TEXT,
-          date DATE NOT NULL,
-          created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          FOREIGN KEY (client_id) REFERENCES clients (id) ON DELETE CASCADE,
-          FOREIGN KEY (user_email) REFERENCES users (email) ON DELETE CASCADE
-        )
-      `);
+// Shard counts for /health; this build keeps everything in one database
+function getShardStats() {
+  return null;
+}
 
-      // Create indexes for better performance
-      database.run(`CREATE INDEX IF NOT EXISTS idx_clients_user_email ON clients (user_email)`);
-      database.run(`CREATE INDEX IF NOT EXISTS idx_work_entries_client_id ON work_entries (client_id)`);
-      database.run(`CREATE INDEX IF NOT EXISTS idx_work_entries_user_email ON work_entries (user_email)`);
-      database.run(`CREATE INDEX IF NOT EXISTS idx_work_entries_date ON work_entries (date)`);
+async function initializeDatabase() {
+  const database = getDatabase();
 
-      console.log('Database tables created successfully');
-      resolve();
-    });
+  await runMigrations(database);
+  console.log('Database tables created successfully');
+
+  // Chunked backfills and index builds run in the background so startup
+  // (and the write lock) is never held for the duration of a large rewrite
+  runOnlineMigrations(database).catch((error) => {
+    console.error('Online migration failed:', error);
   });
 }
 
+// Copy the write-ahead log into the database file and truncate it, so a
+// shutdown leaves a single self-contained file. A no-op for databases not
+// in WAL mode (including in-memory ones).
+async function checkpointDatabase() {
+  if (!db || isClosing || isClosed) {
+    return;
+  }
+  await run(db, 'PRAGMA wal_checkpoint(TRUNCATE)');
+}
+
 function closeDatabase() {
   return new Promise((resolve, reject) => {
     if (isClosed) {
@@ -104,7 +94,8 @@ function closeDatabase() {
     }
     
     isClosing = true;
-    db.close((err) => {
+    // The connection only closes once its prepared statements are finalized
+    SqliteStorage.release(db).then(() => db.close((err) => {
       isClosed = true;
       isClosing = false;
       db = null;
@@ -114,12 +105,16 @@ function closeDatabase() {
         console.log('Database connection closed');
       }
       resolve();
-    });
+    }));
   });
 }
 
 module.exports = {
   getDatabase,
+  acquireDatabase,
+  eachDatabase,
+  getShardStats,
   initializeDatabase,
+  checkpointDatabase,
   closeDatabase
 };
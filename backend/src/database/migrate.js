@@ -0,0 +1,149 @@
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { run, all } = require('./query');
+
+const MIGRATIONS_DIR = path.join(__dirname, 'migrations');
+const MIGRATION_FILE_PATTERN = /^(\d+)_([\w-]+)\.js$/;
+
+// Pause between online chunks so request traffic can take the write lock
+const DEFAULT_CHUNK_PAUSE_MS = 10;
+
+function checksum(source) {
+  // Normalise line endings so a Windows checkout doesn't look like an edit
+  return crypto.createHash('sha256').update(source.replace(/\r\n/g, '\n')).digest('hex');
+}
+
+// Load migration modules in version order
+function loadMigrations(dir = MIGRATIONS_DIR) {
+  const migrations = fs.readdirSync(dir)
+    .filter((file) => MIGRATION_FILE_PATTERN.test(file))
+    .map((file) => {
+      const [, version, name] = file.match(MIGRATION_FILE_PATTERN);
+      const fullPath = path.join(dir, file);
+      const migration = require(fullPath);
+
+      if (typeof migration.up !== 'function') {
+        throw new Error(`Migration ${file} must export an up() function`);
+      }
+
+      return {
+        version: parseInt(version, 10),
+        name,
+        file,
+        checksum: checksum(fs.readFileSync(fullPath, 'utf8')),
+        up: migration.up,
+        online: migration.online
+      };
+    })
+    .sort((a, b) => a.version - b.version);
+
+  for (let i = 1; i < migrations.length; i++) {
+    if (migrations[i].version === migrations[i - 1].version) {
+      throw new Error(`Duplicate migration version ${migrations[i].version}`);
+    }
+  }
+
+  return migrations;
+}
+
+async function ensureVersionTable(db) {
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS schema_version (
+      version INTEGER PRIMARY KEY,
+      name TEXT NOT NULL,
+      checksum TEXT NOT NULL,
+      applied_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+      completed_at DATETIME
+    )
+  `);
+}
+
+// Run a chunked data rewrite. `step` performs one short statement (or a few)
+// and resolves with the number of rows it touched; we stop once it returns 0.
+// Each chunk commits on its own, so the write lock is only ever held briefly.
+async function runInChunks(step, { pauseMs = DEFAULT_CHUNK_PAUSE_MS } = {}) {
+  let total = 0;
+
+  for (;;) {
+    const changed = await step();
+    if (!changed) {
+      return total;
+    }
+    total += changed;
+    await new Promise((resolve) => setTimeout(resolve, pauseMs));
+  }
+}
+
+// Apply every pending schema migration, each in its own transaction.
+// Already-applied migrations are verified against their recorded checksum.
+async function runMigrations(db, { dir = MIGRATIONS_DIR } = {}) {
+  const migrations = loadMigrations(dir);
+  await ensureVersionTable(db);
+
+  const appliedRows = await all(db, 'SELECT version, name, checksum FROM schema_version ORDER BY version');
+  const applied = new Map(appliedRows.map((row) => [row.version, row]));
+
+  for (const row of appliedRows) {
+    const migration = migrations.find((m) => m.version === row.version);
+    if (!migration) {
+      console.warn(`Database has migration ${row.version} (${row.name}) which is not present in this build`);
+    } else if (migration.checksum !== row.checksum) {
+      throw new Error(`Migration ${migration.file} was modified after being applied (checksum mismatch)`);
+    }
+  }
+
+  const pending = migrations.filter((m) => !applied.has(m.version));
+
+  for (const migration of pending) {
+    await run(db, 'BEGIN IMMEDIATE');
+    try {
+      await migration.up(db);
+      await run(
+        db,
+        `INSERT INTO schema_version (version, name, checksum, completed_at)
+         VALUES (?, ?, ?, ${migration.online ? 'NULL' : 'CURRENT_TIMESTAMP'})`,
+        [migration.version, migration.name, migration.checksum]
+      );
+      await run(db, 'COMMIT');
+    } catch (error) {
+      await run(db, 'ROLLBACK').catch(() => {});
+      throw new Error(`Migration ${migration.file} failed: ${error.message}`);
+    }
+    console.log(`Applied migration ${migration.file}`);
+  }
+
+  return pending.map((m) => m.version);
+}
+
+// Run the online (chunked) phase of any migration that hasn't finished it.
+// This runs after the server is accepting traffic, and is safe to resume:
+// online steps must be idempotent, picking up whatever rows remain.
+async function runOnlineMigrations(db, { dir = MIGRATIONS_DIR } = {}) {
+  const migrations = loadMigrations(dir);
+  const unfinished = await all(
+    db,
+    'SELECT version FROM schema_version WHERE completed_at IS NULL ORDER BY version'
+  );
+
+  for (const { version } of unfinished) {
+    const migration = migrations.find((m) => m.version === version);
+    if (!migration || typeof migration.online !== 'function') {
+      continue;
+    }
+
+    console.log(`Running online migration ${migration.file}`);
+    await migration.online(db, { runInChunks });
+    await run(db, 'UPDATE schema_version SET completed_at = CURRENT_TIMESTAMP WHERE version = ?', [version]);
+    console.log(`Completed online migration ${migration.file}`);
+  }
+}
+
+module.exports = {
+  MIGRATIONS_DIR,
+  checksum,
+  loadMigrations,
+  runInChunks,
+  runMigrations,
+  runOnlineMigrations
+};
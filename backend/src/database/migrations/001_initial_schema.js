@@ -0,0 +1,49 @@
+const { run } = require('../query');
+
+// Baseline schema. Uses IF NOT EXISTS so databases created before the
+// migration runner existed are adopted rather than rebuilt.
+async function up(db) {
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS users (
+      email TEXT PRIMARY KEY,
+      created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    )
+  `);
+
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS clients (
+      id INTEGER PRIMARY KEY AUTOINCREMENT,
+      name TEXT NOT NULL,
+      description TEXT,
+      department TEXT,
+      email TEXT,
+      user_email TEXT NOT NULL,
+      created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+      updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+      FOREIGN KEY (user_email) REFERENCES users (email) ON DELETE CASCADE
+    )
+  `);
+
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS work_entries (
+      id INTEGER PRIMARY KEY AUTOINCREMENT,
+      client_id INTEGER NOT NULL,
+      user_email TEXT NOT NULL,
+      hours DECIMAL(5,2) NOT NULL,
+      description TEXT,
+      date DATE NOT NULL,
+      created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+      updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+      FOREIGN KEY (client_id) REFERENCES clients (id) ON DELETE CASCADE,
+      FOREIGN KEY (user_email) REFERENCES users (email) ON DELETE CASCADE
+    )
+  `);
+
+  // Create indexes for better performance
+  await run(db, 'CREATE INDEX IF NOT EXISTS idx_clients_user_email ON clients (user_email)');
+  await run(db, 'CREATE INDEX IF NOT EXISTS idx_work_entries_client_id ON work_entries (client_id)');
+  await run(db, 'CREATE INDEX IF NOT EXISTS idx_work_entries_user_email ON work_entries (user_email)');
+  await run(db, 'CREATE INDEX IF NOT EXISTS idx_work_entries_date ON work_entries (date)');
+}
+
+module.exports = { up };
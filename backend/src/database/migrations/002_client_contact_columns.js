@@ -0,0 +1,18 @@
+const { run, all } = require('../query');
+
+// The routes read and write clients.department and clients.email, but
+// databases created by the original production init never got them.
+async function up(db) {
+  const columns = await all(db, 'PRAGMA table_info(clients)');
+  const existing = new Set(columns.map((column) => column.name));
+
+  if (!existing.has('department')) {
+    await run(db, 'ALTER TABLE clients ADD COLUMN department TEXT');
+  }
+
+  if (!existing.has('email')) {
+    await run(db, 'ALTER TABLE clients ADD COLUMN email TEXT');
+  }
+}
+
+module.exports = { up };
@@ -0,0 +1,18 @@
+const { run } = require('../query');
+
+// Serve the filtered listing (user + date range, newest first) and the
+// per-client report/filter (user + client + date range) from indexes.
+// (user_email, date, created_at) also covers the old user_email index.
+//
+// SQLite builds an index in one statement and can't batch it, so this is
+// an ordinary migration: startup waits for the build, as it would for any
+// other blocking schema change.
+async function up(db) {
+  await run(db, `CREATE INDEX IF NOT EXISTS idx_work_entries_user_date
+                 ON work_entries (user_email, date, created_at)`);
+  await run(db, `CREATE INDEX IF NOT EXISTS idx_work_entries_user_client_date
+                 ON work_entries (user_email, client_id, date)`);
+  await run(db, 'DROP INDEX IF EXISTS idx_work_entries_user_email');
+}
+
+module.exports = { up };
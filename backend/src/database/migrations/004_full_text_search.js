@@ -0,0 +1,128 @@
+const { run, all } = require('../query');
+
+// Full-text indexes over work entry descriptions and client name/description.
+//
+// Each row carries an `owner` token derived from the user's email so that
+// searches intersect the user's postings inside FTS5 instead of filtering
+// every match across all tenants afterwards. Rows are keyed by the source
+// table's id (rowid) and kept in sync by triggers.
+async function up(db) {
+  await run(db, `
+    CREATE VIRTUAL TABLE IF NOT EXISTS work_entries_fts USING fts5(
+      description,
+      owner,
+      tokenize = 'porter unicode61'
+    )
+  `);
+
+  await run(db, `
+    CREATE VIRTUAL TABLE IF NOT EXISTS clients_fts USING fts5(
+      name,
+      description,
+      owner,
+      tokenize = 'porter unicode61'
+    )
+  `);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS work_entries_fts_insert AFTER INSERT ON work_entries
+    WHEN NEW.description IS NOT NULL
+    BEGIN
+      INSERT INTO work_entries_fts (rowid, description, owner)
+      VALUES (NEW.id, NEW.description, 'u' || hex(NEW.user_email));
+    END
+  `);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS work_entries_fts_update AFTER UPDATE OF description ON work_entries
+    BEGIN
+      DELETE FROM work_entries_fts WHERE rowid = OLD.id;
+      INSERT INTO work_entries_fts (rowid, description, owner)
+      SELECT NEW.id, NEW.description, 'u' || hex(NEW.user_email)
+      WHERE NEW.description IS NOT NULL;
+    END
+  `);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS work_entries_fts_delete AFTER DELETE ON work_entries
+    BEGIN
+      DELETE FROM work_entries_fts WHERE rowid = OLD.id;
+    END
+  `);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS clients_fts_insert AFTER INSERT ON clients
+    BEGIN
+      INSERT INTO clients_fts (rowid, name, description, owner)
+      VALUES (NEW.id, NEW.name, NEW.description, 'u' || hex(NEW.user_email));
+    END
+  `);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS clients_fts_update AFTER UPDATE OF name, description ON clients
+    BEGIN
+      DELETE FROM clients_fts WHERE rowid = OLD.id;
+      INSERT INTO clients_fts (rowid, name, description, owner)
+      VALUES (NEW.id, NEW.name, NEW.description, 'u' || hex(NEW.user_email));
+    END
+  `);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS clients_fts_delete AFTER DELETE ON clients
+    BEGIN
+      DELETE FROM clients_fts WHERE rowid = OLD.id;
+    END
+  `);
+}
+
+const BACKFILL_BATCH_SIZE = 1000;
+
+// Index rows that existed before the triggers, walking the id space in
+// chunks. Rows already indexed (by a trigger, or an earlier interrupted
+// run) are skipped, so this is safe to resume.
+async function backfill(db, runInChunks, { table, ftsTable, columns, where = '' }) {
+  let lastId = 0;
+
+  await runInChunks(async () => {
+    const ids = await all(
+      db,
+      `SELECT id FROM ${table} WHERE id > ? ORDER BY id LIMIT ?`,
+      [lastId, BACKFILL_BATCH_SIZE]
+    );
+    if (ids.length === 0) {
+      return 0;
+    }
+
+    const fromId = lastId;
+    lastId = ids[ids.length - 1].id;
+
+    await run(
+      db,
+      `INSERT INTO ${ftsTable} (rowid, ${columns.join(', ')}, owner)
+       SELECT t.id, ${columns.map((column) => `t.${column}`).join(', ')}, 'u' || hex(t.user_email)
+       FROM ${table} t
+       WHERE t.id > ? AND t.id <= ? ${where}
+         AND NOT EXISTS (SELECT 1 FROM ${ftsTable} f WHERE f.rowid = t.id)`,
+      [fromId, lastId]
+    );
+
+    return ids.length;
+  });
+}
+
+async function online(db, { runInChunks }) {
+  await backfill(db, runInChunks, {
+    table: 'work_entries',
+    ftsTable: 'work_entries_fts',
+    columns: ['description'],
+    where: 'AND t.description IS NOT NULL'
+  });
+
+  await backfill(db, runInChunks, {
+    table: 'clients',
+    ftsTable: 'clients_fts',
+    columns: ['name', 'description']
+  });
+}
+
+module.exports = { up, online };
@@ -0,0 +1,84 @@
+const { run } = require('../query');
+
+const ENTITY_TRIGGERS = [
+  { table: 'clients', entity: 'client' },
+  { table: 'work_entries', entity: 'work_entry' }
+];
+
+// Append-only change log for clients and work entries, so clients can sync
+// deltas. Each row records which entity changed, how, and for which user,
+// under a global AUTOINCREMENT sequence number. Rows only name the entity;
+// whether it still exists (upsert) or not (tombstone) is read from its
+// table when the changes are served. Rows are written by triggers, i.e. in
+// the same transaction as the mutation, including rows removed by ON
+// DELETE CASCADE.
+//
+// A `client_entries` row means every work entry of that client changed
+// (say, it was renamed and entries carry its name, or soft deleted in
+// 008_client_soft_delete.js). It is one row however
+// many entries the client has; readers expand it (see changeLog.js).
+async function up(db) {
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS change_log (
+      seq INTEGER PRIMARY KEY AUTOINCREMENT,
+      user_email TEXT NOT NULL,
+      entity TEXT NOT NULL CHECK (entity IN ('client', 'work_entry', 'client_entries')),
+      entity_id INTEGER NOT NULL,
+      op TEXT NOT NULL CHECK (op IN ('insert', 'update', 'delete')),
+      changed_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    )
+  `);
+
+  // "Changes since N" per user, and "newer change to the same row" for compaction
+  await run(db, `CREATE INDEX IF NOT EXISTS idx_change_log_user_entity_seq
+                 ON change_log (user_email, entity, seq)`);
+  await run(db, `CREATE INDEX IF NOT EXISTS idx_change_log_entity_seq
+                 ON change_log (entity, entity_id, seq)`);
+
+  // Oldest version a client may still sync from; anything older was compacted away
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS change_log_state (
+      id INTEGER PRIMARY KEY CHECK (id = 1),
+      compacted_through INTEGER NOT NULL DEFAULT 0
+    )
+  `);
+  await run(db, 'INSERT OR IGNORE INTO change_log_state (id, compacted_through) VALUES (1, 0)');
+
+  for (const { table, entity } of ENTITY_TRIGGERS) {
+    await run(db, `
+      CREATE TRIGGER IF NOT EXISTS ${table}_change_log_insert AFTER INSERT ON ${table}
+      BEGIN
+        INSERT INTO change_log (user_email, entity, entity_id, op)
+        VALUES (NEW.user_email, '${entity}', NEW.id, 'insert');
+      END
+    `);
+
+    await run(db, `
+      CREATE TRIGGER IF NOT EXISTS ${table}_change_log_update AFTER UPDATE ON ${table}
+      BEGIN
+        INSERT INTO change_log (user_email, entity, entity_id, op)
+        VALUES (NEW.user_email, '${entity}', NEW.id, 'update');
+      END
+    `);
+
+    await run(db, `
+      CREATE TRIGGER IF NOT EXISTS ${table}_change_log_delete AFTER DELETE ON ${table}
+      BEGIN
+        INSERT INTO change_log (user_email, entity, entity_id, op)
+        VALUES (OLD.user_email, '${entity}', OLD.id, 'delete');
+      END
+    `);
+  }
+
+  // Work entries carry their client's name, so a rename changes them too
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS clients_change_log_rename AFTER UPDATE OF name ON clients
+    WHEN NEW.name IS NOT OLD.name
+    BEGIN
+      INSERT INTO change_log (user_email, entity, entity_id, op)
+      VALUES (NEW.user_email, 'client_entries', NEW.id, 'update');
+    END
+  `);
+}
+
+module.exports = { up };
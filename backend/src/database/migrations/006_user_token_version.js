@@ -0,0 +1,12 @@
+const { run, all } = require('../query');
+
+// Refresh tokens carry the user's token_version; bumping it (on logout)
+// invalidates every refresh token issued before.
+async function up(db) {
+  const columns = await all(db, 'PRAGMA table_info(users)');
+  if (!columns.some((column) => column.name === 'token_version')) {
+    await run(db, 'ALTER TABLE users ADD COLUMN token_version INTEGER NOT NULL DEFAULT 0');
+  }
+}
+
+module.exports = { up };
@@ -0,0 +1,18 @@
+const { run } = require('../query');
+
+// Token buckets for the shared rate limit store (middleware/rateLimit.js).
+// One small row per recently active user or IP; full buckets are pruned.
+async function up(db) {
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS rate_limit_buckets (
+      key TEXT PRIMARY KEY,
+      tokens REAL NOT NULL,
+      updated_at REAL NOT NULL,
+      allowed INTEGER NOT NULL
+    ) WITHOUT ROWID
+  `);
+
+  await run(db, 'CREATE INDEX IF NOT EXISTS idx_rate_limit_buckets_updated_at ON rate_limit_buckets (updated_at)');
+}
+
+module.exports = { up };
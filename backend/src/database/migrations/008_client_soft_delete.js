@@ -0,0 +1,38 @@
+const { run, all } = require('../query');
+
+// Deleting a client marks it deleted (hidden from every query right away)
+// and leaves its work entries to a background purger that removes them in
+// small chunks (database/clientPurge.js), so deleting a client with a long
+// history doesn't hold the write lock for one huge cascade.
+//
+// purge_entries is the client's entry count when it was deleted, for
+// progress reporting.
+//
+// The entries are gone for readers as soon as the client is, so the soft
+// delete is logged as a change to all of them (one `client_entries` row,
+// see 005_change_log.js) and syncing clients get their tombstones then
+// rather than when the purger catches up.
+async function up(db) {
+  const columns = await all(db, 'PRAGMA table_info(clients)');
+  if (!columns.some((column) => column.name === 'deleted_at')) {
+    await run(db, 'ALTER TABLE clients ADD COLUMN deleted_at DATETIME');
+  }
+  if (!columns.some((column) => column.name === 'purge_entries')) {
+    await run(db, 'ALTER TABLE clients ADD COLUMN purge_entries INTEGER');
+  }
+
+  // The purger's queue; only deleted clients are indexed
+  await run(db, `CREATE INDEX IF NOT EXISTS idx_clients_deleted_at
+                 ON clients (deleted_at) WHERE deleted_at IS NOT NULL`);
+
+  await run(db, `
+    CREATE TRIGGER IF NOT EXISTS clients_change_log_soft_delete AFTER UPDATE OF deleted_at ON clients
+    WHEN OLD.deleted_at IS NULL AND NEW.deleted_at IS NOT NULL
+    BEGIN
+      INSERT INTO change_log (user_email, entity, entity_id, op)
+      VALUES (NEW.user_email, 'client_entries', NEW.id, 'delete');
+    END
+  `);
+}
+
+module.exports = { up };
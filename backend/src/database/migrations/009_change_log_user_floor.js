@@ -0,0 +1,17 @@
+const { run } = require('../query');
+
+// Oldest version each user may still sync from, on top of the global
+// compaction watermark. Change log versions are per database file, so when
+// a user is moved to another shard (database/shardRebalance.js) the versions
+// their clients hold mean nothing there; the move records a floor above any
+// of them and those clients resync from scratch.
+async function up(db) {
+  await run(db, `
+    CREATE TABLE IF NOT EXISTS change_log_user_floor (
+      user_email TEXT PRIMARY KEY,
+      version INTEGER NOT NULL
+    )
+  `);
+}
+
+module.exports = { up };
@@ -0,0 +1,44 @@
+// Promise wrappers around the callback-style sqlite3 API.
+// Routes mostly use the callbacks directly; these are for code that needs
+// to sequence several statements (migrations, background jobs, multi-step
+// reads).
+
+function run(db, sql, params = []) {
+  return new Promise((resolve, reject) => {
+    db.run(sql, params, function(err) {
+      if (err) {
+        return reject(err);
+      }
+      // `this` is the sqlite3 Statement when called by the real driver
+      resolve({ lastID: this && this.lastID, changes: (this && this.changes) || 0 });
+    });
+  });
+}
+
+function get(db, sql, params = []) {
+  return new Promise((resolve, reject) => {
+    db.get(sql, params, (err, row) => {
+      if (err) {
+        return reject(err);
+      }
+      resolve(row);
+    });
+  });
+}
+
+function all(db, sql, params = []) {
+  return new Promise((resolve, reject) => {
+    db.all(sql, params, (err, rows) => {
+      if (err) {
+        return reject(err);
+      }
+      resolve(rows || []);
+    });
+  });
+}
+
+module.exports = {
+  run,
+  get,
+  all
+};
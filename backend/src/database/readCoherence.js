@@ -0,0 +1,29 @@
+const { readFlights } = require('./singleFlight');
+const { workEntryCache } = require('./workEntryCache');
+
+// Besides the database, this process answers reads from queries already in
+// flight (singleFlight.js) and from its cached window of recent work
+// entries (workEntryCache.js). The data layer reports each user's writes
+// here once they commit, before anyone is told of them, so no later read is
+// answered from before the write.
+
+// One row changed. `change` is as published to the user's tabs (see
+// publishChange in realtime/changeEvents.js):
+//   { entity: 'work_entry' | 'client', op: 'upsert', row }
+//   { entity: 'work_entry' | 'client', op: 'delete', id }
+//   { entity: 'client', op: 'clear' }
+function noteChange(userEmail, change) {
+  readFlights.invalidate(userEmail);
+  workEntryCache.apply(userEmail, change);
+}
+
+// Too many rows changed to follow one by one (an import batch)
+function noteBulkChange(userEmail) {
+  readFlights.invalidate(userEmail);
+  workEntryCache.drop(userEmail);
+}
+
+module.exports = {
+  noteChange,
+  noteBulkChange
+};
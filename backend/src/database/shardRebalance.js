@@ -0,0 +1,174 @@
+const { run, get, all } = require('./query');
+
+// Moves users between shards (database/shards.js), and out of the main
+// database when sharding is first turned on. Run it with the server
+// stopped: the server reads the shard directory only at startup, and
+// writes made to a user mid-move would be lost.
+//
+// A move copies the user into the target shard in one transaction, points
+// the directory at the target, then deletes the source copy. If it is
+// interrupted, the copy the directory points at is the real one and the
+// next plan drops the other.
+
+const MAIN = 'main';
+
+// Row ids are per file, so the target assigns new ones. Work entries follow
+// their client's new id.
+async function insertRow(db, table, row) {
+  const columns = Object.keys(row);
+  return run(
+    db,
+    `INSERT INTO ${table} (${columns.join(', ')}) VALUES (${columns.map(() => '?').join(', ')})`,
+    columns.map((column) => row[column])
+  );
+}
+
+async function changeLogVersion(db) {
+  const row = await get(db, "SELECT seq FROM sqlite_sequence WHERE name = 'change_log'");
+  return (row && row.seq) || 0;
+}
+
+// Raise the target's change log sequence to at least `version`
+async function raiseChangeLogVersion(db, version) {
+  const { changes } = await run(db, "UPDATE sqlite_sequence SET seq = ? WHERE name = 'change_log' AND seq < ?", [version, version]);
+  if (changes === 0 && !(await get(db, "SELECT 1 AS present FROM sqlite_sequence WHERE name = 'change_log'"))) {
+    await run(db, "INSERT INTO sqlite_sequence (name, seq) VALUES ('change_log', ?)", [version]);
+  }
+}
+
+// Copy a user's rows from `source` into `target`. The versions their clients
+// hold come from the source's change log; the target's is first raised past
+// all of them, and its floor for the user set above that, so those clients
+// resync rather than read unrelated changes.
+async function copyUser(source, target, email) {
+  const user = await get(source, 'SELECT * FROM users WHERE email = ?', [email]);
+  if (!user) {
+    throw new Error(`${email} is not on the source shard`);
+  }
+  const clients = await all(source, 'SELECT * FROM clients WHERE user_email = ? ORDER BY id', [email]);
+  const entries = await all(source, 'SELECT * FROM work_entries WHERE user_email = ? ORDER BY id', [email]);
+  const sourceVersion = await changeLogVersion(source);
+
+  await run(target, 'BEGIN IMMEDIATE');
+  try {
+    if (await get(target, 'SELECT 1 AS present FROM users WHERE email = ?', [email])) {
+      throw new Error(`${email} is already on the target shard`);
+    }
+    await raiseChangeLogVersion(target, sourceVersion);
+    await insertRow(target, 'users', user);
+
+    const clientIds = new Map();
+    for (const { id, ...client } of clients) {
+      const { lastID } = await insertRow(target, 'clients', client);
+      clientIds.set(id, lastID);
+    }
+    for (const { id, ...entry } of entries) {
+      await insertRow(target, 'work_entries', { ...entry, client_id: clientIds.get(entry.client_id) });
+    }
+
+    await run(target, `INSERT OR REPLACE INTO change_log_user_floor (user_email, version)
+                       VALUES (?, (SELECT seq FROM sqlite_sequence WHERE name = 'change_log'))`, [email]);
+    await run(target, 'COMMIT');
+  } catch (err) {
+    await run(target, 'ROLLBACK');
+    throw err;
+  }
+
+  return { clients: clients.length, entries: entries.length };
+}
+
+// Delete a user's rows, including their change log, from one shard
+async function removeUser(db, email) {
+  await run(db, 'BEGIN IMMEDIATE');
+  try {
+    await run(db, 'DELETE FROM work_entries WHERE user_email = ?', [email]);
+    await run(db, 'DELETE FROM clients WHERE user_email = ?', [email]);
+    await run(db, 'DELETE FROM users WHERE email = ?', [email]);
+    await run(db, 'DELETE FROM change_log WHERE user_email = ?', [email]);
+    await run(db, 'DELETE FROM change_log_user_floor WHERE user_email = ?', [email]);
+    await run(db, 'COMMIT');
+  } catch (err) {
+    await run(db, 'ROLLBACK');
+    throw err;
+  }
+}
+
+// Where each user's rows are: shard name (or MAIN) per email
+async function locateUsers(router) {
+  const locations = new Map();
+  const add = (name) => (rows) => rows.forEach(({ email }) => {
+    locations.set(email, [...(locations.get(email) || []), name]);
+  });
+
+  add(MAIN)(await all(router.main, 'SELECT email FROM users ORDER BY email'));
+  const names = [...new Set([...router.existingShards(), ...router.shardNames()])];
+  await router.each(async (db, name) => {
+    add(name)(await all(db, 'SELECT email FROM users ORDER BY email'));
+  }, names);
+
+  return locations;
+}
+
+// The steps that put every user where the router sends them: `move` a
+// user found only elsewhere, `drop` a copy left behind by an interrupted
+// move. A user with several copies and none on their shard is reported as
+// a `conflict` and left alone.
+async function planRebalance(router) {
+  const plan = [];
+  const locations = await locateUsers(router);
+
+  for (const [email, shards] of locations) {
+    const target = router.shardFor(email);
+    const elsewhere = shards.filter((name) => name !== target);
+    if (elsewhere.length === shards.length && elsewhere.length > 1) {
+      plan.push({ action: 'conflict', email, shards });
+    } else if (elsewhere.length === shards.length) {
+      plan.push({ action: 'move', email, from: elsewhere[0], to: target });
+    } else {
+      elsewhere.forEach((from) => plan.push({ action: 'drop', email, from }));
+    }
+  }
+
+  return plan;
+}
+
+// Moving one user to a named shard, e.g. giving a large tenant its own
+async function planMove(router, email, to) {
+  const shards = (await locateUsers(router)).get(email) || [];
+  const from = router.shardFor(email);
+  if (!shards.includes(from)) {
+    throw new Error(`${email} is not on ${from}; run a full rebalance first`);
+  }
+  return from === to ? [] : [{ action: 'move', email, from, to }];
+}
+
+// Carry out a plan. `prepare` (migrations) runs once on each target shard
+// first, as a target may be a new file.
+async function applyRebalance(router, plan, { prepare, log = () => {} }) {
+  const connection = (name) => (name === MAIN ? router.main : router.connect(name));
+  const targets = [...new Set(plan.filter((step) => step.action === 'move').map((step) => step.to))];
+  await router.each(prepare, targets);
+
+  for (const step of plan) {
+    if (step.action === 'move') {
+      const copied = await copyUser(connection(step.from), connection(step.to), step.email);
+      await router.assign(step.email, step.to);
+      await removeUser(connection(step.from), step.email);
+      log(`Moved ${step.email} from ${step.from} to ${step.to} (${copied.clients} clients, ${copied.entries} work entries)`);
+    } else if (step.action === 'drop') {
+      await removeUser(connection(step.from), step.email);
+      log(`Dropped stale copy of ${step.email} from ${step.from}`);
+    } else {
+      log(`Skipped ${step.email}: found on ${step.shards.join(', ')}, none of them its shard`);
+    }
+  }
+}
+
+module.exports = {
+  MAIN,
+  copyUser,
+  removeUser,
+  planRebalance,
+  planMove,
+  applyRebalance
+};
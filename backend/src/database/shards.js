@@ -0,0 +1,257 @@
+const fs = require('fs');
+const path = require('path');
+const { run, all } = require('./query');
+
+// Routes each user to one of several SQLite files ("shards") next to
+// DATABASE_PATH, so tenants stop sharing one write lock. A user lives on the
+// shard their email hashes to, unless the shard directory pins them
+// elsewhere: a shard of their own for a large tenant, or wherever the
+// rebalance tool moved them (database/shardRebalance.js). The directory is a
+// table in the main database, which also keeps what isn't per user (rate
+// limit buckets), and is read once at startup.
+//
+// Shard connections are opened on first use and closed once idle, so a cold
+// shard costs nothing but its file. A connection held by `each` (a
+// background job) or `acquire` (a long request, such as an export) is
+// never closed under it, and one whose close fails is
+// kept until a later sweep closes it.
+
+const SHARD_NAME = /^[a-z0-9][a-z0-9_-]*$/;
+const DEFAULT_IDLE_MS = 5 * 60 * 1000;
+
+// 32-bit FNV-1a: stable across processes and Node versions, so a user
+// always hashes to the same shard for a given count
+function hashEmail(email) {
+  let hash = 0x811c9dc5;
+  const bytes = Buffer.from(email, 'utf8');
+  for (let i = 0; i < bytes.length; i++) {
+    hash ^= bytes[i];
+    hash = Math.imul(hash, 0x01000193) >>> 0;
+  }
+  return hash;
+}
+
+function hashShard(email, count) {
+  return `shard-${hashEmail(email) % count}`;
+}
+
+// /data/timesheet.db -> /data/timesheet.shard-3.db
+function shardFile(basePath, name) {
+  const ext = path.extname(basePath);
+  return `${basePath.slice(0, basePath.length - ext.length)}.${name}${ext}`;
+}
+
+function validateShardName(name) {
+  if (!SHARD_NAME.test(name)) {
+    throw new Error(`Invalid shard name: ${name}`);
+  }
+  return name;
+}
+
+function closeConnection(db) {
+  return new Promise((resolve, reject) => {
+    db.close((err) => (err ? reject(err) : resolve()));
+  });
+}
+
+class ShardRouter {
+  // `open(file)` returns a new connection for a shard file; `release(db)`
+  // runs before one is closed, to finalize what's prepared on it
+  constructor({ path: basePath, count, open, release = async () => {}, idleMs = DEFAULT_IDLE_MS, now = Date.now }) {
+    if (!Number.isInteger(count) || count < 1) {
+      throw new Error(`Invalid shard count: ${count}`);
+    }
+    this.basePath = basePath;
+    this.count = count;
+    this.open = open;
+    this.release = release;
+    this.idleMs = idleMs;
+    this.now = now;
+    this.main = null;
+    this.directory = new Map();
+    this.connections = new Map();
+    // Connections taken out of `connections` whose close hasn't succeeded
+    // yet; a shard may have been reopened meanwhile
+    this.closing = new Set();
+    this.timer = null;
+    this.opened = 0;
+    this.closed = 0;
+  }
+
+  // Load the directory from `main`, run `prepare` (migrations) on every
+  // shard, and start closing idle connections
+  async initialize(main, prepare) {
+    this.main = main;
+    await run(main, `
+      CREATE TABLE IF NOT EXISTS shard_directory (
+        user_email TEXT PRIMARY KEY,
+        shard TEXT NOT NULL
+      )
+    `);
+    const rows = await all(main, 'SELECT user_email, shard FROM shard_directory');
+    this.directory = new Map(rows.map((row) => [row.user_email, row.shard]));
+
+    await this.each(prepare);
+
+    this.timer = setInterval(() => {
+      this.sweep().catch((error) => console.error('Shard sweep failed:', error));
+    }, Math.max(1000, this.idleMs / 2));
+    this.timer.unref();
+  }
+
+  // The hash shards plus any shard named in the directory
+  shardNames() {
+    const names = new Set(Array.from({ length: this.count }, (_, index) => `shard-${index}`));
+    this.directory.forEach((name) => names.add(name));
+    return [...names];
+  }
+
+  // Shard files on disk, including ones nothing routes to any more (e.g.
+  // after lowering the count)
+  existingShards() {
+    const ext = path.extname(this.basePath);
+    const prefix = `${path.basename(this.basePath, ext)}.`;
+    const dir = path.dirname(this.basePath);
+    if (!fs.existsSync(dir)) {
+      return [];
+    }
+    return fs.readdirSync(dir)
+      .filter((file) => file.startsWith(prefix) && file.endsWith(ext) && file.length > prefix.length + ext.length)
+      .map((file) => file.slice(prefix.length, file.length - ext.length))
+      .filter((name) => SHARD_NAME.test(name))
+      .sort();
+  }
+
+  shardFor(email) {
+    return this.directory.get(email) || hashShard(email, this.count);
+  }
+
+  database(email) {
+    return this.connect(this.shardFor(email));
+  }
+
+  connect(name) {
+    let connection = this.connections.get(name);
+    if (!connection) {
+      connection = { name, db: this.open(shardFile(this.basePath, validateShardName(name))), usedAt: 0, holds: 0 };
+      this.connections.set(name, connection);
+      this.opened += 1;
+    }
+    connection.usedAt = this.now();
+    return connection.db;
+  }
+
+  // The shard's connection, kept open until `release()` is called
+  hold(name) {
+    const db = this.connect(name);
+    const connection = this.connections.get(name);
+    connection.holds += 1;
+    let held = true;
+    const release = () => {
+      if (held) {
+        held = false;
+        connection.holds -= 1;
+        connection.usedAt = this.now();
+      }
+    };
+    return { db, release };
+  }
+
+  // The user's shard, held for a request that uses it over a while
+  acquire(email) {
+    return this.hold(this.shardFor(email));
+  }
+
+  // Run `fn` on every shard in turn, keeping each open while it runs
+  async each(fn, names = this.shardNames()) {
+    for (const name of names) {
+      const { db, release } = this.hold(name);
+      try {
+        await fn(db, name);
+      } finally {
+        release();
+      }
+    }
+  }
+
+  openDatabases() {
+    return [...this.connections.values()].map((connection) => connection.db);
+  }
+
+  // Pin a user to a shard, or with null return them to their hash shard
+  async assign(email, shard) {
+    if (shard === null || shard === hashShard(email, this.count)) {
+      await run(this.main, 'DELETE FROM shard_directory WHERE user_email = ?', [email]);
+      this.directory.delete(email);
+      return;
+    }
+    validateShardName(shard);
+    await run(this.main, 'INSERT OR REPLACE INTO shard_directory (user_email, shard) VALUES (?, ?)', [email, shard]);
+    this.directory.set(email, shard);
+  }
+
+  // Close connections unused for idleMs, and retry those that failed to
+  // close before. One that can't close yet (say, a statement is still
+  // running on it) goes back into use if its shard hasn't been reopened
+  // meanwhile, and is otherwise retried on the next sweep.
+  async sweep() {
+    const cutoff = this.now() - this.idleMs;
+    this.connections.forEach((connection, name) => {
+      if (connection.holds === 0 && connection.usedAt <= cutoff) {
+        this.connections.delete(name);
+        this.closing.add(connection);
+      }
+    });
+
+    const pending = [...this.closing].filter((connection) => !connection.closing);
+    await Promise.all(pending.map(async (connection) => {
+      connection.closing = true;
+      try {
+        await this.release(connection.db);
+        await closeConnection(connection.db);
+        this.closing.delete(connection);
+        this.closed += 1;
+      } catch (error) {
+        console.error(`Error closing shard ${connection.name}:`, error);
+        if (!this.connections.has(connection.name)) {
+          this.closing.delete(connection);
+          this.connections.set(connection.name, connection);
+        }
+      } finally {
+        connection.closing = false;
+      }
+    }));
+  }
+
+  stats() {
+    return {
+      shards: this.count,
+      pinned: this.directory.size,
+      open: this.connections.size,
+      closing: this.closing.size,
+      opened: this.opened,
+      closed: this.closed
+    };
+  }
+
+  async close() {
+    clearInterval(this.timer);
+    this.timer = null;
+    // Those a sweep is closing right now are left to it
+    const connections = [...this.connections.values(), ...[...this.closing].filter((connection) => !connection.closing)];
+    this.connections.clear();
+    this.closing.clear();
+    await Promise.all(connections.map((connection) => this.release(connection.db)
+      .then(() => closeConnection(connection.db))
+      .catch((error) => {
+        console.error('Error closing shard:', error);
+      })));
+  }
+}
+
+module.exports = {
+  ShardRouter,
+  hashEmail,
+  hashShard,
+  shardFile
+};
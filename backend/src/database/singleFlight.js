@@ -0,0 +1,80 @@
+// Single-flight for read queries: while a query is running, identical
+// requests (same user, SQL and parameters) wait for it instead of running
+// their own, and all get its result. A burst of tabs or users opening the
+// same report, or every client refetching after a deploy, costs one scan.
+//
+// Results are shared between the callers, who must not modify them.
+//
+// A caller never gets a result older than its own request's writes: once a
+// user's data changes (see invalidate), their later reads start a new query
+// rather than joining one that may have started before the change.
+
+class SingleFlight {
+  constructor() {
+    // userEmail -> (key -> callbacks waiting for that query)
+    this.flights = new Map();
+    this.executed = 0;
+    this.coalesced = 0;
+  }
+
+  // Call `start(done)` to run the query unless an identical one is in
+  // flight; `callback(err, result)` gets the result either way
+  run(userEmail, key, start, callback) {
+    let userFlights = this.flights.get(userEmail);
+    const waiting = userFlights && userFlights.get(key);
+    if (waiting) {
+      this.coalesced += 1;
+      waiting.push(callback);
+      return;
+    }
+
+    if (!userFlights) {
+      userFlights = new Map();
+      this.flights.set(userEmail, userFlights);
+    }
+    const callbacks = [callback];
+    userFlights.set(key, callbacks);
+    this.executed += 1;
+
+    start((err, result) => {
+      // Unless invalidated meanwhile (a newer flight may hold the key now)
+      if (userFlights.get(key) === callbacks) {
+        userFlights.delete(key);
+        if (userFlights.size === 0 && this.flights.get(userEmail) === userFlights) {
+          this.flights.delete(userEmail);
+        }
+      }
+      callbacks.forEach((waiter) => waiter(err, result));
+    });
+  }
+
+  // db.all / db.get with the sqlite3 callback signature, coalesced
+  all(db, userEmail, sql, params, callback) {
+    this.run(userEmail, `all:${sql}:${JSON.stringify(params)}`, (done) => db.all(sql, params, done), callback);
+  }
+
+  get(db, userEmail, sql, params, callback) {
+    this.run(userEmail, `get:${sql}:${JSON.stringify(params)}`, (done) => db.get(sql, params, done), callback);
+  }
+
+  // The user's data changed: queries already running still answer their
+  // callers, but new reads don't join them
+  invalidate(userEmail) {
+    this.flights.delete(userEmail);
+  }
+
+  stats() {
+    let inFlight = 0;
+    this.flights.forEach((userFlights) => {
+      inFlight += userFlights.size;
+    });
+    return { executed: this.executed, coalesced: this.coalesced, inFlight };
+  }
+}
+
+const readFlights = new SingleFlight();
+
+module.exports = {
+  SingleFlight,
+  readFlights
+};
@@ -0,0 +1,523 @@
+const cluster = require('cluster');
+const { all } = require('./query');
+
+// Opt-in, per-process cache of each active user's recent work entries
+// (WORK_ENTRY_CACHE_MB; off when unset). Most reads are of the last few
+// weeks, so a user's entries dated from WORK_ENTRY_CACHE_DAYS ago onwards
+// are loaded the first time a read needs them, and list, report and
+// summary queries whose range starts inside that window are answered from
+// memory.
+//
+// A user's window is held as columns, sorted like the work entry list
+// (date, created_at, id, newest first): ids, dates, hours in hundredths
+// and client ids in typed arrays, descriptions and timestamps as indexes
+// into a string pool. Writes keep it current through apply() and drop(),
+// which the data layer calls for every change as it commits (see
+// database/readCoherence.js); a load that overlaps a change is discarded
+// rather than cached. Users are evicted least recently used first to keep the
+// whole cache within its memory budget.
+//
+// A user whose window can't be represented exactly (dates stored as
+// strings, hours with more than two decimals, ids over 2^32) or doesn't
+// fit in the budget on its own is read from the database as usual.
+//
+// Only this process's own writes reach apply(), so the cache is only
+// coherent while one process serves the database. It stays off in a
+// cluster worker, whatever WORK_ENTRY_CACHE_MB says.
+
+const DAY_MS = 24 * 60 * 60 * 1000;
+const DEFAULT_WINDOW_DAYS = 42;
+const INITIAL_CAPACITY = 64;
+// id, client id (Uint32), date (Float64), hundredths and three string
+// references (Int32)
+const ENTRY_BYTES = 4 + 4 + 8 + 4 + 3 * 4;
+const STRING_BYTES = 48;
+const CLIENT_BYTES = 96;
+const MAX_ID = 0xffffffff;
+
+const isId = (value) => Number.isInteger(value) && value > 0 && value <= MAX_ID;
+
+// Hours as exact hundredths, or null when they have more precision
+function toHundredths(hours) {
+  const hundredths = Math.round(hours * 100);
+  return Number.isFinite(hours) && hundredths / 100 === hours && Math.abs(hundredths) <= 0x7fffffff ? hundredths : null;
+}
+
+// Text in descending order, as SQLite sorts it: NULL last
+function compareText(a, b) {
+  if (a === b) {
+    return 0;
+  }
+  if (a === null) {
+    return 1;
+  }
+  if (b === null) {
+    return -1;
+  }
+  return a > b ? -1 : 1;
+}
+
+// One user's cached window: entries dated `from` (epoch milliseconds) or
+// later, and their clients (id -> name, every client not deleted)
+class Segment {
+  constructor(from, clients) {
+    this.from = from;
+    this.clients = clients;
+    this.length = 0;
+    this.strings = [];
+    this.stringIds = new Map();
+    this.stringBytes = 0;
+    this.allocate(INITIAL_CAPACITY);
+  }
+
+  allocate(capacity) {
+    const resize = (Type, column) => {
+      const next = new Type(capacity);
+      if (column) {
+        next.set(column.subarray(0, this.length));
+      }
+      return next;
+    };
+    this.ids = resize(Uint32Array, this.ids);
+    this.clientIds = resize(Uint32Array, this.clientIds);
+    this.dates = resize(Float64Array, this.dates);
+    this.hundredths = resize(Int32Array, this.hundredths);
+    this.descriptions = resize(Int32Array, this.descriptions);
+    this.createdAt = resize(Int32Array, this.createdAt);
+    this.updatedAt = resize(Int32Array, this.updatedAt);
+  }
+
+  get columns() {
+    return [this.ids, this.clientIds, this.dates, this.hundredths, this.descriptions, this.createdAt, this.updatedAt];
+  }
+
+  // Approximate memory held
+  get bytes() {
+    let clientBytes = 0;
+    this.clients.forEach((name) => {
+      clientBytes += CLIENT_BYTES + 2 * name.length;
+    });
+    return this.ids.length * ENTRY_BYTES + this.stringBytes + clientBytes;
+  }
+
+  intern(value) {
+    if (typeof value !== 'string') {
+      return -1;
+    }
+    let id = this.stringIds.get(value);
+    if (id === undefined) {
+      id = this.strings.length;
+      this.strings.push(value);
+      this.stringIds.set(value, id);
+      this.stringBytes += STRING_BYTES + 2 * value.length;
+    }
+    return id;
+  }
+
+  text(id) {
+    return id < 0 ? null : this.strings[id];
+  }
+
+  // Rebuild the string pool from the strings still referenced
+  compact() {
+    const strings = this.strings;
+    this.strings = [];
+    this.stringIds = new Map();
+    this.stringBytes = 0;
+    [this.descriptions, this.createdAt, this.updatedAt].forEach((refs) => {
+      for (let i = 0; i < this.length; i++) {
+        refs[i] = this.intern(strings[refs[i]]);
+      }
+    });
+  }
+
+  // Negative when entry `i` comes before the key in list order
+  compareAt(i, date, createdAt, id) {
+    if (this.dates[i] !== date) {
+      return date - this.dates[i];
+    }
+    return compareText(this.text(this.createdAt[i]), createdAt) || id - this.ids[i];
+  }
+
+  // Index of the first entry after the key
+  after(date, createdAt, id) {
+    let low = 0;
+    let high = this.length;
+    while (low < high) {
+      const middle = (low + high) >>> 1;
+      if (this.compareAt(middle, date, createdAt, id) <= 0) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return low;
+  }
+
+  // Index of the first entry dated `date` or earlier
+  datedBy(date) {
+    let low = 0;
+    let high = this.length;
+    while (low < high) {
+      const middle = (low + high) >>> 1;
+      if (this.dates[middle] > date) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return low;
+  }
+
+  // Add a work entry row; false if it can't be held exactly
+  insert(row) {
+    const hundredths = toHundredths(row.hours);
+    if (!isId(row.id) || !isId(row.client_id) || typeof row.date !== 'number' || hundredths === null) {
+      return false;
+    }
+    const createdAt = typeof row.created_at === 'string' ? row.created_at : null;
+    const index = this.after(row.date, createdAt, row.id);
+    if (this.length === this.ids.length) {
+      this.allocate(this.ids.length * 2);
+    }
+    if (index < this.length) {
+      this.columns.forEach((column) => column.copyWithin(index + 1, index, this.length));
+    }
+    this.ids[index] = row.id;
+    this.clientIds[index] = row.client_id;
+    this.dates[index] = row.date;
+    this.hundredths[index] = hundredths;
+    this.descriptions[index] = this.intern(row.description);
+    this.createdAt[index] = this.intern(createdAt);
+    this.updatedAt[index] = this.intern(row.updated_at);
+    this.length += 1;
+    return true;
+  }
+
+  remove(id) {
+    const index = this.ids.subarray(0, this.length).indexOf(id);
+    if (index < 0) {
+      return;
+    }
+    this.columns.forEach((column) => column.copyWithin(index, index + 1, this.length));
+    this.length -= 1;
+    this.compactIfSparse();
+  }
+
+  removeClient(clientId) {
+    let kept = 0;
+    for (let i = 0; i < this.length; i++) {
+      if (this.clientIds[i] !== clientId) {
+        this.columns.forEach((column) => {
+          column[kept] = column[i];
+        });
+        kept += 1;
+      }
+    }
+    this.length = kept;
+    this.compactIfSparse();
+  }
+
+  // Updates and deletes leave strings behind in the pool
+  compactIfSparse() {
+    if (this.strings.length > 6 * this.length + 256) {
+      this.compact();
+    }
+  }
+
+  row(i) {
+    return {
+      id: this.ids[i],
+      client_id: this.clientIds[i],
+      hours: this.hundredths[i] / 100,
+      description: this.text(this.descriptions[i]),
+      date: this.dates[i],
+      created_at: this.text(this.createdAt[i]),
+      updated_at: this.text(this.updatedAt[i]),
+      client_name: this.clients.get(this.clientIds[i])
+    };
+  }
+
+  // Visit the indexes of entries dated in [from, to] in list order, from
+  // `start`, while `visit` returns true
+  scan(from, to, start, visit) {
+    const first = Math.max(start, to === undefined ? 0 : this.datedBy(Number(to)));
+    const floor = from === undefined ? -Infinity : Number(from);
+    for (let i = first; i < this.length && this.dates[i] >= floor; i++) {
+      if (!visit(i)) {
+        return;
+      }
+    }
+  }
+
+  // Work entry rows as GET /api/work-entries lists them: filtered like its
+  // query, after the `cursor` key ([date, created_at, id]) and at most
+  // `limit` + 1 of them. Null when the cursor can't be compared here.
+  list({ clientId, clientIds, from, to, minHours, maxHours, cursor, limit }) {
+    let start = 0;
+    if (cursor) {
+      const [date, createdAt, id] = cursor;
+      if (typeof date !== 'number' || typeof createdAt !== 'string' || typeof id !== 'number') {
+        return null;
+      }
+      start = this.after(date, createdAt, id);
+    }
+    const wanted = limit === undefined ? Infinity : limit + 1;
+    const inClients = clientIds && clientIds.length > 0 ? new Set(clientIds) : null;
+    const rows = [];
+    this.scan(from, to, start, (i) => {
+      const hours = this.hundredths[i] / 100;
+      if ((clientId === undefined || this.clientIds[i] === clientId)
+          && (!inClients || inClients.has(this.clientIds[i]))
+          && (minHours === undefined || hours >= minHours)
+          && (maxHours === undefined || hours <= maxHours)) {
+        rows.push(this.row(i));
+      }
+      return rows.length < wanted;
+    });
+    return rows;
+  }
+
+  // Entries dated in [from, to] as columns per client: client id ->
+  // { days (since the epoch), hundredths }
+  collect({ from, to }) {
+    const counts = new Map();
+    this.scan(from, to, 0, (i) => {
+      counts.set(this.clientIds[i], (counts.get(this.clientIds[i]) || 0) + 1);
+      return true;
+    });
+    const columns = new Map();
+    counts.forEach((count, clientId) => {
+      columns.set(clientId, { days: new Int32Array(count), hundredths: new Int32Array(count), length: 0 });
+    });
+    this.scan(from, to, 0, (i) => {
+      const client = columns.get(this.clientIds[i]);
+      client.days[client.length] = Math.floor(this.dates[i] / DAY_MS);
+      client.hundredths[client.length] = this.hundredths[i];
+      client.length += 1;
+      return true;
+    });
+    return columns;
+  }
+}
+
+class WorkEntryCache {
+  constructor({
+    budgetBytes = (Number(process.env.WORK_ENTRY_CACHE_MB) || 0) * 1024 * 1024,
+    windowDays = Number(process.env.WORK_ENTRY_CACHE_DAYS) || DEFAULT_WINDOW_DAYS,
+    now = Date.now
+  } = {}) {
+    this.budgetBytes = budgetBytes;
+    this.windowDays = windowDays;
+    this.now = now;
+    // userEmail -> Segment, least recently used first
+    this.segments = new Map();
+    // userEmail -> { stale, waiters } while the window loads
+    this.loads = new Map();
+    // Users whose window isn't cached until their data is next resynced
+    this.skipped = new Set();
+    this.bytes = 0;
+    this.hits = 0;
+    this.misses = 0;
+    this.evictions = 0;
+  }
+
+  get enabled() {
+    return this.budgetBytes > 0;
+  }
+
+  // Start (epoch milliseconds, midnight UTC) of the window loaded now
+  windowStart() {
+    return (Math.floor(this.now() / DAY_MS) - this.windowDays) * DAY_MS;
+  }
+
+  // `callback(err, segment)` with the user's cached window if it holds
+  // everything dated `from` or later, or null to read the database. The
+  // first read of a user within the window loads it.
+  window(db, userEmail, from, callback) {
+    if (!this.enabled || from === undefined) {
+      return callback(null, null);
+    }
+    const start = Number(from);
+    const segment = this.segments.get(userEmail);
+    if (segment || start < this.windowStart() || this.skipped.has(userEmail)) {
+      if (segment && start >= segment.from) {
+        this.segments.delete(userEmail);
+        this.segments.set(userEmail, segment);
+        this.hits += 1;
+        return callback(null, segment);
+      }
+      this.misses += 1;
+      return callback(null, null);
+    }
+
+    let load = this.loads.get(userEmail);
+    if (!load) {
+      load = { stale: false, waiters: [] };
+      this.loads.set(userEmail, load);
+      this.load(db, userEmail, load);
+    }
+    load.waiters.push({ start, callback });
+  }
+
+  load(db, userEmail, load) {
+    const from = this.windowStart();
+    Promise.all([
+      all(db, 'SELECT id, name FROM clients WHERE user_email = ? AND deleted_at IS NULL', [userEmail]),
+      all(db, `
+        SELECT we.id, we.client_id, we.hours, we.description, we.date, we.created_at, we.updated_at
+        FROM work_entries we
+        JOIN clients c ON we.client_id = c.id
+        WHERE we.user_email = ? AND c.deleted_at IS NULL AND we.date >= ?
+        ORDER BY we.date DESC, we.created_at DESC, we.id DESC
+      `, [userEmail, from])
+    ]).then(([clients, rows]) => {
+      // Changed while loading: the rows may predate the change
+      if (load.stale) {
+        return null;
+      }
+      const segment = new Segment(from, new Map(clients.map((client) => [client.id, client.name])));
+      if (!rows.every((row) => segment.insert(row))) {
+        this.skipped.add(userEmail);
+        return null;
+      }
+      this.segments.set(userEmail, segment);
+      this.account(userEmail, segment);
+      return this.segments.get(userEmail) || null;
+    }).catch((err) => {
+      console.error('Work entry cache load failed:', err);
+      return null;
+    }).then((segment) => {
+      if (this.loads.get(userEmail) === load) {
+        this.loads.delete(userEmail);
+      }
+      load.waiters.forEach(({ start, callback }) => {
+        const hit = Boolean(segment) && start >= segment.from;
+        if (hit) {
+          this.hits += 1;
+        } else {
+          this.misses += 1;
+        }
+        callback(null, hit ? segment : null);
+      });
+    });
+  }
+
+  // Record a segment's new size, then evict other users, least recently
+  // used first, until the cache is within budget. A segment over the
+  // budget on its own is dropped.
+  account(userEmail, segment) {
+    const bytes = segment.bytes;
+    this.bytes += bytes - (segment.accounted || 0);
+    segment.accounted = bytes;
+
+    if (bytes > this.budgetBytes) {
+      this.remove(userEmail);
+      this.skipped.add(userEmail);
+      return;
+    }
+    for (const user of this.segments.keys()) {
+      if (this.bytes <= this.budgetBytes) {
+        break;
+      }
+      if (user !== userEmail) {
+        this.remove(user);
+        this.evictions += 1;
+      }
+    }
+  }
+
+  remove(userEmail) {
+    const segment = this.segments.get(userEmail);
+    if (segment) {
+      this.bytes -= segment.accounted;
+      this.segments.delete(userEmail);
+    }
+  }
+
+  // Keep the user's window in step with a change (see
+  // database/readCoherence.js)
+  apply(userEmail, change) {
+    const load = this.loads.get(userEmail);
+    if (load) {
+      load.stale = true;
+    }
+    const segment = this.segments.get(userEmail);
+    if (!segment) {
+      return;
+    }
+
+    if (change.entity === 'work_entry' && change.op === 'upsert') {
+      const { row } = change;
+      segment.remove(row.id);
+      if (row.client_name !== undefined) {
+        segment.clients.set(row.client_id, row.client_name);
+      }
+      if (row.date >= segment.from && !segment.insert(row)) {
+        return this.remove(userEmail);
+      }
+    } else if (change.entity === 'work_entry' && change.op === 'delete') {
+      segment.remove(change.id);
+    } else if (change.entity === 'client' && change.op === 'upsert') {
+      segment.clients.set(change.row.id, change.row.name);
+    } else if (change.entity === 'client' && change.op === 'delete') {
+      segment.clients.delete(change.id);
+      segment.removeClient(change.id);
+    } else if (change.entity === 'client' && change.op === 'clear') {
+      segment.clients.clear();
+      segment.length = 0;
+      segment.compact();
+    } else {
+      return this.remove(userEmail);
+    }
+    this.account(userEmail, segment);
+  }
+
+  // Forget the user's window, for changes not sent row by row (an import).
+  // The next read in the window loads it again.
+  drop(userEmail) {
+    const load = this.loads.get(userEmail);
+    if (load) {
+      load.stale = true;
+    }
+    this.remove(userEmail);
+    this.skipped.delete(userEmail);
+  }
+
+  clear() {
+    this.loads.forEach((load) => {
+      load.stale = true;
+    });
+    this.segments.clear();
+    this.skipped.clear();
+    this.bytes = 0;
+  }
+
+  stats() {
+    return {
+      enabled: this.enabled,
+      users: this.segments.size,
+      bytes: this.bytes,
+      budgetBytes: this.budgetBytes,
+      hits: this.hits,
+      misses: this.misses,
+      evictions: this.evictions
+    };
+  }
+}
+
+function createWorkEntryCache() {
+  if (cluster.isWorker && process.env.WORK_ENTRY_CACHE_MB) {
+    console.warn('WORK_ENTRY_CACHE_MB ignored: the work entry cache needs a single server process');
+    return new WorkEntryCache({ budgetBytes: 0 });
+  }
+  return new WorkEntryCache();
+}
+
+const workEntryCache = createWorkEntryCache();
+
+module.exports = {
+  Segment,
+  WorkEntryCache,
+  workEntryCache
+};
@@ -0,0 +1,355 @@
+// Writer for the Apache Arrow IPC streaming format
+// (https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format),
+// covering the column types the exports use. A stream is a schema message,
+// dictionary batches, record batches, then the end-of-stream marker; any
+// Arrow implementation (pyarrow, polars, DuckDB, arrow-js) reads it without
+// parsing text.
+//
+// Message metadata is FlatBuffers. Rather than pull in the FlatBuffers and
+// Arrow libraries for the handful of tables involved, FlatBufferWriter below
+// encodes them directly.
+
+const ALIGNMENT = 8;
+const CONTINUATION = -1;
+const METADATA_V5 = 4;
+
+// Message.fbs MessageHeader and Schema.fbs Type union members
+const HEADER = { Schema: 1, DictionaryBatch: 2, RecordBatch: 3 };
+const TYPE = { Int: 2, FloatingPoint: 3, Utf8: 5, Date: 8, Timestamp: 10 };
+const DOUBLE = 2;
+const DAY = 0;
+const MILLISECOND = 1;
+
+const alignUp = (value, alignment) => Math.ceil(value / alignment) * alignment;
+
+// FlatBuffers building blocks: a table's fields are listed by field id
+// (undefined when absent)
+const table = (...fields) => ({ kind: 'table', fields });
+const scalar = (type, value) => ({ type, value });
+const ref = (node) => ({ type: 'offset', value: node });
+const string = (value) => ({ kind: 'string', value });
+const tables = (nodes) => ({ kind: 'tables', nodes });
+// Vector of structs made of two longs (FieldNode, Buffer)
+const longPairs = (pairs) => ({ kind: 'longPairs', pairs });
+
+const SIZES = { bool: 1, uint8: 1, int16: 2, int32: 4, offset: 4, int64: 8 };
+
+// Lays objects out front to back: a table, then what it references, so
+// every offset points forward as the format requires, with scalars aligned
+// to their size.
+class FlatBufferWriter {
+  constructor() {
+    this.bytes = Buffer.alloc(512);
+    this.pos = 0;
+  }
+
+  ensure(length) {
+    if (this.pos + length > this.bytes.length) {
+      const bytes = Buffer.alloc(Math.max(this.bytes.length * 2, this.pos + length));
+      this.bytes.copy(bytes);
+      this.bytes = bytes;
+    }
+  }
+
+  // Pad until pos % alignment === remainder
+  align(alignment, remainder = 0) {
+    const padding = (alignment + remainder - (this.pos % alignment)) % alignment;
+    this.ensure(padding);
+    this.pos += padding;
+  }
+
+  writeScalar(type, at, value) {
+    switch (type) {
+      case 'bool':
+      case 'uint8':
+        this.bytes.writeUInt8(value, at);
+        break;
+      case 'int16':
+        this.bytes.writeInt16LE(value, at);
+        break;
+      case 'int32':
+        this.bytes.writeInt32LE(value, at);
+        break;
+      case 'int64':
+        this.bytes.writeBigInt64LE(BigInt(value), at);
+        break;
+      default:
+        throw new Error(`Unknown scalar type ${type}`);
+    }
+  }
+
+  // Point the offset slot at `at` to the object `node`, written after it
+  writeOffset(at, node) {
+    const target = this.write(node);
+    this.bytes.writeUInt32LE(target - at, at);
+  }
+
+  write(node) {
+    switch (node.kind) {
+      case 'table':
+        return this.writeTable(node.fields);
+      case 'string': {
+        const bytes = Buffer.from(node.value, 'utf8');
+        this.align(4);
+        const at = this.pos;
+        this.ensure(4 + bytes.length + 1);
+        this.bytes.writeUInt32LE(bytes.length, at);
+        bytes.copy(this.bytes, at + 4);
+        this.pos += 4 + bytes.length + 1;
+        return at;
+      }
+      case 'tables': {
+        this.align(4);
+        const at = this.pos;
+        this.ensure(4 + 4 * node.nodes.length);
+        this.bytes.writeUInt32LE(node.nodes.length, at);
+        this.pos += 4 + 4 * node.nodes.length;
+        node.nodes.forEach((child, index) => this.writeOffset(at + 4 + 4 * index, child));
+        return at;
+      }
+      case 'longPairs': {
+        // Elements 8-aligned, after the 4-byte length
+        this.align(8, 4);
+        const at = this.pos;
+        this.ensure(4 + 16 * node.pairs.length);
+        this.bytes.writeUInt32LE(node.pairs.length, at);
+        node.pairs.forEach(([first, second], index) => {
+          this.bytes.writeBigInt64LE(BigInt(first), at + 4 + 16 * index);
+          this.bytes.writeBigInt64LE(BigInt(second), at + 12 + 16 * index);
+        });
+        this.pos += 4 + 16 * node.pairs.length;
+        return at;
+      }
+      default:
+        throw new Error(`Unknown node kind ${node.kind}`);
+    }
+  }
+
+  writeTable(fields) {
+    const present = [];
+    fields.forEach((field, id) => {
+      if (field) {
+        present.push({ ...field, id, size: SIZES[field.type] });
+      }
+    });
+    // Largest first to minimize padding. A table holding 8-byte fields
+    // starts at 4 mod 8, so after its 4-byte vtable offset they're aligned.
+    present.sort((a, b) => b.size - a.size);
+    const shift = present.some((field) => field.size === 8) ? 4 : 0;
+    let size = 4;
+    present.forEach((field) => {
+      field.offset = alignUp(size + shift, field.size) - shift;
+      size = field.offset + field.size;
+    });
+
+    this.align(2);
+    const vtable = this.pos;
+    const vtableSize = 4 + 2 * fields.length;
+    this.ensure(vtableSize);
+    this.bytes.writeUInt16LE(vtableSize, vtable);
+    this.bytes.writeUInt16LE(size, vtable + 2);
+    present.forEach((field) => this.bytes.writeUInt16LE(field.offset, vtable + 4 + 2 * field.id));
+    this.pos += vtableSize;
+
+    this.align(shift ? 8 : 4, shift);
+    const start = this.pos;
+    this.ensure(size);
+    this.bytes.writeInt32LE(start - vtable, start);
+    this.pos += size;
+
+    present.forEach((field) => {
+      if (field.type !== 'offset') {
+        this.writeScalar(field.type, start + field.offset, field.value);
+      }
+    });
+    present.forEach((field) => {
+      if (field.type === 'offset') {
+        this.writeOffset(start + field.offset, field.value);
+      }
+    });
+    return start;
+  }
+
+  finish(root) {
+    this.ensure(4);
+    this.pos = 4;
+    this.writeOffset(0, root);
+    return this.bytes.subarray(0, this.pos);
+  }
+}
+
+// Column types: 'int32', 'int64', 'float64', 'utf8', 'date32' (days since
+// the epoch) and 'timestamp' (milliseconds, UTC)
+function typeOf(type) {
+  switch (type) {
+    case 'int32':
+    case 'int64':
+      return { id: TYPE.Int, node: table(scalar('int32', type === 'int32' ? 32 : 64), scalar('bool', 1)) };
+    case 'float64':
+      return { id: TYPE.FloatingPoint, node: table(scalar('int16', DOUBLE)) };
+    case 'utf8':
+      return { id: TYPE.Utf8, node: table() };
+    case 'date32':
+      return { id: TYPE.Date, node: table(scalar('int16', DAY)) };
+    case 'timestamp':
+      return { id: TYPE.Timestamp, node: table(scalar('int16', MILLISECOND), ref(string('UTC'))) };
+    default:
+      throw new Error(`Unsupported column type ${type}`);
+  }
+}
+
+// Field { name, type, nullable, dictionary }: with `dictionary` (an id),
+// values are int32 indices into that dictionary batch
+function fieldTable({ name, type, nullable = false, dictionary }) {
+  const { id, node } = typeOf(type);
+  const encoding = dictionary === undefined
+    ? undefined
+    : ref(table(scalar('int64', dictionary), ref(typeOf('int32').node), scalar('bool', 0)));
+  return table(
+    ref(string(name)),
+    scalar('bool', nullable ? 1 : 0),
+    scalar('uint8', id),
+    ref(node),
+    encoding,
+    ref(tables([]))
+  );
+}
+
+// A column's buffers: validity bitmap (empty without nulls), then the
+// values (and, for strings, offsets before the bytes)
+function encodeColumn(type, values) {
+  const length = values.length;
+  let nullCount = 0;
+  let validity = Buffer.alloc(0);
+  if (values.some((value) => value === null || value === undefined)) {
+    validity = Buffer.alloc(Math.ceil(length / 8));
+    values.forEach((value, index) => {
+      if (value === null || value === undefined) {
+        nullCount += 1;
+      } else {
+        validity[index >> 3] |= 1 << (index & 7);
+      }
+    });
+  }
+
+  let buffers;
+  switch (type) {
+    case 'int32':
+    case 'date32':
+      buffers = [Int32Array.from(values, (value) => value || 0)];
+      break;
+    case 'int64':
+    case 'timestamp':
+      buffers = [BigInt64Array.from(values, (value) => BigInt(value || 0))];
+      break;
+    case 'float64':
+      buffers = [Float64Array.from(values, (value) => value || 0)];
+      break;
+    case 'utf8': {
+      const offsets = new Int32Array(length + 1);
+      let size = 0;
+      values.forEach((value, index) => {
+        size += value ? Buffer.byteLength(value) : 0;
+        offsets[index + 1] = size;
+      });
+      const data = Buffer.alloc(size);
+      values.forEach((value, index) => {
+        if (value) {
+          data.write(value, offsets[index]);
+        }
+      });
+      buffers = [offsets, data];
+      break;
+    }
+    default:
+      throw new Error(`Unsupported column type ${type}`);
+  }
+
+  return {
+    node: [length, nullCount],
+    buffers: [validity, ...buffers.map((buffer) => Buffer.from(buffer.buffer, buffer.byteOffset, buffer.byteLength))]
+  };
+}
+
+// RecordBatch table and its body for `columns` ({ type, values } each)
+function recordBatch(columns) {
+  const length = columns.length > 0 ? columns[0].values.length : 0;
+  const nodes = [];
+  const body = [];
+  const layout = [];
+  let offset = 0;
+
+  columns.forEach(({ type, values }) => {
+    const column = encodeColumn(type, values);
+    nodes.push(column.node);
+    column.buffers.forEach((buffer) => {
+      layout.push([offset, buffer.length]);
+      body.push(buffer);
+      const padded = alignUp(buffer.length, ALIGNMENT);
+      if (padded > buffer.length) {
+        body.push(Buffer.alloc(padded - buffer.length));
+      }
+      offset += padded;
+    });
+  });
+
+  return {
+    header: table(scalar('int64', length), ref(longPairs(nodes)), ref(longPairs(layout))),
+    body,
+    bodyLength: offset
+  };
+}
+
+// Encapsulated message: continuation marker, metadata length, metadata
+// padded to 8 bytes, body
+function message(headerType, header, body = [], bodyLength = 0) {
+  const metadata = new FlatBufferWriter().finish(table(
+    scalar('int16', METADATA_V5),
+    scalar('uint8', headerType),
+    ref(header),
+    scalar('int64', bodyLength)
+  ));
+  const prefix = Buffer.alloc(8 + alignUp(metadata.length, ALIGNMENT));
+  prefix.writeInt32LE(CONTINUATION, 0);
+  prefix.writeInt32LE(prefix.length - 8, 4);
+  metadata.copy(prefix, 8);
+  return Buffer.concat([prefix, ...body]);
+}
+
+// Schema message for `fields`
+function encodeSchema(fields) {
+  return message(HEADER.Schema, table(scalar('int16', 0), ref(tables(fields.map(fieldTable)))));
+}
+
+// Dictionary batch `id` holding the string `values`. A `delta` batch
+// appends to the dictionary sent before (indices continue from there).
+function encodeDictionary(id, values, { delta = false } = {}) {
+  const { header, body, bodyLength } = recordBatch([{ type: 'utf8', values }]);
+  return message(
+    HEADER.DictionaryBatch,
+    table(scalar('int64', id), ref(header), scalar('bool', delta ? 1 : 0)),
+    body,
+    bodyLength
+  );
+}
+
+// Record batch with one array of values per field (indices for dictionary
+// fields)
+function encodeRecordBatch(fields, columns) {
+  const { header, body, bodyLength } = recordBatch(fields.map((field, index) => ({
+    type: field.dictionary === undefined ? field.type : 'int32',
+    values: columns[index]
+  })));
+  return message(HEADER.RecordBatch, header, body, bodyLength);
+}
+
+// End-of-stream marker
+const END_OF_STREAM = Buffer.from([0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0]);
+
+module.exports = {
+  FlatBufferWriter,
+  encodeSchema,
+  encodeDictionary,
+  encodeRecordBatch,
+  END_OF_STREAM
+};
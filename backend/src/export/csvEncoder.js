@@ -0,0 +1,131 @@
+const path = require('path');
+
+// RFC 4180 CSV encoding of report rows, handed over column by column: dates
+// (epoch milliseconds) and numbers as Float64Arrays, text as arrays of
+// strings. Fields containing a comma, quote or line break are quoted, with
+// quotes doubled; rows end in CRLF; dates are written as YYYY-MM-DD (UTC)
+// and numbers as String(number) writes them.
+//
+// Rows are encoded in batches. For each batch a text column becomes a
+// string table: its values joined into one string, plus where each starts.
+// The native addon (native/csv_encoder.cc, built by `npm run build:native`)
+// takes the batch in one call and produces the same bytes several times
+// faster than the JavaScript encoder below, which is used without it or
+// with CSV_ENCODER=js.
+
+const COLUMN_TYPES = { date: 0, number: 1, text: 2 };
+const DEFAULT_BATCH_SIZE = 4096;
+const NATIVE_PATH = path.join(__dirname, '../../native/build/Release/csv_encoder.node');
+
+function loadNative() {
+  if (process.env.CSV_ENCODER === 'js') {
+    return null;
+  }
+  try {
+    return require(NATIVE_PATH);
+  } catch (err) {
+    return null;
+  }
+}
+
+const NEEDS_QUOTES = /[",\r\n]/;
+
+const escapeText = (value) => (NEEDS_QUOTES.test(value) ? `"${value.replace(/"/g, '""')}"` : value);
+
+// Date#toISOString's date part, so years outside 0-9999 take the expanded
+// form (+010000, -000001); beyond the Date range the field is empty
+function formatDate(ms) {
+  const date = new Date(ms);
+  if (Number.isNaN(date.getTime())) {
+    return '';
+  }
+  const iso = date.toISOString();
+  return iso.slice(0, iso.indexOf('T'));
+}
+
+const formatNumber = (value) => (Number.isFinite(value) ? String(value) : '');
+
+// Rows [start, end) of a text column as { text, offsets }: row i (from 0)
+// is text.slice(offsets[i], offsets[i + 1]). Anything but a string is
+// empty.
+function textTable(values, start, end) {
+  const offsets = new Uint32Array(end - start + 1);
+  const parts = new Array(end - start);
+  let length = 0;
+  for (let row = start; row < end; row++) {
+    const value = values[row];
+    const part = typeof value === 'string' ? value : '';
+    parts[row - start] = part;
+    length += part.length;
+    offsets[row - start + 1] = length;
+  }
+  return { text: parts.join(''), offsets };
+}
+
+// The JavaScript encoder, with the addon's signature: `rows` rows of
+// `columns` (a Float64Array or string table each)
+function encode(types, columns, rows) {
+  let out = '';
+  for (let row = 0; row < rows; row++) {
+    for (let index = 0; index < types.length; index++) {
+      if (index > 0) {
+        out += ',';
+      }
+      const column = columns[index];
+      switch (types[index]) {
+        case COLUMN_TYPES.date:
+          out += formatDate(column[row]);
+          break;
+        case COLUMN_TYPES.number:
+          out += formatNumber(column[row]);
+          break;
+        default:
+          out += escapeText(column.text.slice(column.offsets[row], column.offsets[row + 1]));
+      }
+    }
+    out += '\r\n';
+  }
+  return Buffer.from(out, 'utf8');
+}
+
+const javascript = { encode };
+
+class CsvEncoder {
+  // `fields`: [{ title, type: 'date' | 'number' | 'text' }]
+  constructor(fields, { batchSize = DEFAULT_BATCH_SIZE, implementation = CsvEncoder.native || javascript } = {}) {
+    this.fields = fields;
+    this.types = fields.map((field) => COLUMN_TYPES[field.type]);
+    this.batchSize = batchSize;
+    this.implementation = implementation;
+  }
+
+  get isNative() {
+    return this.implementation !== javascript;
+  }
+
+  // The header row
+  header() {
+    return Buffer.from(`${this.fields.map((field) => escapeText(field.title)).join(',')}\r\n`, 'utf8');
+  }
+
+  // The rows of `columns` (one per field, `length` rows each) as CSV, one
+  // Buffer per batch so a large report can be written as it's encoded
+  *rows(columns, length) {
+    for (let start = 0; start < length; start += this.batchSize) {
+      const end = Math.min(start + this.batchSize, length);
+      const batch = columns.map((column, index) => (this.types[index] === COLUMN_TYPES.text
+        ? textTable(column, start, end)
+        : column.subarray(start, end)));
+      yield this.implementation.encode(this.types, batch, end - start);
+    }
+  }
+}
+
+CsvEncoder.native = loadNative();
+CsvEncoder.javascript = javascript;
+
+module.exports = {
+  COLUMN_TYPES,
+  CsvEncoder,
+  textTable
+};
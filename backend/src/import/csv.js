@@ -0,0 +1,162 @@
+const { StringDecoder } = require('string_decoder');
+
+// Incremental RFC 4180 CSV parser. Text is fed in chunks as it arrives and
+// complete records come out; only the unfinished record at the end of a
+// chunk is kept, so memory is bounded by the longest record, not the file.
+//
+// Fields may be quoted, with "" for a quote and line breaks inside quotes.
+// Lines end in \n or \r\n. Blank lines are skipped and a leading byte order
+// mark is dropped.
+
+const MAX_RECORD_LENGTH = 64 * 1024;
+const QUOTE = 0x22;
+
+class CsvError extends Error {
+  constructor(message, line) {
+    super(message);
+    this.name = 'CsvError';
+    this.line = line;
+  }
+}
+
+// indexOf, with "not found" sorting after every position
+function find(text, char, from) {
+  const at = text.indexOf(char, from);
+  return at === -1 ? Infinity : at;
+}
+
+function countLines(text) {
+  let lines = 0;
+  for (let at = text.indexOf('\n'); at !== -1; at = text.indexOf('\n', at + 1)) {
+    lines += 1;
+  }
+  return lines;
+}
+
+class CsvParser {
+  constructor({ maxRecordLength = MAX_RECORD_LENGTH } = {}) {
+    this.maxRecordLength = maxRecordLength;
+    this.buffer = '';
+    // Line the next record starts on
+    this.line = 1;
+    this.started = false;
+  }
+
+  // Parse the next chunk; returns the records it completed as
+  // { line, fields }
+  push(text) {
+    return this.parse(text, false);
+  }
+
+  // No more input: returns the last record, if it had no line break
+  end() {
+    return this.parse('', true);
+  }
+
+  parse(text, final) {
+    let buffer = this.buffer + text;
+    if (!this.started && buffer.length > 0) {
+      this.started = true;
+      if (buffer.charCodeAt(0) === 0xfeff) {
+        buffer = buffer.slice(1);
+      }
+    }
+
+    const records = [];
+    let start = 0;
+    // Next comma and line break, reused across fields until passed
+    let comma = -1;
+    let newline = -1;
+
+    record: while (start < buffer.length) {
+      const fields = [];
+      let lines = 0;
+      let i = start;
+
+      for (;;) {
+        let value;
+        if (buffer.charCodeAt(i) === QUOTE) {
+          value = '';
+          let from = i + 1;
+          for (;;) {
+            const close = buffer.indexOf('"', from);
+            // A quote at the very end might be the first half of ""
+            if (close === -1 || (close === buffer.length - 1 && !final)) {
+              if (final) {
+                throw new CsvError(`Unterminated quoted field on line ${this.line + lines}`, this.line);
+              }
+              break record;
+            }
+            value += buffer.slice(from, close);
+            if (buffer.charCodeAt(close + 1) !== QUOTE) {
+              i = close + 1;
+              break;
+            }
+            value += '"';
+            from = close + 2;
+          }
+          lines += countLines(value);
+        }
+
+        if (comma < i) {
+          comma = find(buffer, ',', i);
+        }
+        if (newline < i) {
+          newline = find(buffer, '\n', i);
+        }
+        if (newline === Infinity && !final) {
+          break record;
+        }
+
+        const end = Math.min(comma, newline, buffer.length);
+        let rest = buffer.slice(i, end);
+        if (end !== comma && rest.endsWith('\r')) {
+          rest = rest.slice(0, -1);
+        }
+        if (value === undefined) {
+          value = rest;
+        } else if (rest !== '') {
+          throw new CsvError(`Unexpected text after a quoted field on line ${this.line + lines}`, this.line);
+        }
+        fields.push(value);
+
+        if (end === comma) {
+          i = end + 1;
+        } else {
+          start = end + 1;
+          break;
+        }
+      }
+
+      if (fields.length > 1 || fields[0] !== '') {
+        records.push({ line: this.line, fields });
+      }
+      this.line += lines + 1;
+    }
+
+    this.buffer = start < buffer.length ? buffer.slice(start) : '';
+    if (this.buffer.length > this.maxRecordLength) {
+      throw new CsvError(`Line ${this.line} is longer than ${this.maxRecordLength} characters`, this.line);
+    }
+    return records;
+  }
+}
+
+// Records of a CSV byte stream (e.g. an upload), parsed as they arrive. The
+// stream is read only as fast as the consumer takes records.
+async function* readCsv(stream, options) {
+  const decoder = new StringDecoder('utf8');
+  const parser = new CsvParser(options);
+
+  for await (const chunk of stream) {
+    yield* parser.push(typeof chunk === 'string' ? chunk : decoder.write(chunk));
+  }
+  yield* parser.push(decoder.end());
+  yield* parser.end();
+}
+
+module.exports = {
+  CsvError,
+  CsvParser,
+  readCsv
+};
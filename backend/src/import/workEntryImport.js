@@ -0,0 +1,184 @@
+const { all, run } = require('../database/query');
+const { noteBulkChange } = require('../database/readCoherence');
+const { workEntrySchema } = require('../validation/schemas');
+const { CsvError, readCsv } = require('./csv');
+
+// Bulk import of work entries from CSV (POST /api/work-entries/import).
+//
+// The first row names the columns: `date`, `hours`, a client by `client`
+// name or `clientId`, and optionally `description`; other columns are
+// ignored, so a report export can be read back. Each row is validated like
+// a POST /api/work-entries body. Valid rows are inserted several hundred to
+// a statement, each statement committing on its own; invalid rows are
+// skipped and reported by line.
+
+const INSERT_BATCH_SIZE = 500;
+const MAX_REPORTED_ERRORS = 1000;
+
+// Header names for each field, compared lowercased without spaces or
+// underscores
+const COLUMNS = {
+  date: ['date'],
+  hours: ['hours'],
+  description: ['description'],
+  client: ['client', 'clientname'],
+  clientId: ['clientid']
+};
+
+class ImportError extends Error {
+  constructor(message, { line, imported = 0 } = {}) {
+    super(message);
+    this.name = 'ImportError';
+    this.line = line;
+    this.imported = imported;
+  }
+}
+
+const normalizeHeader = (name) => name.trim().toLowerCase().replace(/[\s_]/g, '');
+const normalizeName = (name) => name.trim().toLowerCase();
+
+// Field -> column index, from the header row
+function mapColumns(header) {
+  const names = header.map(normalizeHeader);
+  const columns = {};
+  Object.entries(COLUMNS).forEach(([field, aliases]) => {
+    const index = names.findIndex((name) => aliases.includes(name));
+    if (index !== -1) {
+      columns[field] = index;
+    }
+  });
+
+  const missing = ['date', 'hours'].filter((field) => columns[field] === undefined);
+  if (columns.client === undefined && columns.clientId === undefined) {
+    missing.push('client');
+  }
+  if (missing.length > 0) {
+    throw new ImportError(`Missing column(s): ${missing.join(', ')}`, { line: 1 });
+  }
+  return columns;
+}
+
+// The user's clients, loaded once per import: ids, and names to ids (null
+// for a name several clients share)
+async function loadClients(db, userEmail) {
+  const rows = await all(
+    db,
+    'SELECT id, name FROM clients WHERE user_email = ? AND deleted_at IS NULL',
+    [userEmail]
+  );
+  const ids = new Set();
+  const byName = new Map();
+  rows.forEach(({ id, name }) => {
+    ids.add(id);
+    const key = normalizeName(name);
+    byName.set(key, byName.has(key) ? null : id);
+  });
+  return { ids, byName };
+}
+
+// A CSV row as a validated work entry, or { error }
+function toWorkEntry(fields, columns, clients) {
+  const entry = {
+    hours: fields[columns.hours],
+    date: fields[columns.date]
+  };
+  if (columns.description !== undefined && fields[columns.description] !== undefined) {
+    entry.description = fields[columns.description];
+  }
+
+  const clientId = columns.clientId !== undefined ? fields[columns.clientId] : undefined;
+  if (clientId !== undefined && clientId !== '') {
+    entry.clientId = clientId;
+  } else {
+    const name = fields[columns.client] || '';
+    const id = clients.byName.get(normalizeName(name));
+    if (id === undefined) {
+      return { error: name ? `Unknown client "${name}"` : 'Client is required' };
+    }
+    if (id === null) {
+      return { error: `Several clients are named "${name}"; use clientId` };
+    }
+    entry.clientId = id;
+  }
+
+  const { error, value } = workEntrySchema.validate(entry);
+  if (error) {
+    return { error: error.message };
+  }
+  if (!clients.ids.has(value.clientId)) {
+    return { error: 'Client not found or does not belong to user' };
+  }
+  return { value };
+}
+
+function insertStatement(rows) {
+  return `INSERT INTO work_entries (client_id, user_email, hours, description, date) VALUES ${
+    new Array(rows).fill('(?, ?, ?, ?, ?)').join(', ')
+  }`;
+}
+
+// Import work entries for `userEmail` from a CSV byte stream. Resolves with
+// { imported, failed, errors: [{ line, error }] }, errors listing at most
+// MAX_REPORTED_ERRORS rows (`failed` counts them all). Rejects with an
+// ImportError if the file itself is unusable (no header, malformed CSV);
+// rows before that point stay imported.
+async function importWorkEntries(db, userEmail, stream, { batchSize = INSERT_BATCH_SIZE } = {}) {
+  const clients = await loadClients(db, userEmail);
+  const report = { imported: 0, failed: 0, errors: [] };
+  const fullBatch = insertStatement(batchSize);
+  let params = [];
+  let columns = null;
+
+  const flush = async () => {
+    const rows = params.length / 5;
+    if (rows === 0) {
+      return;
+    }
+    await run(db, rows === batchSize ? fullBatch : insertStatement(rows), params);
+    noteBulkChange(userEmail);
+    report.imported += rows;
+    params = [];
+  };
+
+  try {
+    for await (const { line, fields } of readCsv(stream)) {
+      if (!columns) {
+        columns = mapColumns(fields);
+        continue;
+      }
+
+      const { error, value } = toWorkEntry(fields, columns, clients);
+      if (error) {
+        report.failed += 1;
+        if (report.errors.length < MAX_REPORTED_ERRORS) {
+          report.errors.push({ line, error });
+        }
+        continue;
+      }
+
+      params.push(value.clientId, userEmail, value.hours, value.description || null, value.date);
+      if (params.length === batchSize * 5) {
+        await flush();
+      }
+    }
+  } catch (err) {
+    if (err instanceof CsvError) {
+      throw new ImportError(err.message, { line: err.line, imported: report.imported });
+    }
+    if (err instanceof ImportError) {
+      err.imported = report.imported;
+    }
+    throw err;
+  }
+
+  if (!columns) {
+    throw new ImportError('The file is empty');
+  }
+  await flush();
+  return report;
+}
+
+module.exports = {
+  ImportError,
+  importWorkEntries
+};
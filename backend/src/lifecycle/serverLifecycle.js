@@ -0,0 +1,178 @@
+// Startup/shutdown state of the HTTP server, for zero-downtime deploys.
+//
+// On SIGTERM (forwarded by dumb-init in the container) the process:
+//   1. reports not ready on /health/ready, optionally for a grace period
+//      while still serving, so the load balancer stops sending traffic;
+//   2. stops accepting connections and closes idle keep-alive ones;
+//   3. waits for in-flight requests, up to a deadline, after which the
+//      remaining connections are cut;
+//   4. runs the shutdown hooks in order (stop background jobs, flush logs,
+//      checkpoint and close the database) and exits.
+//
+// Long-lived streams (GET /api/events) would never drain; they are closed
+// by an `onDrain` hook as soon as draining starts.
+
+const DEFAULT_DRAIN_TIMEOUT_MS = 25 * 1000;
+
+class ServerLifecycle {
+  constructor({
+    drainTimeoutMs = Number(process.env.SHUTDOWN_DRAIN_TIMEOUT_MS) || DEFAULT_DRAIN_TIMEOUT_MS,
+    readinessDelayMs = Number(process.env.SHUTDOWN_READINESS_DELAY_MS) || 0
+  } = {}) {
+    this.drainTimeoutMs = drainTimeoutMs;
+    this.readinessDelayMs = readinessDelayMs;
+    // starting -> ready -> draining -> stopped
+    this.state = 'starting';
+    this.inFlight = 0;
+    this.server = null;
+    this.drainHooks = [];
+    this.closeHooks = [];
+    this.idleWaiters = [];
+    this.stopping = null;
+  }
+
+  // Count requests so draining knows when they're done. While draining,
+  // responses ask keep-alive clients to reconnect (to another instance).
+  middleware() {
+    return (req, res, next) => {
+      this.inFlight += 1;
+      let done = false;
+      const finish = () => {
+        if (done) {
+          return;
+        }
+        done = true;
+        this.inFlight -= 1;
+        if (this.inFlight === 0) {
+          this.idleWaiters.splice(0).forEach((resolve) => resolve());
+        }
+      };
+      res.on('finish', finish);
+      res.on('close', finish);
+
+      if (this.state === 'draining') {
+        res.set('Connection', 'close');
+      }
+      next();
+    };
+  }
+
+  // Mark the instance ready once `server` is listening
+  ready(server) {
+    this.server = server;
+    this.state = 'ready';
+  }
+
+  // Run when draining starts, e.g. closing event streams
+  onDrain(name, hook) {
+    this.drainHooks.push({ name, hook });
+    return this;
+  }
+
+  // Run in registration order once requests have drained
+  onClose(name, hook) {
+    this.closeHooks.push({ name, hook });
+    return this;
+  }
+
+  // GET /health/live: the process is up and serving (draining included)
+  liveness(req, res) {
+    const alive = this.state !== 'stopped';
+    res.status(alive ? 200 : 503).json({ status: alive ? 'OK' : 'STOPPED', state: this.state });
+  }
+
+  // GET /health/ready: send this instance traffic
+  readiness(req, res) {
+    const ready = this.state === 'ready';
+    res.status(ready ? 200 : 503).json({
+      status: ready ? 'OK' : 'UNAVAILABLE',
+      state: this.state,
+      inFlight: this.inFlight
+    });
+  }
+
+  waitForIdle() {
+    if (this.inFlight === 0) {
+      return Promise.resolve(true);
+    }
+    return new Promise((resolve) => {
+      const timer = setTimeout(() => resolve(false), this.drainTimeoutMs);
+      this.idleWaiters.push(() => {
+        clearTimeout(timer);
+        resolve(true);
+      });
+    });
+  }
+
+  async runHooks(hooks) {
+    for (const { name, hook } of hooks) {
+      try {
+        await hook();
+      } catch (error) {
+        console.error(`Shutdown step "${name}" failed:`, error);
+      }
+    }
+  }
+
+  // Idempotent: a second signal while stopping waits for the same shutdown
+  shutdown(reason = 'shutdown') {
+    if (!this.stopping) {
+      this.stopping = this.stop(reason);
+    }
+    return this.stopping;
+  }
+
+  async stop(reason) {
+    console.log(`Received ${reason}, draining ${this.inFlight} in-flight request(s)`);
+    this.state = 'draining';
+
+    if (this.readinessDelayMs > 0) {
+      await new Promise((resolve) => setTimeout(resolve, this.readinessDelayMs));
+    }
+
+    await this.runHooks(this.drainHooks);
+
+    const server = this.server;
+    const closed = server
+      ? new Promise((resolve) => server.close(() => resolve()))
+      : Promise.resolve();
+    if (server && server.closeIdleConnections) {
+      server.closeIdleConnections();
+    }
+
+    const drained = await this.waitForIdle();
+    if (!drained) {
+      console.warn(`Drain deadline reached with ${this.inFlight} request(s) in flight; closing connections`);
+    }
+    if (server && server.closeAllConnections) {
+      server.closeAllConnections();
+    }
+    await closed;
+
+    await this.runHooks(this.closeHooks);
+    this.state = 'stopped';
+    console.log('Shutdown complete');
+  }
+
+  // Shut down on SIGTERM/SIGINT, then exit
+  handleSignals(exit = (code) => process.exit(code)) {
+    ['SIGTERM', 'SIGINT'].forEach((signal) => {
+      process.once(signal, () => {
+        this.shutdown(signal).then(() => exit(0), (error) => {
+          console.error('Shutdown failed:', error);
+          exit(1);
+        });
+      });
+    });
+  }
+}
+
+// Wait until everything written to stdout/stderr so far has been flushed
+const flushOutput = () => Promise.all(
+  [process.stdout, process.stderr].map((stream) => new Promise((resolve) => stream.write('', resolve)))
+);
+
+module.exports = {
+  ServerLifecycle,
+  flushOutput
+};
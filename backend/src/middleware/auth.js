@@ -1,46 +1,48 @@
-const { getDatabase } = require('../database/init');
+const { verifyToken } = require('../auth/tokens');
 
-// Simple email-based authentication middleware
+// The request's Bearer access token, verified at most once per request: the
+// rate limiter and authenticateUser both need it. `{ payload }` for a valid
+// token, `{ error }` for an invalid one, null without one.
+function verifyBearerToken(req) {
+  if (req.accessToken === undefined) {
+    const [scheme, token] = (req.headers.authorization || '').split(' ');
+    if (scheme !== 'Bearer' || !token) {
+      req.accessToken = null;
+    } else {
+      try {
+        req.accessToken = { payload: verifyToken(token, 'access') };
+      } catch (error) {
+        req.accessToken = { error };
+      }
+    }
+  }
+  return req.accessToken;
+}
+
+// Bearer token authentication. The token is verified in memory, so this
+// doesn't touch the database; users are created at login.
 function authenticateUser(req, res, next) {
-  const userEmail = req.headers['x-user-email'];
-  
-  if (!userEmail) {
-    return res.status(401).json({ error: 'User email required in x-user-email header' });
+  // A sub-request of POST /api/batch, which authenticated the batch
+  if (req.userEmail) {
+    return next();
   }
 
-  // Validate email format
-  const emailRegex = /^[^\s@]+@[^\s@]+\.[^\s@]+$/;
-  if (!emailRegex.test(userEmail)) {
-    return res.status(400).json({ error: 'Invalid email format' });
+  const verified = verifyBearerToken(req);
+
+  if (!verified) {
+    return res.status(401).json({ error: 'Bearer token required in Authorization header' });
   }
 
-  const db = getDatabase();
-  
-  // Check if user exists, create if not
-  db.get('SELECT email FROM users WHERE email = ?', [userEmail], (err, row) => {
-    if (err) {
-      console.error('Database error:', err);
-      return res.status(500).json({ error: 'Internal server error' });
-    }
-    
-    if (!row) {
-      // Create new user
-      db.run('INSERT INTO users (email) VALUES (?)', [userEmail], (err) => {
-        if (err) {
-          console.error('Error creating user:', err);
-          return res.status(500).json({ error: 'Failed to create user' });
-        }
-        
-        req.userEmail = userEmail;
-        next();
-      });
-    } else {
-      req.userEmail = userEmail;
-      next();
-    }
-  });
+  if (verified.error) {
+    const expired = verified.error.name === 'TokenExpiredError';
+    return res.status(401).json({ error: expired ? 'Token expired' : 'Invalid token' });
+  }
+
+  req.userEmail = verified.payload.sub;
+  next();
 }
 
 module.exports = {
-  authenticateUser
+  authenticateUser,
+  verifyBearerToken
 };
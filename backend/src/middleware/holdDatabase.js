@@ -0,0 +1,16 @@
+const { acquireDatabase } = require('../database/init');
+
+// For routes that keep using the user's database for as long as the
+// response takes (a streamed export, an upload imported in batches): holds
+// the connection open until the response closes, so an idle sweep of its
+// shard (database/shards.js) can't close it between queries. The route
+// still gets the connection from getDatabase().
+function holdDatabase(req, res, next) {
+  const { release } = acquireDatabase(req.userEmail);
+  res.on('close', release);
+  next();
+}
+
+module.exports = {
+  holdDatabase
+};
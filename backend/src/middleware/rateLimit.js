@@ -0,0 +1,243 @@
+const { verifyBearerToken } = require('./auth');
+
+// Token-bucket rate limiting, keyed by the authenticated user (or by IP for
+// unauthenticated calls such as login).
+//
+// Every key has a bucket of `capacity` tokens that refills continuously at
+// `refillPerSecond`. A request spends its route's cost; if the bucket holds
+// less than that it gets a 429 and spends nothing. Costs reflect how
+// expensive a route is to serve, so exports drain the bucket faster than
+// list reads.
+
+const DEFAULT_CAPACITY = 120;
+const DEFAULT_REFILL_PER_SECOND = 2;
+const DEFAULT_COST = 1;
+const MEMORY_STORE_SLOTS = 1 << 16;
+const PRUNE_EVERY = 1000;
+
+// First match wins; `path` is matched against the start of req.originalUrl
+const ROUTE_COSTS = [
+  { method: 'GET', path: '/api/reports/export/', cost: 20 },
+  { method: 'GET', path: '/api/export/', cost: 20 },
+  { method: 'GET', path: '/api/reports/', cost: 3 },
+  { method: 'GET', path: '/api/search', cost: 2 },
+  { method: 'POST', path: '/api/work-entries/import', cost: 20 },
+  { method: 'POST', path: '/api/auth/login', cost: 5 },
+  { method: 'POST', cost: 2 },
+  { method: 'PUT', cost: 2 },
+  { method: 'DELETE', cost: 2 }
+];
+
+function routeCost(req, costs = ROUTE_COSTS) {
+  const match = costs.find((rule) =>
+    rule.method === req.method && (!rule.path || req.originalUrl.startsWith(rule.path))
+  );
+  return match ? match.cost : DEFAULT_COST;
+}
+
+// Tokens in a bucket last updated at `updatedAt`, as of `now` (ms)
+const refill = (tokens, updatedAt, now, { capacity, refillPerSecond }) =>
+  Math.min(capacity, tokens + Math.max(0, now - updatedAt) * refillPerSecond / 1000);
+
+// FNV-1a; the store only needs a cheap, well-spread 32-bit hash
+function hash(key) {
+  let h = 0x811c9dc5;
+  for (let i = 0; i < key.length; i++) {
+    h ^= key.charCodeAt(i);
+    h = Math.imul(h, 0x01000193);
+  }
+  return h >>> 0;
+}
+
+// Per-process store in a fixed number of slots (20 bytes each), however
+// many keys it sees. Keys hash to a set of two slots. A key missing from
+// its set takes over the slot holding more tokens (an empty slot counts as
+// full) and starts from that slot's balance, not from a full bucket, so
+// cycling through keys that collide with a drained bucket can't refill it
+// or anyone else's. A new key only shares a drained balance when both
+// slots of its set are in active use.
+class MemoryBucketStore {
+  constructor({ slots = MEMORY_STORE_SLOTS } = {}) {
+    // Mask of the set index; slot 2 * set and the one after it form a set
+    this.mask = slots / 2 - 1;
+    this.tokens = new Float64Array(slots);
+    this.updatedAt = new Float64Array(slots);
+    // Identifies the key owning a slot; 0 marks an empty slot
+    this.tags = new Uint32Array(slots);
+  }
+
+  // Tokens in `slot` as of `now`
+  level(slot, now, policy) {
+    return this.tags[slot] === 0
+      ? policy.capacity
+      : refill(this.tokens[slot], this.updatedAt[slot], now, policy);
+  }
+
+  async take(key, cost, policy, now = Date.now()) {
+    const h = hash(key);
+    const first = (h & this.mask) * 2;
+    const tag = (Math.imul(h, 0x9e3779b1) | 1) >>> 0;
+
+    let slot = this.tags[first] === tag ? first : this.tags[first + 1] === tag ? first + 1 : -1;
+    if (slot < 0) {
+      slot = this.level(first, now, policy) >= this.level(first + 1, now, policy) ? first : first + 1;
+    }
+    const tokens = this.level(slot, now, policy);
+    const allowed = tokens >= cost;
+
+    this.tags[slot] = tag;
+    this.tokens[slot] = allowed ? tokens - cost : tokens;
+    this.updatedAt[slot] = now;
+    return { allowed, tokens: this.tokens[slot] };
+  }
+}
+
+// The user whose database holds a bucket; IP buckets have none
+function bucketOwner(key) {
+  return key.startsWith('user:') ? key.slice('user:'.length) : undefined;
+}
+
+// Store in the rate_limit_buckets table (migrations/007), shared by every
+// process using the same database file. Each take is a single upsert, so
+// concurrent processes can't both spend the same tokens. `getDb(userEmail)`
+// picks the database: with sharding, a user's bucket lives on their own
+// shard, which their request writes to anyway, and only IP buckets
+// (unauthenticated calls) are kept in the main database.
+class SqliteBucketStore {
+  constructor(getDb) {
+    this.getDb = getDb;
+    this.takes = 0;
+  }
+
+  take(key, cost, policy, now = Date.now()) {
+    const { capacity, refillPerSecond } = policy;
+    const refilled = 'MIN(?2, tokens + MAX(0, ?4 - updated_at) * ?5)';
+    const db = this.getDb(bucketOwner(key));
+
+    // Each database is pruned in proportion to the buckets taken from it
+    this.takes += 1;
+    if (this.takes % PRUNE_EVERY === 0) {
+      this.prune(policy, now, db);
+    }
+
+    return new Promise((resolve, reject) => {
+      // SET expressions all see the row as it was before the update
+      db.get(`
+        INSERT INTO rate_limit_buckets (key, tokens, updated_at, allowed)
+        VALUES (?1, CASE WHEN ?3 <= ?2 THEN ?2 - ?3 ELSE ?2 END, ?4, ?3 <= ?2)
+        ON CONFLICT (key) DO UPDATE SET
+          tokens = ${refilled} - CASE WHEN ${refilled} >= ?3 THEN ?3 ELSE 0 END,
+          allowed = ${refilled} >= ?3,
+          updated_at = ?4
+        RETURNING tokens, allowed
+      `, [key, capacity, cost, now, refillPerSecond / 1000], (err, row) => {
+        if (err) {
+          return reject(err);
+        }
+        resolve({ allowed: row.allowed === 1, tokens: row.tokens });
+      });
+    });
+  }
+
+  // Buckets that have refilled completely carry no state; drop them so the
+  // table only holds recently active keys
+  prune({ capacity, refillPerSecond }, now = Date.now(), db = this.getDb()) {
+    const fullAfterMs = capacity / refillPerSecond * 1000;
+    db.run('DELETE FROM rate_limit_buckets WHERE updated_at < ?', [now - fullAfterMs], (err) => {
+      if (err) {
+        console.error('Failed to prune rate limit buckets:', err);
+      }
+    });
+  }
+}
+
+// Bucket key: the user from a valid access token, else the client IP. An
+// invalid or expired token is left for the route's own authentication to
+// reject; the verification is shared with it (middleware/auth.js).
+function rateLimitKey(req) {
+  const verified = verifyBearerToken(req);
+  return verified && verified.payload ? `user:${verified.payload.sub}` : `ip:${req.ip}`;
+}
+
+// RateLimit-* headers as in the IETF "RateLimit header fields" draft:
+// remaining whole tokens and seconds until the bucket is full again
+function setRateLimitHeaders(res, tokens, { capacity, refillPerSecond }) {
+  res.set({
+    'RateLimit-Policy': `${capacity};w=${Math.ceil(capacity / refillPerSecond)}`,
+    'RateLimit-Limit': String(capacity),
+    'RateLimit-Remaining': String(Math.floor(tokens)),
+    'RateLimit-Reset': String(Math.ceil((capacity - tokens) / refillPerSecond))
+  });
+}
+
+function createRateLimiter({
+  store = new MemoryBucketStore(),
+  capacity = Number(process.env.RATE_LIMIT_CAPACITY) || DEFAULT_CAPACITY,
+  refillPerSecond = Number(process.env.RATE_LIMIT_REFILL_PER_SECOND) || DEFAULT_REFILL_PER_SECOND,
+  costs = ROUTE_COSTS,
+  now = Date.now
+} = {}) {
+  const policy = { capacity, refillPerSecond };
+
+  return async function rateLimit(req, res, next) {
+    const cost = routeCost(req, costs);
+    const key = rateLimitKey(req);
+
+    let result;
+    try {
+      result = await store.take(key, cost, policy, now());
+    } catch (err) {
+      // Don't turn a store failure into an outage
+      console.error('Rate limit store error:', err);
+      return next();
+    }
+
+    setRateLimitHeaders(res, result.tokens, policy);
+
+    if (!result.allowed) {
+      const retryAfter = Math.ceil((cost - result.tokens) / refillPerSecond);
+      res.set('Retry-After', String(retryAfter));
+      return res.status(429).json({ error: 'Too many requests', retryAfter });
+    }
+
+    // For routes whose cost depends on the request body (POST /api/batch):
+    // spend `extra` more tokens from the same bucket. Resolves to false, with
+    // the 429 sent, when the bucket doesn't hold them.
+    req.spendRateLimit = async (extra) => {
+      let spent;
+      try {
+        spent = await store.take(key, extra, policy, now());
+      } catch (err) {
+        console.error('Rate limit store error:', err);
+        return true;
+      }
+      setRateLimitHeaders(res, spent.tokens, policy);
+      if (spent.allowed) {
+        return true;
+      }
+      const retryAfter = Math.ceil((extra - spent.tokens) / refillPerSecond);
+      res.set('Retry-After', String(retryAfter));
+      res.status(429).json({ error: 'Too many requests', retryAfter });
+      return false;
+    };
+
+    next();
+  };
+}
+
+// `RATE_LIMIT_STORE=sqlite` shares buckets through the database, for
+// several processes on one database file; defaults to that when
+// DATABASE_PATH is set, otherwise per-process memory
+function createRateLimitStore(getDb, type = process.env.RATE_LIMIT_STORE) {
+  const useSqlite = type ? type === 'sqlite' : Boolean(process.env.DATABASE_PATH);
+  return useSqlite ? new SqliteBucketStore(getDb) : new MemoryBucketStore();
+}
+
+module.exports = {
+  ROUTE_COSTS,
+  MemoryBucketStore,
+  SqliteBucketStore,
+  createRateLimiter,
+  createRateLimitStore,
+  routeCost
+};
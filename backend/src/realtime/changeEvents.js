@@ -0,0 +1,163 @@
+// Per-process registry of Server-Sent Events subscribers (GET /api/events).
+//
+// Connections are grouped by user so a mutation only touches that user's
+// streams. Idle connections cost a map entry and a socket: there are no
+// per-connection timers, a single shared interval sends the heartbeats.
+//
+// A subscriber that can't keep up (res.write returns false) is not buffered
+// for: further events are dropped until the socket drains, then a single
+// `resync` event tells the client to refetch what it missed. One that stays
+// stuck across heartbeats is disconnected.
+
+const HEARTBEAT_INTERVAL_MS = 25 * 1000;
+const MAX_CONNECTIONS_PER_USER = 10;
+const RETRY_MS = 5000;
+
+const HEARTBEAT = ': ping\n\n';
+const RESYNC = 'event: resync\ndata: {}\n\n';
+
+const formatEvent = (event, data) => `event: ${event}\ndata: ${JSON.stringify(data)}\n\n`;
+
+class SubscriberRegistry {
+  constructor({
+    heartbeatIntervalMs = HEARTBEAT_INTERVAL_MS,
+    maxConnectionsPerUser = MAX_CONNECTIONS_PER_USER
+  } = {}) {
+    this.heartbeatIntervalMs = heartbeatIntervalMs;
+    this.maxConnectionsPerUser = maxConnectionsPerUser;
+    this.byUser = new Map();
+    this.size = 0;
+    this.timer = null;
+  }
+
+  // Register an open response as a subscriber. Returns the unsubscribe
+  // function, which is also called when the response closes.
+  subscribe(userEmail, res) {
+    let subscribers = this.byUser.get(userEmail);
+    if (!subscribers) {
+      subscribers = new Set();
+      this.byUser.set(userEmail, subscribers);
+    }
+
+    // Too many tabs: close the oldest, it will reconnect if still in use
+    if (subscribers.size >= this.maxConnectionsPerUser) {
+      const [oldest] = subscribers;
+      oldest.res.end();
+      this.remove(userEmail, oldest);
+    }
+
+    const subscriber = { res, blockedSince: null, missed: false };
+    subscribers.add(subscriber);
+    this.size += 1;
+    this.startHeartbeat();
+
+    const unsubscribe = () => this.remove(userEmail, subscriber);
+    res.on('close', unsubscribe);
+
+    this.write(subscriber, `retry: ${RETRY_MS}\n\n`);
+    return unsubscribe;
+  }
+
+  remove(userEmail, subscriber) {
+    const subscribers = this.byUser.get(userEmail);
+    if (!subscribers || !subscribers.delete(subscriber)) {
+      return;
+    }
+    this.size -= 1;
+    if (subscribers.size === 0) {
+      this.byUser.delete(userEmail);
+    }
+    if (this.size === 0) {
+      this.stopHeartbeat();
+    }
+  }
+
+  // Send an event to all of the user's connections. The payload is
+  // serialized once however many tabs are open.
+  publish(userEmail, event, data) {
+    const subscribers = this.byUser.get(userEmail);
+    if (!subscribers) {
+      return 0;
+    }
+    const chunk = formatEvent(event, data);
+    subscribers.forEach((subscriber) => this.write(subscriber, chunk));
+    return subscribers.size;
+  }
+
+  write(subscriber, chunk) {
+    if (subscriber.blockedSince !== null) {
+      subscriber.missed = true;
+      return;
+    }
+    if (subscriber.res.write(chunk)) {
+      return;
+    }
+
+    subscriber.blockedSince = Date.now();
+    subscriber.res.once('drain', () => {
+      subscriber.blockedSince = null;
+      if (subscriber.missed) {
+        subscriber.missed = false;
+        this.write(subscriber, RESYNC);
+      }
+    });
+  }
+
+  heartbeat(now = Date.now()) {
+    this.byUser.forEach((subscribers) => {
+      subscribers.forEach((subscriber) => {
+        if (subscriber.blockedSince === null) {
+          subscriber.res.write(HEARTBEAT);
+        } else if (now - subscriber.blockedSince > 2 * this.heartbeatIntervalMs) {
+          subscriber.res.destroy();
+        }
+      });
+    });
+  }
+
+  startHeartbeat() {
+    if (this.timer) {
+      return;
+    }
+    this.timer = setInterval(() => this.heartbeat(), this.heartbeatIntervalMs);
+    this.timer.unref();
+  }
+
+  stopHeartbeat() {
+    clearInterval(this.timer);
+    this.timer = null;
+  }
+
+  // End every stream, e.g. on shutdown
+  closeAll() {
+    this.byUser.forEach((subscribers) => subscribers.forEach(({ res }) => res.end()));
+    this.byUser.clear();
+    this.size = 0;
+    this.stopHeartbeat();
+  }
+}
+
+const registry = new SubscriberRegistry();
+
+// Notify the user's open tabs that a row changed. `change` is
+//   { entity: 'work_entry' | 'client', op: 'upsert', row }
+//   { entity: 'work_entry' | 'client', op: 'delete', id }
+//   { entity: 'client', op: 'clear' }   (all clients and entries deleted)
+// The data layer has already brought this process's own reads up to date
+// (database/readCoherence.js).
+function publishChange(userEmail, change) {
+  return registry.publish(userEmail, 'change', change);
+}
+
+// Tell the user's open tabs to refetch everything, for changes too large to
+// send row by row (an import)
+function publishResync(userEmail) {
+  return registry.publish(userEmail, 'resync', {});
+}
+
+module.exports = {
+  SubscriberRegistry,
+  registry,
+  publishChange,
+  publishResync
+};
@@ -0,0 +1,165 @@
+const path = require('path');
+
+// Hour totals and per-day/week/month histograms over work entries held as
+// columns: `days` (days since 1970-01-01, UTC) and `hundredths` (hours in
+// hundredths, the precision hours are stored with), both Int32Arrays.
+// Integer hundredths make every sum exact, so results don't depend on the
+// order entries are added in, and the native kernel and the JavaScript
+// below agree bit for bit.
+//
+// Three kernels do the per-entry work: sum() totals hundredths, range()
+// finds the first and last day, and histogram() counts and sums entries
+// per day. The native addon (native/aggregate.cc, built by
+// `npm run build:native`) runs them with SIMD; without it, or with
+// AGGREGATE_KERNEL=js, the JavaScript versions run. Weeks and months are
+// rolled up from the days, which are few.
+
+const DAY_MS = 24 * 60 * 60 * 1000;
+// 1970-01-01 was a Thursday: day + 3 counts from a Monday
+const WEEK_OFFSET = 3;
+// About 400 years of days; beyond that a range is a data error
+const MAX_SPAN = 146100;
+const NATIVE_PATH = path.join(__dirname, '../../native/build/Release/aggregate.node');
+
+function loadNative() {
+  if (process.env.AGGREGATE_KERNEL === 'js') {
+    return null;
+  }
+  try {
+    return require(NATIVE_PATH);
+  } catch (err) {
+    return null;
+  }
+}
+
+// The JavaScript kernels, with the addon's signatures
+const javascript = {
+  sum(values) {
+    let total = 0;
+    for (let i = 0; i < values.length; i++) {
+      total += values[i];
+    }
+    return total;
+  },
+
+  range(days) {
+    if (days.length === 0) {
+      return null;
+    }
+    let min = days[0];
+    let max = days[0];
+    for (let i = 1; i < days.length; i++) {
+      const day = days[i];
+      if (day < min) {
+        min = day;
+      } else if (day > max) {
+        max = day;
+      }
+    }
+    return [min, max];
+  },
+
+  histogram(days, hundredths, from, counts, totals) {
+    const span = counts.length;
+    for (let i = 0; i < days.length; i++) {
+      const offset = days[i] - from;
+      if (offset >= 0 && offset < span) {
+        counts[offset] += 1;
+        totals[offset] += hundredths[i];
+      }
+    }
+  }
+};
+
+const native = loadNative();
+
+// Days since the epoch of a stored date (epoch milliseconds, or a date
+// string in older rows)
+const dayNumber = (date) => Math.floor((typeof date === 'number' ? date : Date.parse(date)) / DAY_MS);
+
+const toHundredths = (hours) => Math.round(hours * 100);
+
+// Work entry rows ({ date, hours }) as columns
+function toColumns(entries) {
+  const days = new Int32Array(entries.length);
+  const hundredths = new Int32Array(entries.length);
+  entries.forEach((entry, index) => {
+    days[index] = dayNumber(entry.date);
+    hundredths[index] = toHundredths(entry.hours);
+  });
+  return { days, hundredths };
+}
+
+// Month index (year * 12 + month - 1) of a day number
+function monthOf(day) {
+  const date = new Date(day * DAY_MS);
+  return date.getUTCFullYear() * 12 + date.getUTCMonth();
+}
+
+// Sums per bucket of the per-day histogram; `bucketOf(day)` must not
+// decrease with the day
+function rollUp(from, counts, totals, bucketOf) {
+  const first = bucketOf(from);
+  const size = bucketOf(from + counts.length - 1) - first + 1;
+  const rolled = { start: first, counts: new Uint32Array(size), totals: new Float64Array(size) };
+  for (let offset = 0; offset < counts.length; offset++) {
+    const bucket = bucketOf(from + offset) - first;
+    rolled.counts[bucket] += counts[offset];
+    rolled.totals[bucket] += totals[offset];
+  }
+  return rolled;
+}
+
+const toHours = (bucket) => ({ start: bucket.start, counts: bucket.counts, hours: bucket.totals.map((total) => total / 100) });
+
+// Count, total hours and histograms of the entries between the days `from`
+// and `to` (inclusive; by default the first and last entry's). Buckets are
+// { start, counts, hours }, typed arrays indexed from `start`: a day
+// number, a week number (weeks start on Monday; day = week * 7 - 3) or a
+// month index (year * 12 + month - 1).
+function aggregate({ days, hundredths }, { from, to, kernel = native || javascript } = {}) {
+  let range = [from, to];
+  if (from === undefined || to === undefined) {
+    const found = kernel.range(days) || [0, -1];
+    range = [from === undefined ? found[0] : from, to === undefined ? found[1] : to];
+  }
+  const [first, last] = range;
+  const span = Math.max(0, last - first + 1);
+  if (span > MAX_SPAN) {
+    throw new RangeError(`Date range of ${span} days is too long to aggregate`);
+  }
+
+  const counts = new Uint32Array(span);
+  const totals = new Float64Array(span);
+  if (span > 0) {
+    kernel.histogram(days, hundredths, first, counts, totals);
+  }
+
+  let count = 0;
+  let total = 0;
+  for (let offset = 0; offset < span; offset++) {
+    count += counts[offset];
+    total += totals[offset];
+  }
+
+  const result = { count, hours: total / 100, from: span > 0 ? first : null, to: span > 0 ? last : null };
+  if (span > 0) {
+    result.day = toHours({ start: first, counts, totals });
+    result.week = toHours(rollUp(first, counts, totals, (day) => Math.floor((day + WEEK_OFFSET) / 7)));
+    result.month = toHours(rollUp(first, counts, totals, monthOf));
+  }
+  return result;
+}
+
+// Exact total hours of work entry rows
+function totalHours(entries, { kernel = native || javascript } = {}) {
+  return kernel.sum(Int32Array.from(entries, (entry) => toHundredths(entry.hours))) / 100;
+}
+
+module.exports = {
+  aggregate,
+  dayNumber,
+  toColumns,
+  totalHours,
+  kernels: { native, javascript }
+};
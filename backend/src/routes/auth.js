@@ -1,11 +1,13 @@
 const express = require('express');
 const { getDatabase } = require('../database/init');
-const { emailSchema } = require('../validation/schemas');
+const { emailSchema, refreshTokenSchema } = require('../validation/schemas');
 const { authenticateUser } = require('../middleware/auth');
+const { issueTokens, verifyToken } = require('../auth/tokens');
 
 const router = express.Router();
 
-// Login endpoint - creates user if doesn't exist
+// Login endpoint - creates user if doesn't exist and issues an access
+// token plus a refresh token
 router.post('/login', async (req, res, next) => {
   try {
     const { error, value } = emailSchema.validate(req.body);
@@ -14,10 +16,10 @@ router.post('/login', async (req, res, next) => {
     }
 
     const { email } = value;
-    const db = getDatabase();
+    const db = getDatabase(email);
 
     // Check if user exists
-    db.get('SELECT email, created_at FROM users WHERE email = ?', [email], (err, row) => {
+    db.get('SELECT email, created_at, token_version FROM users WHERE email = ?', [email], (err, row) => {
       if (err) {
         console.error('Database error:', err);
         return res.status(500).json({ error: 'Internal server error' });
@@ -30,7 +32,8 @@ router.post('/login', async (req, res, next) => {
           user: {
             email: row.email,
             createdAt: row.created_at
-          }
+          },
+          ...issueTokens(row.email, row.token_version)
         });
       } else {
         // Create new user
@@ -45,7 +48,8 @@ router.post('/login', async (req, res, next) => {
             user: {
               email: email,
               createdAt: new Date().toISOString()
-            }
+            },
+            ...issueTokens(email)
           });
         });
       }
@@ -55,9 +59,55 @@ router.post('/login', async (req, res, next) => {
   }
 });
 
+// Exchange a refresh token for a new token pair. Unlike access tokens this
+// checks the database, so logging out revokes the refresh token.
+router.post('/refresh', (req, res, next) => {
+  const { error, value } = refreshTokenSchema.validate(req.body);
+  if (error) {
+    return next(error);
+  }
+
+  let payload;
+  try {
+    payload = verifyToken(value.refreshToken, 'refresh');
+  } catch (err) {
+    return res.status(401).json({ error: 'Invalid refresh token' });
+  }
+
+  const db = getDatabase(payload.sub);
+
+  db.get('SELECT email, token_version FROM users WHERE email = ?', [payload.sub], (err, row) => {
+    if (err) {
+      console.error('Database error:', err);
+      return res.status(500).json({ error: 'Internal server error' });
+    }
+
+    if (!row || row.token_version !== payload.ver) {
+      return res.status(401).json({ error: 'Invalid refresh token' });
+    }
+
+    res.json(issueTokens(row.email, row.token_version));
+  });
+});
+
+// Revoke the user's refresh tokens. Access tokens already handed out stay
+// valid until they expire.
+router.post('/logout', authenticateUser, (req, res) => {
+  const db = getDatabase(req.userEmail);
+
+  db.run('UPDATE users SET token_version = token_version + 1 WHERE email = ?', [req.userEmail], (err) => {
+    if (err) {
+      console.error('Database error:', err);
+      return res.status(500).json({ error: 'Internal server error' });
+    }
+
+    res.json({ message: 'Logged out successfully' });
+  });
+});
+
 // Get current user info
 router.get('/me', authenticateUser, (req, res) => {
-  const db = getDatabase();
+  const db = getDatabase(req.userEmail);
   
   db.get('SELECT email, created_at FROM users WHERE email = ?', [req.userEmail], (err, row) => {
     if (err) {
@@ -0,0 +1,145 @@
+const express = require('express');
+const querystring = require('querystring');
+const { authenticateUser } = require('../middleware/auth');
+const { errorHandler } = require('../middleware/errorHandler');
+const { routeCost } = require('../middleware/rateLimit');
+const { batchSchema } = require('../validation/schemas');
+
+const clientRoutes = require('./clients');
+const workEntryRoutes = require('./workEntries');
+const reportRoutes = require('./reports');
+const searchRoutes = require('./search');
+
+const router = express.Router();
+
+// Routes a sub-request may target, by mount path (as in server.js). Auth,
+// the event stream, file downloads and uploads stay separate requests.
+const BATCH_ROUTES = {
+  '/api/clients': clientRoutes,
+  '/api/work-entries': workEntryRoutes,
+  '/api/reports': reportRoutes,
+  '/api/search': searchRoutes
+};
+const EXCLUDED_PATHS = ['/api/reports/export/', '/api/work-entries/import'];
+
+// Stands in for the response object of a sub-request. Routes only set a
+// status and send JSON; that is what gets collected.
+class BatchResponse {
+  constructor(onFinish) {
+    this.statusCode = 200;
+    this.headers = {};
+    this.locals = {};
+    this.headersSent = false;
+    this.onFinish = onFinish;
+  }
+
+  status(code) {
+    this.statusCode = code;
+    return this;
+  }
+
+  setHeader(name, value) {
+    this.headers[name.toLowerCase()] = value;
+    return this;
+  }
+
+  set(name, value) {
+    if (typeof name === 'object') {
+      Object.entries(name).forEach(([key, headerValue]) => this.setHeader(key, headerValue));
+      return this;
+    }
+    return this.setHeader(name, value);
+  }
+
+  getHeader(name) {
+    return this.headers[name.toLowerCase()];
+  }
+
+  json(body) {
+    return this.end(body);
+  }
+
+  send(body) {
+    return this.end(body);
+  }
+
+  end(body = null) {
+    if (!this.headersSent) {
+      this.headersSent = true;
+      this.onFinish({ status: this.statusCode, body });
+    }
+    return this;
+  }
+}
+
+function findMount(pathname) {
+  if (EXCLUDED_PATHS.some((excluded) => pathname.startsWith(excluded))) {
+    return null;
+  }
+  return Object.keys(BATCH_ROUTES).find((mount) => pathname === mount || pathname.startsWith(`${mount}/`));
+}
+
+// Run one sub-request through its route as if it had been sent on its own.
+// The sub-request inherits from the batch request, so it carries the
+// already authenticated user.
+function dispatch(parent, { method, path, query = {}, body = {} }) {
+  return new Promise((resolve) => {
+    const [pathname, search = ''] = path.split('?');
+    const mount = findMount(pathname);
+    if (!mount) {
+      return resolve({ status: 404, body: { error: 'Route not found' } });
+    }
+
+    const req = Object.create(parent);
+    Object.assign(req, {
+      method,
+      url: `${pathname.slice(mount.length) || '/'}${search ? `?${search}` : ''}`,
+      originalUrl: path,
+      baseUrl: mount,
+      params: {},
+      query: { ...querystring.parse(search), ...query },
+      body
+    });
+    const res = new BatchResponse(resolve);
+
+    BATCH_ROUTES[mount].handle(req, res, (err) => {
+      if (err) {
+        return errorHandler(err, req, res);
+      }
+      res.status(404).json({ error: 'Route not found' });
+    });
+  });
+}
+
+router.use(authenticateUser);
+
+// Execute several API calls in one round trip. Sub-requests run
+// concurrently, so a batch has no ordering between them; each gets its own
+// status and body, in request order:
+//   { responses: [{ id, status, body }, ...] }
+router.post('/', async (req, res, next) => {
+  const { error, value } = batchSchema.validate(req.body);
+  if (error) {
+    return next(error);
+  }
+
+  // The batch itself was charged as one POST; charge for what it contains
+  if (req.spendRateLimit) {
+    const cost = value.requests.reduce(
+      (sum, sub) => sum + routeCost({ method: sub.method, originalUrl: sub.path }),
+      0
+    );
+    const extra = cost - routeCost(req);
+    if (extra > 0 && !(await req.spendRateLimit(extra))) {
+      return;
+    }
+  }
+
+  const results = await Promise.all(value.requests.map((sub) => dispatch(req, sub)));
+
+  res.json({
+    responses: results.map((result, index) => ({ id: value.requests[index].id, ...result }))
+  });
+});
+
+module.exports = router;
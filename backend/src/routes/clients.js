@@ -1,19 +1,28 @@
 const express = require('express');
 const { getDatabase } = require('../database/init');
+const { all } = require('../database/query');
+const { readFlights } = require('../database/singleFlight');
+const { noteBulkChange, noteChange } = require('../database/readCoherence');
+const { clientPurger, getPurgeProgress, softDeleteClients } = require('../database/clientPurge');
+const { ChangeLogVersionError, getCurrentVersion, readChanges } = require('../database/changeLog');
 const { authenticateUser } = require('../middleware/auth');
-const { clientSchema, updateClientSchema } = require('../validation/schemas');
+const { publishChange } = require('../realtime/changeEvents');
+const { clientSchema, updateClientSchema, changesQuerySchema } = require('../validation/schemas');
 
 const router = express.Router();
 
 // All routes require authentication
 router.use(authenticateUser);
 
-// Get all clients for authenticated user
+// Get all clients for authenticated user. Identical concurrent requests
+// share one query.
 router.get('/', (req, res) => {
-  const db = getDatabase();
+  const db = getDatabase(req.userEmail);
   
-  db.all(
-    'SELECT id, name, description, department, email, created_at, updated_at FROM clients WHERE user_email = ? ORDER BY name',
+  readFlights.all(
+    db,
+    req.userEmail,
+    'SELECT id, name, description, department, email, created_at, updated_at FROM clients WHERE user_email = ? AND deleted_at IS NULL ORDER BY name',
     [req.userEmail],
     (err, rows) => {
       if (err) {
@@ -26,6 +35,66 @@ router.get('/', (req, res) => {
   );
 });
 
+// Delta sync of the user's clients, same contract as
+// GET /api/work-entries/changes: upserted rows in `clients`, ids of deleted
+// clients in `deleted`, and the `version` to send as `since` next time.
+// A client is reported deleted as soon as it is marked, before its purge.
+router.get('/changes', async (req, res, next) => {
+  const { error, value } = changesQuerySchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
+
+  const db = getDatabase(req.userEmail);
+  const columns = 'id, name, description, department, email, created_at, updated_at';
+
+  try {
+    if (value.since === 0) {
+      const version = await getCurrentVersion(db);
+      const rows = await all(db, `SELECT ${columns} FROM clients WHERE user_email = ? AND deleted_at IS NULL ORDER BY name`, [req.userEmail]);
+      return res.json({ clients: rows, deleted: [], version, hasMore: false });
+    }
+
+    const changes = await readChanges(db, {
+      userEmail: req.userEmail,
+      entity: 'client',
+      since: value.since,
+      limit: value.limit
+    });
+    const rows = changes.ids.length === 0 ? [] : await all(
+      db,
+      `SELECT ${columns} FROM clients WHERE user_email = ? AND id IN (SELECT value FROM json_each(?)) AND deleted_at IS NULL`,
+      [req.userEmail, JSON.stringify(changes.ids)]
+    );
+
+    const existing = new Set(rows.map((row) => row.id));
+    res.json({
+      clients: rows,
+      deleted: changes.ids.filter((id) => !existing.has(id)),
+      version: changes.version,
+      hasMore: changes.hasMore
+    });
+  } catch (err) {
+    if (err instanceof ChangeLogVersionError) {
+      return res.status(410).json({ error: err.message, version: err.version });
+    }
+    console.error('Database error:', err);
+    res.status(500).json({ error: 'Internal server error' });
+  }
+});
+
+// Deleted clients whose work entries are still being removed, with how
+// many are left
+router.get('/purges', async (req, res) => {
+  try {
+    const purges = await getPurgeProgress(getDatabase(req.userEmail), req.userEmail);
+    res.json({ purges });
+  } catch (err) {
+    console.error('Database error:', err);
+    res.status(500).json({ error: 'Internal server error' });
+  }
+});
+
 // Get specific client
 router.get('/:id', (req, res) => {
   const clientId = parseInt(req.params.id);
@@ -34,10 +103,10 @@ router.get('/:id', (req, res) => {
     return res.status(400).json({ error: 'Invalid client ID' });
   }
   
-  const db = getDatabase();
+  const db = getDatabase(req.userEmail);
   
   db.get(
-    'SELECT id, name, description, department, email, created_at, updated_at FROM clients WHERE id = ? AND user_email = ?',
+    'SELECT id, name, description, department, email, created_at, updated_at FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
     [clientId, req.userEmail],
     (err, row) => {
       if (err) {
@@ -63,7 +132,7 @@ router.post('/', (req, res, next) => {
     }
 
     const { name, description, department, email } = value;
-    const db = getDatabase();
+    const db = getDatabase(req.userEmail);
 
     db.run(
       'INSERT INTO clients (name, description, department, email, user_email) VALUES (?, ?, ?, ?, ?)',
@@ -81,9 +150,14 @@ router.post('/', (req, res, next) => {
           (err, row) => {
             if (err) {
               console.error('Database error:', err);
+              noteBulkChange(req.userEmail);
               return res.status(500).json({ error: 'Client created but failed to retrieve' });
             }
 
+            const change = { entity: 'client', op: 'upsert', row };
+            noteChange(req.userEmail, change);
+            publishChange(req.userEmail, change);
+
             res.status(201).json({ 
               message: 'Client created successfully',
               client: row 
@@ -111,11 +185,11 @@ router.put('/:id', (req, res, next) => {
       return next(error);
     }
 
-    const db = getDatabase();
+    const db = getDatabase(req.userEmail);
 
     // Check if client exists and belongs to user
     db.get(
-      'SELECT id FROM clients WHERE id = ? AND user_email = ?',
+      'SELECT id FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
       [clientId, req.userEmail],
       (err, row) => {
         if (err) {
@@ -154,7 +228,7 @@ router.put('/:id', (req, res, next) => {
         updates.push('updated_at = CURRENT_TIMESTAMP');
         values.push(clientId, req.userEmail);
 
-        const query = `UPDATE clients SET ${updates.join(', ')} WHERE id = ? AND user_email = ?`;
+        const query = `UPDATE clients SET ${updates.join(', ')} WHERE id = ? AND user_email = ? AND deleted_at IS NULL`;
 
         db.run(query, values, function(err) {
           if (err) {
@@ -169,9 +243,14 @@ router.put('/:id', (req, res, next) => {
             (err, row) => {
               if (err) {
                 console.error('Database error:', err);
+                noteBulkChange(req.userEmail);
                 return res.status(500).json({ error: 'Client updated but failed to retrieve' });
               }
 
+              const change = { entity: 'client', op: 'upsert', row };
+              noteChange(req.userEmail, change);
+              publishChange(req.userEmail, change);
+
               res.json({
                 message: 'Client updated successfully',
                 client: row
@@ -186,25 +265,23 @@ router.put('/:id', (req, res, next) => {
   }
 });
 
-// Delete all clients for authenticated user
-router.delete('/', (req, res) => {
-  const db = getDatabase();
-  
-  db.run(
-    'DELETE FROM clients WHERE user_email = ?',
-    [req.userEmail],
-    function(err) {
-      if (err) {
-        console.error('Database error:', err);
-        return res.status(500).json({ error: 'Failed to delete clients' });
-      }
-      
-      res.json({ 
-        message: 'All clients deleted successfully',
-        deletedCount: this.changes
-      });
-    }
-  );
+// Delete all clients for authenticated user. Clients are marked deleted
+// right away; their work entries are purged in the background (see
+// database/clientPurge.js and GET /api/clients/purges).
+router.delete('/', async (req, res) => {
+  try {
+    const deletedCount = await softDeleteClients(getDatabase(req.userEmail), req.userEmail);
+
+    publishChange(req.userEmail, { entity: 'client', op: 'clear' });
+    clientPurger.wake();
+    res.json({ 
+      message: 'All clients deleted successfully',
+      deletedCount
+    });
+  } catch (err) {
+    console.error('Database error:', err);
+    res.status(500).json({ error: 'Failed to delete clients' });
+  }
 });
 
 // Delete client
@@ -215,13 +292,13 @@ router.delete('/:id', (req, res) => {
     return res.status(400).json({ error: 'Invalid client ID' });
   }
   
-  const db = getDatabase();
+  const db = getDatabase(req.userEmail);
   
   // Check if client exists and belongs to user
   db.get(
-    'SELECT id FROM clients WHERE id = ? AND user_email = ?',
+    'SELECT id FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
     [clientId, req.userEmail],
-    (err, row) => {
+    async (err, row) => {
       if (err) {
         console.error('Database error:', err);
         return res.status(500).json({ error: 'Internal server error' });
@@ -231,19 +308,17 @@ router.delete('/:id', (req, res) => {
         return res.status(404).json({ error: 'Client not found' });
       }
       
-      // Delete client (work entries will be deleted due to CASCADE)
-      db.run(
-        'DELETE FROM clients WHERE id = ? AND user_email = ?',
-        [clientId, req.userEmail],
-        function(err) {
-          if (err) {
-            console.error('Database error:', err);
-            return res.status(500).json({ error: 'Failed to delete client' });
-          }
-          
-          res.json({ message: 'Client deleted successfully' });
-        }
-      );
+      // Mark the client deleted; its work entries go in the background
+      try {
+        await softDeleteClients(db, req.userEmail, clientId);
+      } catch (err) {
+        console.error('Database error:', err);
+        return res.status(500).json({ error: 'Failed to delete client' });
+      }
+
+      publishChange(req.userEmail, { entity: 'client', op: 'delete', id: clientId });
+      clientPurger.wake();
+      res.json({ message: 'Client deleted successfully' });
     }
   );
 });
@@ -0,0 +1,30 @@
+const express = require('express');
+const { authenticateUser } = require('../middleware/auth');
+const { registry } = require('../realtime/changeEvents');
+
+const router = express.Router();
+
+router.use(authenticateUser);
+
+// Server-Sent Events stream of the user's data changes. Events are
+// `change` (see publishChange in realtime/changeEvents.js) and `resync`,
+// sent when notifications were dropped and the client should refetch.
+router.get('/', (req, res) => {
+  // Long-lived: no idle timeout, and flush each small event right away
+  req.socket.setTimeout(0);
+  req.socket.setNoDelay(true);
+  req.socket.setKeepAlive(true);
+
+  res.writeHead(200, {
+    'Content-Type': 'text/event-stream',
+    'Cache-Control': 'no-cache, no-transform',
+    Connection: 'keep-alive',
+    // Stop reverse proxies (nginx) from buffering the stream
+    'X-Accel-Buffering': 'no'
+  });
+  res.flushHeaders();
+
+  registry.subscribe(req.userEmail, res);
+});
+
+module.exports = router;
@@ -0,0 +1,285 @@
+const express = require('express');
+const zlib = require('zlib');
+const { getDatabase } = require('../database/init');
+const { all } = require('../database/query');
+const { getCurrentVersion } = require('../database/changeLog');
+const { authenticateUser } = require('../middleware/auth');
+const { holdDatabase } = require('../middleware/holdDatabase');
+const { accountExportSchema, dateRangeSchema } = require('../validation/schemas');
+const { encodeSchema, encodeDictionary, encodeRecordBatch, END_OF_STREAM } = require('../export/arrow');
+
+const router = express.Router();
+
+router.use(authenticateUser);
+// Downloads page through the database for as long as they take
+router.use(holdDatabase);
+
+const PAGE_SIZE = 1000;
+// Sort before and after any stored date
+const MIN_DATE = -8640000000000000;
+const MAX_DATE = 8640000000000000;
+
+// The export's record types, in output order. Each is read in keyset
+// pages, so every query is a short indexed range scan and no read
+// transaction stays open while the client downloads. `key` is where a page
+// ends: the next page, or a resumed export, starts after it.
+const SECTIONS = [
+  {
+    type: 'client',
+    start: [0],
+    key: (row) => [row.id],
+    query: `SELECT id, name, description, department, email, created_at, updated_at
+            FROM clients
+            WHERE user_email = ? AND deleted_at IS NULL AND id > ?
+            ORDER BY id LIMIT ?`
+  },
+  {
+    type: 'work_entry',
+    start: [MIN_DATE, 0],
+    key: (row) => [row.date, row.id],
+    query: `SELECT we.id, we.client_id, c.name AS client_name, we.hours, we.description,
+                   we.date, we.created_at, we.updated_at
+            FROM work_entries we
+            JOIN clients c ON c.id = we.client_id
+            WHERE we.user_email = ? AND (we.date, we.id) > (?, ?) AND c.deleted_at IS NULL
+            ORDER BY we.date, we.id LIMIT ?`
+  }
+];
+
+// `after` as the section to resume in and the key to resume after
+function resumePoint(after) {
+  if (!after) {
+    return { section: 0, key: SECTIONS[0].start };
+  }
+  const [type, ...key] = after.split(':');
+  return { section: SECTIONS.findIndex((section) => section.type === type), key: key.map(Number) };
+}
+
+// A streamed download. Sets the headers, gzips when the client accepts it,
+// and lets the writer wait whenever the client (or the gzip stream) is
+// behind, so memory use doesn't depend on the size of the download.
+// Content is generated as it's sent, so there are no byte ranges to resume
+// from.
+class Download {
+  constructor(req, res, { contentType, filename }) {
+    this.res = res;
+    this.closed = false;
+    res.on('close', () => {
+      this.closed = true;
+    });
+
+    res.set({
+      'Content-Type': contentType,
+      'Content-Disposition': `attachment; filename="${filename}"`,
+      'Cache-Control': 'no-store',
+      'Accept-Ranges': 'none',
+      Vary: 'Accept-Encoding'
+    });
+    this.out = res;
+    if (req.acceptsEncodings('gzip', 'identity') === 'gzip') {
+      res.set('Content-Encoding', 'gzip');
+      this.out = zlib.createGzip();
+      this.out.pipe(res);
+    }
+  }
+
+  // Resolves once the chunk is buffered and there is room for more, or
+  // the client has gone
+  async write(chunk) {
+    if (this.out.write(chunk)) {
+      return;
+    }
+    await new Promise((resolve) => {
+      const done = () => {
+        this.out.off('drain', done);
+        this.res.off('close', done);
+        resolve();
+      };
+      this.out.on('drain', done);
+      this.res.on('close', done);
+    });
+  }
+
+  end(chunk) {
+    this.out.end(chunk);
+  }
+
+  // Cut the response short. Headers are gone by now, so this is how the
+  // client learns the download is incomplete.
+  abort(err) {
+    if (this.out !== this.res) {
+      this.out.destroy();
+    }
+    this.res.destroy(err);
+  }
+}
+
+// Everything in the user's account as newline-delimited JSON, one record
+// per line:
+//   {"type":"export","version":...}   first; the change log version
+//   {"type":"client",...}             each client
+//   {"type":"work_entry",...}         each work entry, by date
+//   {"type":"end","clients":n,"workEntries":n}
+// An interrupted download resumes with ?after=<type>:<key> from its last
+// complete line (`client:<id>` or `work_entry:<date>:<id>`); changes made
+// since are in GET /api/{clients,work-entries}/changes?since=<version>.
+router.get('/account.ndjson', async (req, res, next) => {
+  const { error, value } = accountExportSchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
+
+  const db = getDatabase(req.userEmail);
+  let version;
+  try {
+    version = await getCurrentVersion(db);
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Internal server error' });
+  }
+
+  const download = new Download(req, res, {
+    contentType: 'application/x-ndjson; charset=utf-8',
+    filename: 'account.ndjson'
+  });
+  const counts = { client: 0, work_entry: 0 };
+
+  try {
+    await download.write(`${JSON.stringify({ type: 'export', user: req.userEmail, version, exportedAt: new Date().toISOString() })}\n`);
+
+    const resume = resumePoint(value.after);
+    for (let index = resume.section; index < SECTIONS.length && !download.closed; index++) {
+      const section = SECTIONS[index];
+      let key = index === resume.section ? resume.key : section.start;
+
+      while (!download.closed) {
+        const rows = await all(db, section.query, [req.userEmail, ...key, PAGE_SIZE]);
+        if (rows.length > 0) {
+          await download.write(rows.map((row) => `${JSON.stringify({ type: section.type, ...row })}\n`).join(''));
+          counts[section.type] += rows.length;
+          key = section.key(rows[rows.length - 1]);
+        }
+        if (rows.length < PAGE_SIZE) {
+          break;
+        }
+      }
+    }
+
+    if (download.closed) {
+      return download.abort();
+    }
+    download.end(`${JSON.stringify({ type: 'end', clients: counts.client, workEntries: counts.work_entry })}\n`);
+  } catch (err) {
+    // No `end` line, so the client knows to resume
+    console.error('Export failed:', err);
+    download.abort(err);
+  }
+});
+
+// Columns of the Arrow export; client names are dictionary-encoded
+const ARROW_FIELDS = [
+  { name: 'id', type: 'int64' },
+  { name: 'client_id', type: 'int64' },
+  { name: 'client', type: 'utf8', dictionary: 0 },
+  { name: 'hours', type: 'float64' },
+  { name: 'description', type: 'utf8', nullable: true },
+  { name: 'date', type: 'date32' },
+  { name: 'created_at', type: 'timestamp', nullable: true },
+  { name: 'updated_at', type: 'timestamp', nullable: true }
+];
+const ARROW_BATCH_SIZE = 10000;
+const DAY_MS = 24 * 60 * 60 * 1000;
+
+const ARROW_QUERY = `
+  SELECT we.id, we.client_id, c.name AS client_name, we.hours, we.description,
+         we.date, we.created_at, we.updated_at
+  FROM work_entries we
+  JOIN clients c ON c.id = we.client_id
+  WHERE we.user_email = ? AND (we.date, we.id) > (?, ?) AND we.date <= ? AND c.deleted_at IS NULL
+  ORDER BY we.date, we.id LIMIT ?
+`;
+
+// SQLite's CURRENT_TIMESTAMP text (UTC) as epoch milliseconds
+const timestamp = (text) => {
+  const ms = text ? Date.parse(`${text.replace(' ', 'T')}Z`) : NaN;
+  return Number.isNaN(ms) ? null : ms;
+};
+
+// The user's work entries (optionally within ?from=&to=) as an Apache Arrow
+// IPC stream, for analytics tools: typed columns (dates as days, hours as
+// doubles, client names dictionary-encoded) instead of text to parse.
+// Each page read from SQLite becomes one record batch. A client first seen
+// in a batch is appended to the name dictionary (a delta batch) just
+// before it.
+router.get('/work-entries.arrow', async (req, res, next) => {
+  const { error, value } = dateRangeSchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
+
+  const db = getDatabase(req.userEmail);
+  const to = value.to !== undefined ? value.to.getTime() : MAX_DATE;
+  let key = [value.from !== undefined ? value.from.getTime() : MIN_DATE, 0];
+
+  let rows;
+  try {
+    rows = await all(db, ARROW_QUERY, [req.userEmail, ...key, to, ARROW_BATCH_SIZE]);
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Internal server error' });
+  }
+
+  const download = new Download(req, res, {
+    contentType: 'application/vnd.apache.arrow.stream',
+    filename: 'work-entries.arrow'
+  });
+  // client id -> dictionary index
+  const clientIndex = new Map();
+
+  try {
+    await download.write(encodeSchema(ARROW_FIELDS));
+    await download.write(encodeDictionary(0, []));
+
+    while (rows.length > 0 && !download.closed) {
+      const added = [];
+      rows.forEach((row) => {
+        if (!clientIndex.has(row.client_id)) {
+          clientIndex.set(row.client_id, clientIndex.size);
+          added.push(row.client_name);
+        }
+      });
+      if (added.length > 0) {
+        await download.write(encodeDictionary(0, added, { delta: true }));
+      }
+
+      await download.write(encodeRecordBatch(ARROW_FIELDS, [
+        rows.map((row) => row.id),
+        rows.map((row) => row.client_id),
+        rows.map((row) => clientIndex.get(row.client_id)),
+        rows.map((row) => row.hours),
+        rows.map((row) => row.description),
+        rows.map((row) => Math.floor(row.date / DAY_MS)),
+        rows.map((row) => timestamp(row.created_at)),
+        rows.map((row) => timestamp(row.updated_at))
+      ]));
+
+      if (rows.length < ARROW_BATCH_SIZE) {
+        break;
+      }
+      const last = rows[rows.length - 1];
+      key = [last.date, last.id];
+      rows = await all(db, ARROW_QUERY, [req.userEmail, ...key, to, ARROW_BATCH_SIZE]);
+    }
+
+    if (download.closed) {
+      return download.abort();
+    }
+    download.end(END_OF_STREAM);
+  } catch (err) {
+    // Without the end-of-stream marker readers report a truncated stream
+    console.error('Export failed:', err);
+    download.abort(err);
+  }
+});
+
+module.exports = router;
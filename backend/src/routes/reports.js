@@ -1,81 +1,339 @@
 const express = require('express');
 const { getDatabase } = require('../database/init');
+const { readFlights } = require('../database/singleFlight');
+const { workEntryCache } = require('../database/workEntryCache');
 const { authenticateUser } = require('../middleware/auth');
-const createCsvWriter = require('csv-writer').createObjectCsvWriter;
+const { dateRangeSchema, reportSummarySchema } = require('../validation/schemas');
+const { CsvEncoder } = require('../export/csvEncoder');
+const { aggregate, totalHours } = require('../reports/aggregate');
 const PDFDocument = require('pdfkit');
-const path = require('path');
-const fs = require('fs');
 
 const router = express.Router();
 
 // All routes require authentication
 router.use(authenticateUser);
 
-// Get hourly report for specific client
-router.get('/client/:clientId', (req, res) => {
+// Build the work entry query for a client report, bounded by the optional
+// ?from=&to= range so a report only covers the window being viewed
+function buildReportQuery(columns, clientId, userEmail, range) {
+  let query = `SELECT ${columns}
+         FROM work_entries 
+         WHERE client_id = ? AND user_email = ?`;
+  const params = [clientId, userEmail];
+
+  if (range.from !== undefined) {
+    query += ' AND date >= ?';
+    params.push(range.from);
+  }
+
+  if (range.to !== undefined) {
+    query += ' AND date <= ?';
+    params.push(range.to);
+  }
+
+  // The work entry list's order, which the cached window keeps too
+  query += ' ORDER BY date DESC, created_at DESC, id DESC';
+  return { query, params };
+}
+
+// Get hourly report for specific client. Ranges within the user's cached
+// window (database/workEntryCache.js) are reported from memory; otherwise
+// identical concurrent requests (several tabs opening the same report)
+// share one query.
+router.get('/client/:clientId', (req, res, next) => {
   const clientId = parseInt(req.params.clientId);
   
   if (isNaN(clientId)) {
     return res.status(400).json({ error: 'Invalid client ID' });
   }
+
+  const { error, value: range } = dateRangeSchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
   
-  const db = getDatabase();
-  
-  // Verify client belongs to user
-  db.get(
-    'SELECT id, name FROM clients WHERE id = ? AND user_email = ?',
-    [clientId, req.userEmail],
-    (err, client) => {
-      if (err) {
-        console.error('Database error:', err);
-        return res.status(500).json({ error: 'Internal server error' });
-      }
-      
-      if (!client) {
+  const db = getDatabase(req.userEmail);
+
+  const respond = (client, workEntries) => res.json({
+    client: client,
+    workEntries: workEntries,
+    totalHours: totalHours(workEntries),
+    entryCount: workEntries.length
+  });
+
+  workEntryCache.window(db, req.userEmail, range.from, (err, segment) => {
+    if (segment) {
+      if (!segment.clients.has(clientId)) {
         return res.status(404).json({ error: 'Client not found' });
       }
-      
-      // Get work entries for this client
-      db.all(
-        `SELECT id, hours, description, date, created_at, updated_at
-         FROM work_entries 
-         WHERE client_id = ? AND user_email = ? 
-         ORDER BY date DESC`,
-        [clientId, req.userEmail],
-        (err, workEntries) => {
-          if (err) {
-            console.error('Database error:', err);
-            return res.status(500).json({ error: 'Internal server error' });
+      const workEntries = segment.list({ clientId, from: range.from, to: range.to })
+        .map(({ client_id, client_name, ...entry }) => entry);
+      return respond({ id: clientId, name: segment.clients.get(clientId) }, workEntries);
+    }
+
+    // Verify client belongs to user
+    readFlights.get(
+      db,
+      req.userEmail,
+      'SELECT id, name FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
+      [clientId, req.userEmail],
+      (err, client) => {
+        if (err) {
+          console.error('Database error:', err);
+          return res.status(500).json({ error: 'Internal server error' });
+        }
+        
+        if (!client) {
+          return res.status(404).json({ error: 'Client not found' });
+        }
+        
+        // Get work entries for this client
+        const { query, params } = buildReportQuery(
+          'id, hours, description, date, created_at, updated_at',
+          clientId,
+          req.userEmail,
+          range
+        );
+
+        readFlights.all(
+          db,
+          req.userEmail,
+          query,
+          params,
+          (err, workEntries) => {
+            if (err) {
+              console.error('Database error:', err);
+              return res.status(500).json({ error: 'Internal server error' });
+            }
+
+            respond(client, workEntries);
           }
-          
-          // Calculate total hours
-          const totalHours = workEntries.reduce((sum, entry) => sum + parseFloat(entry.hours), 0);
-          
-          res.json({
-            client: client,
-            workEntries: workEntries,
-            totalHours: totalHours,
-            entryCount: workEntries.length
-          });
+        );
+      }
+    );
+  });
+});
+
+// Period label of a work entry's date (stored as epoch milliseconds, UTC)
+// for each summary grouping: the day, the Monday starting its ISO week, or
+// the month
+const PERIODS = {
+  day: "date(we.date / 1000, 'unixepoch')",
+  week: "date(we.date / 1000, 'unixepoch', 'weekday 0', '-6 days')",
+  month: "strftime('%Y-%m', we.date / 1000, 'unixepoch')"
+};
+
+// The same labels for the buckets of reports/aggregate.js
+const DAY_MS = 24 * 60 * 60 * 1000;
+const dayLabel = (day) => new Date(day * DAY_MS).toISOString().slice(0, 10);
+const PERIOD_LABELS = {
+  day: dayLabel,
+  week: (week) => dayLabel(week * 7 - 3),
+  month: (month) => `${Math.floor(month / 12)}-${String((month % 12) + 1).padStart(2, '0')}`
+};
+
+// Hours summed in SQL as aggregate() sums them: in whole hundredths, so
+// the total is exact and the same from either path
+const SQL_HOURS = 'SUM(CAST(ROUND(we.hours * 100) AS INTEGER)) / 100.0';
+
+// The summary query's rows from the columns of each client's entries
+// (reports/aggregate.js), or null if their dates span too long to bucket
+function summaryRows(columnsByClient, names, groupBy) {
+  const rows = [];
+  try {
+    columnsByClient.forEach((columns, clientId) => {
+      const name = names.get(clientId);
+      const totals = aggregate(columns);
+      if (groupBy === 'client') {
+        rows.push({ clientId, name, period: null, hours: totals.hours, entryCount: totals.count });
+        return;
+      }
+      const buckets = totals[groupBy];
+      buckets.counts.forEach((count, index) => {
+        if (count > 0) {
+          const period = PERIOD_LABELS[groupBy](buckets.start + index);
+          rows.push({ clientId, name, period, hours: buckets.hours[index], entryCount: count });
         }
-      );
+      });
+    });
+  } catch (error) {
+    if (error instanceof RangeError) {
+      return null;
+    }
+    throw error;
+  }
+  return rows;
+}
+
+// The user's work entries in the summary's range, selecting `columns`
+function buildSummaryQuery(columns, userEmail, { from, to }) {
+  let query = `SELECT ${columns}
+               FROM work_entries we
+               JOIN clients c ON c.id = we.client_id
+               WHERE we.user_email = ? AND c.deleted_at IS NULL`;
+  const params = [userEmail];
+
+  if (from !== undefined) {
+    query += ' AND we.date >= ?';
+    params.push(from);
+  }
+
+  if (to !== undefined) {
+    query += ' AND we.date <= ?';
+    params.push(to);
+  }
+
+  return { query, params };
+}
+
+// Hours for all of the user's clients, e.g. for month-end invoicing. With
+// groupBy=client each client gets its totals; with day, week or month also
+// `hours`, one number per entry of `periods` (0 where nothing was logged).
+// Only clients with entries in the range are listed. Ranges within the
+// user's cached window are bucketed by reports/aggregate.js straight from
+// its columns; anything else is one grouped query, so the entries never
+// leave the database.
+router.get('/summary', (req, res, next) => {
+  const { error, value } = reportSummarySchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
+
+  const period = PERIODS[value.groupBy];
+
+  const respond = (rows) => {
+    const periods = period ? [...new Set(rows.map((row) => row.period))].sort() : [];
+    const column = new Map(periods.map((label, index) => [label, index]));
+    const clients = new Map();
+    const periodTotals = periods.map(() => 0);
+    let totalHours = 0;
+    let entryCount = 0;
+
+    // Added up in hundredths, like the rows, so totals stay exact
+    rows.forEach((row) => {
+      let client = clients.get(row.clientId);
+      if (!client) {
+        client = { clientId: row.clientId, name: row.name, totalHours: 0, entryCount: 0 };
+        if (period) {
+          client.hours = periods.map(() => 0);
+        }
+        clients.set(row.clientId, client);
+      }
+      const hundredths = Math.round(row.hours * 100);
+      client.totalHours += hundredths;
+      client.entryCount += row.entryCount;
+      if (period) {
+        client.hours[column.get(row.period)] += hundredths;
+        periodTotals[column.get(row.period)] += hundredths;
+      }
+      totalHours += hundredths;
+      entryCount += row.entryCount;
+    });
+    clients.forEach((client) => {
+      client.totalHours /= 100;
+      if (period) {
+        client.hours = client.hours.map((hours) => hours / 100);
+      }
+    });
+
+    const summary = {
+      groupBy: value.groupBy,
+      from: value.from,
+      to: value.to,
+      periods,
+      clients: [...clients.values()].sort((a, b) => a.name.localeCompare(b.name) || a.clientId - b.clientId),
+      totalHours: totalHours / 100,
+      entryCount
+    };
+    if (period) {
+      summary.periodTotals = periodTotals.map((hours) => hours / 100);
     }
+    res.json(summary);
+  };
+
+  const db = getDatabase(req.userEmail);
+
+  const query = (columns, groupBy, callback) => {
+    const built = buildSummaryQuery(columns, req.userEmail, value);
+    readFlights.all(db, req.userEmail, built.query + groupBy, built.params, (err, rows) => {
+      if (err) {
+        console.error('Database error:', err);
+        return res.status(500).json({ error: 'Internal server error' });
+      }
+      callback(rows);
+    });
+  };
+
+  // Totals grouped in SQL, by client and period
+  const grouped = () => query(
+    `we.client_id AS clientId, c.name, ${period || 'NULL'} AS period, ${SQL_HOURS} AS hours, COUNT(*) AS entryCount`,
+    period ? ' GROUP BY we.client_id, period' : ' GROUP BY we.client_id',
+    respond
   );
+
+  workEntryCache.window(db, req.userEmail, value.from, (err, segment) => {
+    const cached = segment && summaryRows(segment.collect(value), segment.clients, value.groupBy);
+    // Also for a cached window spanning too long to bucket in memory
+    return cached ? respond(cached) : grouped();
+  });
 });
 
+// CSV report layout. Rows are written a batch at a time as they are
+// encoded (natively when the addon is built; see export/csvEncoder.js).
+const reportCsv = new CsvEncoder([
+  { title: 'Date', type: 'date' },
+  { title: 'Hours', type: 'number' },
+  { title: 'Description', type: 'text' },
+  { title: 'Created At', type: 'text' }
+]);
+
+// Work entry rows as the encoder's columns: dates in epoch milliseconds
+// (older rows may hold date strings) and hours as Float64Arrays
+function reportCsvColumns(workEntries) {
+  const dates = new Float64Array(workEntries.length);
+  const hours = new Float64Array(workEntries.length);
+  const descriptions = new Array(workEntries.length);
+  const createdAt = new Array(workEntries.length);
+  workEntries.forEach((entry, index) => {
+    dates[index] = typeof entry.date === 'number' ? entry.date : Date.parse(entry.date);
+    hours[index] = entry.hours;
+    descriptions[index] = entry.description;
+    createdAt[index] = entry.created_at;
+  });
+  return [dates, hours, descriptions, createdAt];
+}
+
+// Resolves once `res` can take more data, or the client has gone
+function drained(res) {
+  return new Promise((resolve) => {
+    const done = () => {
+      res.off('drain', done);
+      res.off('close', done);
+      resolve();
+    };
+    res.on('drain', done);
+    res.on('close', done);
+  });
+}
+
 // Export client report as CSV
-router.get('/export/csv/:clientId', (req, res) => {
+router.get('/export/csv/:clientId', (req, res, next) => {
   const clientId = parseInt(req.params.clientId);
   
   if (isNaN(clientId)) {
     return res.status(400).json({ error: 'Invalid client ID' });
   }
+
+  const { error, value: range } = dateRangeSchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
   
-  const db = getDatabase();
+  const db = getDatabase(req.userEmail);
   
   // Verify client belongs to user and get data
   db.get(
-    'SELECT id, name FROM clients WHERE id = ? AND user_email = ?',
+    'SELECT id, name FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
     [clientId, req.userEmail],
     (err, client) => {
       if (err) {
@@ -88,58 +346,54 @@ router.get('/export/csv/:clientId', (req, res) => {
       }
       
       // Get work entries
+      const { query, params } = buildReportQuery(
+        'hours, description, date, created_at',
+        clientId,
+        req.userEmail,
+        range
+      );
+
       db.all(
-        `SELECT hours, description, date, created_at
-         FROM work_entries 
-         WHERE client_id = ? AND user_email = ? 
-         ORDER BY date DESC`,
-        [clientId, req.userEmail],
-        (err, workEntries) => {
+        query,
+        params,
+        async (err, workEntries) => {
           if (err) {
             console.error('Database error:', err);
             return res.status(500).json({ error: 'Internal server error' });
           }
           
-          // Create temporary CSV file
           const timestamp = new Date().toISOString().replace(/[:.]/g, '-');
           const filename = `${client.name.replace(/[^a-zA-Z0-9]/g, '_')}_report_${timestamp}.csv`;
-          const tempPath = path.join(__dirname, '../../temp', filename);
-          
-          // Ensure temp directory exists
-          const tempDir = path.dirname(tempPath);
-          if (!fs.existsSync(tempDir)) {
-            fs.mkdirSync(tempDir, { recursive: true });
+
+          let chunks;
+          try {
+            chunks = reportCsv.rows(reportCsvColumns(workEntries), workEntries.length);
+            // Encode the first batch before committing to a 200
+            const first = chunks.next();
+            res.attachment(filename);
+            res.write(reportCsv.header());
+            if (!first.done) {
+              res.write(first.value);
+            }
+          } catch (error) {
+            console.error('Error creating CSV:', error);
+            return res.status(500).json({ error: 'Failed to generate CSV report' });
+          }
+
+          try {
+            for (const chunk of chunks) {
+              if (!res.write(chunk)) {
+                await drained(res);
+              }
+              if (res.destroyed) {
+                return;
+              }
+            }
+            res.end();
+          } catch (error) {
+            console.error('Error creating CSV:', error);
+            res.destroy(error);
           }
-          
-          const csvWriter = createCsvWriter({
-            path: tempPath,
-            header: [
-              { id: 'date', title: 'Date' },
-              { id: 'hours', title: 'Hours' },
-              { id: 'description', title: 'Description' },
-              { id: 'created_at', title: 'Created At' }
-            ]
-          });
-          
-          csvWriter.writeRecords(workEntries)
-            .then(() => {
-              // Send file and clean up
-              res.download(tempPath, filename, (err) => {
-                if (err) {
-                  console.error('Error sending file:', err);
-                }
-                // Clean up temp file
-                fs.unlink(tempPath, (unlinkErr) => {
-                  if (unlinkErr) {
-                    console.error('Error deleting temp file:', unlinkErr);
-                  }
-                });
-              });
-            })
-            .catch((error) => {
-              console.error('Error creating CSV:', error);
-              res.status(500).json({ error: 'Failed to generate CSV report' });
-            });
         }
       );
     }
@@ -147,18 +401,23 @@ router.get('/export/csv/:clientId', (req, res) => {
 });
 
 // Export client report as PDF
-router.get('/export/pdf/:clientId', (req, res) => {
+router.get('/export/pdf/:clientId', (req, res, next) => {
   const clientId = parseInt(req.params.clientId);
   
   if (isNaN(clientId)) {
     return res.status(400).json({ error: 'Invalid client ID' });
   }
+
+  const { error, value: range } = dateRangeSchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
   
-  const db = getDatabase();
+  const db = getDatabase(req.userEmail);
   
   // Verify client belongs to user and get data
   db.get(
-    'SELECT id, name FROM clients WHERE id = ? AND user_email = ?',
+    'SELECT id, name FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
     [clientId, req.userEmail],
     (err, client) => {
       if (err) {
@@ -171,12 +430,16 @@ router.get('/export/pdf/:clientId', (req, res) => {
       }
       
       // Get work entries
+      const { query, params } = buildReportQuery(
+        'hours, description, date, created_at',
+        clientId,
+        req.userEmail,
+        range
+      );
+
       db.all(
-        `SELECT hours, description, date, created_at
-         FROM work_entries 
-         WHERE client_id = ? AND user_email = ? 
-         ORDER BY date DESC`,
-        [clientId, req.userEmail],
+        query,
+        params,
         (err, workEntries) => {
           if (err) {
             console.error('Database error:', err);
@@ -199,8 +462,7 @@ router.get('/export/pdf/:clientId', (req, res) => {
           doc.fontSize(20).text(`Time Report for ${client.name}`, { align: 'center' });
           doc.moveDown();
           
-          const totalHours = workEntries.reduce((sum, entry) => sum + parseFloat(entry.hours), 0);
-          doc.fontSize(14).text(`Total Hours: ${totalHours.toFixed(2)}`);
+          doc.fontSize(14).text(`Total Hours: ${totalHours(workEntries).toFixed(2)}`);
           doc.text(`Total Entries: ${workEntries.length}`);
           doc.text(`Generated: ${new Date().toLocaleString()}`);
           doc.moveDown();
@@ -0,0 +1,142 @@
+const express = require('express');
+const { getDatabase } = require('../database/init');
+const { authenticateUser } = require('../middleware/auth');
+const { searchQuerySchema } = require('../validation/schemas');
+
+const router = express.Router();
+
+// All routes require authentication
+router.use(authenticateUser);
+
+const MAX_TERMS = 10;
+
+// Snippet delimiters; control characters can't appear in a tokenized match
+const MATCH_START = '\u0002';
+const MATCH_END = '\u0003';
+
+// Must match the `'u' || hex(user_email)` token written by the FTS triggers
+function ownerToken(userEmail) {
+  return 'u' + Buffer.from(userEmail, 'utf8').toString('hex');
+}
+
+// Turn free text into a safe FTS5 expression: every word becomes a quoted
+// prefix term, so FTS5 operators and punctuation in user input are inert.
+function buildMatchTerms(text) {
+  const words = text.match(/[\p{L}\p{N}]+/gu) || [];
+  return words.slice(0, MAX_TERMS).map((word) => `"${word}"*`).join(' ');
+}
+
+// Split an FTS5 snippet into plain/highlighted segments so clients can
+// render highlights without trusting HTML from the server
+function toSegments(snippet) {
+  const segments = [];
+  let rest = snippet || '';
+
+  while (rest.length > 0) {
+    const start = rest.indexOf(MATCH_START);
+    if (start === -1) {
+      segments.push({ text: rest, match: false });
+      break;
+    }
+    if (start > 0) {
+      segments.push({ text: rest.slice(0, start), match: false });
+    }
+    const end = rest.indexOf(MATCH_END, start);
+    const stop = end === -1 ? rest.length : end;
+    segments.push({ text: rest.slice(start + 1, stop), match: true });
+    rest = rest.slice(stop + 1);
+  }
+
+  return segments;
+}
+
+function searchWorkEntries(userEmail, terms, options) {
+  const params = [`owner:"${ownerToken(userEmail)}" AND description:(${terms})`, userEmail];
+  let query = `
+    SELECT we.id, we.client_id, we.hours, we.date, we.description, c.name as client_name,
+           snippet(work_entries_fts, 0, '${MATCH_START}', '${MATCH_END}', '…', 16) as snippet
+    FROM work_entries_fts
+    JOIN work_entries we ON we.id = work_entries_fts.rowid
+    JOIN clients c ON c.id = we.client_id
+    WHERE work_entries_fts MATCH ? AND we.user_email = ? AND c.deleted_at IS NULL
+  `;
+
+  if (options.from !== undefined) {
+    query += ' AND we.date >= ?';
+    params.push(options.from);
+  }
+
+  if (options.to !== undefined) {
+    query += ' AND we.date <= ?';
+    params.push(options.to);
+  }
+
+  // Owner column is weighted 0 so it doesn't affect relevance
+  query += ' ORDER BY bm25(work_entries_fts, 1.0, 0.0) LIMIT ? OFFSET ?';
+  params.push(options.limit + 1, options.offset);
+
+  return { query, params };
+}
+
+function searchClients(userEmail, terms, options) {
+  const query = `
+    SELECT c.id, c.name, c.description, c.department, c.email,
+           highlight(clients_fts, 0, '${MATCH_START}', '${MATCH_END}') as name_highlight,
+           snippet(clients_fts, 1, '${MATCH_START}', '${MATCH_END}', '…', 16) as snippet
+    FROM clients_fts
+    JOIN clients c ON c.id = clients_fts.rowid
+    WHERE clients_fts MATCH ? AND c.user_email = ? AND c.deleted_at IS NULL
+    ORDER BY bm25(clients_fts, 2.0, 1.0, 0.0) LIMIT ? OFFSET ?
+  `;
+  const params = [
+    `owner:"${ownerToken(userEmail)}" AND {name description}:(${terms})`,
+    userEmail,
+    options.limit + 1,
+    options.offset
+  ];
+
+  return { query, params };
+}
+
+// Ranked, paginated full-text search over the user's work entries or clients
+router.get('/', (req, res, next) => {
+  const { error, value } = searchQuerySchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
+
+  const terms = buildMatchTerms(value.q);
+  if (!terms) {
+    return res.status(400).json({ error: 'Search query must contain letters or numbers' });
+  }
+
+  const build = value.type === 'clients' ? searchClients : searchWorkEntries;
+  const { query, params } = build(req.userEmail, terms, value);
+  const db = getDatabase(req.userEmail);
+
+  db.all(query, params, (err, rows) => {
+    if (err) {
+      console.error('Database error:', err);
+      return res.status(500).json({ error: 'Internal server error' });
+    }
+
+    const hasMore = rows.length > value.limit;
+    const results = rows.slice(0, value.limit).map((row) => {
+      const result = { ...row, snippet: toSegments(row.snippet) };
+      if (row.name_highlight !== undefined) {
+        result.name_highlight = toSegments(row.name_highlight);
+      }
+      return result;
+    });
+
+    res.json({
+      results,
+      type: value.type,
+      limit: value.limit,
+      offset: value.offset,
+      hasMore
+    });
+  });
+});
+
+module.exports = router;
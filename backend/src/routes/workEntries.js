@@ -1,301 +1,318 @@
 const express = require('express');
 const { getDatabase } = require('../database/init');
+const { all } = require('../database/query');
+const { readFlights } = require('../database/singleFlight');
+const { workEntryCache } = require('../database/workEntryCache');
+const { ChangeLogVersionError, getCurrentVersion, readChanges } = require('../database/changeLog');
+const { getStorage } = require('../storage');
 const { authenticateUser } = require('../middleware/auth');
-const { workEntrySchema, updateWorkEntrySchema } = require('../validation/schemas');
+const { holdDatabase } = require('../middleware/holdDatabase');
+const { publishChange, publishResync } = require('../realtime/changeEvents');
+const { ImportError, importWorkEntries } = require('../import/workEntryImport');
+const {
+  workEntrySchema,
+  updateWorkEntrySchema,
+  workEntryQuerySchema,
+  changesQuerySchema
+} = require('../validation/schemas');
 
 const router = express.Router();
 
 // All routes require authentication
 router.use(authenticateUser);
 
-// Get all work entries for authenticated user (with optional client filter)
-router.get('/', (req, res) => {
-  const { clientId } = req.query;
-  const db = getDatabase();
-  
-  let query = `
-    SELECT we.id, we.client_id, we.hours, we.description, we.date, 
-           we.created_at, we.updated_at, c.name as client_name
-    FROM work_entries we
-    JOIN clients c ON we.client_id = c.id
-    WHERE we.user_email = ?
-  `;
-  
-  const params = [req.userEmail];
-  
+// Keyset pagination cursor: the sort key of the last row on a page
+function encodeCursor(row) {
+  return Buffer.from(JSON.stringify([row.date, row.created_at, row.id])).toString('base64url');
+}
+
+function decodeCursor(cursor) {
+  try {
+    const key = JSON.parse(Buffer.from(cursor, 'base64url').toString('utf8'));
+    return Array.isArray(key) && key.length === 3 ? key : null;
+  } catch (error) {
+    return null;
+  }
+}
+
+// Get work entries for authenticated user, filtered in SQL by client,
+// date range and hours so clients only download the window they show.
+// With ?limit= the list is paged by an opaque keyset cursor. Identical
+// concurrent requests share one query; ranges starting within the hot
+// cache's window (database/workEntryCache.js) don't query at all.
+router.get('/', (req, res, next) => {
+  const { clientId, ...filters } = req.query;
+
+  const { error, value } = workEntryQuerySchema.validate(filters);
+  if (error) {
+    return next(error);
+  }
+
+  let clientIdNum;
   if (clientId) {
-    const clientIdNum = parseInt(clientId);
+    clientIdNum = parseInt(clientId);
     if (isNaN(clientIdNum)) {
       return res.status(400).json({ error: 'Invalid client ID' });
     }
-    query += ' AND we.client_id = ?';
-    params.push(clientIdNum);
   }
+
+  let key;
+  if (value.cursor !== undefined) {
+    key = decodeCursor(value.cursor);
+    if (!key) {
+      return res.status(400).json({ error: 'Invalid cursor' });
+    }
+  }
+
+  const query = { ...value, clientId: clientIdNum, cursor: key };
   
-  query += ' ORDER BY we.date DESC, we.created_at DESC';
-  
-  db.all(query, params, (err, rows) => {
-    if (err) {
-      console.error('Database error:', err);
-      return res.status(500).json({ error: 'Internal server error' });
+  const respond = (rows) => {
+    if (value.limit === undefined) {
+      return res.json({ workEntries: rows });
+    }
+
+    const page = rows.slice(0, value.limit);
+    res.json({
+      workEntries: page,
+      nextCursor: rows.length > value.limit ? encodeCursor(page[page.length - 1]) : null
+    });
+  };
+
+  // Ranges within the user's recent window are listed from memory
+  workEntryCache.window(getDatabase(req.userEmail), req.userEmail, value.from, (err, segment) => {
+    const cached = segment && segment.list(query);
+    if (cached) {
+      return respond(cached);
     }
-    
-    res.json({ workEntries: rows });
+
+    // Fetch one extra row to know whether another page exists
+    const listed = { ...query, limit: value.limit === undefined ? undefined : value.limit + 1 };
+    readFlights.run(req.userEmail, `listWorkEntries:${JSON.stringify(listed)}`, (done) => {
+      getStorage(req.userEmail).listWorkEntries(req.userEmail, listed).then((rows) => done(null, rows), done);
+    }, (err, rows) => {
+      if (err) {
+        console.error('Database error:', err);
+        return res.status(500).json({ error: 'Internal server error' });
+      }
+      respond(rows);
+    });
   });
 });
 
+const ENTRY_COLUMNS = `we.id, we.client_id, we.hours, we.description, we.date,
+                       we.created_at, we.updated_at, c.name as client_name`;
+
+// Delta sync. `since` is the `version` returned by a previous call; the
+// response holds the entries inserted or updated after it and tombstones
+// (ids in `deleted`) for entries deleted after it. since=0 returns a full
+// snapshot. Large deltas are paged: repeat with the new version while
+// `hasMore` is true.
+router.get('/changes', async (req, res, next) => {
+  const { error, value } = changesQuerySchema.validate(req.query);
+  if (error) {
+    return next(error);
+  }
+
+  const db = getDatabase(req.userEmail);
+
+  try {
+    if (value.since === 0) {
+      // Version first: anything changed while reading is sent again next time
+      const version = await getCurrentVersion(db);
+      const rows = await all(db, `
+        SELECT ${ENTRY_COLUMNS}
+        FROM work_entries we
+        JOIN clients c ON we.client_id = c.id
+        WHERE we.user_email = ? AND c.deleted_at IS NULL
+        ORDER BY we.date DESC, we.created_at DESC, we.id DESC
+      `, [req.userEmail]);
+      return res.json({ workEntries: rows, deleted: [], version, hasMore: false });
+    }
+
+    const changes = await readChanges(db, {
+      userEmail: req.userEmail,
+      entity: 'work_entry',
+      since: value.since,
+      limit: value.limit
+    });
+    const rows = changes.ids.length === 0 ? [] : await all(db, `
+      SELECT ${ENTRY_COLUMNS}
+      FROM work_entries we
+      JOIN clients c ON we.client_id = c.id
+      WHERE we.user_email = ? AND we.id IN (SELECT value FROM json_each(?)) AND c.deleted_at IS NULL
+    `, [req.userEmail, JSON.stringify(changes.ids)]);
+
+    const existing = new Set(rows.map((row) => row.id));
+    res.json({
+      workEntries: rows,
+      deleted: changes.ids.filter((id) => !existing.has(id)),
+      version: changes.version,
+      hasMore: changes.hasMore
+    });
+  } catch (err) {
+    if (err instanceof ChangeLogVersionError) {
+      return res.status(410).json({ error: err.message, version: err.version });
+    }
+    console.error('Database error:', err);
+    res.status(500).json({ error: 'Internal server error' });
+  }
+});
+
 // Get specific work entry
-router.get('/:id', (req, res) => {
+router.get('/:id', async (req, res) => {
   const workEntryId = parseInt(req.params.id);
   
   if (isNaN(workEntryId)) {
     return res.status(400).json({ error: 'Invalid work entry ID' });
   }
   
-  const db = getDatabase();
-  
-  db.get(
-    `SELECT we.id, we.client_id, we.hours, we.description, we.date, 
-            we.created_at, we.updated_at, c.name as client_name
-     FROM work_entries we
-     JOIN clients c ON we.client_id = c.id
-     WHERE we.id = ? AND we.user_email = ?`,
-    [workEntryId, req.userEmail],
-    (err, row) => {
-      if (err) {
-        console.error('Database error:', err);
-        return res.status(500).json({ error: 'Internal server error' });
-      }
-      
-      if (!row) {
-        return res.status(404).json({ error: 'Work entry not found' });
-      }
-      
-      res.json({ workEntry: row });
+  try {
+    const row = await getStorage(req.userEmail).getWorkEntry(req.userEmail, workEntryId);
+    if (!row) {
+      return res.status(404).json({ error: 'Work entry not found' });
     }
-  );
+    res.json({ workEntry: row });
+  } catch (err) {
+    console.error('Database error:', err);
+    res.status(500).json({ error: 'Internal server error' });
+  }
 });
 
 // Create new work entry
-router.post('/', (req, res, next) => {
+router.post('/', async (req, res, next) => {
+  const { error, value } = workEntrySchema.validate(req.body);
+  if (error) {
+    return next(error);
+  }
+
+  const storage = getStorage(req.userEmail);
+
+  // Verify client exists and belongs to user
   try {
-    const { error, value } = workEntrySchema.validate(req.body);
-    if (error) {
-      return next(error);
+    if (!await storage.getClient(req.userEmail, value.clientId)) {
+      return res.status(400).json({ error: 'Client not found or does not belong to user' });
     }
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Internal server error' });
+  }
 
-    const { clientId, hours, description, date } = value;
-    const db = getDatabase();
-
-    // Verify client exists and belongs to user
-    db.get(
-      'SELECT id FROM clients WHERE id = ? AND user_email = ?',
-      [clientId, req.userEmail],
-      (err, row) => {
-        if (err) {
-          console.error('Database error:', err);
-          return res.status(500).json({ error: 'Internal server error' });
-        }
-
-        if (!row) {
-          return res.status(400).json({ error: 'Client not found or does not belong to user' });
-        }
-
-        // Create work entry
-        db.run(
-          'INSERT INTO work_entries (client_id, user_email, hours, description, date) VALUES (?, ?, ?, ?, ?)',
-          [clientId, req.userEmail, hours, description || null, date],
-          function(err) {
-            if (err) {
-              console.error('Database error:', err);
-              return res.status(500).json({ error: 'Failed to create work entry' });
-            }
-
-            // Return the created work entry with client name
-            db.get(
-              `SELECT we.id, we.client_id, we.hours, we.description, we.date, 
-                      we.created_at, we.updated_at, c.name as client_name
-               FROM work_entries we
-               JOIN clients c ON we.client_id = c.id
-               WHERE we.id = ?`,
-              [this.lastID],
-              (err, row) => {
-                if (err) {
-                  console.error('Database error:', err);
-                  return res.status(500).json({ error: 'Work entry created but failed to retrieve' });
-                }
-
-                res.status(201).json({
-                  message: 'Work entry created successfully',
-                  workEntry: row
-                });
-              }
-            );
-          }
-        );
-      }
-    );
-  } catch (error) {
-    next(error);
+  let row;
+  try {
+    row = await storage.insertWorkEntry(req.userEmail, { ...value, description: value.description || null });
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Failed to create work entry' });
   }
+
+  publishChange(req.userEmail, { entity: 'work_entry', op: 'upsert', row });
+
+  res.status(201).json({
+    message: 'Work entry created successfully',
+    workEntry: row
+  });
 });
 
-// Update work entry
-router.put('/:id', (req, res, next) => {
+// Bulk import from a CSV upload (Content-Type: text/csv). The body is parsed
+// as it streams in, not buffered, so it isn't bound by the JSON body limit.
+// Responds with { imported, failed, errors: [{ line, error }] }; see
+// import/workEntryImport.js for the columns.
+router.post('/import', holdDatabase, async (req, res) => {
+  if (!req.is('text/csv')) {
+    return res.status(415).json({ error: 'Upload the file as text/csv' });
+  }
+
   try {
-    const workEntryId = parseInt(req.params.id);
-    
-    if (isNaN(workEntryId)) {
-      return res.status(400).json({ error: 'Invalid work entry ID' });
+    const report = await importWorkEntries(getDatabase(req.userEmail), req.userEmail, req);
+    if (report.imported > 0) {
+      publishResync(req.userEmail);
+    }
+    res.json(report);
+  } catch (err) {
+    // Rows before the failure stay imported
+    if (!(err instanceof ImportError) || err.imported > 0) {
+      publishResync(req.userEmail);
+    }
+    if (err instanceof ImportError) {
+      return res.status(400).json({ error: err.message, line: err.line, imported: err.imported });
     }
+    console.error('Database error:', err);
+    res.status(500).json({ error: 'Failed to import work entries' });
+  }
+});
+
+// Update work entry
+router.put('/:id', async (req, res, next) => {
+  const workEntryId = parseInt(req.params.id);
+  
+  if (isNaN(workEntryId)) {
+    return res.status(400).json({ error: 'Invalid work entry ID' });
+  }
+
+  const { error, value } = updateWorkEntrySchema.validate(req.body);
+  if (error) {
+    return next(error);
+  }
+
+  const storage = getStorage(req.userEmail);
 
-    const { error, value } = updateWorkEntrySchema.validate(req.body);
-    if (error) {
-      return next(error);
+  // Check the work entry exists and belongs to user, and if clientId is
+  // being updated, that the client does too
+  try {
+    if (!await storage.getWorkEntry(req.userEmail, workEntryId)) {
+      return res.status(404).json({ error: 'Work entry not found' });
+    }
+    if (value.clientId && !await storage.getClient(req.userEmail, value.clientId)) {
+      return res.status(400).json({ error: 'Client not found or does not belong to user' });
     }
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Internal server error' });
+  }
 
-    const db = getDatabase();
-
-    // Check if work entry exists and belongs to user
-    db.get(
-      'SELECT id FROM work_entries WHERE id = ? AND user_email = ?',
-      [workEntryId, req.userEmail],
-      (err, row) => {
-        if (err) {
-          console.error('Database error:', err);
-          return res.status(500).json({ error: 'Internal server error' });
-        }
-
-        if (!row) {
-          return res.status(404).json({ error: 'Work entry not found' });
-        }
-
-        // If clientId is being updated, verify it belongs to user
-        if (value.clientId) {
-          db.get(
-            'SELECT id FROM clients WHERE id = ? AND user_email = ?',
-            [value.clientId, req.userEmail],
-            (err, clientRow) => {
-              if (err) {
-                console.error('Database error:', err);
-                return res.status(500).json({ error: 'Internal server error' });
-              }
-
-              if (!clientRow) {
-                return res.status(400).json({ error: 'Client not found or does not belong to user' });
-              }
-
-              performUpdate();
-            }
-          );
-        } else {
-          performUpdate();
-        }
-
-        function performUpdate() {
-          // Build update query dynamically
-          const updates = [];
-          const values = [];
-
-          if (value.clientId !== undefined) {
-            updates.push('client_id = ?');
-            values.push(value.clientId);
-          }
-
-          if (value.hours !== undefined) {
-            updates.push('hours = ?');
-            values.push(value.hours);
-          }
-
-          if (value.description !== undefined) {
-            updates.push('description = ?');
-            values.push(value.description || null);
-          }
-
-          if (value.date !== undefined) {
-            updates.push('date = ?');
-            values.push(value.date);
-          }
-
-          updates.push('updated_at = CURRENT_TIMESTAMP');
-          values.push(workEntryId, req.userEmail);
-
-          const query = `UPDATE work_entries SET ${updates.join(', ')} WHERE id = ? AND user_email = ?`;
-
-          db.run(query, values, function(err) {
-            if (err) {
-              console.error('Database error:', err);
-              return res.status(500).json({ error: 'Failed to update work entry' });
-            }
-
-            // Return updated work entry with client name
-            db.get(
-              `SELECT we.id, we.client_id, we.hours, we.description, we.date, 
-                      we.created_at, we.updated_at, c.name as client_name
-               FROM work_entries we
-               JOIN clients c ON we.client_id = c.id
-               WHERE we.id = ?`,
-              [workEntryId],
-              (err, row) => {
-                if (err) {
-                  console.error('Database error:', err);
-                  return res.status(500).json({ error: 'Work entry updated but failed to retrieve' });
-                }
-
-                res.json({
-                  message: 'Work entry updated successfully',
-                  workEntry: row
-                });
-              }
-            );
-          });
-        }
-      }
-    );
-  } catch (error) {
-    next(error);
+  let row;
+  try {
+    row = await storage.updateWorkEntry(req.userEmail, workEntryId, value);
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Failed to update work entry' });
   }
+
+  // Deleted in the meantime
+  if (!row) {
+    return res.status(404).json({ error: 'Work entry not found' });
+  }
+
+  publishChange(req.userEmail, { entity: 'work_entry', op: 'upsert', row });
+
+  res.json({
+    message: 'Work entry updated successfully',
+    workEntry: row
+  });
 });
 
 // Delete work entry
-router.delete('/:id', (req, res) => {
+router.delete('/:id', async (req, res) => {
   const workEntryId = parseInt(req.params.id);
   
   if (isNaN(workEntryId)) {
     return res.status(400).json({ error: 'Invalid work entry ID' });
   }
   
-  const db = getDatabase();
-  
-  // Check if work entry exists and belongs to user
-  db.get(
-    'SELECT id FROM work_entries WHERE id = ? AND user_email = ?',
-    [workEntryId, req.userEmail],
-    (err, row) => {
-      if (err) {
-        console.error('Database error:', err);
-        return res.status(500).json({ error: 'Internal server error' });
-      }
-      
-      if (!row) {
-        return res.status(404).json({ error: 'Work entry not found' });
-      }
-      
-      // Delete work entry
-      db.run(
-        'DELETE FROM work_entries WHERE id = ? AND user_email = ?',
-        [workEntryId, req.userEmail],
-        function(err) {
-          if (err) {
-            console.error('Database error:', err);
-            return res.status(500).json({ error: 'Failed to delete work entry' });
-          }
-          
-          res.json({ message: 'Work entry deleted successfully' });
-        }
-      );
-    }
-  );
+  let deleted;
+  try {
+    deleted = await getStorage(req.userEmail).deleteWorkEntry(req.userEmail, workEntryId);
+  } catch (err) {
+    console.error('Database error:', err);
+    return res.status(500).json({ error: 'Failed to delete work entry' });
+  }
+
+  if (!deleted) {
+    return res.status(404).json({ error: 'Work entry not found' });
+  }
+
+  publishChange(req.userEmail, { entity: 'work_entry', op: 'delete', id: workEntryId });
+  res.json({ message: 'Work entry deleted successfully' });
 });
 
 module.exports = router;
@@ -2,32 +2,45 @@ const express = require('express');
 const cors = require('cors');
 const helmet = require('helmet');
 const morgan = require('morgan');
-const rateLimit = require('express-rate-limit');
 
 const authRoutes = require('./routes/auth');
 const clientRoutes = require('./routes/clients');
 const workEntryRoutes = require('./routes/workEntries');
 const reportRoutes = require('./routes/reports');
+const searchRoutes = require('./routes/search');
+const eventRoutes = require('./routes/events');
+const exportRoutes = require('./routes/export');
+const batchRoutes = require('./routes/batch');
 
-const { initializeDatabase } = require('./database/init');
+const { initializeDatabase, getDatabase, eachDatabase, getShardStats, checkpointDatabase, closeDatabase } = require('./database/init');
+const { startChangeLogCompaction } = require('./database/changeLog');
+const { checkSigningKey } = require('./auth/tokens');
+const { clientPurger } = require('./database/clientPurge');
+const { readFlights } = require('./database/singleFlight');
+const { workEntryCache } = require('./database/workEntryCache');
+const { ServerLifecycle, flushOutput } = require('./lifecycle/serverLifecycle');
+const { registry } = require('./realtime/changeEvents');
 const { errorHandler } = require('./middleware/errorHandler');
+const { createRateLimiter, createRateLimitStore } = require('./middleware/rateLimit');
 
 const app = express();
 const PORT = process.env.PORT || 3001;
+const lifecycle = new ServerLifecycle();
+
+// Track in-flight requests so SIGTERM can drain them
+app.use(lifecycle.middleware());
 
 // Security middleware
 app.use(helmet());
 app.use(cors({
   origin: process.env.FRONTEND_URL || 'http://localhost:5173',
-  credentials: true
+  credentials: true,
+  exposedHeaders: ['RateLimit-Policy', 'RateLimit-Limit', 'RateLimit-Remaining', 'RateLimit-Reset', 'Retry-After']
 }));
 
-// Rate limiting
-const limiter = rateLimit({
-  windowMs: 15 * 60 * 1000, // 15 minutes
-  max: 100 // limit each IP to 100 requests per windowMs
-});
-app.use(limiter);
+// Rate limiting: a token bucket per user (per IP before login), with
+// per-route costs; see middleware/rateLimit.js
+app.use('/api', createRateLimiter({ store: createRateLimitStore(getDatabase) }));
 
 // Logging
 app.use(morgan('combined'));
@@ -38,14 +51,31 @@ app.use(express.urlencoded({ extended: true }));
 
 // Health check
 app.get('/health', (req, res) => {
-  res.status(200).json({ status: 'OK', timestamp: new Date().toISOString() });
+  res.status(200).json({
+    status: 'OK',
+    timestamp: new Date().toISOString(),
+    // Reads served by joining an identical in-flight query
+    singleFlight: readFlights.stats(),
+    // Reads served from cached recent windows
+    workEntryCache: workEntryCache.stats(),
+    // Open and pinned database shards, when sharding is on
+    shards: getShardStats()
+  });
 });
 
+// Liveness and readiness for orchestrators: not ready while draining
+app.get('/health/live', (req, res) => lifecycle.liveness(req, res));
+app.get('/health/ready', (req, res) => lifecycle.readiness(req, res));
+
 // Routes
 app.use('/api/auth', authRoutes);
 app.use('/api/clients', clientRoutes);
 app.use('/api/work-entries', workEntryRoutes);
 app.use('/api/reports', reportRoutes);
+app.use('/api/search', searchRoutes);
+app.use('/api/events', eventRoutes);
+app.use('/api/export', exportRoutes);
+app.use('/api/batch', batchRoutes);
 
 // Error handling
 app.use(errorHandler);
@@ -58,8 +88,22 @@ app.use('*', (req, res) => {
 // Initialize database and start server
 async function startServer() {
   try {
+    checkSigningKey();
     await initializeDatabase();
-    app.listen(PORT, () => {
+    const stopCompaction = startChangeLogCompaction(eachDatabase);
+    clientPurger.start(eachDatabase);
+
+    lifecycle
+      .onDrain('close event streams', () => registry.closeAll())
+      .onClose('stop change log compaction', stopCompaction)
+      .onClose('stop client purger', () => clientPurger.stop())
+      .onClose('checkpoint database', checkpointDatabase)
+      .onClose('close database', closeDatabase)
+      .onClose('flush logs', flushOutput);
+    lifecycle.handleSignals();
+
+    const server = app.listen(PORT, () => {
+      lifecycle.ready(server);
       console.log(`Server running on port ${PORT}`);
       console.log(`Health check: http://localhost:${PORT}/health`);
     });
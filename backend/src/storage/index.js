@@ -0,0 +1,60 @@
+const { getDatabase } = require('../database/init');
+const { SqliteStorage } = require('./sqlite');
+
+// Storage layer for work entries, with one adapter per database:
+//   sqlite    storage/sqlite.js, on the app's SQLite connection (default)
+//   postgres  storage/postgres.js, on a pool to DATABASE_URL
+// chosen by STORAGE_BACKEND. Every adapter passes the same conformance
+// suite (__tests__/storage/conformance.test.js) and implements, all
+// returning promises:
+//
+//   migrate()                                 create or update the schema
+//   createUser(email)
+//   createClient(userEmail, { name, description })        -> client
+//   getClient(userEmail, id)                  -> client or undefined
+//   insertWorkEntry(userEmail, { clientId, hours, description, date }) -> entry
+//   insertWorkEntries(userEmail, entries)     bulk insert -> count
+//   getWorkEntry(userEmail, id)               -> entry or undefined
+//   listWorkEntries(userEmail, { clientId, clientIds, from, to,
+//                                minHours, maxHours, cursor, limit })
+//                                             newest first; `cursor` is the
+//                                             [date, created_at, id] of the
+//                                             previous page's last entry
+//   updateWorkEntry(userEmail, id, fields)    -> entry or undefined
+//   deleteWorkEntry(userEmail, id)            -> whether it existed
+//   hoursByClient(userEmail, { from, to })    -> [{ clientId, name, hours, entryCount }]
+//   close()
+//
+// Entries are rows as the API returns them: { id, client_id, hours,
+// description, date, created_at, updated_at, client_name }, dates in epoch
+// milliseconds. Clients must belong to the user; callers check that, as
+// the routes do, before inserting. Entries of a deleted client are neither
+// read nor written.
+//
+// The server keeps all its data in SQLite, so the routes use getStorage():
+// the SQLite adapter on the user's database (their shard, when sharded).
+// STORAGE_BACKEND only picks the default for createStorage(), which tools
+// and benchmarks use.
+
+function createStorage({ backend = process.env.STORAGE_BACKEND || 'sqlite', ...options } = {}) {
+  switch (backend) {
+    case 'sqlite':
+      return new SqliteStorage(options.db || getDatabase());
+    case 'postgres': {
+      // Loaded on demand: pg is only installed where it's used
+      const { PostgresStorage } = require('./postgres');
+      return new PostgresStorage(options);
+    }
+    default:
+      throw new Error(`Unknown storage backend: ${backend}`);
+  }
+}
+
+function getStorage(userEmail) {
+  return SqliteStorage.for(getDatabase(userEmail));
+}
+
+module.exports = {
+  createStorage,
+  getStorage
+};
@@ -0,0 +1,316 @@
+const { Readable } = require('stream');
+const { pipeline } = require('stream/promises');
+const { ENTRY_ORDER, LIVE_CLIENT, entryFilters, entryUpdates } = require('./sql');
+
+// Work entry storage on PostgreSQL (see storage/index.js for the
+// interface), through a pg connection pool. Queries are named, so each is
+// prepared once per pooled connection; bulk inserts stream COPY ... FROM
+// STDIN. The pg and pg-copy-streams packages aren't dependencies of the
+// server, which runs on SQLite; they're loaded when this backend is used
+// and installed where it is (the conformance suite, benchmarks, tools).
+//
+// Rows come back as SQLite returns them: dates as epoch milliseconds,
+// hours as numbers, timestamps as 'YYYY-MM-DD HH:MM:SS' (UTC).
+
+const DEFAULT_POOL_SIZE = 10;
+const COPY_CHUNK_ROWS = 1000;
+
+const ENTRY_COLUMNS = `we.id, we.client_id, we.hours, we.description, we.date::float8 AS date,
+                       to_char(we.created_at, 'YYYY-MM-DD HH24:MI:SS') AS created_at,
+                       to_char(we.updated_at, 'YYYY-MM-DD HH24:MI:SS') AS updated_at,
+                       c.name AS client_name`;
+
+// The schema the adapter reads and writes, matching the SQLite migrations
+// (database/migrations/): the tables the routes share, the change log and
+// its triggers (005, 008, 009), and full-text search (004), here a
+// generated tsvector column with a GIN index in place of FTS5 tables.
+// Triggers need PostgreSQL 14 or later (CREATE OR REPLACE TRIGGER).
+const SCHEMA = [
+  `CREATE TABLE IF NOT EXISTS users (
+    email TEXT PRIMARY KEY,
+    created_at TIMESTAMP(0) NOT NULL DEFAULT CURRENT_TIMESTAMP
+  )`,
+  `CREATE TABLE IF NOT EXISTS clients (
+    id INTEGER GENERATED BY DEFAULT AS IDENTITY PRIMARY KEY,
+    name TEXT NOT NULL,
+    description TEXT,
+    department TEXT,
+    email TEXT,
+    user_email TEXT NOT NULL REFERENCES users (email) ON DELETE CASCADE,
+    created_at TIMESTAMP(0) NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    updated_at TIMESTAMP(0) NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    deleted_at TIMESTAMP(0),
+    purge_entries INTEGER,
+    search TSVECTOR GENERATED ALWAYS AS (
+      setweight(to_tsvector('english', name), 'A') || to_tsvector('english', coalesce(description, ''))
+    ) STORED
+  )`,
+  `CREATE TABLE IF NOT EXISTS work_entries (
+    id INTEGER GENERATED BY DEFAULT AS IDENTITY PRIMARY KEY,
+    client_id INTEGER NOT NULL REFERENCES clients (id) ON DELETE CASCADE,
+    user_email TEXT NOT NULL REFERENCES users (email) ON DELETE CASCADE,
+    hours DOUBLE PRECISION NOT NULL,
+    description TEXT,
+    date BIGINT NOT NULL,
+    created_at TIMESTAMP(0) NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    updated_at TIMESTAMP(0) NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    search TSVECTOR GENERATED ALWAYS AS (to_tsvector('english', coalesce(description, ''))) STORED
+  )`,
+  'CREATE INDEX IF NOT EXISTS idx_clients_user_email ON clients (user_email)',
+  'CREATE INDEX IF NOT EXISTS idx_clients_deleted_at ON clients (deleted_at) WHERE deleted_at IS NOT NULL',
+  'CREATE INDEX IF NOT EXISTS idx_clients_search ON clients USING GIN (search)',
+  'CREATE INDEX IF NOT EXISTS idx_work_entries_user_date ON work_entries (user_email, date, created_at, id)',
+  'CREATE INDEX IF NOT EXISTS idx_work_entries_client_id ON work_entries (client_id)',
+  'CREATE INDEX IF NOT EXISTS idx_work_entries_search ON work_entries USING GIN (search)',
+  `CREATE TABLE IF NOT EXISTS change_log (
+    seq BIGINT GENERATED ALWAYS AS IDENTITY PRIMARY KEY,
+    user_email TEXT NOT NULL,
+    entity TEXT NOT NULL CHECK (entity IN ('client', 'work_entry', 'client_entries')),
+    entity_id INTEGER NOT NULL,
+    op TEXT NOT NULL CHECK (op IN ('insert', 'update', 'delete')),
+    changed_at TIMESTAMP(0) NOT NULL DEFAULT CURRENT_TIMESTAMP
+  )`,
+  'CREATE INDEX IF NOT EXISTS idx_change_log_user_entity_seq ON change_log (user_email, entity, seq)',
+  'CREATE INDEX IF NOT EXISTS idx_change_log_entity_seq ON change_log (entity, entity_id, seq)',
+  `CREATE TABLE IF NOT EXISTS change_log_state (
+    id INTEGER PRIMARY KEY CHECK (id = 1),
+    compacted_through BIGINT NOT NULL DEFAULT 0
+  )`,
+  'INSERT INTO change_log_state (id, compacted_through) VALUES (1, 0) ON CONFLICT DO NOTHING',
+  `CREATE TABLE IF NOT EXISTS change_log_user_floor (
+    user_email TEXT PRIMARY KEY,
+    version BIGINT NOT NULL
+  )`,
+  // log_change(entity[, op]): one change_log row for the row changed, with
+  // the trigger's operation unless `op` is given
+  `CREATE OR REPLACE FUNCTION log_change() RETURNS trigger LANGUAGE plpgsql AS $$
+  BEGIN
+    IF TG_OP = 'DELETE' THEN
+      INSERT INTO change_log (user_email, entity, entity_id, op)
+      VALUES (OLD.user_email, TG_ARGV[0], OLD.id, coalesce(TG_ARGV[1], 'delete'));
+      RETURN OLD;
+    END IF;
+    INSERT INTO change_log (user_email, entity, entity_id, op)
+    VALUES (NEW.user_email, TG_ARGV[0], NEW.id, coalesce(TG_ARGV[1], lower(TG_OP)));
+    RETURN NEW;
+  END
+  $$`,
+  ...[['clients', 'client'], ['work_entries', 'work_entry']].map(([table, entity]) => `
+    CREATE OR REPLACE TRIGGER ${table}_change_log AFTER INSERT OR UPDATE OR DELETE ON ${table}
+    FOR EACH ROW EXECUTE FUNCTION log_change('${entity}')`),
+  // Work entries carry their client's name, and go with their client
+  `CREATE OR REPLACE TRIGGER clients_change_log_rename AFTER UPDATE OF name ON clients
+    FOR EACH ROW WHEN (NEW.name IS DISTINCT FROM OLD.name)
+    EXECUTE FUNCTION log_change('client_entries', 'update')`,
+  `CREATE OR REPLACE TRIGGER clients_change_log_soft_delete AFTER UPDATE OF deleted_at ON clients
+    FOR EACH ROW WHEN (OLD.deleted_at IS NULL AND NEW.deleted_at IS NOT NULL)
+    EXECUTE FUNCTION log_change('client_entries', 'delete')`
+];
+
+function loadDriver(name) {
+  try {
+    return require(name);
+  } catch (err) {
+    throw new Error(`The PostgreSQL storage backend needs the ${name} package (npm install --no-save pg pg-copy-streams)`);
+  }
+}
+
+// Collects parameters for `$n` placeholders
+function binder() {
+  const params = [];
+  const bind = (value) => {
+    params.push(value);
+    return `$${params.length}`;
+  };
+  return { params, bind };
+}
+
+// A value in COPY's text format
+function copyField(value) {
+  if (value === null || value === undefined) {
+    return '\\N';
+  }
+  return String(value).replace(/[\\\t\n\r]/g, (char) => ({ '\\': '\\\\', '\t': '\\t', '\n': '\\n', '\r': '\\r' })[char]);
+}
+
+// COPY text rows, COPY_CHUNK_ROWS lines per chunk
+function* copyRows(userEmail, entries) {
+  for (let start = 0; start < entries.length; start += COPY_CHUNK_ROWS) {
+    let chunk = '';
+    entries.slice(start, start + COPY_CHUNK_ROWS).forEach(({ clientId, hours, description, date }) => {
+      chunk += `${[clientId, userEmail, hours, description, Number(date)].map(copyField).join('\t')}\n`;
+    });
+    yield chunk;
+  }
+}
+
+class PostgresStorage {
+  // `schema` puts the tables in their own schema (created by migrate()),
+  // e.g. to isolate a test run
+  constructor({
+    connectionString = process.env.DATABASE_URL,
+    poolSize = Number(process.env.PG_POOL_SIZE) || DEFAULT_POOL_SIZE,
+    schema = null
+  } = {}) {
+    if (schema && !/^[a-z_][a-z0-9_]*$/.test(schema)) {
+      throw new Error(`Invalid schema name: ${schema}`);
+    }
+    const { Pool } = loadDriver('pg');
+    const options = ['-c TimeZone=UTC'];
+    if (schema) {
+      options.push(`-c search_path=${schema}`);
+    }
+    this.schema = schema;
+    this.pool = new Pool({ connectionString, max: poolSize, options: options.join(' ') });
+    this.pool.on('error', (err) => console.error('PostgreSQL pool error:', err));
+    this.names = new Map();
+  }
+
+  get name() {
+    return 'postgres';
+  }
+
+  // Run a statement as a named (prepared) query
+  async query(text, params = []) {
+    let name = this.names.get(text);
+    if (!name) {
+      name = `storage_${this.names.size + 1}`;
+      this.names.set(text, name);
+    }
+    return this.pool.query({ name, text, values: params });
+  }
+
+  async migrate() {
+    const client = await this.pool.connect();
+    try {
+      await client.query('BEGIN');
+      if (this.schema) {
+        await client.query(`CREATE SCHEMA IF NOT EXISTS ${this.schema}`);
+      }
+      for (const statement of SCHEMA) {
+        await client.query(statement);
+      }
+      await client.query('COMMIT');
+    } catch (err) {
+      await client.query('ROLLBACK');
+      throw err;
+    } finally {
+      client.release();
+    }
+  }
+
+  async createUser(email) {
+    await this.query('INSERT INTO users (email) VALUES ($1) ON CONFLICT DO NOTHING', [email]);
+  }
+
+  async createClient(userEmail, { name, description = null }) {
+    const { rows } = await this.query(`
+      INSERT INTO clients (name, description, user_email) VALUES ($1, $2, $3)
+      RETURNING id, name, description,
+                to_char(created_at, 'YYYY-MM-DD HH24:MI:SS') AS created_at,
+                to_char(updated_at, 'YYYY-MM-DD HH24:MI:SS') AS updated_at
+    `, [name, description, userEmail]);
+    return rows[0];
+  }
+
+  async getClient(userEmail, id) {
+    const { rows } = await this.query(`
+      SELECT id, name, description,
+             to_char(created_at, 'YYYY-MM-DD HH24:MI:SS') AS created_at,
+             to_char(updated_at, 'YYYY-MM-DD HH24:MI:SS') AS updated_at
+      FROM clients
+      WHERE id = $1 AND user_email = $2 AND deleted_at IS NULL
+    `, [id, userEmail]);
+    return rows[0];
+  }
+
+  async insertWorkEntry(userEmail, { clientId, hours, description = null, date }) {
+    const { rows } = await this.query(
+      'INSERT INTO work_entries (client_id, user_email, hours, description, date) VALUES ($1, $2, $3, $4, $5) RETURNING id',
+      [clientId, userEmail, hours, description, Number(date)]
+    );
+    return this.getWorkEntry(userEmail, rows[0].id);
+  }
+
+  // One COPY, streamed in chunks
+  async insertWorkEntries(userEmail, entries) {
+    if (entries.length === 0) {
+      return 0;
+    }
+    const { from: copyFrom } = loadDriver('pg-copy-streams');
+    const client = await this.pool.connect();
+    try {
+      const copy = client.query(copyFrom(
+        'COPY work_entries (client_id, user_email, hours, description, date) FROM STDIN'
+      ));
+      await pipeline(Readable.from(copyRows(userEmail, entries)), copy);
+    } finally {
+      client.release();
+    }
+    return entries.length;
+  }
+
+  async getWorkEntry(userEmail, id) {
+    const { rows } = await this.query(`
+      SELECT ${ENTRY_COLUMNS}
+      FROM work_entries we
+      JOIN clients c ON we.client_id = c.id
+      WHERE we.id = $1 AND we.user_email = $2 AND c.deleted_at IS NULL
+    `, [id, userEmail]);
+    return rows[0];
+  }
+
+  async listWorkEntries(userEmail, filters = {}) {
+    const { params, bind } = binder();
+    let sql = `
+      SELECT ${ENTRY_COLUMNS}
+      FROM work_entries we
+      JOIN clients c ON we.client_id = c.id
+      WHERE we.user_email = ${bind(userEmail)} AND c.deleted_at IS NULL${entryFilters(filters, bind)}
+      ORDER BY ${ENTRY_ORDER}`;
+    if (filters.limit !== undefined) {
+      sql += ` LIMIT ${bind(filters.limit)}`;
+    }
+    const { rows } = await this.query(sql, params);
+    return rows;
+  }
+
+  async updateWorkEntry(userEmail, id, fields) {
+    const { params, bind } = binder();
+    const { rowCount } = await this.query(
+      `UPDATE work_entries SET ${entryUpdates(fields, bind)} WHERE id = ${bind(id)} AND user_email = ${bind(userEmail)} AND ${LIVE_CLIENT}`,
+      params
+    );
+    return rowCount > 0 ? this.getWorkEntry(userEmail, id) : undefined;
+  }
+
+  async deleteWorkEntry(userEmail, id) {
+    const { rowCount } = await this.query(
+      `DELETE FROM work_entries WHERE id = $1 AND user_email = $2 AND ${LIVE_CLIENT}`,
+      [id, userEmail]
+    );
+    return rowCount > 0;
+  }
+
+  async hoursByClient(userEmail, { from, to } = {}) {
+    const { params, bind } = binder();
+    const { rows } = await this.query(`
+      SELECT we.client_id AS "clientId", c.name, SUM(we.hours) AS hours, COUNT(*)::int AS "entryCount"
+      FROM work_entries we
+      JOIN clients c ON c.id = we.client_id
+      WHERE we.user_email = ${bind(userEmail)} AND c.deleted_at IS NULL${entryFilters({ from, to }, bind)}
+      GROUP BY we.client_id, c.name
+      ORDER BY c.name COLLATE "C", we.client_id
+    `, params);
+    return rows;
+  }
+
+  close() {
+    return this.pool.end();
+  }
+}
+
+module.exports = {
+  PostgresStorage,
+  copyField
+};
@@ -0,0 +1,66 @@
+// SQL shared by the storage adapters. `bind(value)` adds a parameter and
+// returns its placeholder (`?` for SQLite, `$n` for PostgreSQL), so each
+// combination of filters is one statement, prepared once.
+
+// Work entry lists are newest first; ties (same date) go by creation
+const ENTRY_ORDER = 'we.date DESC, we.created_at DESC, we.id DESC';
+
+// Conditions for the optional work entry filters. Dates are epoch
+// milliseconds (numbers or Dates); `cursor` is the [date, created_at, id]
+// of the last entry of the previous page.
+function entryFilters({ clientId, clientIds, from, to, minHours, maxHours, cursor }, bind) {
+  let sql = '';
+  if (clientId !== undefined && clientId !== null) {
+    sql += ` AND we.client_id = ${bind(clientId)}`;
+  }
+  if (clientIds && clientIds.length > 0) {
+    sql += ` AND we.client_id IN (${clientIds.map((id) => bind(id)).join(', ')})`;
+  }
+  if (from !== undefined && from !== null) {
+    sql += ` AND we.date >= ${bind(Number(from))}`;
+  }
+  if (to !== undefined && to !== null) {
+    sql += ` AND we.date <= ${bind(Number(to))}`;
+  }
+  if (minHours !== undefined && minHours !== null) {
+    sql += ` AND we.hours >= ${bind(minHours)}`;
+  }
+  if (maxHours !== undefined && maxHours !== null) {
+    sql += ` AND we.hours <= ${bind(maxHours)}`;
+  }
+  if (cursor) {
+    sql += ` AND (we.date, we.created_at, we.id) < (${bind(Number(cursor[0]))}, ${bind(cursor[1])}, ${bind(cursor[2])})`;
+  }
+  return sql;
+}
+
+// Entries of a deleted client are gone for every reader and writer, though
+// the purger (database/clientPurge.js) may not have removed them yet. The
+// check only looks up the entry's own client, by primary key.
+const LIVE_CLIENT = 'EXISTS (SELECT 1 FROM clients c WHERE c.id = work_entries.client_id AND c.deleted_at IS NULL)';
+
+// SET clause for the fields present in a work entry update
+function entryUpdates({ clientId, hours, description, date }, bind) {
+  const updates = [];
+  if (clientId !== undefined) {
+    updates.push(`client_id = ${bind(clientId)}`);
+  }
+  if (hours !== undefined) {
+    updates.push(`hours = ${bind(hours)}`);
+  }
+  if (description !== undefined) {
+    updates.push(`description = ${bind(description || null)}`);
+  }
+  if (date !== undefined) {
+    updates.push(`date = ${bind(Number(date))}`);
+  }
+  updates.push('updated_at = CURRENT_TIMESTAMP');
+  return updates.join(', ');
+}
+
+module.exports = {
+  ENTRY_ORDER,
+  LIVE_CLIENT,
+  entryFilters,
+  entryUpdates
+};
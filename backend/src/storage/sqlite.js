@@ -0,0 +1,222 @@
+const { runMigrations } = require('../database/migrate');
+const { noteBulkChange, noteChange } = require('../database/readCoherence');
+const { ENTRY_ORDER, LIVE_CLIENT, entryFilters, entryUpdates } = require('./sql');
+
+// Work entry storage on SQLite (see storage/index.js for the interface).
+// Wraps one sqlite3 connection, the app's own by default: SQLite serializes
+// writers anyway, so a pool would only add contention. Statements are
+// prepared once and reused.
+//
+// The routes get their adapter from SqliteStorage.for(db), one per
+// connection. A connection can't close while statements are prepared on
+// it, so whoever closes one calls SqliteStorage.release(db) first.
+//
+// Every write is reported to database/readCoherence.js as it commits, so
+// the process's shared queries and cached windows never answer from before
+// it.
+
+const INSERT_BATCH_SIZE = 500;
+
+const ENTRY_COLUMNS = `we.id, we.client_id, we.hours, we.description, we.date,
+                       we.created_at, we.updated_at, c.name AS client_name`;
+
+const adapters = new WeakMap();
+
+function insertStatement(rows) {
+  return `INSERT INTO work_entries (client_id, user_email, hours, description, date) VALUES ${
+    new Array(rows).fill('(?, ?, ?, ?, ?)').join(', ')
+  }`;
+}
+
+// Collects parameters for `?` placeholders
+function binder() {
+  const params = [];
+  const bind = (value) => {
+    params.push(value);
+    return '?';
+  };
+  return { params, bind };
+}
+
+class SqliteStorage {
+  constructor(db) {
+    this.db = db;
+    this.statements = new Map();
+  }
+
+  // The adapter on `db`, created on first use
+  static for(db) {
+    let storage = adapters.get(db);
+    if (!storage) {
+      storage = new SqliteStorage(db);
+      adapters.set(db, storage);
+    }
+    return storage;
+  }
+
+  // Finalize the statements of `db`'s adapter, if it has one
+  static async release(db) {
+    const storage = adapters.get(db);
+    if (storage) {
+      adapters.delete(db);
+      await storage.close();
+    }
+  }
+
+  get name() {
+    return 'sqlite';
+  }
+
+  statement(sql) {
+    let statement = this.statements.get(sql);
+    if (!statement) {
+      statement = this.db.prepare(sql);
+      this.statements.set(sql, statement);
+    }
+    return statement;
+  }
+
+  run(sql, params) {
+    return new Promise((resolve, reject) => {
+      this.statement(sql).run(params, function(err) {
+        if (err) {
+          return reject(err);
+        }
+        resolve({ lastID: this.lastID, changes: this.changes });
+      });
+    });
+  }
+
+  get(sql, params) {
+    return new Promise((resolve, reject) => {
+      this.statement(sql).get(params, (err, row) => (err ? reject(err) : resolve(row)));
+    });
+  }
+
+  all(sql, params) {
+    return new Promise((resolve, reject) => {
+      this.statement(sql).all(params, (err, rows) => (err ? reject(err) : resolve(rows)));
+    });
+  }
+
+  migrate() {
+    return runMigrations(this.db);
+  }
+
+  async createUser(email) {
+    await this.run('INSERT OR IGNORE INTO users (email) VALUES (?)', [email]);
+  }
+
+  async createClient(userEmail, { name, description = null }) {
+    const { lastID } = await this.run(
+      'INSERT INTO clients (name, description, user_email) VALUES (?, ?, ?)',
+      [name, description, userEmail]
+    );
+    const client = await this.get('SELECT id, name, description, created_at, updated_at FROM clients WHERE id = ?', [lastID]);
+    noteChange(userEmail, { entity: 'client', op: 'upsert', row: client });
+    return client;
+  }
+
+  getClient(userEmail, id) {
+    return this.get(
+      'SELECT id, name, description, created_at, updated_at FROM clients WHERE id = ? AND user_email = ? AND deleted_at IS NULL',
+      [id, userEmail]
+    );
+  }
+
+  async insertWorkEntry(userEmail, { clientId, hours, description = null, date }) {
+    const { lastID } = await this.run(
+      'INSERT INTO work_entries (client_id, user_email, hours, description, date) VALUES (?, ?, ?, ?, ?)',
+      [clientId, userEmail, hours, description, Number(date)]
+    );
+    const entry = await this.getWorkEntry(userEmail, lastID);
+    noteChange(userEmail, { entity: 'work_entry', op: 'upsert', row: entry });
+    return entry;
+  }
+
+  // Multi-row INSERTs of up to INSERT_BATCH_SIZE entries
+  async insertWorkEntries(userEmail, entries) {
+    for (let start = 0; start < entries.length; start += INSERT_BATCH_SIZE) {
+      const batch = entries.slice(start, start + INSERT_BATCH_SIZE);
+      const params = [];
+      batch.forEach(({ clientId, hours, description = null, date }) => {
+        params.push(clientId, userEmail, hours, description, Number(date));
+      });
+      await this.run(insertStatement(batch.length), params);
+      noteBulkChange(userEmail);
+    }
+    return entries.length;
+  }
+
+  getWorkEntry(userEmail, id) {
+    return this.get(`
+      SELECT ${ENTRY_COLUMNS}
+      FROM work_entries we
+      JOIN clients c ON we.client_id = c.id
+      WHERE we.id = ? AND we.user_email = ? AND c.deleted_at IS NULL
+    `, [id, userEmail]);
+  }
+
+  listWorkEntries(userEmail, filters = {}) {
+    const { params, bind } = binder();
+    let sql = `
+      SELECT ${ENTRY_COLUMNS}
+      FROM work_entries we
+      JOIN clients c ON we.client_id = c.id
+      WHERE we.user_email = ${bind(userEmail)} AND c.deleted_at IS NULL${entryFilters(filters, bind)}
+      ORDER BY ${ENTRY_ORDER}`;
+    if (filters.limit !== undefined) {
+      sql += ` LIMIT ${bind(filters.limit)}`;
+    }
+    return this.all(sql, params);
+  }
+
+  async updateWorkEntry(userEmail, id, fields) {
+    const { params, bind } = binder();
+    const { changes } = await this.run(
+      `UPDATE work_entries SET ${entryUpdates(fields, bind)} WHERE id = ${bind(id)} AND user_email = ${bind(userEmail)} AND ${LIVE_CLIENT}`,
+      params
+    );
+    if (changes === 0) {
+      return undefined;
+    }
+    const entry = await this.getWorkEntry(userEmail, id);
+    noteChange(userEmail, { entity: 'work_entry', op: 'upsert', row: entry });
+    return entry;
+  }
+
+  async deleteWorkEntry(userEmail, id) {
+    const { changes } = await this.run(
+      `DELETE FROM work_entries WHERE id = ? AND user_email = ? AND ${LIVE_CLIENT}`,
+      [id, userEmail]
+    );
+    if (changes > 0) {
+      noteChange(userEmail, { entity: 'work_entry', op: 'delete', id });
+    }
+    return changes > 0;
+  }
+
+  hoursByClient(userEmail, { from, to } = {}) {
+    const { params, bind } = binder();
+    return this.all(`
+      SELECT we.client_id AS "clientId", c.name, SUM(we.hours) AS hours, COUNT(*) AS "entryCount"
+      FROM work_entries we
+      JOIN clients c ON c.id = we.client_id
+      WHERE we.user_email = ${bind(userEmail)} AND c.deleted_at IS NULL${entryFilters({ from, to }, bind)}
+      GROUP BY we.client_id, c.name
+      ORDER BY c.name, we.client_id
+    `, params);
+  }
+
+  // Finalize the prepared statements; the connection stays open for its
+  // owner to close
+  async close() {
+    const statements = [...this.statements.values()];
+    this.statements.clear();
+    await Promise.all(statements.map((statement) => new Promise((resolve) => statement.finalize(resolve))));
+  }
+}
+
+module.exports = {
+  SqliteStorage
+};
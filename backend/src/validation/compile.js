@@ -0,0 +1,286 @@
+const Joi = require('joi');
+
+// Compiles Joi object schemas into plain validator functions.
+//
+// Joi interprets its schema tree on every call, which costs microseconds and
+// several allocations per field. From schema.describe() we generate one
+// straight-line function per schema that handles the common case of input
+// that is already valid (optionally after the conversions Joi does by
+// default: trimming, numeric strings, ISO date strings, defaults).
+//
+// The generated code only accepts what Joi is certain to accept. Anything
+// else - every invalid payload, and valid but unusual ones such as hours
+// with more decimals than the precision - is handed to Joi itself, so error
+// messages, details and edge-case conversions stay exactly Joi's.
+//
+// Schemas using features the compiler doesn't model (references, `when`,
+// arrays, custom messages, ...) are not compiled; their validate() is Joi's.
+
+class UnsupportedSchemaError extends Error {}
+
+const unsupported = (what) => {
+  throw new UnsupportedSchemaError(`Unsupported in compiled validators: ${what}`);
+};
+
+// Strict subset of the ISO 8601 forms Joi's date().iso() accepts
+const ISO_DATE = /^\d{4}-(0[1-9]|1[0-2])-(0[1-9]|[12]\d|3[01])(T([01]\d|2[0-3]):[0-5]\d(:[0-5]\d(\.\d{1,3})?)?(Z|[+-]([01]\d|2[0-3]):[0-5]\d)?)?$/;
+// Numeric strings Joi converts to exactly Number(value)
+const NUMERIC = /^-?(0|[1-9]\d{0,14})(\.\d{1,6})?$/;
+
+// Helpers available to generated code
+const runtime = {
+  // Number of decimal places as Joi's precision rule counts them
+  decimals(number) {
+    const text = String(number);
+    if (text.includes('e')) {
+      return Infinity;
+    }
+    const dot = text.indexOf('.');
+    return dot === -1 ? 0 : text.length - dot - 1;
+  },
+
+  // A finite, safe number or numeric string -> number; undefined when Joi's
+  // own conversion could differ
+  toNumber(value) {
+    let number = value;
+    if (typeof value === 'string') {
+      if (!NUMERIC.test(value)) {
+        return undefined;
+      }
+      number = Number(value);
+      if (String(number) !== value) {
+        return undefined;
+      }
+    }
+    if (typeof number !== 'number' || !Number.isFinite(number) || Object.is(number, -0) ||
+        Math.abs(number) > Number.MAX_SAFE_INTEGER) {
+      return undefined;
+    }
+    return number;
+  },
+
+  toIsoDate(value) {
+    if (typeof value !== 'string' || !ISO_DATE.test(value)) {
+      return undefined;
+    }
+    const date = new Date(value);
+    return Number.isNaN(date.getTime()) ? undefined : date;
+  }
+};
+
+const literal = (value) => JSON.stringify(value);
+
+function checkKeys(description, allowed, what) {
+  Object.keys(description).forEach((key) => {
+    if (!allowed.includes(key)) {
+      unsupported(`${what} ${key}`);
+    }
+  });
+}
+
+function ruleArg(rule, name) {
+  const value = rule.args && rule.args[name];
+  if (value !== null && typeof value === 'object') {
+    // { ref: ... } or similar
+    unsupported(`${rule.name} with a reference`);
+  }
+  return value;
+}
+
+// Code that converts and checks `v` for one field, or jumps to the slow
+// path. `helpers` collects per-field Joi schemas some rules delegate to.
+function compileField(key, description, helpers) {
+  checkKeys(description, ['type', 'flags', 'rules', 'allow'], 'field option');
+  const flags = description.flags || {};
+  checkKeys(flags, ['presence', 'default', 'only', 'format'], 'flag');
+
+  const lines = [];
+  const fail = 'return slow(input);';
+  const allow = description.allow || [];
+  if (allow.some((value) => typeof value !== 'string')) {
+    unsupported('non-string allow()');
+  }
+
+  switch (description.type) {
+    case 'string': {
+      if (flags.format) {
+        unsupported('string format');
+      }
+      lines.push(`if (typeof v !== 'string') ${fail}`);
+      const rules = description.rules || [];
+      if (rules.some((rule) => rule.name === 'trim' && ruleArg(rule, 'enabled') !== false)) {
+        lines.push('v = v.trim();');
+      }
+      if (flags.only) {
+        // valid(...): the value must be one of the listed strings
+        lines.push(`if (!${literal(allow)}.includes(v)) ${fail}`);
+        break;
+      }
+      // allow('') short-circuits the remaining rules, as in Joi
+      const checks = [];
+      rules.forEach((rule) => {
+        switch (rule.name) {
+          case 'trim':
+            break;
+          case 'min':
+            checks.push(`if (v.length < ${ruleArg(rule, 'limit')}) ${fail}`);
+            break;
+          case 'max':
+            checks.push(`if (v.length > ${ruleArg(rule, 'limit')}) ${fail}`);
+            break;
+          case 'email': {
+            // Address validation (with the TLD list) is Joi's; only this
+            // field is checked by it
+            const options = (rule.args && rule.args.options) || {};
+            helpers.push(Joi.string().email(options));
+            checks.push(`if (helpers[${helpers.length - 1}].validate(v).error) ${fail}`);
+            break;
+          }
+          default:
+            unsupported(`string rule ${rule.name}`);
+        }
+      });
+      if (allow.length > 0) {
+        lines.push(
+          `if (!${literal(allow)}.includes(v)) {`,
+          `  if (v === '') ${fail}`,
+          ...checks.map((line) => `  ${line}`),
+          '}'
+        );
+      } else {
+        lines.push(`if (v === '') ${fail}`, ...checks);
+      }
+      break;
+    }
+
+    case 'number': {
+      if (allow.length > 0 || flags.only || flags.format) {
+        unsupported('number allow/valid/format');
+      }
+      lines.push(`v = toNumber(v);`, `if (v === undefined) ${fail}`);
+      (description.rules || []).forEach((rule) => {
+        switch (rule.name) {
+          case 'integer':
+            lines.push(`if (!Number.isInteger(v)) ${fail}`);
+            break;
+          case 'sign':
+            lines.push(ruleArg(rule, 'sign') === 'positive'
+              ? `if (!(v > 0)) ${fail}`
+              : `if (!(v < 0)) ${fail}`);
+            break;
+          case 'min':
+            lines.push(`if (v < ${ruleArg(rule, 'limit')}) ${fail}`);
+            break;
+          case 'max':
+            lines.push(`if (v > ${ruleArg(rule, 'limit')}) ${fail}`);
+            break;
+          case 'precision':
+            lines.push(`if (decimals(v) > ${ruleArg(rule, 'limit')}) ${fail}`);
+            break;
+          default:
+            unsupported(`number rule ${rule.name}`);
+        }
+      });
+      break;
+    }
+
+    case 'date': {
+      if (allow.length > 0 || flags.only || flags.format !== 'iso' || description.rules) {
+        unsupported('date other than date().iso()');
+      }
+      lines.push(`v = toIsoDate(v);`, `if (v === undefined) ${fail}`);
+      break;
+    }
+
+    default:
+      unsupported(`type ${description.type}`);
+  }
+
+  const missing = [];
+  if (flags.presence === 'required') {
+    missing.push(fail);
+  } else if (flags.presence && flags.presence !== 'optional') {
+    unsupported(`presence ${flags.presence}`);
+  } else if (flags.default !== undefined) {
+    if (typeof flags.default === 'object') {
+      unsupported('non-literal default');
+    }
+    missing.push(`value[${literal(key)}] = ${literal(flags.default)};`);
+  }
+
+  return [
+    `v = input[${literal(key)}];`,
+    'if (v === undefined) {',
+    ...missing.map((line) => `  ${line}`),
+    '} else {',
+    ...lines.map((line) => `  ${line}`),
+    `  value[${literal(key)}] = v;`,
+    '}'
+  ].join('\n');
+}
+
+// Generate the fast-path source for an object schema description
+function generate(description, helpers) {
+  if (description.type !== 'object' || !description.keys) {
+    unsupported('schemas other than Joi.object({...})');
+  }
+  checkKeys(description, ['type', 'keys', 'rules'], 'object option');
+
+  const keys = Object.keys(description.keys);
+  const objectChecks = (description.rules || []).map((rule) => {
+    if (rule.name !== 'min') {
+      unsupported(`object rule ${rule.name}`);
+    }
+    return `if (Object.keys(input).length < ${ruleArg(rule, 'limit')}) return slow(input);`;
+  });
+
+  return [
+    `if (typeof input !== 'object' || input === null || Array.isArray(input)) return slow(input);`,
+    // Unknown keys are an error in Joi
+    'const present = Object.keys(input);',
+    'for (let i = 0; i < present.length; i++) {',
+    `  if (!${literal(keys)}.includes(present[i])) return slow(input);`,
+    '}',
+    ...objectChecks,
+    // Joi's result keeps the input's key order, with defaults added after
+    'const value = { ...input };',
+    'let v;',
+    ...keys.map((key) => compileField(key, description.keys[key], helpers)),
+    'return { value };'
+  ].join('\n');
+}
+
+// Returns { validate, schema, compiled, source }. validate() has Joi's
+// signature and result shape; calls with options always go to Joi.
+function compileSchema(schema, name = 'schema') {
+  const slowValidate = (input, options) => schema.validate(input, options);
+
+  let source;
+  let fast;
+  try {
+    const helpers = [];
+    source = generate(schema.describe(), helpers);
+    const factory = new Function(
+      'slow', 'helpers', 'toNumber', 'toIsoDate', 'decimals',
+      `return function ${name.replace(/\W/g, '_')}(input) {\n${source}\n};`
+    );
+    fast = factory(slowValidate, helpers, runtime.toNumber, runtime.toIsoDate, runtime.decimals);
+  } catch (error) {
+    if (!(error instanceof UnsupportedSchemaError)) {
+      throw error;
+    }
+    return { validate: slowValidate, schema, compiled: false, reason: error.message };
+  }
+
+  return {
+    validate: (input, options) => (options === undefined ? fast(input) : slowValidate(input, options)),
+    schema,
+    compiled: true,
+    source
+  };
+}
+
+module.exports = {
+  compileSchema,
+  UnsupportedSchemaError
+};
@@ -1,4 +1,5 @@
 const Joi = require('joi');
+const { compileSchema } = require('./compile');
 
 const clientSchema = Joi.object({
   name: Joi.string().trim().min(1).max(255).required(),
@@ -28,14 +29,82 @@ const updateClientSchema = Joi.object({
   email: Joi.string().trim().email().max(255).optional().allow('')
 }).min(1); // At least one field must be provided
 
+const dateRangeSchema = Joi.object({
+  from: Joi.date().iso().optional(),
+  to: Joi.date().iso().optional()
+    .when('from', { is: Joi.exist(), then: Joi.date().min(Joi.ref('from')) })
+});
+
+const workEntryQuerySchema = dateRangeSchema.keys({
+  clientIds: Joi.array().items(Joi.number().integer().positive()).single().max(100).optional(),
+  minHours: Joi.number().min(0).max(24).optional(),
+  maxHours: Joi.number().min(0).max(24).optional()
+    .when('minHours', { is: Joi.exist(), then: Joi.number().min(Joi.ref('minHours')) }),
+  limit: Joi.number().integer().min(1).max(1000).optional(),
+  cursor: Joi.string().max(500).optional()
+});
+
+// GET /api/reports/summary: hours per client, optionally split into
+// day/week/month periods
+const reportSummarySchema = dateRangeSchema.keys({
+  groupBy: Joi.string().valid('client', 'day', 'week', 'month').default('client')
+});
+
+const changesQuerySchema = Joi.object({
+  since: Joi.number().integer().min(0).default(0),
+  limit: Joi.number().integer().min(1).max(5000).default(1000)
+});
+
+const searchQuerySchema = dateRangeSchema.keys({
+  q: Joi.string().trim().min(1).max(200).required(),
+  type: Joi.string().valid('entries', 'clients').default('entries'),
+  limit: Joi.number().integer().min(1).max(100).default(20),
+  offset: Joi.number().integer().min(0).max(10000).default(0)
+});
+
 const emailSchema = Joi.object({
   email: Joi.string().email().required()
 });
 
-module.exports = {
+const refreshTokenSchema = Joi.object({
+  refreshToken: Joi.string().required()
+});
+
+// GET /api/export/account.ndjson: `after` resumes after the given record,
+// `client:<id>` or `work_entry:<date>:<id>`
+const accountExportSchema = Joi.object({
+  after: Joi.string().pattern(/^(client:\d+|work_entry:-?\d+:\d+)$/).optional()
+});
+
+// POST /api/batch: sub-requests against the other API routes
+const batchSchema = Joi.object({
+  requests: Joi.array().items(Joi.object({
+    id: Joi.string().max(100).optional(),
+    method: Joi.string().valid('GET', 'POST', 'PUT', 'DELETE').required(),
+    path: Joi.string().pattern(/^\/api\//).max(2000).required(),
+    query: Joi.object().optional(),
+    body: Joi.object().optional()
+  })).min(1).max(20).required()
+});
+
+// Exported validators are compiled (see compile.js) where the schema allows;
+// each has Joi's validate() signature, and `.schema` is the Joi schema.
+const compiled = (schemas) => Object.fromEntries(
+  Object.entries(schemas).map(([name, schema]) => [name, compileSchema(schema, name)])
+);
+
+module.exports = compiled({
   clientSchema,
   workEntrySchema,
   updateWorkEntrySchema,
   updateClientSchema,
-  emailSchema
-};
+  dateRangeSchema,
+  workEntryQuerySchema,
+  reportSummarySchema,
+  changesQuerySchema,
+  searchQuerySchema,
+  emailSchema,
+  refreshTokenSchema,
+  accountExportSchema,
+  batchSchema
+});
@@ -1,94 +1,124 @@
 const sqlite3 = require('sqlite3').verbose();
 const path = require('path');
 const fs = require('fs');
+const { run } = require('./query');
+const { runMigrations, runOnlineMigrations } = require('./migrate');
+const { ShardRouter } = require('./shards');
+const { SqliteStorage } = require('../storage/sqlite');
 
 let db = null;
+let router = null;
 let isClosing = false;
 let isClosed = false;
 
-function getDatabase() {
+function openDatabase(dbPath) {
+  // Ensure the directory exists for file-based database
+  if (dbPath !== ':memory:') {
+    const dbDir = path.dirname(dbPath);
+    if (!fs.existsSync(dbDir)) {
+      fs.mkdirSync(dbDir, { recursive: true });
+    }
+  }
+
+  const database = new sqlite3.Database(dbPath, (err) => {
+    if (err) {
+      console.error('Error opening database:', err);
+      throw err;
+    }
+    const dbType = dbPath === ':memory:' ? 'in-memory' : `file: ${dbPath}`;
+    console.log(`Connected to SQLite database (${dbType})`);
+  });
+  // Enable foreign keys (must be set outside a transaction). exec() runs
+  // exclusively, so this lands before any statement queued behind it.
+  database.exec('PRAGMA foreign_keys = ON');
+  return database;
+}
+
+// With DATABASE_SHARDS set, a user's data lives in their shard (see
+// database/shards.js); without a user, or unsharded, this is the main
+// database.
+function getDatabase(userEmail) {
+  if (router && userEmail) {
+    return router.database(userEmail);
+  }
   if (!db) {
     // Reset state when creating a new database connection
     isClosing = false;
     isClosed = false;
     // Use file-based database in production, in-memory for development/testing
-    const dbPath = process.env.DATABASE_PATH || ':memory:';
-    
-    // Ensure the directory exists for file-based database
-    if (dbPath !== ':memory:') {
-      const dbDir = path.dirname(dbPath);
-      if (!fs.existsSync(dbDir)) {
-        fs.mkdirSync(dbDir, { recursive: true });
-      }
-    }
-    
-    db = new sqlite3.Database(dbPath, (err) => {
-      if (err) {
-        console.error('Error opening database:', err);
-        throw err;
-      }
-      const dbType = dbPath === ':memory:' ? 'in-memory' : `file: ${dbPath}`;
-      console.log(`Connected to SQLite database (${dbType})`);
-    });
+    db = openDatabase(process.env.DATABASE_PATH || ':memory:');
   }
   return db;
 }
 
-async function initializeDatabase() {
-  const database = getDatabase();
-  
-  return new Promise((resolve, reject) => {
-    database.serialize(() => {
-      // Enable foreign keys
-      database.run('PRAGMA foreign_keys = ON');
-      
-      // Create users table
-      database.run(`
-        CREATE TABLE IF NOT EXISTS users (
-          email TEXT PRIMARY KEY,
-          created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-        )
-      `);
+// Run `fn` on every database holding user data in turn, for background jobs
+async function eachDatabase(fn) {
+  if (router) {
+    return router.each(fn);
+  }
+  return fn(getDatabase());
+}
 
-      // Create clients table
-      database.run(`
-        CREATE TABLE IF NOT EXISTS clients (
-          id INTEGER PRIMARY KEY AUTOINCREMENT,
-          name TEXT NOT NULL,
-          description TEXT,
-          user_email TEXT NOT NULL,
-          created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          FOREIGN KEY (user_email) REFERENCES users (email) ON DELETE CASCADE
-        )
-      `);
+// The user's database for a request using it over a while (a streamed
+// export, an import), kept open until `release()` so a sweep can't close
+// its shard between queries
+function acquireDatabase(userEmail) {
+  if (router && userEmail) {
+    return router.acquire(userEmail);
+  }
+  return { db: getDatabase(userEmail), release: () => {} };
+}
 
-      // Create work_entries table
-      database.run(`
-        CREATE TABLE IF NOT EXISTS work_entries (
-          id INTEGER PRIMARY KEY AUTOINCREMENT,
-          client_id INTEGER NOT NULL,
-          user_email TEXT NOT NULL,
-          hours DECIMAL(5,2) NOT NULL,
-          description TEXT,
-          date DATE NOT NULL,
-          created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-          FOREIGN KEY (client_id) REFERENCES clients (id) ON DELETE CASCADE,
-          FOREIGN KEY (user_email) REFERENCES users (email) ON DELETE CASCADE
-        )
-      `);
+function getShardStats() {
+  return router ? router.stats() : null;
+}
 
-      // Create indexes for better performance
-      database.run(`CREATE INDEX IF NOT EXISTS idx_clients_user_email ON clients (user_email)`);
-      database.run(`CREATE INDEX IF NOT EXISTS idx_work_entries_client_id ON work_entries (client_id)`);
-      database.run(`CREATE INDEX IF NOT EXISTS idx_work_entries_user_email ON work_entries (user_email)`);
-      database.run(`CREATE INDEX IF NOT EXISTS idx_work_entries_date ON work_entries (date)`);
+// Schema and journal mode for one database file
+async function prepareDatabase(database) {
+  // Readers don't block the writer; the log is checkpointed on shutdown
+  await run(database, 'PRAGMA journal_mode = WAL');
+  await runMigrations(database);
+}
 
-      console.log('Database tables created successfully');
-      resolve();
+async function initializeDatabase() {
+  const database = getDatabase();
+  await prepareDatabase(database);
+
+  const dbPath = process.env.DATABASE_PATH || ':memory:';
+  const shards = Number(process.env.DATABASE_SHARDS) || 0;
+  if (shards > 1 && dbPath !== ':memory:') {
+    router = new ShardRouter({
+      path: dbPath,
+      count: shards,
+      open: openDatabase,
+      release: (shard) => SqliteStorage.release(shard),
+      idleMs: (Number(process.env.DATABASE_SHARD_IDLE_SECONDS) || 300) * 1000
+    });
+    await router.initialize(database, prepareDatabase);
+    console.log(`Routing users across ${shards} database shards`);
+  }
+  console.log('Database tables created successfully');
+
+  // Chunked backfills and index builds run in the background so startup
+  // (and the write lock) is never held for the duration of a large rewrite
+  runOnlineMigrations(database)
+    .then(() => router && router.each(runOnlineMigrations))
+    .catch((error) => {
+      console.error('Online migration failed:', error);
     });
-  });
+}
+
+// Copy the write-ahead log into the database file and truncate it, so a
+// shutdown leaves a single self-contained file. A no-op for databases not
+// in WAL mode (including in-memory ones).
+async function checkpointDatabase() {
+  if (!db || isClosing || isClosed) {
+    return;
+  }
+  const databases = [db, ...(router ? router.openDatabases() : [])];
+  for (const database of databases) {
+    await run(database, 'PRAGMA wal_checkpoint(TRUNCATE)');
+  }
 }
 
 function closeDatabase() {
@@ -117,7 +147,9 @@ function closeDatabase() {
     }
     
     isClosing = true;
-    db.close((err) => {
+    const shardsClosed = router ? router.close() : Promise.resolve();
+    router = null;
+    shardsClosed.then(() => SqliteStorage.release(db)).then(() => db.close((err) => {
       isClosed = true;
       isClosing = false;
       db = null;
@@ -127,12 +159,16 @@ function closeDatabase() {
         console.log('Database connection closed');
       }
       resolve();
-    });
+    }));
   });
 }
 
 module.exports = {
   getDatabase,
+  acquireDatabase,
+  eachDatabase,
+  getShardStats,
   initializeDatabase,
+  checkpointDatabase,
   closeDatabase
 };
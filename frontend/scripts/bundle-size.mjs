@@ -0,0 +1,78 @@
+// Bundle size report and budget check, run after `vite build`.
+//
+// Reads the Vite manifest, works out what each route downloads (the entry
+// chunk plus everything it statically imports, then each lazy route's
+// additional chunks) and compares gzipped sizes against bundle-budget.json.
+// Writes dist/bundle-report.json and exits non-zero when over budget.
+import { readFileSync, writeFileSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+import { gzipSync } from 'node:zlib';
+
+const root = join(dirname(fileURLToPath(import.meta.url)), '..');
+const dist = join(root, 'dist');
+const manifest = JSON.parse(readFileSync(join(dist, '.vite', 'manifest.json'), 'utf8'));
+const budget = JSON.parse(readFileSync(join(root, 'bundle-budget.json'), 'utf8'));
+
+const gzipSizes = new Map();
+const gzipSize = (file) => {
+  if (!gzipSizes.has(file)) {
+    gzipSizes.set(file, gzipSync(readFileSync(join(dist, file))).length);
+  }
+  return gzipSizes.get(file);
+};
+
+// Files fetched when a chunk loads: itself, its CSS and its static imports
+const closure = (key, files = new Set()) => {
+  const chunk = manifest[key];
+  if (files.has(chunk.file)) return files;
+  files.add(chunk.file);
+  (chunk.css || []).forEach((css) => files.add(css));
+  (chunk.imports || []).forEach((imported) => closure(imported, files));
+  return files;
+};
+
+const total = (files) => [...files].reduce((sum, file) => sum + gzipSize(file), 0);
+const kb = (bytes) => Math.round((bytes / 1024) * 10) / 10;
+
+const entryKey = Object.keys(manifest).find((key) => manifest[key].isEntry);
+const initial = closure(entryKey);
+const loginKey = Object.keys(manifest).find((key) => key.endsWith('pages/LoginPage.tsx'));
+const loginFiles = loginKey ? closure(loginKey, new Set(initial)) : initial;
+
+const routes = Object.keys(manifest)
+  .filter((key) => manifest[key].isDynamicEntry)
+  .map((key) => {
+    const extra = [...closure(key)].filter((file) => !initial.has(file));
+    return { route: manifest[key].src || key, gzipKb: kb(total(extra)), files: extra };
+  })
+  .sort((a, b) => b.gzipKb - a.gzipKb);
+
+const report = {
+  entry: { gzipKb: kb(total(initial)), files: [...initial] },
+  loginFirstLoad: { gzipKb: kb(total(loginFiles)), budgetKb: budget.initialKb },
+  routes: routes.map((route) => ({ ...route, budgetKb: budget.routeKb })),
+};
+writeFileSync(join(dist, 'bundle-report.json'), `${JSON.stringify(report, null, 2)}\n`);
+
+const failures = [];
+if (report.loginFirstLoad.gzipKb > budget.initialKb) {
+  failures.push(`login first load ${report.loginFirstLoad.gzipKb} kB > ${budget.initialKb} kB`);
+}
+routes
+  .filter((route) => route.gzipKb > budget.routeKb)
+  .forEach((route) => failures.push(`${route.route} ${route.gzipKb} kB > ${budget.routeKb} kB`));
+
+console.log('\nBundle size (gzip)');
+console.log(`  entry                           ${report.entry.gzipKb} kB`);
+console.log(`  login first load                ${report.loginFirstLoad.gzipKb} kB (budget ${budget.initialKb} kB)`);
+routes.forEach((route) => {
+  console.log(`  + ${route.route.padEnd(30)} ${route.gzipKb} kB (budget ${budget.routeKb} kB)`);
+});
+console.log('  report written to dist/bundle-report.json\n');
+
+if (failures.length > 0) {
+  console.error('Bundle size budget exceeded:');
+  failures.forEach((failure) => console.error(`  ${failure}`));
+  process.exit(1);
+}
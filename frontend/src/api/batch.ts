@@ -0,0 +1,101 @@
+import axios, { AxiosError, AxiosHeaders, type AxiosAdapter, type AxiosResponse, type InternalAxiosRequestConfig } from 'axios';
+import { type BatchRequest, type BatchResponse } from '../types/api';
+
+// Coalesces GET requests made in the same tick into one POST /api/batch.
+// A page mounting typically starts several queries at once (clients and
+// work entries, say); they reach the server as a single request.
+//
+// Used as the API client's adapter, so interceptors still see one
+// request/response per call: the 401 refresh and retry works per call.
+
+// Routes the server accepts in a batch; file downloads are never batched
+const BATCHABLE_PATHS = ['/api/clients', '/api/work-entries', '/api/reports/client/', '/api/reports/summary', '/api/search'];
+const MAX_BATCH_SIZE = 20;
+
+interface Pending {
+  config: InternalAxiosRequestConfig;
+  resolve: (response: AxiosResponse) => void;
+  reject: (error: unknown) => void;
+}
+
+const isBatchable = (config: InternalAxiosRequestConfig) =>
+  config.method === 'get' &&
+  (config.responseType ?? 'json') === 'json' &&
+  BATCHABLE_PATHS.some((path) => config.url?.startsWith(path));
+
+// Query parameters as axios would send them: null and undefined are dropped
+const toQuery = (params: Record<string, unknown> = {}) =>
+  Object.fromEntries(Object.entries(params).filter(([, value]) => value !== undefined && value !== null));
+
+// Settle one call the way axios's own adapter would
+const settle = ({ config, resolve, reject }: Pending, status: number, data: unknown) => {
+  const response: AxiosResponse = { data, status, statusText: '', headers: new AxiosHeaders(), config };
+  if (!config.validateStatus || config.validateStatus(status)) {
+    resolve(response);
+    return;
+  }
+  const code = status >= 500 ? AxiosError.ERR_BAD_RESPONSE : AxiosError.ERR_BAD_REQUEST;
+  reject(new AxiosError(`Request failed with status code ${status}`, code, config, undefined, response));
+};
+
+export const createBatchAdapter = (): AxiosAdapter => {
+  const send = axios.getAdapter(axios.defaults.adapter);
+  let queue: Pending[] = [];
+
+  const sendBatch = async (calls: Pending[]) => {
+    if (calls.length === 1) {
+      const [call] = calls;
+      send(call.config).then(call.resolve, call.reject);
+      return;
+    }
+
+    const [{ config }] = calls;
+    const requests: BatchRequest[] = calls.map((call) => ({
+      method: 'GET',
+      path: call.config.url ?? '',
+      query: toQuery(call.config.params),
+    }));
+
+    try {
+      const response = await axios.post<BatchResponse>(
+        `${config.baseURL ?? ''}/api/batch`,
+        { requests },
+        { headers: { Authorization: config.headers.Authorization }, timeout: config.timeout }
+      );
+      response.data.responses.forEach(({ status, body }, index) => settle(calls[index], status, body));
+    } catch (error) {
+      // The batch as a whole failed (network, 401, 429...): fail each call
+      // the same way, so each is retried or reported on its own
+      const cause = error as AxiosError;
+      calls.forEach((call) =>
+        call.reject(new AxiosError(cause.message, cause.code, call.config, cause.request, cause.response))
+      );
+    }
+  };
+
+  const flush = () => {
+    const calls = queue;
+    queue = [];
+
+    // Calls signed with different tokens (around a refresh) go separately
+    const byToken = new Map<string, Pending[]>();
+    calls.forEach((call) => {
+      const token = String(call.config.headers.Authorization ?? '');
+      byToken.set(token, [...(byToken.get(token) ?? []), call]);
+    });
+    byToken.forEach((group) => {
+      for (let i = 0; i < group.length; i += MAX_BATCH_SIZE) {
+        sendBatch(group.slice(i, i + MAX_BATCH_SIZE));
+      }
+    });
+  };
+
+  return (config) => {
+    if (!isBatchable(config)) return send(config);
+
+    return new Promise<AxiosResponse>((resolve, reject) => {
+      queue.push({ config, resolve, reject });
+      if (queue.length === 1) window.setTimeout(flush, 0);
+    });
+  };
+};
@@ -1,9 +1,27 @@
-import axios, { type AxiosInstance, type AxiosResponse } from 'axios';
+import axios, { type AxiosInstance, type AxiosResponse, type InternalAxiosRequestConfig } from 'axios';
+import { createBatchAdapter } from './batch';
+import { clearSession, getAccessToken, refreshSession } from './session';
+import {
+  type Client,
+  type DateRange,
+  type ReportSummary,
+  type SummaryGrouping,
+  type LoginResponse,
+  type WorkEntry,
+  type WorkEntryChanges,
+  type SearchResponse,
+  type WorkEntryFilters,
+  type WorkEntryPage,
+  type WorkEntrySearchResult,
+} from '../types/api';
 
 // Use empty string to make requests relative to the current origin
 // Vite proxy will forward /api requests to the backend
 const API_BASE_URL = '';
 
+// A 401 from these means bad credentials, not an expired access token
+const SESSION_ENDPOINTS = ['/api/auth/login', '/api/auth/logout'];
+
 class ApiClient {
   private client: AxiosInstance;
 
@@ -14,14 +32,16 @@ class ApiClient {
       headers: {
         'Content-Type': 'application/json',
       },
+      // GETs made in the same tick share one POST /api/batch
+      adapter: createBatchAdapter(),
     });
 
-    // Request interceptor to add email header
+    // Request interceptor to add the access token
     this.client.interceptors.request.use(
       (config) => {
-        const userEmail = localStorage.getItem('userEmail');
-        if (userEmail) {
-          config.headers['x-user-email'] = userEmail;
+        const accessToken = getAccessToken();
+        if (accessToken) {
+          config.headers.Authorization = `Bearer ${accessToken}`;
         }
         return config;
       },
@@ -30,13 +50,20 @@ class ApiClient {
       }
     );
 
-    // Response interceptor for error handling
+    // Response interceptor for error handling: an expired access token is
+    // refreshed and the request retried once
     this.client.interceptors.response.use(
       (response: AxiosResponse) => response,
-      (error) => {
-        if (error.response?.status === 401) {
-          // Clear stored email on auth error
-          localStorage.removeItem('userEmail');
+      async (error) => {
+        const config = error.config as (InternalAxiosRequestConfig & { retried?: boolean }) | undefined;
+        const expired =
+          error.response?.status === 401 && config && !config.retried && !SESSION_ENDPOINTS.includes(config.url ?? '');
+        if (expired) {
+          config.retried = true;
+          if (await refreshSession()) {
+            return this.client.request(config);
+          }
+          clearSession();
           window.location.href = '/login';
         }
         return Promise.reject(error);
@@ -46,7 +73,17 @@ class ApiClient {
 
   // Auth endpoints
   async login(email: string) {
-    const response = await this.client.post('/api/auth/login', { email });
+    const response = await this.client.post<LoginResponse>('/api/auth/login', { email });
+    return response.data;
+  }
+
+  // Revokes the refresh token. The token is read before the first await,
+  // so the caller may clear the local session right after calling this.
+  async logout() {
+    const accessToken = getAccessToken();
+    const response = await this.client.post('/api/auth/logout', null, {
+      headers: { Authorization: `Bearer ${accessToken}` },
+    });
     return response.data;
   }
 
@@ -67,12 +104,12 @@ class ApiClient {
   }
 
   async createClient(clientData: { name: string; description?: string; department?: string; email?: string }) {
-    const response = await this.client.post('/api/clients', clientData);
+    const response = await this.client.post<{ message: string; client: Client }>('/api/clients', clientData);
     return response.data;
   }
 
   async updateClient(id: number, clientData: { name?: string; description?: string; department?: string; email?: string }) {
-    const response = await this.client.put(`/api/clients/${id}`, clientData);
+    const response = await this.client.put<{ message: string; client: Client }>(`/api/clients/${id}`, clientData);
     return response.data;
   }
 
@@ -87,9 +124,15 @@ class ApiClient {
   }
 
   // Work entry endpoints
-  async getWorkEntries(clientId?: number) {
-    const params = clientId ? { clientId } : {};
-    const response = await this.client.get('/api/work-entries', { params });
+  async getWorkEntries(filters: WorkEntryFilters = {}) {
+    const response = await this.client.get<WorkEntryPage>('/api/work-entries', { params: filters });
+    return response.data;
+  }
+
+  async getWorkEntryChanges(since: number, limit?: number) {
+    const response = await this.client.get<WorkEntryChanges>('/api/work-entries/changes', {
+      params: { since, limit },
+    });
     return response.data;
   }
 
@@ -99,12 +142,12 @@ class ApiClient {
   }
 
   async createWorkEntry(entryData: { clientId: number; hours: number; description?: string; date: string }) {
-    const response = await this.client.post('/api/work-entries', entryData);
+    const response = await this.client.post<{ message: string; workEntry: WorkEntry }>('/api/work-entries', entryData);
     return response.data;
   }
 
   async updateWorkEntry(id: number, entryData: { clientId?: number; hours?: number; description?: string; date?: string }) {
-    const response = await this.client.put(`/api/work-entries/${id}`, entryData);
+    const response = await this.client.put<{ message: string; workEntry: WorkEntry }>(`/api/work-entries/${id}`, entryData);
     return response.data;
   }
 
@@ -114,25 +157,40 @@ class ApiClient {
   }
 
   // Report endpoints
-  async getClientReport(clientId: number) {
-    const response = await this.client.get(`/api/reports/client/${clientId}`);
+  async getClientReport(clientId: number, range: DateRange = {}) {
+    const response = await this.client.get(`/api/reports/client/${clientId}`, { params: range });
+    return response.data;
+  }
+
+  async getReportSummary(groupBy: SummaryGrouping = 'client', range: DateRange = {}) {
+    const response = await this.client.get<ReportSummary>('/api/reports/summary', { params: { ...range, groupBy } });
     return response.data;
   }
 
-  async exportClientReportCsv(clientId: number) {
+  async exportClientReportCsv(clientId: number, range: DateRange = {}) {
     const response = await this.client.get(`/api/reports/export/csv/${clientId}`, {
+      params: range,
       responseType: 'blob',
     });
     return response.data;
   }
 
-  async exportClientReportPdf(clientId: number) {
+  async exportClientReportPdf(clientId: number, range: DateRange = {}) {
     const response = await this.client.get(`/api/reports/export/pdf/${clientId}`, {
+      params: range,
       responseType: 'blob',
     });
     return response.data;
   }
 
+  // Search endpoints
+  async searchWorkEntries(q: string, options: DateRange & { limit?: number; offset?: number } = {}) {
+    const response = await this.client.get<SearchResponse<WorkEntrySearchResult>>('/api/search', {
+      params: { q, type: 'entries', ...options },
+    });
+    return response.data;
+  }
+
   // Health check
   async healthCheck() {
     const response = await this.client.get('/health');
@@ -0,0 +1,173 @@
+import { type QueryClient } from '@tanstack/react-query';
+import {
+  findClient,
+  findWorkEntry,
+  invalidateClientAggregates,
+  removeAllClients,
+  removeClient,
+  removeWorkEntry,
+  upsertClient,
+  upsertWorkEntry,
+} from './queryCache';
+import { getAccessToken, refreshSession } from './session';
+import { type ChangeEvent } from '../types/api';
+
+// Client for the GET /api/events stream: applies each change to the cached
+// lists in place, the same way our own mutations do, so edits made in
+// another tab or device show up without refetching.
+//
+// EventSource can't send an Authorization header, so the stream is read
+// with fetch instead.
+
+const MAX_RETRY_MS = 60 * 1000;
+
+// A tab receives the echo of its own mutations too; those are already in
+// the cache and are skipped
+const isCached = (cached: object | undefined, row: object) =>
+  cached !== undefined && JSON.stringify(cached) === JSON.stringify(row);
+
+export const applyChange = (queryClient: QueryClient, change: ChangeEvent) => {
+  if (change.entity === 'work_entry') {
+    if (change.op === 'upsert') {
+      const previous = findWorkEntry(queryClient, change.row.id);
+      if (isCached(previous, change.row)) return;
+      upsertWorkEntry(queryClient, change.row);
+      invalidateClientAggregates(queryClient, [change.row.client_id, previous?.client_id]);
+    } else {
+      const previous = findWorkEntry(queryClient, change.id);
+      if (!previous) {
+        // Not loaded here; reports may still include it
+        queryClient.invalidateQueries({ queryKey: ['clientReport'], refetchType: 'none' });
+        return;
+      }
+      removeWorkEntry(queryClient, change.id);
+      invalidateClientAggregates(queryClient, [previous.client_id]);
+    }
+    return;
+  }
+
+  if (change.op === 'upsert') {
+    if (isCached(findClient(queryClient, change.row.id), change.row)) return;
+    upsertClient(queryClient, change.row);
+    queryClient.invalidateQueries({ queryKey: ['clientReport', change.row.id] });
+  } else if (change.op === 'delete') {
+    removeClient(queryClient, change.id);
+  } else {
+    removeAllClients(queryClient);
+  }
+  queryClient.invalidateQueries({ queryKey: ['search'], refetchType: 'none' });
+};
+
+// Changes may have been missed (while disconnected, or dropped because we
+// read too slowly): let every query refresh, the full work entry list by
+// delta sync
+const resync = (queryClient: QueryClient) => {
+  queryClient.invalidateQueries();
+};
+
+// Split the stream into events and hand each to `onEvent`. Resolves when
+// the server closes the stream.
+const readEvents = async (
+  body: ReadableStream<Uint8Array>,
+  onEvent: (event: string, data: string) => void,
+  onRetry: (ms: number) => void
+) => {
+  const reader = body.pipeThrough(new TextDecoderStream()).getReader();
+  let buffer = '';
+
+  for (;;) {
+    const { value, done } = await reader.read();
+    if (done) return;
+    buffer += value;
+
+    let end: number;
+    while ((end = buffer.indexOf('\n\n')) !== -1) {
+      const block = buffer.slice(0, end);
+      buffer = buffer.slice(end + 2);
+
+      let event = 'message';
+      const data: string[] = [];
+      for (const line of block.split('\n')) {
+        // Lines starting with ':' are heartbeats
+        const colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        const field = line.slice(0, colon);
+        const fieldValue = line.slice(colon + 1).replace(/^ /, '');
+        if (field === 'event') event = fieldValue;
+        else if (field === 'data') data.push(fieldValue);
+        else if (field === 'retry' && /^\d+$/.test(fieldValue)) onRetry(Number(fieldValue));
+      }
+      if (data.length > 0) onEvent(event, data.join('\n'));
+    }
+  }
+};
+
+const sleep = (ms: number, signal: AbortSignal) =>
+  new Promise<void>((resolve) => {
+    const timer = window.setTimeout(resolve, ms);
+    signal.addEventListener('abort', () => {
+      window.clearTimeout(timer);
+      resolve();
+    });
+  });
+
+// Keep a stream open for the signed-in user, reconnecting with backoff.
+// Returns a function that closes it.
+export const subscribeToChanges = (queryClient: QueryClient) => {
+  const controller = new AbortController();
+  const { signal } = controller;
+
+  const run = async () => {
+    let retryMs = 5000;
+    let failures = 0;
+    let connected = false;
+    let renewed = false;
+
+    while (!signal.aborted) {
+      try {
+        const response = await fetch('/api/events', {
+          headers: { Accept: 'text/event-stream', Authorization: `Bearer ${getAccessToken()}` },
+          cache: 'no-store',
+          signal,
+        });
+        if (response.status === 401) {
+          // Access token expired: renew it and reconnect right away. If the
+          // session is over, the API client handles the redirect.
+          if (!renewed && (await refreshSession())) {
+            renewed = true;
+            continue;
+          }
+          return;
+        }
+        if (!response.ok || !response.body) throw new Error(`Event stream failed: ${response.status}`);
+
+        if (connected) resync(queryClient);
+        connected = true;
+        renewed = false;
+        failures = 0;
+
+        await readEvents(
+          response.body,
+          (event, data) => {
+            if (event === 'change') applyChange(queryClient, JSON.parse(data) as ChangeEvent);
+            else if (event === 'resync') resync(queryClient);
+          },
+          (ms) => {
+            retryMs = ms;
+          }
+        );
+      } catch (error) {
+        if (signal.aborted) return;
+        console.warn('Live updates disconnected:', error);
+        failures += 1;
+      }
+
+      // Jittered so a server restart doesn't get every tab back at once
+      const backoff = Math.min(retryMs * 2 ** failures, MAX_RETRY_MS);
+      await sleep(backoff / 2 + Math.random() * (backoff / 2), signal);
+    }
+  };
+
+  run();
+  return () => controller.abort();
+};
@@ -0,0 +1,131 @@
+import { dehydrate, hydrate, type DehydratedState, type Query, type QueryClient } from '@tanstack/react-query';
+
+// Persists the long-lived query results to IndexedDB so returning users see
+// their data immediately; the restored queries then refresh themselves
+// (work entries via delta sync) in the background.
+
+const DB_NAME = 'timesheet';
+const STORE = 'queryCache';
+// Bump when the shape of a persisted query result changes
+const CACHE_VERSION = 1;
+const MAX_AGE = 1000 * 60 * 60 * 24 * 7;
+const WRITE_DELAY = 1000;
+
+// Only whole-collection queries are worth keeping; filtered, paged and
+// search results are cheap to refetch and would grow without bound
+const PERSISTED_KEYS = ['clients', 'workEntries'];
+
+interface PersistedCache {
+  version: number;
+  savedAt: number;
+  state: DehydratedState;
+}
+
+let dbPromise: Promise<IDBDatabase> | null = null;
+
+const openDb = () => {
+  dbPromise ??= new Promise<IDBDatabase>((resolve, reject) => {
+    const request = indexedDB.open(DB_NAME, 1);
+    request.onupgradeneeded = () => request.result.createObjectStore(STORE);
+    request.onsuccess = () => resolve(request.result);
+    request.onerror = () => reject(request.error);
+  });
+  return dbPromise;
+};
+
+const withStore = async <T>(mode: IDBTransactionMode, action: (store: IDBObjectStore) => IDBRequest<T>) => {
+  const db = await openDb();
+  return new Promise<T>((resolve, reject) => {
+    const transaction = db.transaction(STORE, mode);
+    const request = action(transaction.objectStore(STORE));
+    transaction.oncomplete = () => resolve(request.result);
+    transaction.onerror = () => reject(transaction.error);
+    transaction.onabort = () => reject(transaction.error);
+  });
+};
+
+// Cached data is per user; never restore one user's data for another
+const cacheKey = () => {
+  const userEmail = localStorage.getItem('userEmail');
+  return userEmail ? `user:${userEmail}` : null;
+};
+
+const shouldPersist = (query: Query) =>
+  query.state.status === 'success' &&
+  query.queryKey.length === 1 &&
+  PERSISTED_KEYS.includes(query.queryKey[0] as string);
+
+// Load the persisted cache into `queryClient`. Resolves (without data) if
+// IndexedDB is unavailable or slow, so it never blocks startup for long.
+export const restoreQueryCache = async (queryClient: QueryClient, timeoutMs = 1000) => {
+  const key = cacheKey();
+  if (!key || typeof indexedDB === 'undefined') return;
+
+  const restore = async () => {
+    const cached = await withStore<PersistedCache | undefined>('readonly', (store) => store.get(key));
+    if (!cached || cached.version !== CACHE_VERSION || Date.now() - cached.savedAt > MAX_AGE) {
+      return;
+    }
+    hydrate(queryClient, cached.state);
+  };
+
+  try {
+    await Promise.race([restore(), new Promise((resolve) => setTimeout(resolve, timeoutMs))]);
+  } catch (error) {
+    console.warn('Failed to restore query cache:', error);
+  }
+};
+
+// Write persisted queries back (debounced) whenever they change. Returns an
+// unsubscribe function.
+export const persistQueryCache = (queryClient: QueryClient) => {
+  if (typeof indexedDB === 'undefined') return () => {};
+
+  let timer: number | undefined;
+
+  const save = () => {
+    timer = undefined;
+    const key = cacheKey();
+    if (!key) return;
+    const value: PersistedCache = {
+      version: CACHE_VERSION,
+      savedAt: Date.now(),
+      state: dehydrate(queryClient, { shouldDehydrateQuery: shouldPersist }),
+    };
+    withStore('readwrite', (store) => store.put(value, key)).catch((error) => {
+      console.warn('Failed to persist query cache:', error);
+    });
+  };
+
+  const unsubscribe = queryClient.getQueryCache().subscribe((event) => {
+    if (event.type === 'updated' && shouldPersist(event.query) && timer === undefined) {
+      timer = window.setTimeout(save, WRITE_DELAY);
+    }
+  });
+
+  // Don't lose a pending write when the tab goes away
+  const flush = () => {
+    if (timer !== undefined && document.visibilityState === 'hidden') {
+      window.clearTimeout(timer);
+      save();
+    }
+  };
+  document.addEventListener('visibilitychange', flush);
+
+  return () => {
+    unsubscribe();
+    document.removeEventListener('visibilitychange', flush);
+    if (timer !== undefined) window.clearTimeout(timer);
+  };
+};
+
+// Forget everything cached for the signed-in user (on logout)
+export const clearPersistedCache = async () => {
+  const key = cacheKey();
+  if (!key || typeof indexedDB === 'undefined') return;
+  try {
+    await withStore('readwrite', (store) => store.delete(key));
+  } catch (error) {
+    console.warn('Failed to clear query cache:', error);
+  }
+};
@@ -0,0 +1,165 @@
+import { type InfiniteData, type QueryClient, type QueryKey } from '@tanstack/react-query';
+import { type Client, type WorkEntry, type WorkEntryFilters, type WorkEntryPage } from '../types/api';
+
+// Helpers that patch cached lists in place after a mutation, so an edit
+// doesn't refetch every list that might contain the row.
+//
+// Cached shapes:
+//   ['clients']                           -> { clients }   (ordered by name)
+//   ['workEntries']                       -> { workEntries, version } (full list, delta synced)
+//   ['workEntries', filters, 'paged']     -> InfiniteData<WorkEntryPage>
+//   ['clientReport', clientId, range]     -> server-side aggregates
+
+type EntryList = { workEntries: WorkEntry[] };
+type EntryCache = EntryList | InfiniteData<WorkEntryPage, string>;
+type ClientList = { clients: Client[] };
+
+const isPaged = (data: EntryCache): data is InfiniteData<WorkEntryPage, string> => 'pages' in data;
+
+// Same order as the API: date, created_at, id, newest first
+export const compareEntries = (a: WorkEntry, b: WorkEntry) =>
+  new Date(b.date).getTime() - new Date(a.date).getTime() ||
+  (a.created_at === b.created_at ? 0 : a.created_at < b.created_at ? 1 : -1) ||
+  b.id - a.id;
+
+// Mirrors the SQL filters in GET /api/work-entries
+const matchesFilters = (entry: WorkEntry, filters: WorkEntryFilters) => {
+  const time = new Date(entry.date).getTime();
+  return (
+    (!filters.clientIds || filters.clientIds.includes(entry.client_id)) &&
+    (!filters.from || time >= Date.parse(filters.from)) &&
+    (!filters.to || time <= Date.parse(filters.to)) &&
+    (filters.minHours === undefined || entry.hours >= filters.minHours) &&
+    (filters.maxHours === undefined || entry.hours <= filters.maxHours)
+  );
+};
+
+// Insert into the loaded page the row sorts into. Rows past the last loaded
+// row are left for the next page fetch, which the keyset cursor will return.
+const insertEntry = (pages: WorkEntryPage[], entry: WorkEntry) => {
+  const target = pages.findIndex((page) => {
+    const last = page.workEntries[page.workEntries.length - 1];
+    return !page.nextCursor || (last !== undefined && compareEntries(entry, last) < 0);
+  });
+  if (target === -1) {
+    return pages;
+  }
+  return pages.map((page, index) =>
+    index === target ? { ...page, workEntries: [...page.workEntries, entry].sort(compareEntries) } : page
+  );
+};
+
+const patchEntryCaches = (
+  queryClient: QueryClient,
+  patch: (pages: WorkEntryPage[], filters: WorkEntryFilters) => WorkEntryPage[]
+) => {
+  queryClient.getQueriesData<EntryCache>({ queryKey: ['workEntries'] }).forEach(([queryKey, data]) => {
+    if (!data) return;
+    const filters = (queryKey[1] as WorkEntryFilters | undefined) ?? {};
+    if (isPaged(data)) {
+      queryClient.setQueryData(queryKey, { ...data, pages: patch(data.pages, filters) });
+    } else {
+      const [page] = patch([{ workEntries: data.workEntries, nextCursor: null }], filters);
+      queryClient.setQueryData(queryKey, { ...data, workEntries: page.workEntries });
+    }
+  });
+};
+
+const without = (pages: WorkEntryPage[], keep: (entry: WorkEntry) => boolean) =>
+  pages.map((page) =>
+    page.workEntries.every(keep) ? page : { ...page, workEntries: page.workEntries.filter(keep) }
+  );
+
+export const findWorkEntry = (queryClient: QueryClient, id: number): WorkEntry | undefined => {
+  for (const [, data] of queryClient.getQueriesData<EntryCache>({ queryKey: ['workEntries'] })) {
+    if (!data) continue;
+    const entries = isPaged(data) ? data.pages.flatMap((page) => page.workEntries) : data.workEntries;
+    const found = entries.find((entry) => entry.id === id);
+    if (found) return found;
+  }
+  return undefined;
+};
+
+// Put `entry` into every cached list whose filters it matches, replacing the
+// row with id `replaceId` (e.g. an optimistic placeholder) if present
+export const upsertWorkEntry = (queryClient: QueryClient, entry: WorkEntry, replaceId = entry.id) => {
+  patchEntryCaches(queryClient, (pages, filters) => {
+    const rest = without(pages, (row) => row.id !== replaceId && row.id !== entry.id);
+    return matchesFilters(entry, filters) ? insertEntry(rest, entry) : rest;
+  });
+};
+
+export const removeWorkEntry = (queryClient: QueryClient, id: number) => {
+  patchEntryCaches(queryClient, (pages) => without(pages, (row) => row.id !== id));
+};
+
+// Deleting clients cascades to their entries on the server
+export const removeClientWorkEntries = (queryClient: QueryClient, clientId?: number) => {
+  patchEntryCaches(queryClient, (pages) =>
+    without(pages, (row) => clientId !== undefined && row.client_id !== clientId)
+  );
+};
+
+const renameClientInEntries = (queryClient: QueryClient, client: Client) => {
+  patchEntryCaches(queryClient, (pages) =>
+    pages.map((page) =>
+      page.workEntries.some((row) => row.client_id === client.id && row.client_name !== client.name)
+        ? {
+            ...page,
+            workEntries: page.workEntries.map((row) =>
+              row.client_id === client.id ? { ...row, client_name: client.name } : row
+            ),
+          }
+        : page
+    )
+  );
+};
+
+export const findClient = (queryClient: QueryClient, id: number): Client | undefined =>
+  queryClient.getQueryData<ClientList>(['clients'])?.clients.find((client) => client.id === id);
+
+export const upsertClient = (queryClient: QueryClient, client: Client, replaceId = client.id) => {
+  queryClient.setQueryData<ClientList>(['clients'], (data) => {
+    if (!data) return data;
+    const clients = data.clients.filter((row) => row.id !== replaceId && row.id !== client.id);
+    // SQLite's default BINARY collation, as used by ORDER BY name
+    clients.push(client);
+    clients.sort((a, b) => (a.name === b.name ? 0 : a.name < b.name ? -1 : 1));
+    return { ...data, clients };
+  });
+  renameClientInEntries(queryClient, client);
+};
+
+export const removeClient = (queryClient: QueryClient, id: number) => {
+  queryClient.setQueryData<ClientList>(['clients'], (data) =>
+    data ? { ...data, clients: data.clients.filter((client) => client.id !== id) } : data
+  );
+  removeClientWorkEntries(queryClient, id);
+  queryClient.removeQueries({ queryKey: ['clientReport', id] });
+};
+
+export const removeAllClients = (queryClient: QueryClient) => {
+  queryClient.setQueryData<ClientList>(['clients'], (data) => (data ? { ...data, clients: [] } : data));
+  removeClientWorkEntries(queryClient);
+  queryClient.removeQueries({ queryKey: ['clientReport'] });
+};
+
+// Only the aggregates that include the changed rows are refetched; search
+// results are marked stale and refresh the next time they're shown
+export const invalidateClientAggregates = (queryClient: QueryClient, clientIds: Array<number | undefined>) => {
+  new Set(clientIds.filter((id): id is number => id !== undefined)).forEach((clientId) => {
+    queryClient.invalidateQueries({ queryKey: ['clientReport', clientId] });
+  });
+  queryClient.invalidateQueries({ queryKey: ['search'], refetchType: 'none' });
+};
+
+// Capture the cached lists before an optimistic patch; the returned
+// function restores them if the mutation fails
+export const snapshotQueries = (queryClient: QueryClient, prefixes: QueryKey[]) => {
+  const saved = prefixes.flatMap((queryKey) => queryClient.getQueriesData({ queryKey }));
+  return () => saved.forEach(([queryKey, data]) => queryClient.setQueryData(queryKey, data));
+};
+
+// Stop in-flight fetches from overwriting an optimistic patch
+export const cancelQueries = (queryClient: QueryClient, prefixes: QueryKey[]) =>
+  Promise.all(prefixes.map((queryKey) => queryClient.cancelQueries({ queryKey })));
@@ -0,0 +1,12 @@
+import { QueryClient } from '@tanstack/react-query';
+
+export const queryClient = new QueryClient({
+  defaultOptions: {
+    queries: {
+      retry: 1,
+      refetchOnWindowFocus: false,
+      // Keep unused results around as long as the persisted copy is valid
+      gcTime: 1000 * 60 * 60 * 24,
+    },
+  },
+});
@@ -0,0 +1,48 @@
+import axios from 'axios';
+import { type SessionTokens } from '../types/api';
+
+// Session tokens from /api/auth/login. The access token is short-lived;
+// when the API rejects it, one refresh request is shared by every caller
+// that noticed.
+
+const ACCESS_TOKEN_KEY = 'accessToken';
+const REFRESH_TOKEN_KEY = 'refreshToken';
+
+export const getAccessToken = () => localStorage.getItem(ACCESS_TOKEN_KEY);
+
+export const hasSession = () => localStorage.getItem(REFRESH_TOKEN_KEY) !== null;
+
+export const saveSession = ({ accessToken, refreshToken }: SessionTokens) => {
+  localStorage.setItem(ACCESS_TOKEN_KEY, accessToken);
+  localStorage.setItem(REFRESH_TOKEN_KEY, refreshToken);
+};
+
+export const clearSession = () => {
+  localStorage.removeItem(ACCESS_TOKEN_KEY);
+  localStorage.removeItem(REFRESH_TOKEN_KEY);
+  localStorage.removeItem('userEmail');
+};
+
+let refreshing: Promise<boolean> | null = null;
+
+// Resolves false if the session can't be renewed (expired or revoked
+// refresh token) and the user has to sign in again
+export const refreshSession = () => {
+  if (!refreshing) {
+    const refreshToken = localStorage.getItem(REFRESH_TOKEN_KEY);
+    refreshing = (
+      refreshToken
+        ? axios
+            .post<SessionTokens>('/api/auth/refresh', { refreshToken })
+            .then((response) => {
+              saveSession(response.data);
+              return true;
+            })
+            .catch(() => false)
+        : Promise.resolve(false)
+    ).finally(() => {
+      refreshing = null;
+    });
+  }
+  return refreshing;
+};
@@ -0,0 +1,43 @@
+import { isAxiosError } from 'axios';
+import { type QueryClient } from '@tanstack/react-query';
+import apiClient from './client';
+import { compareEntries } from './queryCache';
+import { type SyncedWorkEntries } from '../types/api';
+
+const fullSync = async (): Promise<SyncedWorkEntries> => {
+  const { workEntries, version } = await apiClient.getWorkEntryChanges(0);
+  return { workEntries, version };
+};
+
+// Query function for ['workEntries']: the first load (or a load after the
+// server forgot our version) fetches a snapshot; after that, including when
+// the list was restored from the persisted cache, only the rows changed
+// since the cached version are transferred and merged in.
+export const syncWorkEntries = async (queryClient: QueryClient): Promise<SyncedWorkEntries> => {
+  const cached = queryClient.getQueryData<SyncedWorkEntries>(['workEntries']);
+  if (!cached || typeof cached.version !== 'number') {
+    return fullSync();
+  }
+
+  const byId = new Map(cached.workEntries.map((entry) => [entry.id, entry]));
+  let version = cached.version;
+
+  try {
+    for (;;) {
+      const changes = await apiClient.getWorkEntryChanges(version);
+      changes.deleted.forEach((id) => byId.delete(id));
+      changes.workEntries.forEach((entry) => byId.set(entry.id, entry));
+      version = changes.version;
+      if (!changes.hasMore) break;
+    }
+  } catch (error) {
+    if (isAxiosError(error) && error.response?.status === 410) {
+      return fullSync();
+    }
+    throw error;
+  }
+
+  // Drop optimistic placeholders; their real rows arrived with the delta
+  const workEntries = [...byId.values()].filter((entry) => entry.id > 0).sort(compareEntries);
+  return { workEntries, version };
+};
@@ -1,4 +1,4 @@
-import React, { type ReactNode } from 'react';
+import React, { useEffect, type ReactNode } from 'react';
 import {
   AppBar,
   Box,
@@ -25,6 +25,8 @@ import {
 } from '@mui/icons-material';
 import { useNavigate, useLocation } from 'react-router-dom';
 import { useAuth } from '../hooks/useAuth';
+import { useLiveUpdates } from '../hooks/useLiveUpdates';
+import { prefetchRoute, prefetchWhenIdle, type RoutePath } from '../routes';
 
 const drawerWidth = 240;
 
@@ -42,13 +44,18 @@ const Layout: React.FC<LayoutProps> = ({ children }) => {
     setMobileOpen(!mobileOpen);
   };
 
-  const menuItems = [
+  const menuItems: { text: string; icon: React.ReactElement; path: RoutePath }[] = [
     { text: 'Dashboard', icon: <DashboardIcon />, path: '/dashboard' },
     { text: 'Clients', icon: <BusinessIcon />, path: '/clients' },
     { text: 'Work Entries', icon: <AssignmentIcon />, path: '/work-entries' },
     { text: 'Reports', icon: <AssessmentIcon />, path: '/reports' },
   ];
 
+  useLiveUpdates(user?.email);
+
+  // Warm the other pages' chunks once the current one has settled
+  useEffect(() => prefetchWhenIdle(['/dashboard', '/work-entries', '/clients', '/reports']), []);
+
   const drawer = (
     <div>
       <Toolbar>
@@ -62,6 +69,8 @@ const Layout: React.FC<LayoutProps> = ({ children }) => {
             <ListItemButton
               selected={location.pathname === item.path}
               onClick={() => navigate(item.path)}
+              onMouseEnter={() => prefetchRoute(item.path)}
+              onFocus={() => prefetchRoute(item.path)}
             >
               <ListItemIcon>{item.icon}</ListItemIcon>
               <ListItemText primary={item.text} />
@@ -0,0 +1,62 @@
+import React, { useEffect, type ReactNode, type RefObject } from 'react';
+import { TableBody, TableCell, TableRow } from '@mui/material';
+import { useVirtualRows } from '../hooks/useVirtualRows';
+
+interface VirtualTableBodyProps<T> {
+  items: T[];
+  columns: number;
+  scrollRef: RefObject<HTMLElement | null>;
+  estimateRowHeight: number;
+  getKey: (item: T) => React.Key;
+  renderCells: (item: T) => ReactNode;
+  // Called when the window gets close to the last loaded row
+  onEndReached?: () => void;
+  endThreshold?: number;
+}
+
+const Spacer: React.FC<{ height: number; columns: number }> = ({ height, columns }) => (
+  <TableRow style={{ height }}>
+    <TableCell colSpan={columns} sx={{ p: 0, border: 0 }} />
+  </TableRow>
+);
+
+// Table body that only mounts the rows near the viewport of `scrollRef`;
+// spacer rows stand in for everything above and below.
+function VirtualTableBody<T>({
+  items,
+  columns,
+  scrollRef,
+  estimateRowHeight,
+  getKey,
+  renderCells,
+  onEndReached,
+  endThreshold = 20,
+}: VirtualTableBodyProps<T>) {
+  const { virtualRows, paddingTop, paddingBottom, measureRow } = useVirtualRows({
+    count: items.length,
+    scrollRef,
+    estimateSize: estimateRowHeight,
+  });
+
+  const lastVisible = virtualRows.length > 0 ? virtualRows[virtualRows.length - 1].index : -1;
+
+  useEffect(() => {
+    if (onEndReached && items.length > 0 && lastVisible >= items.length - endThreshold) {
+      onEndReached();
+    }
+  }, [lastVisible, items.length, endThreshold, onEndReached]);
+
+  return (
+    <TableBody>
+      {paddingTop > 0 && <Spacer height={paddingTop} columns={columns} />}
+      {virtualRows.map(({ index }) => (
+        <TableRow key={getKey(items[index])} data-index={index} ref={measureRow}>
+          {renderCells(items[index])}
+        </TableRow>
+      ))}
+      {paddingBottom > 0 && <Spacer height={paddingBottom} columns={columns} />}
+    </TableBody>
+  );
+}
+
+export default VirtualTableBody;
@@ -0,0 +1,93 @@
+import React, { useEffect, useState } from 'react';
+import {
+  Box,
+  Button,
+  CircularProgress,
+  List,
+  ListItem,
+  ListItemText,
+  Paper,
+  TextField,
+  Typography,
+} from '@mui/material';
+import { useInfiniteQuery } from '@tanstack/react-query';
+import apiClient from '../api/client';
+import { type DateRange, type SearchSegment } from '../types/api';
+
+const PAGE_SIZE = 20;
+const DEBOUNCE_MS = 250;
+
+const Highlighted: React.FC<{ segments: SearchSegment[] }> = ({ segments }) => (
+  <>
+    {segments.map((segment, index) =>
+      segment.match ? <mark key={index}>{segment.text}</mark> : <span key={index}>{segment.text}</span>
+    )}
+  </>
+);
+
+interface WorkEntrySearchProps {
+  range: DateRange;
+}
+
+const WorkEntrySearch: React.FC<WorkEntrySearchProps> = ({ range }) => {
+  const [input, setInput] = useState('');
+  const [query, setQuery] = useState('');
+
+  useEffect(() => {
+    const timer = setTimeout(() => setQuery(input.trim()), DEBOUNCE_MS);
+    return () => clearTimeout(timer);
+  }, [input]);
+
+  const { data, isFetching, hasNextPage, fetchNextPage, isFetchingNextPage } = useInfiniteQuery({
+    queryKey: ['search', 'entries', query, range],
+    queryFn: ({ pageParam }) =>
+      apiClient.searchWorkEntries(query, { ...range, limit: PAGE_SIZE, offset: pageParam }),
+    initialPageParam: 0,
+    getNextPageParam: (lastPage) => (lastPage.hasMore ? lastPage.offset + lastPage.limit : undefined),
+    enabled: query.length > 0,
+  });
+
+  const results = data?.pages.flatMap((page) => page.results) || [];
+
+  return (
+    <Box sx={{ flexGrow: 1, minWidth: 240 }}>
+      <TextField
+        size="small"
+        fullWidth
+        label="Search descriptions"
+        value={input}
+        onChange={(e) => setInput(e.target.value)}
+        slotProps={{ input: { endAdornment: isFetching ? <CircularProgress size={18} /> : null } }}
+      />
+      {query && data && (
+        <Paper variant="outlined" sx={{ mt: 1, maxHeight: 360, overflow: 'auto' }}>
+          {results.length > 0 ? (
+            <List dense>
+              {results.map((result) => (
+                <ListItem key={result.id} divider>
+                  <ListItemText
+                    primary={<Highlighted segments={result.snippet} />}
+                    secondary={`${result.client_name} · ${new Date(result.date).toLocaleDateString()} · ${result.hours} hours`}
+                  />
+                </ListItem>
+              ))}
+            </List>
+          ) : (
+            <Typography color="text.secondary" sx={{ p: 2 }}>
+              No matching work entries.
+            </Typography>
+          )}
+          {hasNextPage && (
+            <Box textAlign="center" pb={1}>
+              <Button size="small" onClick={() => fetchNextPage()} disabled={isFetchingNextPage}>
+                Load more
+              </Button>
+            </Box>
+          )}
+        </Paper>
+      )}
+    </Box>
+  );
+};
+
+export default WorkEntrySearch;
@@ -1,6 +1,9 @@
 import React, { useState, useEffect, type ReactNode } from 'react';
+import { useQueryClient } from '@tanstack/react-query';
 import { type User } from '../types/api';
 import apiClient from '../api/client';
+import { clearPersistedCache } from '../api/persistCache';
+import { clearSession, hasSession, saveSession } from '../api/session';
 import { AuthContext, type AuthContextType } from './AuthContextValue';
 
 interface AuthProviderProps {
@@ -10,18 +13,17 @@ interface AuthProviderProps {
 export const AuthProvider: React.FC<AuthProviderProps> = ({ children }) => {
   const [user, setUser] = useState<User | null>(null);
   const [isLoading, setIsLoading] = useState(true);
+  const queryClient = useQueryClient();
 
   useEffect(() => {
     const checkAuth = async () => {
-      const storedEmail = localStorage.getItem('userEmail');
-      
-      if (storedEmail) {
+      if (hasSession()) {
         try {
           const response = await apiClient.getCurrentUser();
           setUser(response.user);
         } catch (error) {
           console.error('Auth check failed:', error);
-          localStorage.removeItem('userEmail');
+          clearSession();
         }
       }
       setIsLoading(false);
@@ -33,8 +35,9 @@ export const AuthProvider: React.FC<AuthProviderProps> = ({ children }) => {
   const login = async (email: string) => {
     try {
       const response = await apiClient.login(email);
-      setUser(response.user);
+      saveSession(response);
       localStorage.setItem('userEmail', email);
+      setUser(response.user);
     } catch (error) {
       console.error('Login failed:', error);
       throw error;
@@ -43,7 +46,12 @@ export const AuthProvider: React.FC<AuthProviderProps> = ({ children }) => {
 
   const logout = () => {
     setUser(null);
-    localStorage.removeItem('userEmail');
+    // Don't leave this user's data in memory or on disk for the next one
+    clearPersistedCache();
+    queryClient.clear();
+    // Best effort: revoke the refresh token server-side
+    apiClient.logout().catch(() => {});
+    clearSession();
   };
 
   const value: AuthContextType = {
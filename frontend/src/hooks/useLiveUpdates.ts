@@ -0,0 +1,15 @@
+import { useEffect } from 'react';
+import { useQueryClient } from '@tanstack/react-query';
+import { subscribeToChanges } from '../api/liveUpdates';
+
+// Keep the query cache in step with changes made elsewhere (other tabs,
+// devices) for as long as the signed-in layout is mounted. Reconnects when
+// the user changes.
+export const useLiveUpdates = (userEmail: string | undefined) => {
+  const queryClient = useQueryClient();
+
+  useEffect(() => {
+    if (!userEmail) return;
+    return subscribeToChanges(queryClient);
+  }, [queryClient, userEmail]);
+};
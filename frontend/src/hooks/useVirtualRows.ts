@@ -0,0 +1,148 @@
+import { useCallback, useEffect, useLayoutEffect, useMemo, useRef, useState, type RefObject } from 'react';
+
+interface VirtualRowsOptions {
+  count: number;
+  scrollRef: RefObject<HTMLElement | null>;
+  // Height used for rows that haven't been measured yet
+  estimateSize: number;
+  // Extra rows rendered above and below the viewport
+  overscan?: number;
+}
+
+export interface VirtualRow {
+  index: number;
+  start: number;
+}
+
+// Find the last row whose offset is <= target
+const findRow = (offsets: Float64Array, count: number, target: number): number => {
+  let low = 0;
+  let high = count - 1;
+  while (low < high) {
+    const mid = (low + high + 1) >> 1;
+    if (offsets[mid] <= target) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return low;
+};
+
+// Windowed rendering for long lists of variable-height rows: only the rows
+// in (or near) the scroll container's viewport are mounted. Rows report
+// their real height through `measureRow`; unmeasured rows use the estimate.
+export const useVirtualRows = ({ count, scrollRef, estimateSize, overscan = 8 }: VirtualRowsOptions) => {
+  const [sizes, setSizes] = useState<ReadonlyMap<number, number>>(() => new Map());
+  const [viewport, setViewport] = useState({ scrollTop: 0, height: 0 });
+
+  // offsets[i] is the top of row i; offsets[count] is the total height
+  const offsets = useMemo(() => {
+    const result = new Float64Array(count + 1);
+    for (let i = 0; i < count; i++) {
+      result[i + 1] = result[i] + (sizes.get(i) ?? estimateSize);
+    }
+    return result;
+  }, [count, estimateSize, sizes]);
+
+  useLayoutEffect(() => {
+    const element = scrollRef.current;
+    if (!element) return;
+
+    let frame = 0;
+    const schedule = () => {
+      if (!frame) {
+        frame = requestAnimationFrame(() => {
+          frame = 0;
+          setViewport({ scrollTop: element.scrollTop, height: element.clientHeight });
+        });
+      }
+    };
+
+    element.addEventListener('scroll', schedule, { passive: true });
+    // Also fires once on observe, which picks up the initial viewport
+    const resizeObserver = new ResizeObserver(schedule);
+    resizeObserver.observe(element);
+
+    return () => {
+      element.removeEventListener('scroll', schedule);
+      resizeObserver.disconnect();
+      if (frame) cancelAnimationFrame(frame);
+    };
+  }, [scrollRef]);
+
+  // One observer for all mounted rows; measurements are applied once per frame
+  const pending = useRef(new Map<number, number>());
+  const pendingFrame = useRef(0);
+  const rowObserver = useMemo(
+    () =>
+      typeof ResizeObserver === 'undefined'
+        ? null
+        : new ResizeObserver((entries, observer) => {
+            for (const entry of entries) {
+              const target = entry.target as HTMLElement;
+              // Rows scrolled out of the window are unmounted; stop tracking them
+              if (!target.isConnected) {
+                observer.unobserve(target);
+                continue;
+              }
+              const index = Number(target.dataset.index);
+              const height = target.getBoundingClientRect().height;
+              if (!Number.isNaN(index) && height > 0) {
+                pending.current.set(index, height);
+              }
+            }
+            if (pending.current.size > 0 && !pendingFrame.current) {
+              pendingFrame.current = requestAnimationFrame(() => {
+                pendingFrame.current = 0;
+                const measured = pending.current;
+                pending.current = new Map();
+                setSizes((previous) => {
+                  let next: Map<number, number> | null = null;
+                  measured.forEach((height, index) => {
+                    if (previous.get(index) !== height) {
+                      next ??= new Map(previous);
+                      next.set(index, height);
+                    }
+                  });
+                  return next ?? previous;
+                });
+              });
+            }
+          }),
+    []
+  );
+
+  useEffect(
+    () => () => {
+      rowObserver?.disconnect();
+      if (pendingFrame.current) cancelAnimationFrame(pendingFrame.current);
+    },
+    [rowObserver]
+  );
+
+  const measureRow = useCallback(
+    (element: HTMLElement | null) => {
+      if (element && rowObserver) {
+        rowObserver.observe(element);
+      }
+    },
+    [rowObserver]
+  );
+
+  const virtualRows: VirtualRow[] = [];
+  if (count > 0) {
+    const first = Math.max(0, findRow(offsets, count, viewport.scrollTop) - overscan);
+    const last = Math.min(count - 1, findRow(offsets, count, viewport.scrollTop + viewport.height) + overscan);
+    for (let i = first; i <= last; i++) {
+      virtualRows.push({ index: i, start: offsets[i] });
+    }
+  }
+
+  const totalSize = offsets[count];
+  const paddingTop = virtualRows.length > 0 ? virtualRows[0].start : 0;
+  const paddingBottom =
+    virtualRows.length > 0 ? totalSize - offsets[virtualRows[virtualRows.length - 1].index + 1] : 0;
+
+  return { virtualRows, paddingTop, paddingBottom, totalSize, measureRow };
+};
@@ -2,9 +2,16 @@ import { StrictMode } from 'react'
 import { createRoot } from 'react-dom/client'
 import './index.css'
 import App from './App.tsx'
+import { queryClient } from './api/queryClient'
+import { persistQueryCache, restoreQueryCache } from './api/persistCache'
 
-createRoot(document.getElementById('root')!).render(
-  <StrictMode>
-    <App />
-  </StrictMode>,
-)
+// Render with the persisted cache already in place so returning users
+// don't start from a spinner
+restoreQueryCache(queryClient).finally(() => {
+  persistQueryCache(queryClient)
+  createRoot(document.getElementById('root')!).render(
+    <StrictMode>
+      <App />
+    </StrictMode>,
+  )
+})
@@ -28,8 +28,19 @@ import {
 } from '@mui/icons-material';
 import { useQuery, useMutation, useQueryClient } from '@tanstack/react-query';
 import apiClient from '../api/client';
+import {
+  cancelQueries,
+  findClient,
+  invalidateClientAggregates,
+  removeAllClients,
+  removeClient,
+  snapshotQueries,
+  upsertClient,
+} from '../api/queryCache';
 import { type Client } from '../types/api';
 
+type ClientData = { name: string; description?: string; department?: string; email?: string };
+
 const ClientsPage: React.FC = () => {
   const [open, setOpen] = useState(false);
   const [editingClient, setEditingClient] = useState<Client | null>(null);
@@ -43,27 +54,60 @@ const ClientsPage: React.FC = () => {
     queryFn: () => apiClient.getClients(),
   });
 
+  // Client deletes cascade to work entries, so those lists are patched too
+  const listKeys = [['clients'], ['workEntries']];
+
+  const optimisticClient = (id: number, data: ClientData, base?: Client): Client => {
+    const now = new Date().toISOString().replace('T', ' ').slice(0, 19);
+    return {
+      id,
+      created_at: now,
+      ...base,
+      name: data.name,
+      description: data.description ?? null,
+      department: data.department ?? null,
+      email: data.email ?? null,
+      updated_at: now,
+    };
+  };
+
   const createMutation = useMutation({
-    mutationFn: (clientData: { name: string; description?: string; department?: string; email?: string }) =>
-      apiClient.createClient(clientData),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['clients'] });
+    mutationFn: (clientData: ClientData) => apiClient.createClient(clientData),
+    onMutate: async (clientData) => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      // Negative ids can't collide with rows from the server
+      const tempId = -Date.now();
+      upsertClient(queryClient, optimisticClient(tempId, clientData));
+      return { rollback, tempId };
+    },
+    onSuccess: ({ client }, _clientData, context) => {
+      upsertClient(queryClient, client, context.tempId);
       handleClose();
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _clientData, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to create client');
     },
   });
 
   const updateMutation = useMutation({
-    mutationFn: ({ id, data }: { id: number; data: { name?: string; description?: string; department?: string; email?: string } }) =>
+    mutationFn: ({ id, data }: { id: number; data: ClientData }) =>
       apiClient.updateClient(id, data),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['clients'] });
+    onMutate: async ({ id, data }) => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      upsertClient(queryClient, optimisticClient(id, data, findClient(queryClient, id)));
+      return { rollback };
+    },
+    onSuccess: ({ client }) => {
+      upsertClient(queryClient, client);
+      invalidateClientAggregates(queryClient, [client.id]);
       handleClose();
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _variables, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to update client');
     },
@@ -71,10 +115,14 @@ const ClientsPage: React.FC = () => {
 
   const deleteMutation = useMutation({
     mutationFn: (id: number) => apiClient.deleteClient(id),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['clients'] });
+    onMutate: async (id) => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      removeClient(queryClient, id);
+      return { rollback };
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _id, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to delete client');
     },
@@ -82,10 +130,14 @@ const ClientsPage: React.FC = () => {
 
   const deleteAllMutation = useMutation({
     mutationFn: () => apiClient.deleteAllClients(),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['clients'] });
+    onMutate: async () => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      removeAllClients(queryClient);
+      return { rollback };
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _variables, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to delete all clients');
     },
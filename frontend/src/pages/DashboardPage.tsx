@@ -15,11 +15,13 @@ import {
   Add as AddIcon,
 } from '@mui/icons-material';
 import { useNavigate } from 'react-router-dom';
-import { useQuery } from '@tanstack/react-query';
+import { useQuery, useQueryClient } from '@tanstack/react-query';
 import apiClient from '../api/client';
+import { syncWorkEntries } from '../api/workEntrySync';
 
 const DashboardPage: React.FC = () => {
   const navigate = useNavigate();
+  const queryClient = useQueryClient();
 
   const { data: clientsData } = useQuery({
     queryKey: ['clients'],
@@ -28,7 +30,7 @@ const DashboardPage: React.FC = () => {
 
   const { data: workEntriesData } = useQuery({
     queryKey: ['workEntries'],
-    queryFn: () => apiClient.getWorkEntries(),
+    queryFn: () => syncWorkEntries(queryClient),
   });
 
   const clients = clientsData?.clients || [];
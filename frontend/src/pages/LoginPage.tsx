@@ -1,4 +1,4 @@
-import React, { useState } from 'react';
+import React, { useEffect, useState } from 'react';
 import {
   Container,
   Paper,
@@ -11,6 +11,7 @@ import {
 } from '@mui/material';
 import { useAuth } from '../hooks/useAuth';
 import { useNavigate } from 'react-router-dom';
+import { prefetchRoute, prefetchWhenIdle } from '../routes';
 
 const LoginPage: React.FC = () => {
   const [email, setEmail] = useState('');
@@ -19,10 +20,16 @@ const LoginPage: React.FC = () => {
   const { login } = useAuth();
   const navigate = useNavigate();
 
+  // The dashboard is where a successful login lands
+  useEffect(() => prefetchWhenIdle(['layout', '/dashboard']), []);
+
   const handleSubmit = async (e: React.FormEvent) => {
     e.preventDefault();
     setError('');
     setIsLoading(true);
+    // Fetch the next page's code alongside the login request
+    prefetchRoute('layout');
+    prefetchRoute('/dashboard');
 
     try {
       await login(email);
@@ -1,4 +1,4 @@
-import React, { useState } from 'react';
+import React, { useRef, useState } from 'react';
 import {
   Box,
   Typography,
@@ -27,13 +27,22 @@ import {
   PictureAsPdf as PdfIcon,
   Description as CsvIcon,
 } from '@mui/icons-material';
-import { useQuery } from '@tanstack/react-query';
+import { useQuery, keepPreviousData } from '@tanstack/react-query';
+import { DatePicker } from '@mui/x-date-pickers/DatePicker';
+import { LocalizationProvider } from '@mui/x-date-pickers/LocalizationProvider';
+import { AdapterDateFns } from '@mui/x-date-pickers/AdapterDateFns';
 import apiClient from '../api/client';
-import { type ClientReport } from '../types/api';
+import VirtualTableBody from '../components/VirtualTableBody';
+import { type ClientReport, type WorkEntry } from '../types/api';
+import { lastDays, toApiRange } from '../utils/dateRange';
 
 const ReportsPage: React.FC = () => {
   const [selectedClientId, setSelectedClientId] = useState<number>(0);
   const [error, setError] = useState('');
+  const [range, setRange] = useState<{ from: Date | null; to: Date | null }>(() => lastDays(30));
+
+  const apiRange = toApiRange(range.from, range.to);
+  const scrollRef = useRef<HTMLDivElement>(null);
 
   const { data: clientsData, isLoading: clientsLoading } = useQuery({
     queryKey: ['clients'],
@@ -41,9 +50,10 @@ const ReportsPage: React.FC = () => {
   });
 
   const { data: reportData, isLoading: reportLoading } = useQuery({
-    queryKey: ['clientReport', selectedClientId],
-    queryFn: () => apiClient.getClientReport(selectedClientId),
+    queryKey: ['clientReport', selectedClientId, apiRange],
+    queryFn: () => apiClient.getClientReport(selectedClientId, apiRange),
     enabled: selectedClientId > 0,
+    placeholderData: keepPreviousData,
   });
 
   const clients = clientsData?.clients || [];
@@ -53,7 +63,7 @@ const ReportsPage: React.FC = () => {
     if (!selectedClientId) return;
     
     try {
-      const blob = await apiClient.exportClientReportCsv(selectedClientId);
+      const blob = await apiClient.exportClientReportCsv(selectedClientId, apiRange);
       const url = window.URL.createObjectURL(blob);
       const a = document.createElement('a');
       a.href = url;
@@ -73,7 +83,7 @@ const ReportsPage: React.FC = () => {
     if (!selectedClientId) return;
 
     try {
-      const blob = await apiClient.exportClientReportPdf(selectedClientId);
+      const blob = await apiClient.exportClientReportPdf(selectedClientId, apiRange);
       const url = window.URL.createObjectURL(blob);
       const a = document.createElement('a');
       a.href = url;
@@ -124,7 +134,7 @@ const ReportsPage: React.FC = () => {
         <>
           <Paper sx={{ p: 3, mb: 3 }}>
             <Grid container spacing={3} alignItems="center">
-              <Grid size={{ xs: 12, md: 6 }}>
+              <Grid size={{ xs: 12, md: 4 }}>
                 <FormControl fullWidth>
                   <InputLabel>Select Client</InputLabel>
                   <Select
@@ -141,7 +151,25 @@ const ReportsPage: React.FC = () => {
                   </Select>
                 </FormControl>
               </Grid>
-              <Grid size={{ xs: 12, md: 6 }}>
+              <Grid size={{ xs: 12, md: 5 }}>
+                <LocalizationProvider dateAdapter={AdapterDateFns}>
+                  <Box display="flex" gap={2}>
+                    <DatePicker
+                      label="From"
+                      value={range.from}
+                      onChange={(date) => setRange({ ...range, from: date })}
+                      slotProps={{ field: { clearable: true } }}
+                    />
+                    <DatePicker
+                      label="To"
+                      value={range.to}
+                      onChange={(date) => setRange({ ...range, to: date })}
+                      slotProps={{ field: { clearable: true } }}
+                    />
+                  </Box>
+                </LocalizationProvider>
+              </Grid>
+              <Grid size={{ xs: 12, md: 3 }}>
                 <Box display="flex" gap={2}>
                   <Tooltip title="Export as CSV">
                     <IconButton
@@ -216,8 +244,8 @@ const ReportsPage: React.FC = () => {
               </Grid>
 
               <Paper>
-                <TableContainer>
-                  <Table>
+                <TableContainer ref={scrollRef} sx={{ maxHeight: '70vh' }}>
+                  <Table stickyHeader>
                     <TableHead>
                       <TableRow>
                         <TableCell>Date</TableCell>
@@ -226,10 +254,15 @@ const ReportsPage: React.FC = () => {
                         <TableCell>Created</TableCell>
                       </TableRow>
                     </TableHead>
-                    <TableBody>
-                      {report.workEntries.length > 0 ? (
-                        report.workEntries.map((entry) => (
-                          <TableRow key={entry.id}>
+                    {report.workEntries.length > 0 ? (
+                      <VirtualTableBody
+                        items={report.workEntries}
+                        columns={4}
+                        scrollRef={scrollRef}
+                        estimateRowHeight={57}
+                        getKey={(entry: WorkEntry) => entry.id}
+                        renderCells={(entry: WorkEntry) => (
+                          <>
                             <TableCell>
                               <Typography variant="body2">
                                 {new Date(entry.date).toLocaleDateString()}
@@ -256,18 +289,20 @@ const ReportsPage: React.FC = () => {
                                 {new Date(entry.created_at).toLocaleDateString()}
                               </Typography>
                             </TableCell>
-                          </TableRow>
-                        ))
-                      ) : (
+                          </>
+                        )}
+                      />
+                    ) : (
+                      <TableBody>
                         <TableRow>
                           <TableCell colSpan={4} align="center">
                             <Typography color="text.secondary" sx={{ py: 3 }}>
-                              No work entries found for this client.
+                              No work entries found for this client in this period.
                             </Typography>
                           </TableCell>
                         </TableRow>
-                      )}
-                    </TableBody>
+                      </TableBody>
+                    )}
                   </Table>
                 </TableContainer>
               </Paper>
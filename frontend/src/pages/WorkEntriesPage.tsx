@@ -1,4 +1,4 @@
-import React, { useState } from 'react';
+import React, { useCallback, useRef, useState } from 'react';
 import {
   Box,
   Typography,
@@ -29,12 +29,30 @@ import {
   Edit as EditIcon,
   Delete as DeleteIcon,
 } from '@mui/icons-material';
-import { useQuery, useMutation, useQueryClient } from '@tanstack/react-query';
+import { useQuery, useInfiniteQuery, useMutation, useQueryClient, keepPreviousData } from '@tanstack/react-query';
 import { DatePicker } from '@mui/x-date-pickers/DatePicker';
 import { LocalizationProvider } from '@mui/x-date-pickers/LocalizationProvider';
 import { AdapterDateFns } from '@mui/x-date-pickers/AdapterDateFns';
 import apiClient from '../api/client';
-import { type WorkEntry } from '../types/api';
+import {
+  cancelQueries,
+  findClient,
+  findWorkEntry,
+  invalidateClientAggregates,
+  removeWorkEntry,
+  snapshotQueries,
+  upsertWorkEntry,
+} from '../api/queryCache';
+import VirtualTableBody from '../components/VirtualTableBody';
+import WorkEntrySearch from '../components/WorkEntrySearch';
+import { type WorkEntry, type WorkEntryFilters } from '../types/api';
+import { lastDays, toApiRange } from '../utils/dateRange';
+
+// Entries are fetched in pages as the user scrolls towards the end
+const PAGE_SIZE = 100;
+const ESTIMATED_ROW_HEIGHT = 73;
+
+type EntryData = { clientId: number; hours: number; description?: string; date: string };
 
 const WorkEntriesPage: React.FC = () => {
   const [open, setOpen] = useState(false);
@@ -46,40 +64,101 @@ const WorkEntriesPage: React.FC = () => {
     date: new Date(),
   });
   const [error, setError] = useState('');
+  const [range, setRange] = useState<{ from: Date | null; to: Date | null }>(() => lastDays(30));
+  const [filterClientIds, setFilterClientIds] = useState<number[]>([]);
 
   const queryClient = useQueryClient();
 
-  const { data: workEntriesData, isLoading: entriesLoading } = useQuery({
-    queryKey: ['workEntries'],
-    queryFn: () => apiClient.getWorkEntries(),
+  // Only the visible window is fetched; filtering happens in SQL
+  const filters: WorkEntryFilters = {
+    ...toApiRange(range.from, range.to),
+    ...(filterClientIds.length > 0 ? { clientIds: filterClientIds } : {}),
+  };
+
+  const {
+    data: workEntriesData,
+    isLoading: entriesLoading,
+    hasNextPage,
+    isFetchingNextPage,
+    fetchNextPage,
+  } = useInfiniteQuery({
+    queryKey: ['workEntries', filters, 'paged'],
+    queryFn: ({ pageParam }) =>
+      apiClient.getWorkEntries({ ...filters, limit: PAGE_SIZE, ...(pageParam ? { cursor: pageParam } : {}) }),
+    initialPageParam: '',
+    getNextPageParam: (lastPage) => lastPage.nextCursor || undefined,
+    placeholderData: keepPreviousData,
   });
 
+  const scrollRef = useRef<HTMLDivElement>(null);
+  const loadMore = useCallback(() => {
+    if (hasNextPage && !isFetchingNextPage) {
+      fetchNextPage();
+    }
+  }, [hasNextPage, isFetchingNextPage, fetchNextPage]);
+
   const { data: clientsData, isLoading: clientsLoading } = useQuery({
     queryKey: ['clients'],
     queryFn: () => apiClient.getClients(),
   });
 
+  // Optimistic row built from the form; replaced by the server's row on success
+  const optimisticEntry = (id: number, data: EntryData, base?: WorkEntry): WorkEntry => {
+    const now = new Date().toISOString().replace('T', ' ').slice(0, 19);
+    return {
+      id,
+      created_at: now,
+      ...base,
+      client_id: data.clientId,
+      client_name: findClient(queryClient, data.clientId)?.name ?? base?.client_name,
+      hours: data.hours,
+      description: data.description ?? null,
+      date: data.date,
+      updated_at: now,
+    };
+  };
+
+  const listKeys = [['workEntries']];
+
   const createMutation = useMutation({
-    mutationFn: (entryData: { clientId: number; hours: number; description?: string; date: string }) =>
-      apiClient.createWorkEntry(entryData),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['workEntries'] });
+    mutationFn: (entryData: EntryData) => apiClient.createWorkEntry(entryData),
+    onMutate: async (entryData) => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      // Negative ids can't collide with rows from the server
+      const tempId = -Date.now();
+      upsertWorkEntry(queryClient, optimisticEntry(tempId, entryData));
+      return { rollback, tempId };
+    },
+    onSuccess: ({ workEntry }, _entryData, context) => {
+      upsertWorkEntry(queryClient, workEntry, context.tempId);
+      invalidateClientAggregates(queryClient, [workEntry.client_id]);
       handleClose();
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _entryData, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to create work entry');
     },
   });
 
   const updateMutation = useMutation({
-    mutationFn: ({ id, data }: { id: number; data: { clientId?: number; hours?: number; description?: string; date?: string } }) =>
+    mutationFn: ({ id, data }: { id: number; data: EntryData }) =>
       apiClient.updateWorkEntry(id, data),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['workEntries'] });
+    onMutate: async ({ id, data }) => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      const previous = findWorkEntry(queryClient, id);
+      upsertWorkEntry(queryClient, optimisticEntry(id, data, previous));
+      return { rollback, previousClientId: previous?.client_id };
+    },
+    onSuccess: ({ workEntry }, _variables, context) => {
+      upsertWorkEntry(queryClient, workEntry);
+      invalidateClientAggregates(queryClient, [workEntry.client_id, context.previousClientId]);
       handleClose();
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _variables, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to update work entry');
     },
@@ -87,16 +166,24 @@ const WorkEntriesPage: React.FC = () => {
 
   const deleteMutation = useMutation({
     mutationFn: (id: number) => apiClient.deleteWorkEntry(id),
-    onSuccess: () => {
-      queryClient.invalidateQueries({ queryKey: ['workEntries'] });
+    onMutate: async (id) => {
+      await cancelQueries(queryClient, listKeys);
+      const rollback = snapshotQueries(queryClient, listKeys);
+      const clientId = findWorkEntry(queryClient, id)?.client_id;
+      removeWorkEntry(queryClient, id);
+      return { rollback, clientId };
+    },
+    onSuccess: (_data, _id, context) => {
+      invalidateClientAggregates(queryClient, [context.clientId]);
     },
-    onError: (err: unknown) => {
+    onError: (err: unknown, _id, context) => {
+      context?.rollback();
       const error = err as { response?: { data?: { error?: string } } };
       setError(error.response?.data?.error || 'Failed to delete work entry');
     },
   });
 
-  const workEntries = workEntriesData?.workEntries || [];
+  const workEntries = workEntriesData?.pages.flatMap((page) => page.workEntries) || [];
   const clients = clientsData?.clients || [];
 
   const handleOpen = (entry?: WorkEntry) => {
@@ -210,79 +297,135 @@ const WorkEntriesPage: React.FC = () => {
             </Button>
           </Paper>
         ) : (
-          <Paper>
-            <TableContainer>
-              <Table>
-                <TableHead>
-                  <TableRow>
-                    <TableCell>Client</TableCell>
-                    <TableCell>Date</TableCell>
-                    <TableCell>Hours</TableCell>
-                    <TableCell>Description</TableCell>
-                    <TableCell align="right">Actions</TableCell>
-                  </TableRow>
-                </TableHead>
-                <TableBody>
+          <>
+            <Paper sx={{ p: 2, mb: 2 }}>
+              <Box display="flex" gap={2} flexWrap="wrap">
+                <DatePicker
+                  label="From"
+                  value={range.from}
+                  onChange={(date) => setRange({ ...range, from: date })}
+                  slotProps={{ textField: { size: 'small' }, field: { clearable: true } }}
+                />
+                <DatePicker
+                  label="To"
+                  value={range.to}
+                  onChange={(date) => setRange({ ...range, to: date })}
+                  slotProps={{ textField: { size: 'small' }, field: { clearable: true } }}
+                />
+                <FormControl size="small" sx={{ minWidth: 220 }}>
+                  <InputLabel>Clients</InputLabel>
+                  <Select
+                    multiple
+                    label="Clients"
+                    value={filterClientIds}
+                    onChange={(e) => {
+                      const selected = e.target.value;
+                      setFilterClientIds(typeof selected === 'string' ? [] : selected.map(Number));
+                    }}
+                    renderValue={(selected) =>
+                      clients
+                        .filter((client: { id: number }) => selected.includes(client.id))
+                        .map((client: { name: string }) => client.name)
+                        .join(', ')
+                    }
+                  >
+                    {clients.map((client: { id: number; name: string }) => (
+                      <MenuItem key={client.id} value={client.id}>
+                        {client.name}
+                      </MenuItem>
+                    ))}
+                  </Select>
+                </FormControl>
+                <WorkEntrySearch range={toApiRange(range.from, range.to)} />
+              </Box>
+            </Paper>
+            <Paper>
+              <TableContainer ref={scrollRef} sx={{ maxHeight: '70vh' }}>
+                <Table stickyHeader>
+                  <TableHead>
+                    <TableRow>
+                      <TableCell>Client</TableCell>
+                      <TableCell>Date</TableCell>
+                      <TableCell>Hours</TableCell>
+                      <TableCell>Description</TableCell>
+                      <TableCell align="right">Actions</TableCell>
+                    </TableRow>
+                  </TableHead>
                   {workEntries.length > 0 ? (
-                    workEntries.map((entry: WorkEntry) => (
-                      <TableRow key={entry.id}>
-                        <TableCell>
-                          <Typography variant="subtitle1" fontWeight="medium">
-                            {entry.client_name}
-                          </Typography>
-                        </TableCell>
-                        <TableCell>
-                          <Typography variant="body2">
-                            {new Date(entry.date).toLocaleDateString()}
-                          </Typography>
-                        </TableCell>
-                        <TableCell>
-                          <Chip 
-                            label={`${entry.hours} hours`} 
-                            color="primary" 
-                            variant="outlined" 
-                          />
-                        </TableCell>
-                        <TableCell>
-                          {entry.description ? (
-                            <Typography variant="body2" color="text.secondary">
-                              {entry.description}
+                    <VirtualTableBody
+                      items={workEntries}
+                      columns={5}
+                      scrollRef={scrollRef}
+                      estimateRowHeight={ESTIMATED_ROW_HEIGHT}
+                      getKey={(entry: WorkEntry) => entry.id}
+                      onEndReached={loadMore}
+                      renderCells={(entry: WorkEntry) => (
+                        <>
+                          <TableCell>
+                            <Typography variant="subtitle1" fontWeight="medium">
+                              {entry.client_name}
                             </Typography>
-                          ) : (
-                            <Chip label="No description" size="small" variant="outlined" />
-                          )}
-                        </TableCell>
-                        <TableCell align="right">
-                          <IconButton
-                            onClick={() => handleOpen(entry)}
-                            color="primary"
-                            size="small"
-                          >
-                            <EditIcon />
-                          </IconButton>
-                          <IconButton
-                            onClick={() => handleDelete(entry)}
-                            color="error"
-                            size="small"
-                          >
-                            <DeleteIcon />
-                          </IconButton>
+                          </TableCell>
+                          <TableCell>
+                            <Typography variant="body2">
+                              {new Date(entry.date).toLocaleDateString()}
+                            </Typography>
+                          </TableCell>
+                          <TableCell>
+                            <Chip 
+                              label={`${entry.hours} hours`} 
+                              color="primary" 
+                              variant="outlined" 
+                            />
+                          </TableCell>
+                          <TableCell>
+                            {entry.description ? (
+                              <Typography variant="body2" color="text.secondary">
+                                {entry.description}
+                              </Typography>
+                            ) : (
+                              <Chip label="No description" size="small" variant="outlined" />
+                            )}
+                          </TableCell>
+                          <TableCell align="right">
+                            <IconButton
+                              onClick={() => handleOpen(entry)}
+                              color="primary"
+                              size="small"
+                            >
+                              <EditIcon />
+                            </IconButton>
+                            <IconButton
+                              onClick={() => handleDelete(entry)}
+                              color="error"
+                              size="small"
+                            >
+                              <DeleteIcon />
+                            </IconButton>
+                          </TableCell>
+                        </>
+                      )}
+                    />
+                  ) : (
+                    <TableBody>
+                      <TableRow>
+                        <TableCell colSpan={5} align="center">
+                          <Typography color="text.secondary" sx={{ py: 3 }}>
+                            No work entries found in this period. Adjust the filters or add a work entry.
+                          </Typography>
                         </TableCell>
                       </TableRow>
-                    ))
-                  ) : (
-                    <TableRow>
-                      <TableCell colSpan={5} align="center">
-                        <Typography color="text.secondary" sx={{ py: 3 }}>
-                          No work entries found. Add your first work entry to get started.
-                        </Typography>
-                      </TableCell>
-                    </TableRow>
+                    </TableBody>
                   )}
-                </TableBody>
-              </Table>
-            </TableContainer>
-          </Paper>
+                </Table>
+                {isFetchingNextPage && (
+                  <Box display="flex" justifyContent="center" py={2}>
+                    <CircularProgress size={24} />
+                  </Box>
+                )}
+              </TableContainer>
+            </Paper>
+          </>
         )}
 
         <Dialog open={open} onClose={handleClose} maxWidth="sm" fullWidth>
@@ -0,0 +1,65 @@
+import { lazy } from 'react';
+
+// Each page is its own chunk. Loaders are memoized so a prefetch and the
+// later render share one request.
+const loader = <T>(load: () => Promise<T>) => {
+  let promise: Promise<T> | null = null;
+  return () => {
+    if (!promise) {
+      promise = load().catch((error) => {
+        // Allow a retry after a failed (e.g. offline) fetch
+        promise = null;
+        throw error;
+      });
+    }
+    return promise;
+  };
+};
+
+const loaders = {
+  login: loader(() => import('./pages/LoginPage')),
+  layout: loader(() => import('./components/Layout')),
+  '/dashboard': loader(() => import('./pages/DashboardPage')),
+  '/clients': loader(() => import('./pages/ClientsPage')),
+  '/work-entries': loader(() => import('./pages/WorkEntriesPage')),
+  '/reports': loader(() => import('./pages/ReportsPage')),
+};
+
+export type RoutePath = '/dashboard' | '/clients' | '/work-entries' | '/reports';
+
+export const LoginPage = lazy(loaders.login);
+export const Layout = lazy(loaders.layout);
+export const DashboardPage = lazy(loaders['/dashboard']);
+export const ClientsPage = lazy(loaders['/clients']);
+export const WorkEntriesPage = lazy(loaders['/work-entries']);
+export const ReportsPage = lazy(loaders['/reports']);
+
+// Start downloading a route's chunk, e.g. when its link is hovered
+export const prefetchRoute = (path: RoutePath | 'layout') => {
+  loaders[path]().catch(() => {
+    // Ignored; the route retries when it's actually rendered
+  });
+};
+
+const canPrefetchInBackground = () => {
+  const connection = (navigator as Navigator & { connection?: { saveData?: boolean; effectiveType?: string } })
+    .connection;
+  return !connection?.saveData && !/2g/.test(connection?.effectiveType ?? '');
+};
+
+// Prefetch routes once the browser is idle, skipping data-saver/slow connections
+export const prefetchWhenIdle = (paths: Array<RoutePath | 'layout'>) => {
+  if (!canPrefetchInBackground()) {
+    return () => {};
+  }
+
+  const prefetchAll = () => paths.forEach(prefetchRoute);
+
+  if ('requestIdleCallback' in window) {
+    const handle = window.requestIdleCallback(prefetchAll, { timeout: 5000 });
+    return () => window.cancelIdleCallback(handle);
+  }
+
+  const handle = window.setTimeout(prefetchAll, 2000);
+  return () => window.clearTimeout(handle);
+};
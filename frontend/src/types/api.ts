@@ -3,6 +3,17 @@ export interface User {
   createdAt: string;
 }
 
+export interface SessionTokens {
+  accessToken: string;
+  refreshToken: string;
+  expiresIn: number;
+}
+
+export interface LoginResponse extends SessionTokens {
+  message: string;
+  user: User;
+}
+
 export interface Client {
   id: number;
   name: string;
@@ -63,6 +74,103 @@ export interface UpdateWorkEntryRequest {
   date?: string;
 }
 
+export interface DateRange {
+  from?: string;
+  to?: string;
+}
+
+export type SummaryGrouping = 'client' | 'day' | 'week' | 'month';
+
+export interface ClientSummary {
+  clientId: number;
+  name: string;
+  totalHours: number;
+  entryCount: number;
+  // Hours per period, aligned with ReportSummary.periods
+  hours?: number[];
+}
+
+export interface ReportSummary {
+  groupBy: SummaryGrouping;
+  from?: string;
+  to?: string;
+  periods: string[];
+  clients: ClientSummary[];
+  periodTotals?: number[];
+  totalHours: number;
+  entryCount: number;
+}
+
+export interface WorkEntryFilters extends DateRange {
+  clientId?: number;
+  clientIds?: number[];
+  minHours?: number;
+  maxHours?: number;
+  limit?: number;
+  cursor?: string;
+}
+
+export interface WorkEntryPage {
+  workEntries: WorkEntry[];
+  nextCursor?: string | null;
+}
+
+// Response of GET /api/work-entries/changes
+export interface WorkEntryChanges {
+  workEntries: WorkEntry[];
+  deleted: number[];
+  version: number;
+  hasMore: boolean;
+}
+
+// Full work entry list kept current by delta sync
+export interface SyncedWorkEntries {
+  workEntries: WorkEntry[];
+  version: number;
+}
+
+// Notification pushed on GET /api/events when the user's data changes
+export type ChangeEvent =
+  | { entity: 'work_entry'; op: 'upsert'; row: WorkEntry }
+  | { entity: 'client'; op: 'upsert'; row: Client }
+  | { entity: 'work_entry' | 'client'; op: 'delete'; id: number }
+  | { entity: 'client'; op: 'clear' };
+
+export interface SearchSegment {
+  text: string;
+  match: boolean;
+}
+
+export interface WorkEntrySearchResult {
+  id: number;
+  client_id: number;
+  client_name: string;
+  hours: number;
+  date: string;
+  description: string | null;
+  snippet: SearchSegment[];
+}
+
+export interface SearchResponse<T> {
+  results: T[];
+  type: 'entries' | 'clients';
+  limit: number;
+  offset: number;
+  hasMore: boolean;
+}
+
+export interface BatchRequest {
+  id?: string;
+  method: 'GET' | 'POST' | 'PUT' | 'DELETE';
+  path: string;
+  query?: Record<string, unknown>;
+  body?: unknown;
+}
+
+export interface BatchResponse {
+  responses: { id?: string; status: number; body: unknown }[];
+}
+
 export interface LoginRequest {
   email: string;
 }
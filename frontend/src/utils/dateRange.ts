@@ -0,0 +1,17 @@
+import { type DateRange } from '../types/api';
+
+// Format a Date the way the API expects it (YYYY-MM-DD)
+export const toApiDate = (date: Date): string => date.toISOString().split('T')[0];
+
+export const toApiRange = (from: Date | null, to: Date | null): DateRange => ({
+  ...(from ? { from: toApiDate(from) } : {}),
+  ...(to ? { to: toApiDate(to) } : {}),
+});
+
+// The last `days` days, ending today
+export const lastDays = (days: number): { from: Date; to: Date } => {
+  const to = new Date();
+  const from = new Date(to);
+  from.setDate(from.getDate() - days);
+  return { from, to };
+};
@@ -4,6 +4,10 @@ import react from '@vitejs/plugin-react'
 // https://vite.dev/config/
 export default defineConfig({
   plugins: [react()],
+  build: {
+    // Read by scripts/bundle-size.mjs to report per-route sizes
+    manifest: true,
+  },
   server: {
     proxy: {
       '/api': {